@@ -371,8 +371,6 @@ static int assemble(Input input, const QInstaller::Settings &settings, const Bin
     }
 #endif
 
-    QFile out(generateTemporaryFileName());
-
     QString targetName = input.outputPath;
 #ifdef Q_OS_MACOS
     QDir resourcePath(QFileInfo(input.outputPath).dir());
@@ -381,11 +379,16 @@ static int assemble(Input input, const QInstaller::Settings &settings, const Bin
     targetName = resourcePath.filePath(QLatin1String("installer.dat"));
 #endif
 
+    // Assemble next to the target, so that the final rename does not need to copy the payload
+    // in case the temporary directory is on another file system.
+    QFile out(generateTemporaryFileName(targetName));
+
     {
         QFile target(targetName);
         if (target.exists() && !target.remove()) {
             qCritical("Cannot remove target %s: %s", qPrintable(target.fileName()),
                 qPrintable(target.errorString()));
+            out.remove();
             QFile::remove(tempFile);
             return EXIT_FAILURE;
         }
@@ -427,6 +430,7 @@ static int assemble(Input input, const QInstaller::Settings &settings, const Bin
 
     } catch (const Error &e) {
         qCritical("Error occurred while assembling the installer: %s", qPrintable(e.message()));
+        out.remove();
         QFile::remove(tempFile);
         return EXIT_FAILURE;
     }
@@ -434,6 +438,7 @@ static int assemble(Input input, const QInstaller::Settings &settings, const Bin
     if (!out.rename(targetName)) {
         qCritical("Cannot write installer to %s: %s", targetName.toUtf8().constData(),
             out.errorString().toUtf8().constData());
+        out.remove();
         QFile::remove(tempFile);
         return EXIT_FAILURE;
     }
@@ -820,7 +825,7 @@ int QInstallerTools::createBinary(BinaryCreatorArgs args, QString &argumentError
             //    must happen before copying meta data because files will be compressed if
             //    needed and meta data generation relies on this
             copyComponentData(args.packagesDirectories, tmpRepoDir, &preparedPackages,
-                args.archiveSuffix, args.compression);
+                args.archiveSuffix, args.compression, args.jobs);
             // 2.3; add to common vector
             packages.append(preparedPackages);
         }
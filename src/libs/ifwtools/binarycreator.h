@@ -61,6 +61,7 @@ struct IFWTOOLS_EXPORT BinaryCreatorArgs
     QStringList repositoryDirectories;
     QString archiveSuffix = QLatin1String("7z");
     Compression compression = Compression::Normal;
+    int jobs = 0;
     bool onlineOnly = false;
     bool offlineOnly = false;
     QStringList resources;
@@ -30,6 +30,7 @@
 
 #include "constants.h"
 #include "fileio.h"
+#include "filehasher.h"
 #include "fileutils.h"
 #include "errors.h"
 #include "globals.h"
@@ -42,8 +43,13 @@
 
 #include "updater.h"
 
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
 #include <QtCore/QDirIterator>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QRegularExpression>
+#include <QtCore/QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <QtXml/QDomDocument>
 #include <QTemporaryDir>
@@ -56,6 +62,8 @@
 using namespace QInstaller;
 using namespace QInstallerTools;
 
+static const QLatin1String scRepositoryManifest("RepogenManifest.xml");
+
 void QInstallerTools::printRepositoryGenOptions()
 {
     std::cout << "  -p|--packages dir         The directory containing the available packages." << std::endl;
@@ -892,7 +900,7 @@ QStringList QInstallerTools::unifyMetadata(const QString &repoDir, const QString
 
     QFile tmp(tmpTarget);
     tmp.open(QFile::ReadOnly);
-    const QByteArray sha1Sum = QInstaller::calculateHash(&tmp, QCryptographicHash::Sha1);
+    const QByteArray sha1Sum = FileHasher::hash(&tmp, QCryptographicHash::Sha1);
     QDomNodeList elements =  doc.elementsByTagName(QLatin1String("Updates"));
     writeSHA1ToNodeWithName(doc, elements, sha1Sum, QString());
 
@@ -935,7 +943,7 @@ void QInstallerTools::splitMetadata(const QStringList &entryList, const QString
         QInstaller::removeFiles(absPath, true);
         QFile tmp(tmpTarget);
         tmp.open(QFile::ReadOnly);
-        const QByteArray sha1Sum = QInstaller::calculateHash(&tmp, QCryptographicHash::Sha1);
+        const QByteArray sha1Sum = FileHasher::hash(&tmp, QCryptographicHash::Sha1);
         writeSHA1ToNodeWithName(doc, elements, sha1Sum, path);
         const QString finalTarget = absPath + QLatin1String("/") + fn;
         if (!tmp.rename(finalTarget)) {
@@ -990,104 +998,140 @@ void QInstallerTools::copyScriptFiles(const QDomNodeList &childNodes, const Pack
     }
 }
 
-void QInstallerTools::copyComponentData(const QStringList &packageDirs, const QString &repoDir,
-    PackageInfoVector *const infos, const QString &archiveSuffix, Compression compression)
+static void copyPackageComponentData(const QStringList &packageDirs, const QString &repoDir,
+    PackageInfo *const packageInfo, const QString &archiveSuffix, Compression compression)
 {
-    for (int i = 0; i < infos->count(); ++i) {
-        const PackageInfo info = infos->at(i);
-        const QString name = info.name;
-        qDebug() << "Copying component data for" << name;
-
-        const QString namedRepoDir = QString::fromLatin1("%1/%2").arg(repoDir, name);
-        if (!QDir().mkpath(namedRepoDir)) {
-            throw QInstaller::Error(QString::fromLatin1("Cannot create repository directory for component \"%1\".")
-                .arg(name));
-        }
+    const PackageInfo info = *packageInfo;
+    const QString name = info.name;
+    qDebug() << "Copying component data for" << name;
+
+    const QString namedRepoDir = QString::fromLatin1("%1/%2").arg(repoDir, name);
+    if (!QDir().mkpath(namedRepoDir)) {
+        throw QInstaller::Error(QString::fromLatin1("Cannot create repository directory for component \"%1\".")
+            .arg(name));
+    }
 
-        if (info.copiedFiles.isEmpty()) {
-            QStringList compressedFiles;
-            QStringList filesToCompress;
-            foreach (const QString &packageDir, packageDirs) {
-                const QDir dataDir(QString::fromLatin1("%1/%2/data").arg(packageDir, name));
-                foreach (const QString &entry, dataDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Files)) {
-                    QFileInfo fileInfo(dataDir.absoluteFilePath(entry));
-                    if (fileInfo.isFile() && !fileInfo.isSymLink()) {
-                        const QString absoluteEntryFilePath = dataDir.absoluteFilePath(entry);
-                        QScopedPointer<AbstractArchive> archive(ArchiveFactory::instance()
-                            .create(absoluteEntryFilePath));
-                        if (archive && archive->open(QIODevice::ReadOnly) && archive->isSupported()) {
-                            QFile tmp(absoluteEntryFilePath);
-                            QString target = QString::fromLatin1("%1/%3%2").arg(namedRepoDir, entry, info.version);
-                            qDebug() << "Copying archive from" << tmp.fileName() << "to" << target;
-                            if (!tmp.copy(target)) {
-                                throw QInstaller::Error(QString::fromLatin1("Cannot copy file \"%1\" to \"%2\": %3")
-                                    .arg(QDir::toNativeSeparators(tmp.fileName()), QDir::toNativeSeparators(target), tmp.errorString()));
-                            }
-                            compressedFiles.append(target);
-                        } else {
-                            filesToCompress.append(absoluteEntryFilePath);
+    if (info.copiedFiles.isEmpty()) {
+        QStringList compressedFiles;
+        QStringList filesToCompress;
+        foreach (const QString &packageDir, packageDirs) {
+            const QDir dataDir(QString::fromLatin1("%1/%2/data").arg(packageDir, name));
+            foreach (const QString &entry, dataDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Files)) {
+                QFileInfo fileInfo(dataDir.absoluteFilePath(entry));
+                if (fileInfo.isFile() && !fileInfo.isSymLink()) {
+                    const QString absoluteEntryFilePath = dataDir.absoluteFilePath(entry);
+                    QScopedPointer<AbstractArchive> archive(ArchiveFactory::instance()
+                        .create(absoluteEntryFilePath));
+                    if (archive && archive->open(QIODevice::ReadOnly) && archive->isSupported()) {
+                        QFile tmp(absoluteEntryFilePath);
+                        QString target = QString::fromLatin1("%1/%3%2").arg(namedRepoDir, entry, info.version);
+                        qDebug() << "Copying archive from" << tmp.fileName() << "to" << target;
+                        if (!tmp.copy(target)) {
+                            throw QInstaller::Error(QString::fromLatin1("Cannot copy file \"%1\" to \"%2\": %3")
+                                .arg(QDir::toNativeSeparators(tmp.fileName()), QDir::toNativeSeparators(target), tmp.errorString()));
                         }
-                    } else if (fileInfo.isDir()) {
-                        qDebug() << "Compressing data directory" << entry;
-                        QString target = QString::fromLatin1("%1/%3%2.%4").arg(namedRepoDir, entry, info.version, archiveSuffix);
-                        createArchive(target, QStringList() << dataDir.absoluteFilePath(entry), compression);
                         compressedFiles.append(target);
-                    } else if (fileInfo.isSymLink()) {
-                        filesToCompress.append(dataDir.absoluteFilePath(entry));
+                    } else {
+                        filesToCompress.append(absoluteEntryFilePath);
                     }
+                } else if (fileInfo.isDir()) {
+                    qDebug() << "Compressing data directory" << entry;
+                    QString target = QString::fromLatin1("%1/%3%2.%4").arg(namedRepoDir, entry, info.version, archiveSuffix);
+                    createArchive(target, QStringList() << dataDir.absoluteFilePath(entry), compression);
+                    compressedFiles.append(target);
+                } else if (fileInfo.isSymLink()) {
+                    filesToCompress.append(dataDir.absoluteFilePath(entry));
                 }
             }
+        }
 
-            if (!filesToCompress.isEmpty()) {
-                qDebug() << "Compressing files found in data directory:" << filesToCompress;
-                QString target = QString::fromLatin1("%1/%2content.%3").arg(namedRepoDir, info.version, archiveSuffix);
-                createArchive(target, filesToCompress, compression);
-                compressedFiles.append(target);
-            }
-
-            foreach (const QString &target, compressedFiles) {
-                (*infos)[i].copiedFiles.append(target);
-
-                QFile archiveFile(target);
-                QFile archiveHashFile(archiveFile.fileName() + QLatin1String(".sha1"));
-
-                qDebug() << "Hash is stored in" << archiveHashFile.fileName();
-                qDebug() << "Creating hash of archive" << archiveFile.fileName();
+        if (!filesToCompress.isEmpty()) {
+            qDebug() << "Compressing files found in data directory:" << filesToCompress;
+            QString target = QString::fromLatin1("%1/%2content.%3").arg(namedRepoDir, info.version, archiveSuffix);
+            createArchive(target, filesToCompress, compression);
+            compressedFiles.append(target);
+        }
 
-                try {
-                    QInstaller::openForRead(&archiveFile);
-                    const QByteArray hashOfArchiveData = QInstaller::calculateHash(&archiveFile,
-                        QCryptographicHash::Sha1).toHex();
-                    archiveFile.close();
-
-                    QInstaller::openForWrite(&archiveHashFile);
-                    archiveHashFile.write(hashOfArchiveData);
-                    qDebug() << "Generated sha1 hash:" << hashOfArchiveData;
-                    (*infos)[i].copiedFiles.append(archiveHashFile.fileName());
-                    if ((*infos)[i].createContentSha1Node)
-                        (*infos)[i].contentSha1 = QLatin1String(hashOfArchiveData);
-                    archiveHashFile.close();
-                } catch (const QInstaller::Error &/*e*/) {
-                    archiveFile.close();
-                    archiveHashFile.close();
-                    throw;
-                }
+        foreach (const QString &target, compressedFiles) {
+            packageInfo->copiedFiles.append(target);
+
+            QFile archiveFile(target);
+            QFile archiveHashFile(archiveFile.fileName() + QLatin1String(".sha1"));
+
+            qDebug() << "Hash is stored in" << archiveHashFile.fileName();
+            qDebug() << "Creating hash of archive" << archiveFile.fileName();
+
+            try {
+                QInstaller::openForRead(&archiveFile);
+                const QByteArray hashOfArchiveData = FileHasher::hash(&archiveFile,
+                    QCryptographicHash::Sha1).toHex();
+                archiveFile.close();
+
+                QInstaller::openForWrite(&archiveHashFile);
+                archiveHashFile.write(hashOfArchiveData);
+                qDebug() << "Generated sha1 hash:" << hashOfArchiveData;
+                packageInfo->copiedFiles.append(archiveHashFile.fileName());
+                if (packageInfo->createContentSha1Node)
+                    packageInfo->contentSha1 = QLatin1String(hashOfArchiveData);
+                archiveHashFile.close();
+            } catch (const QInstaller::Error &/*e*/) {
+                archiveFile.close();
+                archiveHashFile.close();
+                throw;
             }
-        } else {
-            foreach (const QString &file, (*infos)[i].copiedFiles) {
-                QFileInfo fromInfo(file);
-                QFile from(file);
-                QString target = QString::fromLatin1("%1/%2").arg(namedRepoDir, fromInfo.fileName());
-                qDebug() << "Copying file from" << from.fileName() << "to" << target;
-                if (!from.copy(target)) {
-                    throw QInstaller::Error(QString::fromLatin1("Cannot copy file \"%1\" to \"%2\": %3")
-                        .arg(QDir::toNativeSeparators(from.fileName()), QDir::toNativeSeparators(target), from.errorString()));
-                }
+        }
+    } else {
+        foreach (const QString &file, packageInfo->copiedFiles) {
+            QFileInfo fromInfo(file);
+            QFile from(file);
+            QString target = QString::fromLatin1("%1/%2").arg(namedRepoDir, fromInfo.fileName());
+            qDebug() << "Copying file from" << from.fileName() << "to" << target;
+            if (!from.copy(target)) {
+                throw QInstaller::Error(QString::fromLatin1("Cannot copy file \"%1\" to \"%2\": %3")
+                    .arg(QDir::toNativeSeparators(from.fileName()), QDir::toNativeSeparators(target), from.errorString()));
             }
         }
     }
 }
 
+void QInstallerTools::copyComponentData(const QStringList &packageDirs, const QString &repoDir,
+    PackageInfoVector *const infos, const QString &archiveSuffix, Compression compression, int jobs)
+{
+    // Packages are compressed and hashed concurrently. Each job writes only to the
+    // repository directory and the package info of its own package, so the order
+    // of the packages and the generated metadata do not depend on the scheduling.
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(jobs > 0 ? jobs : QThread::idealThreadCount());
+
+    PackageInfo *const packageInfos = infos->data();
+    QList<QFuture<QString>> futures;
+    for (int i = 0; i < infos->count(); ++i) {
+        PackageInfo *const packageInfo = packageInfos + i;
+        futures.append(QtConcurrent::run(&threadPool, [=]() -> QString {
+            QElapsedTimer timer;
+            timer.start();
+            try {
+                copyPackageComponentData(packageDirs, repoDir, packageInfo, archiveSuffix, compression);
+            } catch (const QInstaller::Error &e) {
+                return e.message();
+            }
+            qDebug() << "Component data for" << packageInfo->name << "created in"
+                << timer.elapsed() << "ms";
+            return QString();
+        }));
+    }
+
+    // Wait for all jobs to finish before reporting the first error in package order
+    QString error;
+    for (QFuture<QString> &future : futures) {
+        future.waitForFinished();
+        if (error.isEmpty())
+            error = future.result();
+    }
+    if (!error.isEmpty())
+        throw QInstaller::Error(error);
+}
+
 void QInstallerTools::filterNewComponents(const QString &repositoryDir, QInstallerTools::PackageInfoVector &packages)
 {
     QDomDocument doc;
@@ -1133,6 +1177,276 @@ void QInstallerTools::filterNewComponents(const QString &repositoryDir, QInstall
     }
 }
 
+namespace {
+
+typedef QInstallerTools::PackageInputFile ManifestFile;
+
+struct ManifestPackage
+{
+    QString version;
+    QByteArray sha1;
+    QVector<ManifestFile> files;
+};
+
+struct RepositoryManifest
+{
+    QString archiveSuffix;
+    int compression = -1;
+    QHash<QString, ManifestPackage> packages;
+};
+
+} // namespace
+
+/*!
+    \internal
+
+    Reads the manifest of package input hashes written by the last run of repogen
+    on \a repositoryDir. Returns an empty manifest if there is none.
+*/
+static RepositoryManifest readRepositoryManifest(const QString &repositoryDir)
+{
+    RepositoryManifest manifest;
+
+    QDomDocument doc;
+    QFile file(repositoryDir + QLatin1Char('/') + scRepositoryManifest);
+    if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file))
+        return manifest;
+
+    const QDomElement root = doc.documentElement();
+    if (root.tagName() != QLatin1String("RepositoryManifest")) {
+        qWarning() << "Ignoring invalid repository manifest" << file.fileName();
+        return manifest;
+    }
+    manifest.archiveSuffix = root.attribute(QLatin1String("ArchiveFormat"));
+    manifest.compression = root.attribute(QLatin1String("Compression"), QLatin1String("-1")).toInt();
+
+    for (QDomElement packageElement = root.firstChildElement(QLatin1String("Package"));
+            !packageElement.isNull(); packageElement = packageElement.nextSiblingElement(QLatin1String("Package"))) {
+        ManifestPackage package;
+        package.version = packageElement.attribute(scVersion);
+        package.sha1 = packageElement.attribute(scSHA1).toLatin1();
+        for (QDomElement fileElement = packageElement.firstChildElement(QLatin1String("File"));
+                !fileElement.isNull(); fileElement = fileElement.nextSiblingElement(QLatin1String("File"))) {
+            ManifestFile manifestFile;
+            manifestFile.path = fileElement.text();
+            manifestFile.size = fileElement.attribute(QLatin1String("Size")).toLongLong();
+            manifestFile.lastModified = fileElement.attribute(QLatin1String("LastModified")).toLongLong();
+            manifestFile.sha1 = fileElement.attribute(scSHA1).toLatin1();
+            package.files.append(manifestFile);
+        }
+        manifest.packages.insert(packageElement.attribute(scName), package);
+    }
+    return manifest;
+}
+
+static void writeRepositoryManifest(const QString &repositoryDir, const RepositoryManifest &manifest)
+{
+    QDomDocument doc;
+    QDomElement root = doc.createElement(QLatin1String("RepositoryManifest"));
+    root.setAttribute(QLatin1String("ArchiveFormat"), manifest.archiveSuffix);
+    root.setAttribute(QLatin1String("Compression"), manifest.compression);
+    doc.appendChild(root);
+
+    QStringList names = manifest.packages.keys();
+    names.sort();
+    foreach (const QString &name, names) {
+        const ManifestPackage package = manifest.packages.value(name);
+        QDomElement packageElement = doc.createElement(QLatin1String("Package"));
+        packageElement.setAttribute(scName, name);
+        packageElement.setAttribute(scVersion, package.version);
+        packageElement.setAttribute(scSHA1, QString::fromLatin1(package.sha1));
+        foreach (const ManifestFile &manifestFile, package.files) {
+            QDomElement fileElement = doc.createElement(QLatin1String("File"));
+            fileElement.setAttribute(QLatin1String("Size"), manifestFile.size);
+            fileElement.setAttribute(QLatin1String("LastModified"), manifestFile.lastModified);
+            fileElement.setAttribute(scSHA1, QString::fromLatin1(manifestFile.sha1));
+            fileElement.appendChild(doc.createTextNode(manifestFile.path));
+            packageElement.appendChild(fileElement);
+        }
+        root.appendChild(packageElement);
+    }
+
+    QFile file(repositoryDir + QLatin1Char('/') + scRepositoryManifest);
+    QInstaller::openForWrite(&file);
+    QInstaller::blockingWrite(&file, doc.toByteArray());
+}
+
+/*!
+    \internal
+
+    Collects the input files of the package \a info below \a subDirectory of
+    \a packageDir. The checksum of a file is taken from \a previous if neither
+    its size nor its modification time changed, otherwise the file is read.
+*/
+static void appendPackageInputs(const QString &packageDir, const QString &subDirectory,
+    const QHash<QString, ManifestFile> &previous, ManifestPackage *package)
+{
+    const QDir baseDir(packageDir);
+    const QString inputDir = baseDir.absoluteFilePath(subDirectory);
+    if (!QFileInfo(inputDir).isDir())
+        return;
+
+    QStringList entries;
+    QDirIterator it(inputDir, QDir::AllEntries | QDir::System | QDir::Hidden | QDir::NoDotAndDotDot,
+        QDirIterator::Subdirectories);
+    while (it.hasNext())
+        entries.append(it.next());
+    entries.sort();
+
+    QStringList changedFiles;
+    QVector<int> changedIndexes;
+    foreach (const QString &entry, entries) {
+        const QFileInfo fileInfo(entry);
+        ManifestFile manifestFile;
+        manifestFile.path = baseDir.relativeFilePath(entry);
+        if (fileInfo.isSymLink()) {
+            manifestFile.sha1 = QCryptographicHash::hash(fileInfo.symLinkTarget().toUtf8(),
+                QCryptographicHash::Sha1).toHex();
+        } else if (fileInfo.isFile()) {
+            manifestFile.size = fileInfo.size();
+            manifestFile.lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+            const ManifestFile cached = previous.value(manifestFile.path);
+            if (!cached.sha1.isEmpty() && cached.size == manifestFile.size
+                    && cached.lastModified == manifestFile.lastModified) {
+                manifestFile.sha1 = cached.sha1;
+            } else {
+                changedFiles.append(entry);
+                changedIndexes.append(package->files.count());
+            }
+        }
+        package->files.append(manifestFile);
+    }
+
+    // Hash the files that changed since the last run concurrently
+    const QHash<QString, QByteArray> hashes = FileHasher::hashFiles(changedFiles,
+        QCryptographicHash::Sha1);
+    for (int i = 0; i < changedFiles.count(); ++i)
+        package->files[changedIndexes.at(i)].sha1 = hashes.value(changedFiles.at(i)).toHex();
+}
+
+/*!
+    \internal
+
+    Returns the manifest entry for the package \a info, covering the data
+    directories in all \a packageDirs and the meta directory of the package.
+*/
+static ManifestPackage packageInputs(const QStringList &packageDirs, const PackageInfo &info,
+    const ManifestPackage &previous)
+{
+    QHash<QString, ManifestFile> previousFiles;
+    foreach (const ManifestFile &manifestFile, previous.files)
+        previousFiles.insert(manifestFile.path, manifestFile);
+
+    ManifestPackage package;
+    package.version = info.version;
+    foreach (const QString &packageDir, packageDirs)
+        appendPackageInputs(packageDir, QString::fromLatin1("%1/data").arg(info.name), previousFiles, &package);
+    const QFileInfo directory(info.directory);
+    appendPackageInputs(directory.path(), QString::fromLatin1("%1/meta").arg(directory.fileName()),
+        previousFiles, &package);
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(info.version.toUtf8());
+    hash.addData(info.createContentSha1Node ? "\n1\n" : "\n0\n");
+    foreach (const ManifestFile &manifestFile, package.files) {
+        hash.addData(manifestFile.path.toUtf8());
+        hash.addData(" ");
+        hash.addData(manifestFile.sha1);
+        hash.addData("\n");
+    }
+    package.sha1 = hash.result().toHex();
+    return package;
+}
+
+void QInstallerTools::filterUnchangedComponents(const QString &repositoryDir, const QStringList &packageDirs,
+    PackageInfoVector &packages, const QString &archiveSuffix, Compression compression)
+{
+    const RepositoryManifest manifest = readRepositoryManifest(repositoryDir);
+    if (manifest.packages.isEmpty())
+        return;
+
+    if (manifest.archiveSuffix != archiveSuffix || manifest.compression != compression) {
+        qDebug() << "Archive format or compression changed since the last update of"
+            << repositoryDir << ", updating all components.";
+        return;
+    }
+
+    for (int i = packages.count() - 1; i >= 0; --i) {
+        const PackageInfo info = packages.at(i);
+        // packages taken from other repositories are copied as they are, always update them
+        if (!info.metaNode.isEmpty())
+            continue;
+
+        const QHash<QString, ManifestPackage>::const_iterator it = manifest.packages.constFind(info.name);
+        if (it != manifest.packages.constEnd() && it->version == info.version
+                && QFileInfo(repositoryDir, info.name).isDir()) {
+            const ManifestPackage inputs = packageInputs(packageDirs, info, *it);
+            if (inputs.sha1 == it->sha1) {
+                qDebug() << "Component" << info.name << "did not change since the last update.";
+                packages.remove(i); // reuse the archives and meta data already in the repository
+                continue;
+            }
+            // keep the hashes for the manifest, the inputs are not read again after the update
+            packages[i].inputFiles = inputs.files;
+            packages[i].inputsSha1 = inputs.sha1;
+        }
+        qDebug() << "Update component" << info.name << "in"<< repositoryDir << ".";
+    }
+}
+
+/*!
+    \internal
+
+    Removes \a packages from the manifest in \a repositoryDir before their
+    content in the repository gets replaced, so that an interrupted run does not
+    leave entries pointing to incomplete data behind.
+*/
+static void invalidateRepositoryManifest(const QString &repositoryDir, const PackageInfoVector &packages)
+{
+    if (!QFileInfo::exists(repositoryDir + QLatin1Char('/') + scRepositoryManifest))
+        return;
+
+    RepositoryManifest manifest = readRepositoryManifest(repositoryDir);
+    foreach (const PackageInfo &package, packages)
+        manifest.packages.remove(package.name);
+    writeRepositoryManifest(repositoryDir, manifest);
+}
+
+/*!
+    \internal
+
+    Records the input hashes of the \a packages just written to the repository
+    described by \a info. Hashes already calculated by filterUnchangedComponents()
+    are reused.
+*/
+static void updateRepositoryManifest(const RepositoryInfo &info, const PackageInfoVector &packages,
+    const QString &archiveSuffix, Compression compression)
+{
+    RepositoryManifest manifest = readRepositoryManifest(info.repositoryDir);
+    if (manifest.archiveSuffix != archiveSuffix || manifest.compression != compression) {
+        // the remaining entries describe archives created with different options
+        manifest.packages.clear();
+        manifest.archiveSuffix = archiveSuffix;
+        manifest.compression = compression;
+    }
+
+    foreach (const PackageInfo &package, packages) {
+        if (!package.metaNode.isEmpty())
+            continue;
+        if (!package.inputsSha1.isEmpty()) {
+            ManifestPackage inputs;
+            inputs.version = package.version;
+            inputs.sha1 = package.inputsSha1;
+            inputs.files = package.inputFiles;
+            manifest.packages.insert(package.name, inputs);
+        } else {
+            manifest.packages.insert(package.name, packageInputs(info.packages, package,
+                manifest.packages.value(package.name)));
+        }
+    }
+    writeRepositoryManifest(info.repositoryDir, manifest);
+}
+
 QString QInstallerTools::existingUniteMeta7z(const QString &repositoryDir)
 {
     QString uniteMeta7z = QString();
@@ -1152,7 +1466,8 @@ QString QInstallerTools::existingUniteMeta7z(const QString &repositoryDir)
     return uniteMeta7z;
 }
 
-PackageInfoVector QInstallerTools::collectPackages(RepositoryInfo info, QStringList *filteredPackages, FilterType filterType, bool updateNewComponents, QStringList packagesUpdatedWithSha)
+PackageInfoVector QInstallerTools::collectPackages(RepositoryInfo info, QStringList *filteredPackages, FilterType filterType, bool updateNewComponents, QStringList packagesUpdatedWithSha,
+    bool updateChangedComponents, const QString &archiveSuffix, Compression compression)
 {
     PackageInfoVector packages;
     PackageInfoVector precompressedPackages = QInstallerTools::createListOfRepositoryPackages(info.repositoryPackages,
@@ -1165,6 +1480,10 @@ PackageInfoVector QInstallerTools::collectPackages(RepositoryInfo info, QStringL
     if (updateNewComponents) {
          filterNewComponents(info.repositoryDir, packages);
     }
+    if (updateChangedComponents) {
+        filterUnchangedComponents(info.repositoryDir, info.packages, packages, archiveSuffix, compression);
+        invalidateRepositoryManifest(info.repositoryDir, packages);
+    }
     foreach (const QInstallerTools::PackageInfo &package, packages) {
         const QFileInfo fi(info.repositoryDir, package.name);
         if (fi.exists())
@@ -1175,7 +1494,7 @@ PackageInfoVector QInstallerTools::collectPackages(RepositoryInfo info, QStringL
 
 void QInstallerTools::createRepository(RepositoryInfo info, PackageInfoVector *packages,
         const QString &tmpMetaDir, bool createComponentMetadata, bool createUnifiedMetadata,
-        const QString &archiveSuffix, Compression compression)
+        const QString &archiveSuffix, Compression compression, int jobs, bool updateChangedComponents)
 {
     QHash<QString, QString> pathToVersionMapping = QInstallerTools::buildPathToVersionMapping(*packages);
 
@@ -1191,7 +1510,8 @@ void QInstallerTools::createRepository(RepositoryInfo info, PackageInfoVector *p
             unite7zFiles.append(it.fileInfo().absoluteFilePath());
         }
     }
-    QInstallerTools::copyComponentData(directories, info.repositoryDir, packages, archiveSuffix, compression);
+    QInstallerTools::copyComponentData(directories, info.repositoryDir, packages, archiveSuffix,
+        compression, jobs);
     QInstallerTools::copyMetaData(tmpMetaDir, info.repositoryDir, *packages, QLatin1String("{AnyApplication}"),
         QLatin1String(QUOTE(IFW_REPOSITORY_FORMAT_VERSION)), unite7zFiles);
 
@@ -1208,4 +1528,6 @@ void QInstallerTools::createRepository(RepositoryInfo info, PackageInfoVector *p
         QFile::remove(it.fileInfo().absoluteFilePath());
     }
     QInstaller::moveDirectoryContents(tmpMetaDir, info.repositoryDir);
+    if (updateChangedComponents)
+        updateRepositoryManifest(info, *packages, archiveSuffix, compression);
 }
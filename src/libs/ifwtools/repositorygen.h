@@ -41,6 +41,14 @@
 
 namespace QInstallerTools {
 
+struct IFWTOOLS_EXPORT PackageInputFile
+{
+    QString path;
+    qint64 size = 0;
+    qint64 lastModified = 0;
+    QByteArray sha1;
+};
+
 struct IFWTOOLS_EXPORT PackageInfo
 {
     QString name;
@@ -52,6 +60,8 @@ struct IFWTOOLS_EXPORT PackageInfo
     QString metaNode;
     QString contentSha1;
     bool createContentSha1Node;
+    QVector<PackageInputFile> inputFiles;
+    QByteArray inputsSha1;
 };
 typedef QVector<PackageInfo> PackageInfoVector;
 typedef QInstaller::AbstractArchive::CompressionLevel Compression;
@@ -94,15 +104,21 @@ void IFWTOOLS_EXPORT copyMetaData(const QString &outDir, const QString &dataDir,
     const QString &appName, const QString& appVersion, const QStringList &uniteMetadatas);
 void IFWTOOLS_EXPORT copyComponentData(const QStringList &packageDir, const QString &repoDir,
                                        PackageInfoVector *const infos, const QString &archiveSuffix,
-                                       Compression compression = Compression::Normal);
+                                       Compression compression = Compression::Normal, int jobs = 0);
 
 void IFWTOOLS_EXPORT filterNewComponents(const QString &repositoryDir, QInstallerTools::PackageInfoVector &packages);
+void IFWTOOLS_EXPORT filterUnchangedComponents(const QString &repositoryDir, const QStringList &packageDirs,
+                                               PackageInfoVector &packages, const QString &archiveSuffix,
+                                               Compression compression = Compression::Normal);
 
 QString IFWTOOLS_EXPORT existingUniteMeta7z(const QString &repositoryDir);
-PackageInfoVector IFWTOOLS_EXPORT collectPackages(RepositoryInfo info, QStringList *filteredPackages, FilterType filterType, bool updateNewComponents, QStringList packagesUpdatedWithSha);
+PackageInfoVector IFWTOOLS_EXPORT collectPackages(RepositoryInfo info, QStringList *filteredPackages, FilterType filterType, bool updateNewComponents, QStringList packagesUpdatedWithSha,
+                                                  bool updateChangedComponents = false, const QString &archiveSuffix = QLatin1String("7z"),
+                                                  Compression compression = Compression::Normal);
 void IFWTOOLS_EXPORT createRepository(RepositoryInfo info, PackageInfoVector *packages, const QString &tmpMetaDir,
                                       bool createComponentMetadata, bool createUnifiedMetadata, const QString &archiveSuffix,
-                                      Compression compression = Compression::Normal);
+                                      Compression compression = Compression::Normal, int jobs = 0,
+                                      bool updateChangedComponents = false);
 } // namespace QInstallerTools
 
 #endif // REPOSITORYGEN_H
@@ -37,6 +37,33 @@ namespace QInstaller {
            which can be for example a file or a directory.
 */
 
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::ArchiveFilePreparer
+    \brief The ArchiveFilePreparer class is the interface for preparing files
+           before they are extracted from an archive.
+
+    An instance set with AbstractArchive::setFilePreparer() is called for every
+    file entry right before it is written to disk, while the extraction is in
+    progress. This allows for example backing up existing files without reading
+    the contents of the archive in a separate pass.
+*/
+
+/*!
+    \fn QInstaller::ArchiveFilePreparer::~ArchiveFilePreparer()
+
+    Destroys the file preparer.
+*/
+
+/*!
+    \fn bool QInstaller::ArchiveFilePreparer::prepareForFile(const QString &filename)
+
+    Implement to prepare for file \a filename to be extracted, e.g. by renaming an
+    existing file. The path of \a filename is locked with the global FileGuard
+    while this function is called. Return \c true if extraction can be continued.
+    If \c false is returned, the extraction is aborted.
+*/
+
 /*!
     \inmodule QtInstallerFramework
     \class QInstaller::AbstractArchive
@@ -138,6 +165,7 @@ namespace QInstaller {
 AbstractArchive::AbstractArchive(QObject *parent)
     : QObject(parent)
     , m_compressionLevel(CompressionLevel::Normal)
+    , m_filePreparer(nullptr)
 {
 }
 
@@ -164,6 +192,24 @@ void AbstractArchive::setCompressionLevel(const CompressionLevel level)
     m_compressionLevel = level;
 }
 
+/*!
+    Sets the \a preparer to be called for each file entry before it is written
+    to disk by extract(). Set \c nullptr to disable the preparation. The archive
+    does not take ownership of \a preparer.
+*/
+void AbstractArchive::setFilePreparer(ArchiveFilePreparer *preparer)
+{
+    m_filePreparer = preparer;
+}
+
+/*!
+    Returns the file preparer set for this archive, or \c nullptr if none is set.
+*/
+ArchiveFilePreparer *AbstractArchive::filePreparer() const
+{
+    return m_filePreparer;
+}
+
 /*!
     Sets a human-readable description of the current \a error.
 */
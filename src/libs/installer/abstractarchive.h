@@ -65,6 +65,13 @@ struct INSTALLER_EXPORT ArchiveEntry
     QFile::Permissions permissions_enum;
 };
 
+class INSTALLER_EXPORT ArchiveFilePreparer
+{
+public:
+    virtual ~ArchiveFilePreparer() = default;
+    virtual bool prepareForFile(const QString &filename) = 0;
+};
+
 class INSTALLER_EXPORT AbstractArchive : public QObject
 {
     Q_OBJECT
@@ -98,6 +105,9 @@ public:
 
     virtual void setCompressionLevel(const CompressionLevel level);
 
+    virtual void setFilePreparer(ArchiveFilePreparer *preparer);
+    ArchiveFilePreparer *filePreparer() const;
+
 Q_SIGNALS:
     void currentEntryChanged(const QString &filename);
     void completedChanged(const quint64 completed, const quint64 total);
@@ -112,6 +122,7 @@ protected:
 private:
     QString m_error;
     CompressionLevel m_compressionLevel;
+    ArchiveFilePreparer *m_filePreparer;
 };
 
 INSTALLER_EXPORT QDataStream &operator>>(QDataStream &istream, ArchiveEntry &entry);
@@ -201,13 +201,26 @@ void BinaryContent::readBinaryContent(QFile *file, QList<OperationBlob> *operati
             throw Error(QCoreApplication::translate("BinaryContent",
                 "Cannot seek to %1 to read the operation data.").arg(posOfOperationsBlock));
         }
-        // read the operations count
+        // read the operations count, or the marker of the binary operations format
         qint64 operationsCount = QInstaller::retrieveInt64(file);
-        // read the operations
-        for (int i = 0; i < operationsCount; ++i) {
-            const QString name = QInstaller::retrieveString(file);
-            const QString xml = QInstaller::retrieveString(file);
-            operations->append(OperationBlob(name, xml));
+        if (operationsCount == BinaryOperationsMarker) {
+            const qint64 version = QInstaller::retrieveInt64(file);
+            if (version > BinaryOperationsVersion) {
+                throw Error(QCoreApplication::translate("BinaryContent",
+                    "Unsupported operation data version %1.").arg(version));
+            }
+            operationsCount = QInstaller::retrieveInt64(file);
+            for (int i = 0; i < operationsCount; ++i) {
+                const QString name = QInstaller::retrieveString(file);
+                const QByteArray data = QInstaller::retrieveByteArray(file);
+                operations->append(OperationBlob(name, data));
+            }
+        } else {
+            for (int i = 0; i < operationsCount; ++i) {
+                const QString name = QInstaller::retrieveString(file);
+                const QString xml = QInstaller::retrieveString(file);
+                operations->append(OperationBlob(name, xml));
+            }
         }
         // operations count
         Q_UNUSED(QInstaller::retrieveInt64(file)) // read it, but deliberately not used
@@ -268,11 +281,20 @@ void BinaryContent::writeBinaryContent(QFile *out, const QList<OperationBlob> &o
     }
     localManager.removeCollection("QResources");
 
-    // operations
+    // operations, fall back to the XML format if any of them is not available as binary data
+    const bool binaryOperations = std::all_of(operations.cbegin(), operations.cend(),
+        [](const OperationBlob &operation) { return !operation.data.isEmpty(); });
+    if (binaryOperations) {
+        QInstaller::appendInt64(out, BinaryOperationsMarker);
+        QInstaller::appendInt64(out, BinaryOperationsVersion);
+    }
     QInstaller::appendInt64(out, operations.count());
     foreach (const OperationBlob &operation, operations) {
         QInstaller::appendString(out, operation.name);
-        QInstaller::appendString(out, operation.xml);
+        if (binaryOperations)
+            QInstaller::appendByteArray(out, operation.data);
+        else
+            QInstaller::appendString(out, operation.xml);
     }
     QInstaller::appendInt64(out, operations.count());
     const Range<qint64> operationsSegment = Range<qint64>::fromStartAndEnd(pos, out->pos());
@@ -59,6 +59,11 @@ public:
     static const quint64 MagicCookie = 0xc2630a1c99d668f8LL;  // binary
     static const quint64 MagicCookieDat = 0xc2630a1c99d668f9LL; // data
 
+    // the marker put in front of binary serialized operations, older files start with the
+    // operations count directly and contain XML serialized operations
+    static const qint64 BinaryOperationsMarker = -1;
+    static const qint64 BinaryOperationsVersion = 1;
+
     static qint64 findMagicCookie(QFile *file, quint64 magicCookie);
     static BinaryLayout binaryLayout(QFile *file, quint64 magicCookie);
 
@@ -40,8 +40,11 @@ namespace QInstaller {
 /*!
     \class QInstaller::OperationBlob
     \inmodule QtInstallerFramework
-    \brief The OperationBlob class is a textual representation of an operation that can be
+    \brief The OperationBlob class is a serialized representation of an operation that can be
         instantiated and executed by the Qt Installer Framework.
+
+    Operations are stored either in the compact binary form created by
+    KDUpdater::UpdateOperation::toBinary() or, for files written by older versions, as XML.
 */
 
 /*!
@@ -51,6 +54,13 @@ namespace QInstaller {
     \a x for the XML representation of the operation.
 */
 
+/*!
+    \fn QInstaller::OperationBlob::OperationBlob(const QString &n, const QByteArray &d)
+
+    Constructs the operation blob with the given arguments, while \a n stands for the name part and
+    \a d for the binary representation of the operation.
+*/
+
 /*!
     \variable QInstaller::OperationBlob::name
     \brief The name of the operation.
@@ -58,7 +68,13 @@ namespace QInstaller {
 
 /*!
     \variable QInstaller::OperationBlob::xml
-    \brief The XML representation of the operation.
+    \brief The XML representation of the operation. Empty if the operation is stored as binary
+        data.
+*/
+
+/*!
+    \variable QInstaller::OperationBlob::data
+    \brief The binary representation of the operation. Empty if the operation is stored as XML.
 */
 
 /*!
@@ -91,6 +107,7 @@ namespace QInstaller {
  */
 Resource::Resource(const QString &path)
     : m_file(path)
+    , m_filePos(-1)
     , m_name(QFileInfo(path).fileName().toUtf8())
     , m_segment(Range<qint64>::fromStartAndLength(0, m_file.size()))
 {
@@ -101,6 +118,7 @@ Resource::Resource(const QString &path)
 */
 Resource::Resource(const QString &path, const QByteArray &name)
     : m_file(path)
+    , m_filePos(-1)
     , m_name(name)
     , m_segment(Range<qint64>::fromStartAndLength(0, m_file.size()))
 {
@@ -111,6 +129,7 @@ Resource::Resource(const QString &path, const QByteArray &name)
 */
 Resource::Resource(const QString &path, const Range<qint64> &segment)
     : m_file(path)
+    , m_filePos(-1)
     , m_name(QFileInfo(path).fileName().toUtf8())
     , m_segment(segment)
 {
@@ -175,6 +194,7 @@ bool Resource::open()
 void Resource::close()
 {
     m_file.close();
+    m_filePos = -1;
     QIODevice::close();
 }
 
@@ -196,10 +216,15 @@ qint64 Resource::readData(char* data, qint64 maxSize)
     if (maxSize <= 0)
         return 0;
 
-    const qint64 p = m_file.pos();
-    m_file.seek(m_segment.start() + pos());
+    // the file is only read through this resource, seek only if the position changed
+    const qint64 filePos = m_segment.start() + pos();
+    if (filePos != m_filePos && !m_file.seek(filePos)) {
+        m_filePos = -1;
+        setErrorString(m_file.errorString());
+        return -1;
+    }
     const qint64 amountRead = m_file.read(data, maxSize);
-    m_file.seek(p);
+    m_filePos = (amountRead > 0) ? filePos + amountRead : -1;
     return amountRead;
 }
 
@@ -228,15 +253,23 @@ qint64 Resource::writeData(const char* data, qint64 maxSize)
 void Resource::copyData(Resource *resource, QFileDevice *out)
 {
     qint64 left = resource->size();
-    char data[4096];
+    const qint64 available = qMax<qint64>(0, resource->size() - resource->pos());
+    const qint64 copied = QInstaller::copyFileRange(resource->m_file.handle(),
+        resource->m_segment.start() + resource->pos(), out, qMin(left, available));
+    if (copied > 0) {
+        resource->seek(resource->pos() + copied);
+        left -= copied;
+    }
+
+    QByteArray data(qMin(scCopyBufferSize, left), '\0');
     while (left > 0) {
-        const qint64 len = qMin<qint64>(left, 4096);
-        const qint64 bytesRead = resource->read(data, len);
+        const qint64 len = qMin<qint64>(left, data.size());
+        const qint64 bytesRead = resource->read(data.data(), len);
         if (bytesRead != len) {
             throw QInstaller::Error(tr("Read failed after %1 bytes: %2")
                 .arg(QString::number(resource->size() - left), resource->errorString()));
         }
-        const qint64 bytesWritten = out->write(data, len);
+        const qint64 bytesWritten = out->write(data.constData(), len);
         if (bytesWritten != len) {
             throw QInstaller::Error(tr("Write failed after %1 bytes: %2")
                 .arg(QString::number(resource->size() - left), out->errorString()));
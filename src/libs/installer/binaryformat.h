@@ -42,8 +42,11 @@ namespace QInstaller {
 struct OperationBlob {
     OperationBlob(const QString &n, const QString &x)
         : name(n), xml(x) {}
+    OperationBlob(const QString &n, const QByteArray &d)
+        : name(n), data(d) {}
     QString name;
     QString xml;
+    QByteArray data;
 };
 
 
@@ -82,6 +85,7 @@ private:
 
 private:
     QFSFileEngine m_file;
+    qint64 m_filePos;
     QByteArray m_name;
     Range<qint64> m_segment;
 };
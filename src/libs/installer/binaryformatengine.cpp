@@ -28,6 +28,8 @@
 
 #include "binaryformatengine.h"
 
+#include "errors.h"
+
 #include <QRegularExpression>
 
 namespace {
@@ -191,24 +193,14 @@ bool BinaryFormatEngine::copy(const QString &newName)
     if (!target.open(QIODevice::WriteOnly))
         return false;
 
-    qint64 bytesLeft = size();
     if (!open(QIODevice::ReadOnly))
         return false;
 
-    char data[4096];
-    while(bytesLeft > 0) {
-        const qint64 len = qMin<qint64>(bytesLeft, 4096);
-        const qint64 bytesRead = read(data, len);
-        if (bytesRead != len) {
-            close();
-            return false;
-        }
-        const qint64 bytesWritten = target.write(data, len);
-        if (bytesWritten != len) {
-            close();
-            return false;
-        }
-        bytesLeft -= len;
+    try {
+        m_resource->copyData(&target);
+    } catch (const Error &) {
+        close();
+        return false;
     }
     close();
 
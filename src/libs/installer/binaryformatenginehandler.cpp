@@ -44,11 +44,17 @@ namespace QInstaller {
     engine, the file name needs to be prefixed with \c {installer://}.
 
     Returns 0 if the engine cannot handle \a fileName.
+
+    Resources may be registered while engines are created from other threads, for
+    example when archives are unpacked while other archives are still downloaded.
 */
 QAbstractFileEngine *BinaryFormatEngineHandler::create(const QString &fileName) const
 {
-    return fileName.startsWith(QLatin1String("installer://"), Qt::CaseInsensitive )
-        ? new BinaryFormatEngine(m_resources, fileName) : nullptr;
+    if (!fileName.startsWith(QLatin1String("installer://"), Qt::CaseInsensitive))
+        return nullptr;
+
+    QMutexLocker _(&m_mutex);
+    return new BinaryFormatEngine(m_resources, fileName);
 }
 
 /*!
@@ -56,6 +62,7 @@ QAbstractFileEngine *BinaryFormatEngineHandler::create(const QString &fileName)
 */
 void BinaryFormatEngineHandler::clear()
 {
+    QMutexLocker _(&m_mutex);
     m_resources.clear();
 }
 
@@ -73,6 +80,7 @@ BinaryFormatEngineHandler *BinaryFormatEngineHandler::instance()
 */
 void BinaryFormatEngineHandler::registerResources(const QList<ResourceCollection> &collections)
 {
+    QMutexLocker _(&m_mutex);
     foreach (const ResourceCollection &collection, collections) {
         if (ProductKeyCheck::instance()->isValidPackage(QString::fromUtf8(collection.name())))
             m_resources.insert(collection.name(), collection);
@@ -104,6 +112,7 @@ BinaryFormatEngineHandler::registerResource(const QString &fileName, const QStri
     if (!ProductKeyCheck::instance()->isValidPackage(QString::fromUtf8(collectionName)))
         return;
 
+    QMutexLocker _(&m_mutex);
     m_resources[collectionName].setName(collectionName);
     m_resources[collectionName].appendResource(QSharedPointer<Resource>(new Resource(resourcePath,
         resourceName)));
@@ -32,6 +32,7 @@
 #include "binaryformat.h"
 
 #include <QtCore/private/qabstractfileengine_p.h>
+#include <QtCore/QMutex>
 
 namespace QInstaller {
 
@@ -53,6 +54,7 @@ private:
     ~BinaryFormatEngineHandler() {}
 
 private:
+    mutable QMutex m_mutex;
     QHash<QByteArray, ResourceCollection> m_resources;
 };
 
@@ -238,6 +238,22 @@ CommandLineParser::CommandLineParser()
                       "to let the application determine the ideal thread count from the amount of logical "
                       "processor cores in the system."),
         QLatin1String("threads")));
+    addOption(QCommandLineOption(QStringList()
+        << CommandLineOptions::scMaxConcurrentDownloadsShort << CommandLineOptions::scMaxConcurrentDownloadsLong,
+        QLatin1String("Specifies the maximum number of archives downloaded concurrently. Set to a "
+                      "positive number, or 0 (default) to download up to four archives at a time."),
+        QLatin1String("downloads")));
+    addOption(QCommandLineOption(QStringList()
+        << CommandLineOptions::scMaxConcurrentDownloadsPerHostShort
+        << CommandLineOptions::scMaxConcurrentDownloadsPerHostLong,
+        QLatin1String("Specifies the maximum number of archives downloaded concurrently from a single "
+                      "host. Set to a positive number, or 0 (default) to limit only by the value of "
+                      "max-concurrent-downloads."),
+        QLatin1String("downloads")));
+    addOption(QCommandLineOption(QStringList()
+        << CommandLineOptions::scPipelinedInstallationShort << CommandLineOptions::scPipelinedInstallationLong,
+        QLatin1String("Unpacks the archives of a component as soon as they are downloaded, while "
+                      "the archives of other components are still being downloaded.")));
 
     QCommandLineOption cleanupUpdate(CommandLineOptions::scCleanupUpdate);
     cleanupUpdate.setValueName(QLatin1String("path"));
@@ -428,6 +428,18 @@ QString Component::value(const QString &key, const QString &defaultValue) const
     return d->m_vars.value(key, defaultValue);
 }
 
+/*!
+    Returns the precompiled version key for the version of this component. The key is
+    created on first use and recreated only when the version of the component changes.
+*/
+KDUpdater::VersionKey Component::versionKey() const
+{
+    const QString version = d->m_vars.value(scVersion);
+    if (d->m_versionKey.componentCount() == 0 || d->m_versionKey.toString() != version)
+        d->m_versionKey = KDUpdater::VersionKey(version);
+    return d->m_versionKey;
+}
+
 /*!
     Removes all the values that have the \a key from the variables set for this component.
     Returns the number of values removed which is 1 if the key exists in the variables,
@@ -470,6 +482,8 @@ void Component::setValue(const QString &key, const QString &value)
         packageManagerCore()->createAutoDependencyHash(name(), d->m_vars[key], normalizedValue);
     if (key == scLocalDependencies)
         packageManagerCore()->createLocalDependencyHash(name(), normalizedValue);
+    if (key == scDependencies)
+        packageManagerCore()->invalidateDependeeIndex();
 
     d->m_vars[key] = normalizedValue;
     emit valueChanged(key, normalizedValue);
@@ -516,6 +530,7 @@ void Component::appendComponent(Component *component)
         parent->removeComponent(component);
     component->d->m_parentComponent = this;
     setTristate(d->m_childComponents.count() > 0);
+    d->m_core->invalidateDependeeIndex();
 }
 
 /*!
@@ -528,6 +543,7 @@ void Component::removeComponent(Component *component)
         component->d->m_parentComponent = 0;
         d->m_childComponents.removeAll(component);
         d->m_allChildComponents.removeAll(component);
+        d->m_core->invalidateDependeeIndex();
     }
 }
 
@@ -604,6 +620,43 @@ void Component::loadComponentScript(const bool postLoad)
     }
 }
 
+/*!
+    \internal
+    Marks the component script to be loaded only when it is first needed, either because
+    the component gets selected for installation or because one of its script methods is
+    called. Does nothing if the component has no install script.
+*/
+void Component::deferComponentScript()
+{
+    d->m_scriptPending = !localTempPath().isEmpty()
+        && !d->m_scriptHash.value(scInstallScript).toString().isEmpty();
+}
+
+/*!
+    \internal
+    Returns \c true if loading the component script was deferred and the script has
+    not been loaded yet.
+*/
+bool Component::isComponentScriptPending() const
+{
+    return d->m_scriptPending;
+}
+
+/*!
+    \internal
+    Loads the component script if loading it was deferred. Returns \c true if the
+    script was loaded by this call.
+*/
+bool Component::loadPendingComponentScript()
+{
+    if (!d->m_scriptPending)
+        return false;
+
+    d->m_scriptPending = false;
+    loadComponentScript();
+    return true;
+}
+
 /*!
     \internal
 */
@@ -636,10 +689,13 @@ void Component::evaluateComponentScript(const QString &fileName, const bool post
 /*!
     \internal
     Calls the script method retranslateUi(), if any. This is done whenever a
-    QTranslator file is being loaded.
+    QTranslator file is being loaded. Does nothing while loading the component
+    script is deferred, the method is called once the script gets loaded.
 */
 void Component::languageChanged()
 {
+    if (d->m_scriptPending)
+        return;
     callScriptMethod(scRetranslateUi);
 }
 
@@ -1211,6 +1267,9 @@ void Component::markComponentUnstable(Component::UnstableError error, const QStr
 
 QJSValue Component::callScriptMethod(const QString &methodName, const QJSValueList &arguments) const
 {
+    if (d->m_scriptPending)
+        const_cast<Component *>(this)->loadPendingComponentScript();
+
     QJSValue scriptContext;
     if (!d->m_postScriptContext.isUndefined() && d->m_postScriptContext.property(methodName).isCallable())
         scriptContext = d->m_postScriptContext;
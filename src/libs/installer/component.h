@@ -110,6 +110,7 @@ public:
     Q_INVOKABLE void setValue(const QString &key, const QString &value);
     Q_INVOKABLE QString value(const QString &key, const QString &defaultValue = QString()) const;
     int removeValue(const QString &key);
+    KDUpdater::VersionKey versionKey() const;
 
     QStringList archives() const;
     PackageManagerCore *packageManagerCore() const;
@@ -121,6 +122,9 @@ public:
 
     void loadComponentScript(const bool postLoad = false);
     void evaluateComponentScript(const QString &fileName, const bool postScriptContext = false);
+    void deferComponentScript();
+    bool isComponentScriptPending() const;
+    bool loadPendingComponentScript();
 
     void loadTranslations(const QDir &directory, const QStringList &qms);
     void loadUserInterfaces(const QDir &directory, const QStringList &uis);
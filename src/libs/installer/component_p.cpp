@@ -56,6 +56,7 @@ ComponentPrivate::ComponentPrivate(PackageManagerCore *core, Component *qq)
     , m_updateIsAvailable(false)
     , m_treeNameMoveChildren(false)
     , m_postLoadScript(false)
+    , m_scriptPending(false)
     , m_scriptContext(QJSValue::UndefinedValue)
     , m_postScriptContext(QJSValue::UndefinedValue)
 {
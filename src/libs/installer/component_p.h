@@ -30,6 +30,7 @@
 #define COMPONENT_P_H
 
 #include "qinstallerglobal.h"
+#include "updater.h"
 
 #include <QJSValue>
 #include <QPointer>
@@ -65,6 +66,7 @@ public:
     bool m_updateIsAvailable;
     bool m_treeNameMoveChildren;
     bool m_postLoadScript;
+    bool m_scriptPending;
 
     QString m_componentName;
     QUrl m_repositoryUrl;
@@ -72,6 +74,7 @@ public:
     QJSValue m_scriptContext;
     QJSValue m_postScriptContext;
     QHash<QString, QString> m_vars;
+    mutable KDUpdater::VersionKey m_versionKey;
     QList<Component*> m_childComponents;
     QList<Component*> m_allChildComponents;
     QStringList m_downloadableArchives;
@@ -53,6 +53,7 @@
 #include <QComboBox>
 #include <QStandardItemModel>
 #include <QStyledItemDelegate>
+#include <QTimer>
 
 namespace QInstaller {
 
@@ -66,6 +67,7 @@ constexpr int scNoCheckSelectionIndex = -1;
 constexpr int scCheckDefaultIndex = 0;
 constexpr int scCheckAllIndex = 1;
 constexpr int scUncheckAllIndex = 2;
+constexpr int scSearchDelay = 200; // ms
 
 ComponentSelectionPagePrivate::ComponentSelectionPagePrivate(ComponentSelectionPage *qq, PackageManagerCore *core)
         : q(qq)
@@ -87,6 +89,8 @@ ComponentSelectionPagePrivate::ComponentSelectionPagePrivate(ComponentSelectionP
     m_treeView->setUniformRowHeights(true);
     m_proxyModel->setRecursiveFilteringEnabled(true);
     m_proxyModel->setFilterCaseSensitivity(Qt::CaseInsensitive);
+    connect(m_proxyModel, &ComponentSortFilterProxyModel::searchPatternApplied,
+            this, &ComponentSelectionPagePrivate::onSearchPatternApplied);
 
     m_descriptionBaseWidget = new QWidget(q);
     m_descriptionBaseWidget->setObjectName(QLatin1String("DescriptionBaseWidget"));
@@ -179,6 +183,11 @@ ComponentSelectionPagePrivate::ComponentSelectionPagePrivate(ComponentSelectionP
     m_searchLineEdit->setClearButtonEnabled(true);
     connect(m_searchLineEdit, &QLineEdit::textChanged,
             this, &ComponentSelectionPagePrivate::setSearchPattern);
+    m_searchTimer = new QTimer(this);
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(scSearchDelay);
+    connect(m_searchTimer, &QTimer::timeout,
+            this, &ComponentSelectionPagePrivate::applySearchPattern);
     connect(q, &ComponentSelectionPage::entered, m_searchLineEdit, &QLineEdit::clear);
     topHLayout->addWidget(m_searchLineEdit);
 
@@ -612,14 +621,34 @@ void ComponentSelectionPagePrivate::onModelStateChanged(QInstaller::ComponentMod
 }
 
 /*!
-    Sets the new filter pattern to \a text and expands the tree nodes.
+    Sets the new filter pattern to \a text. The pattern is applied once the user
+    stopped typing, an empty pattern is applied immediately.
 */
 void ComponentSelectionPagePrivate::setSearchPattern(const QString &text)
 {
-    m_proxyModel->setFilterWildcard(text);
+    if (text.isEmpty()) {
+        m_searchTimer->stop();
+        applySearchPattern();
+    } else {
+        m_searchTimer->start();
+    }
+}
 
+/*!
+    Starts searching for the text of the search line edit.
+*/
+void ComponentSelectionPagePrivate::applySearchPattern()
+{
+    m_proxyModel->setSearchPattern(m_searchLineEdit->text());
+}
+
+/*!
+    Expands the tree nodes after the search for \a pattern was applied.
+*/
+void ComponentSelectionPagePrivate::onSearchPatternApplied(const QString &pattern)
+{
     m_treeView->collapseAll();
-    if (text.isEmpty()) {
+    if (pattern.isEmpty()) {
         // Expand user selection and default expanded, ensure selected is visible
         QModelIndex index = m_treeView->selectionModel()->currentIndex();
         while (index.isValid()) {
@@ -49,6 +49,7 @@ class QHBoxLayout;
 class QGridLayout;
 class QStackedLayout;
 class QComboBox;
+class QTimer;
 
 namespace QInstaller {
 
@@ -91,6 +92,8 @@ public slots:
     void selectDefault();
     void onModelStateChanged(QInstaller::ComponentModel::ModelState state);
     void setSearchPattern(const QString &text);
+    void applySearchPattern();
+    void onSearchPatternApplied(const QString &pattern);
 
 private:
     void storeHeaderResizeModes();
@@ -121,6 +124,7 @@ private:
     QStackedLayout *m_stackedLayout;
     ComponentSortFilterProxyModel *m_proxyModel;
     QLineEdit *m_searchLineEdit;
+    QTimer *m_searchTimer;
     bool m_componentsResolved;
 
     bool m_headerStretchLastSection;
@@ -28,6 +28,13 @@
 
 #include "componentsortfilterproxymodel.h"
 
+#include "component.h"
+#include "componentmodel.h"
+#include "constants.h"
+
+#include <QRegularExpression>
+#include <QtConcurrent>
+
 namespace QInstaller {
 
 /*!
@@ -40,6 +47,12 @@ namespace QInstaller {
            filters affect also child indexes in the base model, meaning if a
            certain row has a parent that is accepted by filter, it is also accepted.
            A distinction is made betweed directly and indirectly accepted indexes.
+
+           In addition to the filters of the base class, a search pattern can be set
+           with setSearchPattern(). The pattern is matched against the name, display name
+           and description of the components in a search index that is built once for
+           the source model. The matching runs in a separate thread, and the result is
+           applied to the model when it is ready.
 */
 
 /*!
@@ -55,12 +68,65 @@ namespace QInstaller {
            Index was not accepted by filter.
 */
 
+/*!
+    \fn void QInstaller::ComponentSortFilterProxyModel::searchPatternApplied(const QString &pattern)
+
+    This signal is emitted when the result of the search for \a pattern was applied
+    to the model.
+*/
+
 /*!
     Constructs object with \a parent.
 */
 ComponentSortFilterProxyModel::ComponentSortFilterProxyModel(QObject *parent)
     : QSortFilterProxyModel(parent)
+    , m_searchIndexValid(false)
+    , m_searchGeneration(0)
+{
+    connect(&m_searchWatcher, &QFutureWatcherBase::finished,
+            this, &ComponentSortFilterProxyModel::onSearchFinished);
+}
+
+/*!
+    Destroys the model. Waits for a running search to finish.
+*/
+ComponentSortFilterProxyModel::~ComponentSortFilterProxyModel()
 {
+    m_searchWatcher.waitForFinished();
+}
+
+/*!
+    Sets the given \a sourceModel to be processed by the proxy model. The search
+    index is rebuilt on the next search.
+*/
+void ComponentSortFilterProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    QAbstractItemModel *const previous = QSortFilterProxyModel::sourceModel();
+    invalidateSearchIndex();
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+    if (previous && previous != sourceModel)
+        disconnect(previous, nullptr, this, nullptr);
+    if (!sourceModel)
+        return;
+
+    // Invalidate before and after structural changes, the base class filters new rows
+    // in between and must not see the stale index.
+    connect(sourceModel, &QAbstractItemModel::modelAboutToBeReset,
+            this, &ComponentSortFilterProxyModel::invalidateSearchIndex, Qt::UniqueConnection);
+    connect(sourceModel, &QAbstractItemModel::modelReset,
+            this, &ComponentSortFilterProxyModel::invalidateSearchIndex, Qt::UniqueConnection);
+    connect(sourceModel, &QAbstractItemModel::layoutAboutToBeChanged,
+            this, &ComponentSortFilterProxyModel::invalidateSearchIndex, Qt::UniqueConnection);
+    connect(sourceModel, &QAbstractItemModel::layoutChanged,
+            this, &ComponentSortFilterProxyModel::invalidateSearchIndex, Qt::UniqueConnection);
+    connect(sourceModel, &QAbstractItemModel::rowsAboutToBeInserted,
+            this, &ComponentSortFilterProxyModel::invalidateSearchIndex, Qt::UniqueConnection);
+    connect(sourceModel, &QAbstractItemModel::rowsInserted,
+            this, &ComponentSortFilterProxyModel::invalidateSearchIndex, Qt::UniqueConnection);
+    connect(sourceModel, &QAbstractItemModel::rowsAboutToBeRemoved,
+            this, &ComponentSortFilterProxyModel::invalidateSearchIndex, Qt::UniqueConnection);
+    connect(sourceModel, &QAbstractItemModel::rowsRemoved,
+            this, &ComponentSortFilterProxyModel::invalidateSearchIndex, Qt::UniqueConnection);
 }
 
 /*!
@@ -69,6 +135,16 @@ ComponentSortFilterProxyModel::ComponentSortFilterProxyModel(QObject *parent)
 QVector<QModelIndex> ComponentSortFilterProxyModel::directlyAcceptedIndexes() const
 {
     QVector<QModelIndex> indexes;
+    if (!m_searchPattern.isEmpty()) {
+        ensureSearchIndex();
+        for (int entry : qAsConst(m_searchResult.matches)) {
+            const QModelIndex index = mapFromSource(m_searchEntryIndexes.at(entry));
+            if (index.isValid())
+                indexes.append(index);
+        }
+        return indexes;
+    }
+
     for (int i = 0; i < rowCount(); i++) {
         QModelIndex childIndex = index(i, 0, QModelIndex());
         findDirectlyAcceptedIndexes(childIndex, indexes);
@@ -76,6 +152,34 @@ QVector<QModelIndex> ComponentSortFilterProxyModel::directlyAcceptedIndexes() co
     return indexes;
 }
 
+/*!
+    Returns the search pattern currently applied to the model.
+*/
+QString ComponentSortFilterProxyModel::searchPattern() const
+{
+    return m_searchPattern;
+}
+
+/*!
+    Searches the components for \a pattern. The pattern may contain wildcards and is
+    matched case insensitively. An empty pattern is applied immediately, otherwise the
+    search runs in a separate thread and searchPatternApplied() is emitted once the result
+    was applied. Patterns set while a search is running replace each other, only the last
+    one is searched for next.
+*/
+void ComponentSortFilterProxyModel::setSearchPattern(const QString &pattern)
+{
+    m_pendingSearchPattern = pattern;
+    if (pattern.isEmpty()) {
+        SearchResult result;
+        result.generation = m_searchGeneration;
+        applySearchResult(result);
+        return;
+    }
+    if (!m_searchWatcher.isRunning())
+        startSearch(pattern);
+}
+
 /*!
     Returns \c true if the item in the row indicated by the given \a sourceRow and
     \a sourceParent should be included in the model; otherwise returns \c false.
@@ -85,6 +189,31 @@ bool ComponentSortFilterProxyModel::filterAcceptsRow(int sourceRow, const QModel
     return acceptsRow(sourceRow, sourceParent);
 }
 
+/*!
+    Marks the search index outdated after a structural change of the source model.
+*/
+void ComponentSortFilterProxyModel::invalidateSearchIndex()
+{
+    m_searchIndexValid = false;
+    ++m_searchGeneration;
+}
+
+/*!
+    Applies the result of a finished search, or starts a search for the pattern that
+    was set in the meantime.
+*/
+void ComponentSortFilterProxyModel::onSearchFinished()
+{
+    const SearchResult result = m_searchWatcher.result();
+    if (m_pendingSearchPattern.isEmpty())
+        return; // cleared while searching
+
+    if (result.generation == m_searchGeneration && result.pattern == m_pendingSearchPattern)
+        applySearchResult(result);
+    else
+        startSearch(m_pendingSearchPattern);
+}
+
 /*!
     Returns \c true if the item in the row indicated by the given \a sourceRow and
     \a sourceParent should be included in the model; otherwise returns \c false. The
@@ -96,6 +225,17 @@ bool ComponentSortFilterProxyModel::acceptsRow(int sourceRow, const QModelIndex
     if (type)
         *type = AcceptType::Rejected;
 
+    if (!m_searchPattern.isEmpty()) {
+        ensureSearchIndex();
+        const int entry = m_searchEntryRows.value(sourceModel()->index(sourceRow, 0, sourceParent), -1);
+        const AcceptType acceptType = m_searchResult.acceptTypes.value(entry, AcceptType::Rejected);
+        if (acceptType == AcceptType::Descendant && !isRecursiveFilteringEnabled())
+            return false;
+        if (type)
+            *type = acceptType;
+        return acceptType != AcceptType::Rejected;
+    }
+
     if (QSortFilterProxyModel::filterAcceptsRow(sourceRow, sourceParent)) {
         if (type)
             *type = AcceptType::Direct;
@@ -149,4 +289,156 @@ bool ComponentSortFilterProxyModel::findDirectlyAcceptedIndexes(const QModelInde
     return found;
 }
 
+/*!
+    Adds the children of the source model index \a parent to the search index. Entries
+    are added in pre-order, so that the entry of a parent, \a parentEntry, always comes
+    before the entries of its children.
+*/
+void ComponentSortFilterProxyModel::buildSearchIndex(const QModelIndex &parent, int parentEntry) const
+{
+    QAbstractItemModel *const model = sourceModel();
+    const ComponentModel *const componentModel = qobject_cast<ComponentModel *>(model);
+
+    for (int row = 0; row < model->rowCount(parent); ++row) {
+        const QModelIndex index = model->index(row, 0, parent);
+
+        SearchEntry entry;
+        entry.parent = parentEntry;
+        if (Component *component = componentModel ? componentModel->componentFromIndex(index) : nullptr) {
+            entry.texts << component->name() << component->displayName()
+                << component->value(scDescription);
+        } else {
+            entry.texts << index.data(Qt::DisplayRole).toString();
+        }
+
+        const int entryIndex = m_searchEntries.count();
+        m_searchEntries.append(entry);
+        m_searchEntryIndexes.append(index);
+        m_searchEntryRows.insert(index, entryIndex);
+        buildSearchIndex(index, entryIndex);
+    }
+}
+
+/*!
+    Rebuilds the search index from the source model if it is outdated. The result for
+    the current search pattern is recalculated synchronously in that case.
+*/
+void ComponentSortFilterProxyModel::ensureSearchIndex() const
+{
+    if (m_searchIndexValid)
+        return;
+
+    m_searchEntries.clear();
+    m_searchEntryIndexes.clear();
+    m_searchEntryRows.clear();
+    if (sourceModel())
+        buildSearchIndex(QModelIndex(), -1);
+    m_searchIndexValid = true;
+
+    if (!m_searchPattern.isEmpty())
+        m_searchResult = search(m_searchEntries, m_searchPattern, QVector<int>(), m_searchGeneration);
+}
+
+/*!
+    Starts searching for \a pattern in a separate thread. If \a pattern extends the
+    previously applied pattern, only the entries matching the previous pattern are
+    searched again.
+*/
+void ComponentSortFilterProxyModel::startSearch(const QString &pattern)
+{
+    ensureSearchIndex();
+
+    QVector<int> candidates;
+    const QString &previous = m_searchResult.pattern;
+    const bool refine = !previous.isEmpty() && m_searchResult.generation == m_searchGeneration
+        && pattern.startsWith(previous, Qt::CaseInsensitive)
+        && !previous.contains(QLatin1Char('[')) && !previous.contains(QLatin1Char('\\'));
+    if (refine) {
+        if (m_searchResult.matches.isEmpty()) {
+            // Nothing matched the shorter pattern, nothing will match this one.
+            SearchResult result = m_searchResult;
+            result.pattern = pattern;
+            applySearchResult(result);
+            return;
+        }
+        candidates = m_searchResult.matches;
+    }
+
+    m_searchWatcher.setFuture(QtConcurrent::run(&ComponentSortFilterProxyModel::search,
+        m_searchEntries, pattern, candidates, m_searchGeneration));
+}
+
+/*!
+    Applies the search \a result to the model and emits searchPatternApplied().
+*/
+void ComponentSortFilterProxyModel::applySearchResult(const SearchResult &result)
+{
+    m_searchPattern = result.pattern;
+    m_searchResult = result;
+    invalidateFilter();
+    emit searchPatternApplied(m_searchPattern);
+}
+
+/*!
+    Matches \a pattern against the search index \a entries. If \a candidates is not empty,
+    only the entries listed there are matched. The returned result contains the directly
+    matching entries and the acception type of every entry, and is tagged with the index
+    \a generation it was calculated for.
+*/
+ComponentSortFilterProxyModel::SearchResult ComponentSortFilterProxyModel::search(
+    const QVector<SearchEntry> &entries, const QString &pattern, const QVector<int> &candidates,
+    quint64 generation)
+{
+    SearchResult result;
+    result.generation = generation;
+    result.pattern = pattern;
+
+    static const QRegularExpression wildcards(QLatin1String("[*?\\[\\\\]"));
+    const bool wildcard = pattern.contains(wildcards);
+    QRegularExpression regExp;
+    if (wildcard) {
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+        regExp.setPattern(QRegularExpression::wildcardToRegularExpression(QLatin1Char('*')
+            + pattern + QLatin1Char('*')));
+#else
+        regExp.setPattern(QRegularExpression::wildcardToRegularExpression(pattern,
+            QRegularExpression::UnanchoredWildcardConversion));
+#endif
+        regExp.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+        regExp.optimize();
+    }
+
+    auto matches = [&](const SearchEntry &entry) {
+        for (const QString &text : entry.texts) {
+            if (wildcard ? regExp.match(text).hasMatch() : text.contains(pattern, Qt::CaseInsensitive))
+                return true;
+        }
+        return false;
+    };
+
+    if (candidates.isEmpty()) {
+        for (int i = 0; i < entries.count(); ++i) {
+            if (matches(entries.at(i)))
+                result.matches.append(i);
+        }
+    } else {
+        for (int i : candidates) {
+            if (matches(entries.at(i)))
+                result.matches.append(i);
+        }
+    }
+
+    result.acceptTypes.fill(AcceptType::Rejected, entries.count());
+    for (int i : qAsConst(result.matches))
+        result.acceptTypes[i] = AcceptType::Direct;
+    for (int i = 0; i < entries.count(); ++i) {
+        const int parent = entries.at(i).parent;
+        if (result.acceptTypes.at(i) == AcceptType::Rejected && parent >= 0
+                && result.acceptTypes.at(parent) != AcceptType::Rejected) {
+            result.acceptTypes[i] = AcceptType::Descendant;
+        }
+    }
+    return result;
+}
+
 } // namespace QInstaller
@@ -31,6 +31,7 @@
 
 #include "installer_global.h"
 
+#include <QFutureWatcher>
 #include <QSortFilterProxyModel>
 
 namespace QInstaller {
@@ -47,15 +48,60 @@ public:
     };
 
     explicit ComponentSortFilterProxyModel(QObject *parent = nullptr);
+    ~ComponentSortFilterProxyModel() override;
+
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
 
     QVector<QModelIndex> directlyAcceptedIndexes() const;
 
+    QString searchPattern() const;
+    void setSearchPattern(const QString &pattern);
+
+Q_SIGNALS:
+    void searchPatternApplied(const QString &pattern);
+
 protected:
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
 
+private Q_SLOTS:
+    void invalidateSearchIndex();
+    void onSearchFinished();
+
 private:
+    struct SearchEntry {
+        QStringList texts;
+        int parent;
+    };
+
+    struct SearchResult {
+        quint64 generation = 0;
+        QString pattern;
+        QVector<int> matches;
+        QVector<AcceptType> acceptTypes;
+    };
+
     bool acceptsRow(int sourceRow, const QModelIndex &sourceParent, AcceptType *type = nullptr) const;
     bool findDirectlyAcceptedIndexes(const QModelIndex &in, QVector<QModelIndex> &indexes) const;
+
+    void buildSearchIndex(const QModelIndex &parent, int parentEntry) const;
+    void ensureSearchIndex() const;
+    void startSearch(const QString &pattern);
+    void applySearchResult(const SearchResult &result);
+
+    static SearchResult search(const QVector<SearchEntry> &entries, const QString &pattern,
+        const QVector<int> &candidates, quint64 generation);
+
+private:
+    mutable QVector<SearchEntry> m_searchEntries;
+    mutable QVector<QModelIndex> m_searchEntryIndexes;
+    mutable QHash<QModelIndex, int> m_searchEntryRows;
+    mutable bool m_searchIndexValid;
+    quint64 m_searchGeneration;
+
+    QString m_searchPattern;
+    QString m_pendingSearchPattern;
+    mutable SearchResult m_searchResult;
+    QFutureWatcher<SearchResult> m_searchWatcher;
 };
 
 } // namespace QInstaller
@@ -29,12 +29,23 @@
 #include "concurrentoperationrunner.h"
 
 #include "errors.h"
+#include "globals.h"
 #include "operationtracer.h"
 
 #include <QtConcurrent>
 
+#include <algorithm>
+
 using namespace QInstaller;
 
+// Minimum time and number of finished operations between two concurrency adjustments.
+static const qint64 scMinSampleInterval = 250;
+// Throughput may vary by this ratio between two samples before it counts as changed.
+static const double scThroughputTolerance = 0.05;
+// Operations per core an adaptive runner may run at most, as I/O bound operations
+// often keep more operations than cores busy.
+static const int scAdaptiveOperationsPerCore = 2;
+
 /*!
     \inmodule QtInstallerFramework
     \class QInstaller::ConcurrentOperationRunner
@@ -46,6 +57,18 @@ using namespace QInstaller;
     operations are run in a separate thread pool of this class, which by default limits
     the maximum number of threads to the ideal number of logical processor cores in the
     system.
+
+    Pending operations are started largest first, based on Operation::sizeHint(), to
+    shorten the tail of a run. Unless a fixed thread count is set, the number of operations
+    running at the same time is tuned while running: the runner measures the throughput of
+    finished operations. It keeps the concurrency while the throughput is stable, and moves
+    it in the direction that improves throughput, which also backs off once the disk is
+    saturated. The decisions are written to the debug log.
+
+    Besides running a fixed list of operations with run(), operations can be passed
+    to the runner incrementally: start() begins a run, addOperations() schedules more
+    operations while earlier ones are still executing, and waitForFinished() blocks
+    until all scheduled operations are finished.
 */
 
 /*!
@@ -73,10 +96,14 @@ ConcurrentOperationRunner::ConcurrentOperationRunner(QObject *parent)
     : QObject(parent)
     , m_completedOperations(0)
     , m_totalOperations(0)
+    , m_acceptingOperations(false)
     , m_operations(nullptr)
     , m_type(Operation::OperationType::Perform)
     , m_threadPool(new QThreadPool(this))
 {
+    setMaxThreadCount(0);
+    resetSample();
+
     connect(this, &ConcurrentOperationRunner::operationStarted,
         this, &ConcurrentOperationRunner::onOperationStarted);
 }
@@ -90,11 +117,14 @@ ConcurrentOperationRunner::ConcurrentOperationRunner(OperationList *operations,
     : QObject(parent)
     , m_completedOperations(0)
     , m_totalOperations(0)
+    , m_acceptingOperations(false)
     , m_operations(operations)
     , m_type(type)
     , m_threadPool(new QThreadPool(this))
 {
     m_totalOperations = m_operations->size();
+    setMaxThreadCount(0);
+    resetSample();
 
     connect(this, &ConcurrentOperationRunner::operationStarted,
         this, &ConcurrentOperationRunner::onOperationStarted);
@@ -128,15 +158,21 @@ void ConcurrentOperationRunner::setType(const Operation::OperationType type)
 
 /*!
     Sets the maximum \a count of threads used by the thread pool of this class.
-    A value of \c 0 sets the count automatically to ideal number of threads.
+    A value of \c 0 starts with the ideal number of threads, and lets the runner tune
+    the number of concurrently running operations up to twice that count, as long as
+    the throughput benefits from it. Any other value runs exactly \a count operations
+    at the same time.
 */
 void ConcurrentOperationRunner::setMaxThreadCount(int count)
 {
-    if (count == 0) {
-        m_threadPool->setMaxThreadCount(QThread::idealThreadCount());
-        return;
-    }
-    m_threadPool->setMaxThreadCount(count);
+    m_adaptive = (count == 0);
+    m_threadPool->setMaxThreadCount(m_adaptive
+        ? QThread::idealThreadCount() * scAdaptiveOperationsPerCore : count);
+
+    m_concurrency = m_adaptive ? QThread::idealThreadCount() : count;
+    m_direction = 0;
+    m_probeUp = true;
+    m_lastThroughput = 0;
 }
 
 /*!
@@ -146,20 +182,48 @@ void ConcurrentOperationRunner::setMaxThreadCount(int count)
 QHash<Operation *, bool> ConcurrentOperationRunner::run()
 {
     reset();
+    m_totalOperations = m_operations->size();
+    startOperations(*m_operations);
+    return waitForFinished();
+}
 
-    QEventLoop loop;
-    for (auto &operation : qAsConst(*m_operations)) {
-        auto futureWatcher = new QFutureWatcher<bool>();
-        m_operationWatchers.insert(operation, futureWatcher);
+/*!
+    Starts an incremental run without any operations. Operations are scheduled
+    with addOperations(), the run is finished with waitForFinished().
 
-        connect(futureWatcher, &QFutureWatcher<bool>::finished,
-            this, &ConcurrentOperationRunner::onOperationfinished);
+    \sa run()
+*/
+void ConcurrentOperationRunner::start()
+{
+    reset();
+    m_totalOperations = 0;
+    m_acceptingOperations = true;
+}
 
-        futureWatcher->setFuture(QtConcurrent::run(m_threadPool,
-            [this, operation] { return runOperation(operation); }));
-    }
+/*!
+    Schedules \a operations to be run in an incremental run started with start().
+    The operations are started as soon as there are free threads in the pool.
+*/
+void ConcurrentOperationRunner::addOperations(const OperationList &operations)
+{
+    Q_ASSERT_X(m_acceptingOperations, Q_FUNC_INFO, "Incremental run not started.");
+
+    m_totalOperations += operations.size();
+    startOperations(operations);
+}
 
+/*!
+    Blocks until all scheduled operations are finished and returns a hash of pointers
+    to the performed operation objects and their results. No further operations can be
+    added to an incremental run after calling this function.
+*/
+QHash<Operation *, bool> ConcurrentOperationRunner::waitForFinished()
+{
+    m_acceptingOperations = false;
+
+    // Pending operations are only left if the maximum number of operations is running
     if (!m_operationWatchers.isEmpty()) {
+        QEventLoop loop;
         connect(this, &ConcurrentOperationRunner::finished, &loop, &QEventLoop::quit);
         loop.exec();
     }
@@ -175,6 +239,11 @@ QHash<Operation *, bool> ConcurrentOperationRunner::run()
 */
 void ConcurrentOperationRunner::cancel()
 {
+    // Remember also operations canceled before they were handed to the thread pool
+    for (auto &operation : qAsConst(m_pendingOperations))
+        m_results.insert(operation, false);
+    m_pendingOperations.clear();
+
     for (auto &watcher : m_operationWatchers)
         watcher->cancel();
 }
@@ -229,15 +298,21 @@ void ConcurrentOperationRunner::onOperationfinished()
         ++m_completedOperations;
         emit progressChanged(m_completedOperations, m_totalOperations);
 
+        m_sampleSize += m_operationSizes.value(op);
+        ++m_sampleOperations;
+        adjustConcurrency();
     } else {
         // Remember also operations canceled before execution
         m_results.insert(op, false);
     }
 
     delete m_operationWatchers.take(op);
+    m_operationSizes.remove(op);
 
-    // All finished
-    if (m_operationWatchers.isEmpty())
+    startPendingOperations();
+
+    // All finished, more operations may still be added to an incremental run
+    if (m_operationWatchers.isEmpty() && !m_acceptingOperations)
         emit finished();
 }
 
@@ -264,6 +339,120 @@ bool ConcurrentOperationRunner::runOperation(Operation *const operation)
     return false;
 }
 
+/*!
+    \internal
+
+    Queues \a operations, ordered by their size hints, and starts as many of the pending
+    operations as the current concurrency allows.
+*/
+void ConcurrentOperationRunner::startOperations(const OperationList &operations)
+{
+    for (auto &operation : operations) {
+        m_operationSizes.insert(operation, operation->sizeHint());
+        m_pendingOperations.append(operation);
+    }
+
+    // We want to run the longest taking operations first
+    std::stable_sort(m_pendingOperations.begin(), m_pendingOperations.end(),
+        [this](Operation *lhs, Operation *rhs) {
+            return m_operationSizes.value(lhs) > m_operationSizes.value(rhs);
+        });
+
+    if (m_operationWatchers.isEmpty())
+        resetSample();
+    startPendingOperations();
+}
+
+/*!
+    \internal
+
+    Starts asynchronous runs of pending operations in the thread pool until the current
+    concurrency is reached.
+*/
+void ConcurrentOperationRunner::startPendingOperations()
+{
+    while (!m_pendingOperations.isEmpty() && m_operationWatchers.count() < m_concurrency) {
+        Operation *const operation = m_pendingOperations.takeFirst();
+
+        auto futureWatcher = new QFutureWatcher<bool>();
+        m_operationWatchers.insert(operation, futureWatcher);
+
+        connect(futureWatcher, &QFutureWatcher<bool>::finished,
+            this, &ConcurrentOperationRunner::onOperationfinished);
+
+        futureWatcher->setFuture(QtConcurrent::run(m_threadPool,
+            [this, operation] { return runOperation(operation); }));
+    }
+}
+
+/*!
+    \internal
+
+    Compares the throughput of operations finished since the last adjustment with the
+    throughput before, and changes the number of concurrently running operations by
+    one. The first sample only records the baseline. If the throughput drops, the last
+    change is reverted, or one thread less is tried if there was none. If it rises, the
+    concurrency keeps moving in the direction of the last change, or one thread more is
+    tried if there was none. Within the tolerance one thread more is probed, unless an
+    earlier probe brought no gain; such a probe is reverted.
+*/
+void ConcurrentOperationRunner::adjustConcurrency()
+{
+    if (!m_adaptive || m_threadPool->maxThreadCount() < 2)
+        return;
+
+    const qint64 elapsed = m_sampleTimer.elapsed();
+    if (m_sampleOperations < m_concurrency || elapsed < scMinSampleInterval)
+        return;
+
+    const double throughput = double(m_sampleSize) * 1000 / elapsed;
+
+    const char *reason = "throughput held";
+    int step = 0;
+    if (m_lastThroughput <= 0) {
+        reason = "baseline";
+    } else if (throughput < m_lastThroughput * (1 - scThroughputTolerance)) {
+        step = (m_direction != 0) ? -m_direction : -1;
+        if (m_direction > 0)
+            m_probeUp = false;
+        reason = "throughput dropped";
+    } else if (throughput > m_lastThroughput * (1 + scThroughputTolerance)) {
+        step = (m_direction != 0) ? m_direction : 1;
+        m_probeUp = true;
+        reason = "throughput increased";
+    } else if (m_direction > 0) {
+        step = -1;
+        m_probeUp = false;
+        reason = "no gain from more operations";
+    } else if (m_direction == 0 && m_probeUp) {
+        step = 1;
+        reason = "throughput held, probing";
+    }
+
+    const int concurrency = qBound(1, m_concurrency + step, m_threadPool->maxThreadCount());
+    m_direction = concurrency - m_concurrency; // zero if held or at a bound
+
+    qCDebug(QInstaller::lcInstallerInstallLog).nospace() << "Concurrent operations: "
+        << m_concurrency << " -> " << concurrency << " (" << reason << ", throughput "
+        << qint64(throughput) << "/s over " << m_sampleOperations << " operations)";
+
+    m_concurrency = concurrency;
+    m_lastThroughput = throughput;
+    resetSample();
+}
+
+/*!
+    \internal
+
+    Starts a new throughput sample for adjustConcurrency().
+*/
+void ConcurrentOperationRunner::resetSample()
+{
+    m_sampleTimer.start();
+    m_sampleSize = 0;
+    m_sampleOperations = 0;
+}
+
 /*!
     \internal
 
@@ -273,7 +462,17 @@ void ConcurrentOperationRunner::reset()
 {
     qDeleteAll(m_operationWatchers);
     m_operationWatchers.clear();
+    m_pendingOperations.clear();
+    m_operationSizes.clear();
     m_results.clear();
 
     m_completedOperations = 0;
+
+    if (m_adaptive) {
+        m_concurrency = QThread::idealThreadCount();
+        m_direction = 0;
+        m_probeUp = true;
+        m_lastThroughput = 0;
+    }
+    resetSample();
 }
@@ -32,6 +32,7 @@
 #include "qinstallerglobal.h"
 
 #include <QObject>
+#include <QElapsedTimer>
 #include <QHash>
 #include <QFutureWatcher>
 
@@ -54,6 +55,10 @@ public:
 
     QHash<Operation *, bool> run();
 
+    void start();
+    void addOperations(const OperationList &operations);
+    QHash<Operation *, bool> waitForFinished();
+
 signals:
     void operationStarted(QInstaller::Operation *operation);
     void progressChanged(const int completed, const int total);
@@ -68,15 +73,33 @@ private slots:
 
 private:
     bool runOperation(Operation *const operation);
+    void startOperations(const OperationList &operations);
+    void startPendingOperations();
+    void adjustConcurrency();
+    void resetSample();
     void reset();
 
 private:
     int m_completedOperations;
     int m_totalOperations;
+    bool m_acceptingOperations;
 
     QHash<Operation *, QFutureWatcher<bool> *> m_operationWatchers;
     QHash<Operation *, bool> m_results;
 
+    OperationList m_pendingOperations;
+    QHash<Operation *, quint64> m_operationSizes;
+
+    bool m_adaptive;
+    int m_concurrency;
+    int m_direction;
+    bool m_probeUp;
+    double m_lastThroughput;
+
+    QElapsedTimer m_sampleTimer;
+    quint64 m_sampleSize;
+    int m_sampleOperations;
+
     OperationList *m_operations;
     Operation::OperationType m_type;
 
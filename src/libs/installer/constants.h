@@ -166,6 +166,7 @@ static const QLatin1String scProductUUID("ProductUUID");
 static const QLatin1String scAllUsers("AllUsers");
 static const QLatin1String scSupportsModify("SupportsModify");
 static const QLatin1String scAllowUnstableComponents("AllowUnstableComponents");
+static const QLatin1String scLoadComponentScriptsOnDemand("LoadComponentScriptsOnDemand");
 static const QLatin1String scSaveDefaultRepositories("SaveDefaultRepositories");
 static const QLatin1String scRepositoryCategoryDisplayName("RepositoryCategoryDisplayName");
 static const QLatin1String scHighDpi("@2x.");
@@ -175,6 +176,14 @@ static const QLatin1String scLogo("Logo");
 static const QLatin1String scBackground("Background");
 static const QLatin1String scPageListPixmap("PageListPixmap");
 const char scRelocatable[] = "@RELOCATABLE_PATH@";
+
+// package elements that are fetched in the meta.7z archive of the package
+Q_GLOBAL_STATIC_WITH_ARGS(QStringList, scMetaElements, (QStringList(
+    QLatin1String("Script")) <<
+    QLatin1String("Licenses") <<
+    QLatin1String("UserInterfaces") <<
+    QLatin1String("Translations")
+));
 }
 
 namespace CommandLineOptions {
@@ -283,6 +292,12 @@ static const QLatin1String scSquishPortShort("q");
 static const QLatin1String scSquishPortLong("squish-port");
 static const QLatin1String scMaxConcurrentOperationsShort("mco");
 static const QLatin1String scMaxConcurrentOperationsLong("max-concurrent-operations");
+static const QLatin1String scMaxConcurrentDownloadsShort("mcd");
+static const QLatin1String scMaxConcurrentDownloadsLong("max-concurrent-downloads");
+static const QLatin1String scMaxConcurrentDownloadsPerHostShort("mcdh");
+static const QLatin1String scMaxConcurrentDownloadsPerHostLong("max-concurrent-downloads-per-host");
+static const QLatin1String scPipelinedInstallationShort("pi");
+static const QLatin1String scPipelinedInstallationLong("pipelined-installation");
 static const QLatin1String scCleanupUpdate("cleanup-update");
 static const QLatin1String scCleanupUpdateOnly("cleanup-update-only");
 
@@ -338,8 +338,9 @@ bool CreateLocalRepositoryOperation::performOperation()
 
                     QFile target(repo.filePath(name) + QDir::separator()
                         + QString::fromUtf8(resource->name()));
-                    QInstaller::openForWrite(&target);
+                    QInstaller::openForWriteBehind(&target);
                     resource->copyData(&target);
+                    QInstaller::flushWritten(&target);
                     helper.m_files.prepend(target.fileName());
                     emit outputTextChanged(helper.m_files.first());
 
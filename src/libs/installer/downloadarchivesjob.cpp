@@ -43,6 +43,7 @@
 using namespace QInstaller;
 using namespace KDUpdater;
 
+static const int scDefaultMaxConcurrentDownloads = 4;
 
 /*!
     Creates a new DownloadArchivesJob with parent \a core.
@@ -50,11 +51,12 @@ using namespace KDUpdater;
 DownloadArchivesJob::DownloadArchivesJob(PackageManagerCore *core)
     : Job(core)
     , m_core(core)
-    , m_downloader(nullptr)
     , m_archivesDownloaded(0)
     , m_archivesToDownloadCount(0)
+    , m_maxConcurrentDownloads(scDefaultMaxConcurrentDownloads)
+    , m_maxConcurrentDownloadsPerHost(0)
+    , m_handlingFailure(false)
     , m_canceled(false)
-    , m_lastFileProgress(0)
     , m_progressChangedTimerId(0)
     , m_totalSizeToDownload(0)
     , m_totalSizeDownloaded(0)
@@ -67,8 +69,9 @@ DownloadArchivesJob::DownloadArchivesJob(PackageManagerCore *core)
 */
 DownloadArchivesJob::~DownloadArchivesJob()
 {
-    if (m_downloader)
-        m_downloader->deleteLater();
+    const QList<FileDownloader *> downloaders = m_activeDownloads.keys();
+    for (FileDownloader *downloader : downloaders)
+        downloader->deleteLater();
 }
 
 /*!
@@ -89,6 +92,42 @@ void DownloadArchivesJob::setExpectedTotalSize(quint64 total)
     m_totalSizeToDownload = total;
 }
 
+/*!
+    Sets the maximum \a count of archives that are downloaded at the same time.
+    A value of \c 0 or less resets the count to the default of four downloads.
+*/
+void DownloadArchivesJob::setMaxConcurrentDownloads(int count)
+{
+    m_maxConcurrentDownloads = (count > 0) ? count : scDefaultMaxConcurrentDownloads;
+}
+
+/*!
+    Returns the maximum count of archives that are downloaded at the same time.
+*/
+int DownloadArchivesJob::maxConcurrentDownloads() const
+{
+    return m_maxConcurrentDownloads;
+}
+
+/*!
+    Sets the maximum \a count of archives that are downloaded at the same time
+    from a single host. A value of \c 0 or less means that only the global limit
+    set with setMaxConcurrentDownloads() applies.
+*/
+void DownloadArchivesJob::setMaxConcurrentDownloadsPerHost(int count)
+{
+    m_maxConcurrentDownloadsPerHost = qMax(0, count);
+}
+
+/*!
+    Returns the maximum count of archives that are downloaded at the same time
+    from a single host, or \c 0 if there is no per host limit.
+*/
+int DownloadArchivesJob::maxConcurrentDownloadsPerHost() const
+{
+    return m_maxConcurrentDownloadsPerHost;
+}
+
 /*!
     \reimp
 */
@@ -96,7 +135,7 @@ void DownloadArchivesJob::doStart()
 {
     m_totalDownloadSpeedTimer.start();
     m_archivesDownloaded = 0;
-    fetchNextArchiveHash();
+    startDownloads();
 }
 
 /*!
@@ -104,87 +143,116 @@ void DownloadArchivesJob::doStart()
 */
 void DownloadArchivesJob::doCancel()
 {
-    m_canceled = true;
-    if (m_downloader != nullptr)
-        m_downloader->cancelDownload();
+    abortDownloads();
 }
 
-void DownloadArchivesJob::fetchNextArchiveHash()
+/*!
+    Starts downloads for the pending archives until either the global or the per host
+    limit of concurrent downloads is reached. The archives are started in the order they
+    were given in setArchivesToDownload(). Emits the \c finished() signal when there is
+    nothing left to download.
+*/
+void DownloadArchivesJob::startDownloads()
 {
-    if (m_archivesToDownload.isEmpty()) {
-        emitFinished();
+    if (m_canceled || m_handlingFailure)
         return;
-    }
 
-    if (m_archivesToDownload.first().checkSha1CheckSum) {
-        if (m_canceled) {
-            finishWithError(tr("Canceled"));
-            return;
+    auto it = m_archivesToDownload.begin();
+    while (it != m_archivesToDownload.end() && m_activeDownloads.count() < m_maxConcurrentDownloads) {
+        const QString host = QUrl(it->sourceUrl).host();
+        if (m_maxConcurrentDownloadsPerHost > 0
+                && m_activeDownloadsPerHost.value(host) >= m_maxConcurrentDownloadsPerHost) {
+            ++it;
+            continue;
         }
+        const PackageManagerCore::DownloadItem item = *it;
+        it = m_archivesToDownload.erase(it);
+        startDownload(item, host);
+    }
 
-        if (m_downloader)
-            m_downloader->deleteLater();
-
-        m_downloader = setupDownloader(QLatin1String(".sha1"));
-        if (!m_downloader) {
-            m_archivesToDownload.removeFirst();
-            QMetaObject::invokeMethod(this, "fetchNextArchiveHash", Qt::QueuedConnection);
-            return;
-        }
+    if (isDone())
+        emitFinished();
+}
 
-        connect(m_downloader, &FileDownloader::downloadCompleted,
-                this, &DownloadArchivesJob::finishedHashDownload, Qt::QueuedConnection);
-        m_downloader->download();
-    } else {
-        QMetaObject::invokeMethod(this, "fetchNextArchive", Qt::QueuedConnection);
-    }
+/*!
+    Starts the download of \a item from \a host. The hash file is fetched first if
+    the item requires checksum verification. Returns \c false if no downloader could be
+    created for the item, in which case the item is skipped.
+*/
+bool DownloadArchivesJob::startDownload(const PackageManagerCore::DownloadItem &item, const QString &host)
+{
+    ActiveDownload download;
+    download.item = item;
+    download.host = host;
+
+    if (!item.checkSha1CheckSum)
+        return startArchiveDownload(download);
+
+    FileDownloader *const downloader = setupDownloader(item, QLatin1String(".sha1"));
+    if (!downloader)
+        return false;
+
+    download.fetchingHash = true;
+    m_activeDownloads.insert(downloader, download);
+    ++m_activeDownloadsPerHost[host];
+    downloader->download();
+    return true;
 }
 
-void DownloadArchivesJob::finishedHashDownload()
+/*!
+    Starts the download of the archive for \a download, reusing the download slot
+    of a possibly preceding hash file download.
+*/
+bool DownloadArchivesJob::startArchiveDownload(ActiveDownload download)
 {
-    Q_ASSERT(m_downloader != nullptr);
+    FileDownloader *const downloader = setupDownloader(download.item, QString(),
+        m_core->value(scUrlQueryString));
+    if (!downloader)
+        return false;
 
-    QFile sha1HashFile(m_downloader->downloadedFileName());
-    if (sha1HashFile.open(QFile::ReadOnly)) {
-        emit hashDownloadReady(m_downloader->downloadedFileName());
-        m_currentHash = sha1HashFile.readAll();
-        fetchNextArchive();
-    } else {
-        finishWithError(tr("Downloading hash signature failed."));
-    }
+    connect(downloader, SIGNAL(downloadProgress(double)), this, SLOT(emitDownloadProgress(double)));
+
+    download.fetchingHash = false;
+    download.progress = 0;
+    m_activeDownloads.insert(downloader, download);
+    ++m_activeDownloadsPerHost[download.host];
+
+    emitTotalProgress();
+    downloader->download();
+    return true;
 }
 
 /*!
-    Fetches the next archive and registers it in the installer.
+    Dispatches a completed hash or archive download to the matching handler.
 */
-void DownloadArchivesJob::fetchNextArchive()
+void DownloadArchivesJob::downloadCompleted()
 {
-    if (m_canceled) {
-        finishWithError(tr("Canceled"));
+    FileDownloader *const downloader = qobject_cast<FileDownloader *>(sender());
+    if (m_canceled || !m_activeDownloads.contains(downloader))
         return;
-    }
 
-    if (m_archivesToDownload.isEmpty()) {
-        emitFinished();
-        return;
-    }
-
-    if (m_downloader != nullptr)
-        m_downloader->deleteLater();
+    const ActiveDownload download = m_activeDownloads.value(downloader);
+    if (download.fetchingHash)
+        finishedHashDownload(downloader, download);
+    else
+        registerFile(downloader, download);
+}
 
-    m_downloader = setupDownloader(QString(), m_core->value(scUrlQueryString));
-    if (!m_downloader) {
-        m_archivesToDownload.removeFirst();
-        QMetaObject::invokeMethod(this, "fetchNextArchiveHash", Qt::QueuedConnection);
+void DownloadArchivesJob::finishedHashDownload(FileDownloader *downloader, const ActiveDownload &download)
+{
+    QFile sha1HashFile(downloader->downloadedFileName());
+    if (!sha1HashFile.open(QFile::ReadOnly)) {
+        finishWithError(tr("Downloading hash signature failed."), downloader->url().toString());
         return;
     }
+    emit hashDownloadReady(downloader->downloadedFileName());
 
-    emit progressChanged(double(m_archivesDownloaded) / m_archivesToDownloadCount);
-    connect(m_downloader, SIGNAL(downloadProgress(double)), this, SLOT(emitDownloadProgress(double)));
-    connect(m_downloader, &FileDownloader::downloadCompleted,
-            this, &DownloadArchivesJob::registerFile, Qt::QueuedConnection);
+    ActiveDownload archiveDownload = download;
+    archiveDownload.expectedHash = sha1HashFile.readAll();
+    releaseDownload(downloader);
 
-    m_downloader->download();
+    startArchiveDownload(archiveDownload);
+    startDownloads();
 }
 
 /*!
@@ -193,7 +261,12 @@ void DownloadArchivesJob::fetchNextArchive()
 */
 void DownloadArchivesJob::emitDownloadProgress(double progress)
 {
-    m_lastFileProgress = progress;
+    FileDownloader *const downloader = qobject_cast<FileDownloader *>(sender());
+    auto it = m_activeDownloads.find(downloader);
+    if (it == m_activeDownloads.end())
+        return;
+
+    it->progress = progress;
     if (!m_progressChangedTimerId)
         m_progressChangedTimerId = startTimer(5);
 }
@@ -206,23 +279,43 @@ void DownloadArchivesJob::timerEvent(QTimerEvent *event)
     if (event->timerId() == m_progressChangedTimerId) {
         killTimer(m_progressChangedTimerId);
         m_progressChangedTimerId = 0;
-        emit progressChanged((double(m_archivesDownloaded) + m_lastFileProgress) / m_archivesToDownloadCount);
+        emitTotalProgress();
     }
 }
 
+/*!
+    Emits the combined progress of the finished archives and the archives currently
+    being downloaded.
+*/
+void DownloadArchivesJob::emitTotalProgress()
+{
+    if (m_archivesToDownloadCount <= 0)
+        return;
+
+    double progress = m_archivesDownloaded;
+    for (const ActiveDownload &download : qAsConst(m_activeDownloads))
+        progress += download.progress;
+    emit progressChanged(progress / m_archivesToDownloadCount);
+}
+
 /*!
     Builds a textual representation of the total download \a status and
     emits the \c {downloadStatusChanged()} signal.
 */
 void DownloadArchivesJob::onDownloadStatusChanged(const QString &status)
 {
-    if (!m_downloader || m_canceled) {
+    if (m_activeDownloads.isEmpty() || m_canceled) {
         emit downloadStatusChanged(status);
         return;
     }
 
     QString extendedStatus;
-    quint64 currentDownloaded = m_totalSizeDownloaded + m_downloader->getBytesReceived();
+    quint64 currentDownloaded = m_totalSizeDownloaded;
+    for (auto it = m_activeDownloads.constBegin(); it != m_activeDownloads.constEnd(); ++it) {
+        if (!it.value().fetchingHash)
+            currentDownloaded += it.key()->getBytesReceived();
+    }
+
     if (m_totalSizeToDownload > 0) {
         QString bytesReceived = humanReadableSize(currentDownloaded);
         const QString bytesToReceive = humanReadableSize(m_totalSizeToDownload);
@@ -270,96 +363,185 @@ void DownloadArchivesJob::onDownloadStatusChanged(const QString &status)
         extendedStatus += tr(" - unknown time remaining.");
     }
 
-    emit downloadStatusChanged(tr("Archive: ") + status
-        + QLatin1String("<br>") + tr("Total: ")+ extendedStatus);
+    QString archiveStatus = tr("Archive: ") + status;
+    if (m_activeDownloads.count() > 1)
+        archiveStatus += tr(" (%n active download(s))", "", m_activeDownloads.count());
+
+    emit downloadStatusChanged(archiveStatus + QLatin1String("<br>") + tr("Total: ") + extendedStatus);
 }
 
 /*!
-    Registers the just downloaded file in the installer's file system.
+    Registers the just downloaded file of \a download in the installer's file system.
 */
-void DownloadArchivesJob::registerFile()
+void DownloadArchivesJob::registerFile(FileDownloader *downloader, const ActiveDownload &download)
 {
-    Q_ASSERT(m_downloader != nullptr);
+    if (download.item.checkSha1CheckSum && download.expectedHash != downloader->sha1Sum().toHex()) {
+        Failure failure;
+        failure.item = download.item;
+        failure.url = downloader->url().toString();
+        failure.hashMismatch = true;
+        releaseDownload(downloader);
+        handleFailure(failure);
+        return;
+    }
+
+    ++m_archivesDownloaded;
+    m_totalSizeDownloaded += QFile(downloader->downloadedFileName()).size();
+
+    BinaryFormatEngineHandler::instance()->registerResource(download.item.fileName,
+        downloader->downloadedFileName());
 
-    if (m_canceled || m_archivesToDownload.isEmpty())
+    emit fileDownloadReady(downloader->downloadedFileName());
+    emit archiveRegistered(download.item.fileName);
+
+    releaseDownload(downloader);
+    if (m_progressChangedTimerId) {
+        killTimer(m_progressChangedTimerId);
+        m_progressChangedTimerId = 0;
+    }
+    emitTotalProgress();
+    startDownloads();
+}
+
+/*!
+    Removes \a downloader from the active downloads and frees its download slot.
+*/
+void DownloadArchivesJob::releaseDownload(FileDownloader *downloader)
+{
+    auto it = m_activeDownloads.find(downloader);
+    if (it == m_activeDownloads.end())
         return;
 
-    if (m_archivesToDownload.first().checkSha1CheckSum && m_currentHash != m_downloader->sha1Sum().toHex()) {
-        //TODO: Maybe we should try to download the file again automatically
-        const QMessageBox::Button res =
-            MessageBoxHandler::critical(MessageBoxHandler::currentBestSuitParent(),
-            QLatin1String("DownloadError"), tr("Download Error"), tr("Hash verification while "
-            "downloading failed. This is a temporary error, please retry."),
-            QMessageBox::Retry | QMessageBox::Cancel, QMessageBox::Cancel);
-
-        // If run from command line instance, do not continue if hash verification failed.
-        // Same download is tried again and again causing infinite loop if hash not
-        // fixed to repositories.
-        if (res == QMessageBox::Cancel || m_core->isCommandLineInstance()) {
-            finishWithError(tr("Cannot verify Hash"));
-            return;
-        }
-    } else {
-        ++m_archivesDownloaded;
-        m_totalSizeDownloaded += QFile(m_downloader->downloadedFileName()).size();
-        if (m_progressChangedTimerId) {
-            killTimer(m_progressChangedTimerId);
-            m_progressChangedTimerId = 0;
-            emit progressChanged(double(m_archivesDownloaded) / m_archivesToDownloadCount);
-        }
+    auto hostIt = m_activeDownloadsPerHost.find(it->host);
+    if (hostIt != m_activeDownloadsPerHost.end() && --hostIt.value() <= 0)
+        m_activeDownloadsPerHost.erase(hostIt);
+
+    m_activeDownloads.erase(it);
+    downloader->deleteLater();
+}
 
-        const PackageManagerCore::DownloadItem item = m_archivesToDownload.takeFirst();
-        BinaryFormatEngineHandler::instance()->registerResource(item.fileName,
-            m_downloader->downloadedFileName());
+/*!
+    Queues \a failure and asks the user how to continue. Failures are resolved one at a
+    time in the order they occurred, and no new downloads are started while a failure is
+    being resolved. Retried archives are put at the front of the queue, canceling any
+    failure aborts all remaining downloads.
+*/
+void DownloadArchivesJob::handleFailure(const Failure &failure)
+{
+    m_failures.append(failure);
+    if (m_handlingFailure)
+        return;
 
-        emit fileDownloadReady(m_downloader->downloadedFileName());
+    m_handlingFailure = true;
+    while (!m_failures.isEmpty() && !m_canceled) {
+        const Failure current = m_failures.takeFirst();
+        if (current.hashMismatch) {
+            const QMessageBox::Button res =
+                MessageBoxHandler::critical(MessageBoxHandler::currentBestSuitParent(),
+                QLatin1String("DownloadError"), tr("Download Error"), tr("Hash verification while "
+                "downloading failed. This is a temporary error, please retry."),
+                QMessageBox::Retry | QMessageBox::Cancel, QMessageBox::Cancel);
+
+            // If run from command line instance, do not continue if hash verification failed.
+            // Same download is tried again and again causing infinite loop if hash not
+            // fixed to repositories.
+            if (res == QMessageBox::Cancel || m_core->isCommandLineInstance()) {
+                m_handlingFailure = false;
+                finishWithError(tr("Cannot verify Hash"), current.url);
+                return;
+            }
+        } else {
+            const QMessageBox::StandardButton b =
+                MessageBoxHandler::critical(MessageBoxHandler::currentBestSuitParent(),
+                QLatin1String("archiveDownloadError"), tr("Download Error"), tr("Cannot download archive %1: %2")
+                .arg(current.item.sourceUrl, current.error), QMessageBox::Retry | QMessageBox::Cancel);
+
+            // Do not retry when using command line instance, installer tries
+            // to download the same archive causing infinite loop
+            if (b != QMessageBox::Retry || m_core->isCommandLineInstance()) {
+                m_handlingFailure = false;
+                abortDownloads();
+                emitFinishedWithError(Job::Canceled, current.error);
+                return;
+            }
+        }
+        m_archivesToDownload.prepend(current.item);
     }
-    fetchNextArchiveHash();
+    m_handlingFailure = false;
+
+    if (!m_canceled)
+        QMetaObject::invokeMethod(this, "startDownloads", Qt::QueuedConnection);
 }
 
 void DownloadArchivesJob::downloadCanceled()
 {
-    emitFinishedWithError(Job::Canceled, m_downloader->errorString());
+    if (m_canceled)
+        return;
+
+    const FileDownloader *const dl = qobject_cast<const FileDownloader *>(sender());
+    const QString error = dl ? dl->errorString() : tr("Canceled");
+    abortDownloads();
+    emitFinishedWithError(Job::Canceled, error);
 }
 
 void DownloadArchivesJob::downloadFailed(const QString &error)
+{
+    FileDownloader *const downloader = qobject_cast<FileDownloader *>(sender());
+    if (m_canceled || !m_activeDownloads.contains(downloader))
+        return;
+
+    Failure failure;
+    failure.item = m_activeDownloads.value(downloader).item;
+    failure.url = downloader->url().toString();
+    failure.error = error;
+    releaseDownload(downloader);
+    handleFailure(failure);
+}
+
+void DownloadArchivesJob::finishWithError(const QString &error, const QString &url)
+{
+    abortDownloads();
+    const QString msg = tr("Cannot fetch archives: %1\nError while loading %2");
+    emitFinishedWithError(QInstaller::DownloadError, msg.arg(error, url));
+}
+
+/*!
+    Cancels all active downloads and discards the pending ones.
+*/
+void DownloadArchivesJob::abortDownloads()
 {
     if (m_canceled)
         return;
 
-    const QMessageBox::StandardButton b =
-        MessageBoxHandler::critical(MessageBoxHandler::currentBestSuitParent(),
-        QLatin1String("archiveDownloadError"), tr("Download Error"), tr("Cannot download archive %1: %2")
-        .arg(m_archivesToDownload.first().sourceUrl, error), QMessageBox::Retry | QMessageBox::Cancel);
+    m_canceled = true;
+    m_archivesToDownload.clear();
+    m_failures.clear();
 
-    // Do not call fetchNextArchiveHash when using command line instance,
-    // installer tries to download the same archive causing infinite loop
-    if (b == QMessageBox::Retry && !m_core->isCommandLineInstance())
-        QMetaObject::invokeMethod(this, "fetchNextArchiveHash", Qt::QueuedConnection);
-    else
-        downloadCanceled();
+    const QList<FileDownloader *> downloaders = m_activeDownloads.keys();
+    for (FileDownloader *downloader : downloaders)
+        downloader->cancelDownload();
 }
 
-void DownloadArchivesJob::finishWithError(const QString &error)
+/*!
+    Returns \c true if there are neither pending nor active downloads left.
+*/
+bool DownloadArchivesJob::isDone() const
 {
-    const FileDownloader *const dl = qobject_cast<const FileDownloader*> (sender());
-    const QString msg = tr("Cannot fetch archives: %1\nError while loading %2");
-    if (dl != nullptr)
-        emitFinishedWithError(QInstaller::DownloadError, msg.arg(error, dl->url().toString()));
-    else
-        emitFinishedWithError(QInstaller::DownloadError, msg.arg(error, m_downloader->url().toString()));
+    return !m_canceled && !m_handlingFailure && m_activeDownloads.isEmpty()
+        && m_archivesToDownload.isEmpty();
 }
 
-KDUpdater::FileDownloader *DownloadArchivesJob::setupDownloader(const QString &suffix, const QString &queryString)
+KDUpdater::FileDownloader *DownloadArchivesJob::setupDownloader(const PackageManagerCore::DownloadItem &item,
+    const QString &suffix, const QString &queryString)
 {
     KDUpdater::FileDownloader *downloader = nullptr;
-    const QFileInfo fi = QFileInfo(m_archivesToDownload.first().fileName);
+    const QFileInfo fi = QFileInfo(item.fileName);
     const Component *const component = m_core->componentByName(PackageManagerCore::checkableName(QFileInfo(fi.path()).fileName()));
     if (component) {
         QString fullQueryString;
         if (!queryString.isEmpty())
             fullQueryString = QLatin1String("?") + queryString;
-        const QUrl url(m_archivesToDownload.first().sourceUrl + suffix + fullQueryString);
+        const QUrl url(item.sourceUrl + suffix + fullQueryString);
         const QString &scheme = url.scheme();
         downloader = FileDownloaderFactory::instance().create(scheme, this);
 
@@ -372,6 +554,8 @@ KDUpdater::FileDownloader *DownloadArchivesJob::setupDownloader(const QString &s
             auth.setPassword(component->value(QLatin1String("password")));
             downloader->setAuthenticator(auth);
 
+            connect(downloader, &FileDownloader::downloadCompleted,
+                this, &DownloadArchivesJob::downloadCompleted, Qt::QueuedConnection);
             connect(downloader, &FileDownloader::downloadCanceled, this, &DownloadArchivesJob::downloadCanceled);
             connect(downloader, &FileDownloader::downloadAborted, this, &DownloadArchivesJob::downloadFailed,
                 Qt::QueuedConnection);
@@ -29,10 +29,12 @@
 #ifndef DOWNLOADARCHIVESJOB_H
 #define DOWNLOADARCHIVESJOB_H
 
+#include "installer_global.h"
 #include "job.h"
 #include "packagemanagercore.h"
 #include <QtCore/QPair>
 #include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
 
 QT_BEGIN_NAMESPACE
 class QTimerEvent;
@@ -46,7 +48,7 @@ namespace QInstaller {
 
 class MessageBoxHandler;
 
-class DownloadArchivesJob : public Job
+class INSTALLER_EXPORT DownloadArchivesJob : public Job
 {
     Q_OBJECT
 
@@ -58,6 +60,12 @@ public:
     void setArchivesToDownload(const QList<PackageManagerCore::DownloadItem> &archives);
     void setExpectedTotalSize(quint64 total);
 
+    void setMaxConcurrentDownloads(int count);
+    int maxConcurrentDownloads() const;
+
+    void setMaxConcurrentDownloadsPerHost(int count);
+    int maxConcurrentDownloadsPerHost() const;
+
 Q_SIGNALS:
     void progressChanged(double progress);
     void outputTextChanged(const QString &progress);
@@ -65,6 +73,7 @@ Q_SIGNALS:
 
     void hashDownloadReady(const QString &localPath);
     void fileDownloadReady(const QString &localPath);
+    void archiveRegistered(const QString &fileName);
 
 protected:
     void doStart() override;
@@ -75,29 +84,60 @@ public Q_SLOTS:
     void onDownloadStatusChanged(const QString &status);
 
 protected Q_SLOTS:
-    void registerFile();
+    void downloadCompleted();
     void downloadCanceled();
     void downloadFailed(const QString &error);
-    void finishWithError(const QString &error);
-    void fetchNextArchive();
-    void fetchNextArchiveHash();
-    void finishedHashDownload();
+    void startDownloads();
     void emitDownloadProgress(double progress);
 
 private:
-    KDUpdater::FileDownloader *setupDownloader(const QString &suffix = QString(), const QString &queryString = QString());
+    struct ActiveDownload
+    {
+        PackageManagerCore::DownloadItem item;
+        QString host;
+        QByteArray expectedHash;
+        double progress = 0;
+        bool fetchingHash = false;
+    };
+
+    struct Failure
+    {
+        PackageManagerCore::DownloadItem item;
+        QString url;
+        QString error;
+        bool hashMismatch = false;
+    };
+
+    bool startDownload(const PackageManagerCore::DownloadItem &item, const QString &host);
+    bool startArchiveDownload(ActiveDownload download);
+    void finishedHashDownload(KDUpdater::FileDownloader *downloader, const ActiveDownload &download);
+    void registerFile(KDUpdater::FileDownloader *downloader, const ActiveDownload &download);
+    void releaseDownload(KDUpdater::FileDownloader *downloader);
+    void handleFailure(const Failure &failure);
+    void finishWithError(const QString &error, const QString &url);
+    void abortDownloads();
+    void emitTotalProgress();
+    bool isDone() const;
+
+    KDUpdater::FileDownloader *setupDownloader(const PackageManagerCore::DownloadItem &item,
+        const QString &suffix = QString(), const QString &queryString = QString());
 
 private:
     PackageManagerCore *m_core;
-    KDUpdater::FileDownloader *m_downloader;
 
     int m_archivesDownloaded;
     int m_archivesToDownloadCount;
     QList<PackageManagerCore::DownloadItem> m_archivesToDownload;
 
+    int m_maxConcurrentDownloads;
+    int m_maxConcurrentDownloadsPerHost;
+    QHash<KDUpdater::FileDownloader *, ActiveDownload> m_activeDownloads;
+    QHash<QString, int> m_activeDownloadsPerHost;
+
+    QList<Failure> m_failures;
+    bool m_handlingFailure;
+
     bool m_canceled;
-    QByteArray m_currentHash;
-    double m_lastFileProgress;
     int m_progressChangedTimerId;
 
     quint64 m_totalSizeToDownload;
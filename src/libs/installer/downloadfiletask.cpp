@@ -135,6 +135,17 @@ void Downloader::onReadyRead()
         return;
 
     Data &data = *m_downloads[reply];
+    if (data.keepInMemory()) {
+        const QByteArray buffer = reply->readAll();
+        data.content.append(buffer);
+
+        data.observer->addSample(buffer.size());
+        data.observer->addBytesTransfered(buffer.size());
+        data.observer->addCheckSumData(buffer.constData(), buffer.size());
+        updateProgress(reply, data);
+        return;
+    }
+
     if (!data.file) {
         std::unique_ptr<QFile> file = Q_NULLPTR;
         const QString target = data.taskItem.target();
@@ -198,21 +209,14 @@ void Downloader::onReadyRead()
         data.observer->addSample(read);
         data.observer->addBytesTransfered(read);
         data.observer->addCheckSumData(buffer.data(), read);
-
-        int progress = m_finished * 100;
-        for (const auto &pair : m_downloads)
-            progress += pair.second->observer->progressValue();
-        if (!reply->attribute(QNetworkRequest::RedirectionTargetAttribute).isValid()) {
-            m_futureInterface->setProgressValueAndText(progress / m_items.count(),
-                data.observer->progressText());
-        }
+        updateProgress(reply, data);
     }
 }
 
 void Downloader::onFinished(QNetworkReply *reply)
 {
     Data &data = *m_downloads[reply];
-    const QString filename = data.file ? data.file->fileName() : QString();
+    QString filename = data.file ? data.file->fileName() : QString();
     if (!m_futureInterface->isCanceled()) {
         if (reply->attribute(QNetworkRequest::RedirectionTargetAttribute).isValid()) {
             const QUrl url = reply->url()
@@ -244,6 +248,10 @@ void Downloader::onFinished(QNetworkReply *reply)
 
     const QByteArray ba = reply->readAll();
     if (!ba.isEmpty()) {
+        if (data.keepInMemory())
+            data.content.append(ba);
+        else if (data.file && data.file->isOpen())
+            data.file->write(ba);
         data.observer->addSample(ba.size());
         data.observer->addBytesTransfered(ba.size());
         data.observer->addCheckSumData(ba.data(), ba.size());
@@ -255,8 +263,13 @@ void Downloader::onFinished(QNetworkReply *reply)
         if (expectedCheckSum != data.observer->checkSum().toHex())
             checksumMismatch = true;
     }
-    m_futureInterface->reportResult(FileTaskResult(filename, data.observer->checkSum(), data.taskItem,
-                                                  checksumMismatch));
+    if (data.keepInMemory())
+        filename = data.taskItem.target();
+
+    FileTaskResult result(filename, data.observer->checkSum(), data.taskItem, checksumMismatch);
+    if (data.keepInMemory())
+        result.insert(TaskRole::Content, data.content);
+    m_futureInterface->reportResult(result);
 
     m_downloads.erase(reply);
     m_redirects.remove(reply);
@@ -375,6 +388,17 @@ void Downloader::onTimeout()
 
 // -- private
 
+void Downloader::updateProgress(QNetworkReply *reply, const Data &data)
+{
+    int progress = m_finished * 100;
+    for (const auto &pair : m_downloads)
+        progress += pair.second->observer->progressValue();
+    if (!reply->attribute(QNetworkRequest::RedirectionTargetAttribute).isValid()) {
+        m_futureInterface->setProgressValueAndText(progress / m_items.count(),
+            data.observer->progressText());
+    }
+}
+
 bool Downloader::testCanceled()
 {
     // TODO: figure out how to implement pause and resume
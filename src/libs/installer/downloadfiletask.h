@@ -40,7 +40,9 @@ namespace QInstaller {
 namespace TaskRole {
 enum
 {
-    Authenticator = TaskRole::TargetFile + 10
+    Authenticator = TaskRole::TargetFile + 10,
+    KeepInMemory,   // item: keep the downloaded data in memory instead of writing the target
+    Content         // result: the downloaded data of items with KeepInMemory set
 };
 }
 
@@ -62,7 +62,10 @@ struct Data
         , observer(new FileTaskObserver(QCryptographicHash::Sha1))
     {}
 
+    bool keepInMemory() const { return taskItem.value(TaskRole::KeepInMemory).toBool(); }
+
     FileTaskItem taskItem;
+    QByteArray content;
     std::unique_ptr<QFile> file;
     std::unique_ptr<FileTaskObserver> observer;
 };
@@ -94,6 +97,7 @@ private slots:
     void onTimeout();
 
 private:
+    void updateProgress(QNetworkReply *reply, const Data &data);
     bool testCanceled();
     QNetworkReply *startDownload(const FileTaskItem &item);
 
@@ -67,6 +67,7 @@ namespace QInstaller {
 ExtractArchiveOperation::ExtractArchiveOperation(PackageManagerCore *core)
     : UpdateOperation(core)
     , m_totalEntries(0)
+    , m_backupOnExtract(false)
 {
     setName(QLatin1String("Extract"));
     setGroup(OperationGroup::Unpack);
@@ -81,6 +82,19 @@ void ExtractArchiveOperation::backup()
     const QString archivePath = args.at(0);
     const QString targetDir = args.at(1);
 
+    const bool hasAdminRights = (AdminAuthorization::hasAdminRights() || RemoteClient::instance().isActive());
+    const bool canCreateSymLinks = QInstaller::canCreateSymbolicLinks();
+
+    // Unless we need to find out whether the archive contains symbolic links that require
+    // elevated rights, or the archive is extracted by the remote server process, existing
+    // files are backed up while extracting. This way the archive is read only once.
+    m_backupOnExtract = (hasAdminRights || canCreateSymLinks) && !RemoteClient::instance().isActive();
+    if (m_backupOnExtract) {
+        m_totalEntries = 0;
+        emit progressChanged(scBackupProgressPart);
+        return;
+    }
+
     QScopedPointer<AbstractArchive> archive(ArchiveFactory::instance().create(archivePath));
     if (!archive) {
         setError(UserDefinedError);
@@ -103,8 +117,6 @@ void ExtractArchiveOperation::backup()
         return;
     }
 
-    const bool hasAdminRights = (AdminAuthorization::hasAdminRights() || RemoteClient::instance().isActive());
-    const bool canCreateSymLinks = QInstaller::canCreateSymbolicLinks();
     bool needsAdminRights = false;
 
     for (auto &entry : entries) {
@@ -135,12 +147,22 @@ bool ExtractArchiveOperation::performOperation()
     const QString archivePath = args.at(0);
     const QString targetDir = args.at(1);
 
+    if (m_backupOnExtract && RemoteClient::instance().isActive()) {
+        // Elevated rights were gained after the backup, so the files are extracted by
+        // the remote server process and cannot be backed up while extracting.
+        backup();
+        if (error() != NoError)
+            return false;
+    }
+
     Receiver receiver;
     Callback callback;
+    FilePreparer preparer(this);
 
     connect(&callback, &Callback::progressChanged, this, &ExtractArchiveOperation::progressChanged);
 
-    Worker *worker = new Worker(archivePath, targetDir, m_totalEntries, &callback);
+    Worker *worker = new Worker(archivePath, targetDir, m_totalEntries, &callback,
+        m_backupOnExtract ? &preparer : nullptr);
     connect(worker, &Worker::finished, &receiver, &Receiver::workerFinished,
         Qt::QueuedConnection);
 
@@ -263,6 +285,23 @@ bool ExtractArchiveOperation::undoOperation()
     return true;
 }
 
+/*!
+    Returns the files and directories extracted by this operation, which are
+    removed when the operation is undone.
+*/
+QStringList ExtractArchiveOperation::extractedFiles()
+{
+    if (value(QLatin1String("files")).type() == QVariant::StringList)
+        return value(QLatin1String("files")).toStringList();
+
+    QString targetDir = arguments().value(1);
+    if (packageManager())
+        targetDir = packageManager()->value(scTargetDir);
+    QStringList files;
+    readDataFileContents(targetDir, &files);
+    return files;
+}
+
 void ExtractArchiveOperation::startUndoProcess(const QStringList &files)
 {
     WorkerThread *const thread = new WorkerThread(this, files);
@@ -314,6 +353,20 @@ bool ExtractArchiveOperation::prepareForFile(const QString &filename)
         return true;
 
     FileGuardLocker locker(filename, FileGuard::globalObject());
+    return backupFile(filename);
+}
+
+/*!
+    \internal
+
+    Renames an existing \a filename to a generated backup name. The caller
+    must hold the lock for \a filename in the global FileGuard. Returns \c true
+    on success or if there is nothing to back up.
+*/
+bool ExtractArchiveOperation::backupFile(const QString &filename)
+{
+    if (!QFile::exists(filename))
+        return true;
 
     const QString backup = generateBackupName(filename);
     QFile f(filename);
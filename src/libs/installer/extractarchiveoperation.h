@@ -51,6 +51,7 @@ public:
     quint64 sizeHint() override;
 
     bool readDataFileContents(QString &targetDir, QStringList *resultList);
+    QStringList extractedFiles();
 
 Q_SIGNALS:
     void outputTextChanged(const QString &progress);
@@ -62,12 +63,14 @@ private:
 
     QString generateBackupName(const QString &fn);
     bool prepareForFile(const QString &filename);
+    bool backupFile(const QString &filename);
 
 private:
     typedef QPair<QString, QString> Backup;
     typedef QVector<Backup> BackupFiles;
 
     class Callback;
+    class FilePreparer;
     class Worker;
     class Receiver;
 
@@ -75,6 +78,7 @@ private:
     QString m_relocatedDataFileName;
     BackupFiles m_backupFiles;
     quint64 m_totalEntries;
+    bool m_backupOnExtract;
 };
 
 }
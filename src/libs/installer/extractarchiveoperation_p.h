@@ -152,17 +152,39 @@ private:
     int m_lastProgressPercentage;
 };
 
+class ExtractArchiveOperation::FilePreparer : public ArchiveFilePreparer
+{
+    Q_DISABLE_COPY(FilePreparer)
+
+public:
+    explicit FilePreparer(ExtractArchiveOperation *op)
+        : m_op(op)
+    {}
+
+    bool prepareForFile(const QString &filename) override
+    {
+        // Ignore failed backups, existing files are overwritten when extracting.
+        m_op->backupFile(filename);
+        return true;
+    }
+
+private:
+    ExtractArchiveOperation *m_op;
+};
+
 class ExtractArchiveOperation::Worker : public QObject
 {
     Q_OBJECT
     Q_DISABLE_COPY(Worker)
 
 public:
-    Worker(const QString &archivePath, const QString &targetDir, quint64 totalEntries, Callback *callback)
+    Worker(const QString &archivePath, const QString &targetDir, quint64 totalEntries,
+            Callback *callback, FilePreparer *preparer = nullptr)
         : m_archivePath(archivePath)
         , m_targetDir(targetDir)
         , m_totalEntries(totalEntries)
         , m_callback(callback)
+        , m_preparer(preparer)
     {}
 
 Q_SIGNALS:
@@ -180,6 +202,7 @@ public Q_SLOTS:
 
         connect(m_archive.get(), &AbstractArchive::currentEntryChanged, m_callback, &Callback::onCurrentEntryChanged);
         connect(m_archive.get(), &AbstractArchive::completedChanged, m_callback, &Callback::onCompletedChanged);
+        m_archive->setFilePreparer(m_preparer);
 
         if (!m_archive->open(QIODevice::ReadOnly)) {
             emit finished(false, tr("Cannot open archive \"%1\" for reading: %2").arg(m_archivePath,
@@ -218,6 +241,7 @@ private:
     quint64 m_totalEntries;
     QScopedPointer<AbstractArchive> m_archive;
     Callback *m_callback;
+    FilePreparer *m_preparer;
 };
 
 class ExtractArchiveOperation::Receiver : public QObject
@@ -0,0 +1,151 @@
+/**************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "filehasher.h"
+
+#include <QFile>
+#include <QFuture>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace QInstaller {
+
+// Files of at least this size are mapped into memory instead of being read.
+static const qint64 scMapThreshold = 4 * 1024 * 1024;
+// Large files are mapped and hashed in chunks of this size to limit the address space used.
+static const qint64 scMapChunkSize = 64 * 1024 * 1024;
+static const int scBufferSize = 1024 * 1024;
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::FileHasher
+    \brief The FileHasher class calculates cryptographic hashes of files and devices.
+
+    All functions of this class are thread-safe. Data is read through a buffer owned by the
+    call, and files larger than a few megabytes are mapped into memory instead of
+    being copied through the buffer. Use hashFiles() to hash many files concurrently.
+*/
+
+/*
+    Adds the data from the current position to the end of \a file to \a hash by mapping
+    the file into memory. Returns \c false if the rest of the file must be read instead.
+*/
+static bool addMappedData(QFile *file, QCryptographicHash *hash)
+{
+    if (file->isSequential() || (file->openMode() & QIODevice::Text))
+        return false;
+
+    const qint64 start = file->pos();
+    const qint64 size = file->size();
+    if (size - start < scMapThreshold)
+        return false;
+
+    for (qint64 offset = start; offset < size; offset += scMapChunkSize) {
+        const qint64 length = qMin(scMapChunkSize, size - offset);
+        uchar *data = file->map(offset, length);
+        if (!data) {
+            // Let the caller read the rest of the file into the same hash.
+            file->seek(offset);
+            return false;
+        }
+        hash->addData(reinterpret_cast<const char *>(data), int(length));
+        file->unmap(data);
+    }
+    file->seek(size);
+    return true;
+}
+
+/*!
+    Returns the hash of the data read from \a device until its end using \a algorithm.
+    The \a device must be open for reading.
+*/
+QByteArray FileHasher::hash(QIODevice *device, QCryptographicHash::Algorithm algorithm)
+{
+    Q_ASSERT(device);
+    QCryptographicHash hash(algorithm);
+    if (QFile *file = qobject_cast<QFile *>(device)) {
+        if (addMappedData(file, &hash))
+            return hash.result();
+    }
+
+    // Owned by this call, so that concurrent and nested calls never share the buffer.
+    QByteArray buffer(scBufferSize, Qt::Uninitialized);
+
+    while (true) {
+        const qint64 numRead = device->read(buffer.data(), buffer.size());
+        if (numRead <= 0)
+            return hash.result();
+        hash.addData(buffer.constData(), numRead);
+    }
+    return QByteArray(); // never reached
+}
+
+/*!
+    Returns the hash of the file at \a path using \a algorithm, or an empty byte array if
+    the file cannot be opened.
+*/
+QByteArray FileHasher::hashFile(const QString &path, QCryptographicHash::Algorithm algorithm)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return hash(&file, algorithm);
+}
+
+/*!
+    Hashes the files in \a paths concurrently using \a algorithm, and returns the hashes
+    mapped to the paths. Files that cannot be opened are mapped to an empty byte array.
+    At most \a maxThreadCount files are hashed at the same time. A value of \c 0 uses the
+    ideal number of threads for the system.
+*/
+QHash<QString, QByteArray> FileHasher::hashFiles(const QStringList &paths,
+    QCryptographicHash::Algorithm algorithm, int maxThreadCount)
+{
+    QHash<QString, QByteArray> hashes;
+    if (paths.isEmpty())
+        return hashes;
+    if (paths.count() == 1) {
+        hashes.insert(paths.first(), hashFile(paths.first(), algorithm));
+        return hashes;
+    }
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(maxThreadCount > 0 ? maxThreadCount : QThread::idealThreadCount());
+
+    QList<QFuture<QByteArray>> futures;
+    for (const QString &path : paths) {
+        futures.append(QtConcurrent::run(&threadPool, [path, algorithm]() {
+            return hashFile(path, algorithm);
+        }));
+    }
+    for (int i = 0; i < paths.count(); ++i)
+        hashes.insert(paths.at(i), futures[i].result());
+    return hashes;
+}
+
+} // namespace QInstaller
@@ -30,6 +30,8 @@
 
 #include "errors.h"
 #include "range.h"
+#include "remoteclient.h"
+#include "remotefileengine.h"
 
 #include <QCoreApplication>
 #include <QByteArray>
@@ -37,6 +39,12 @@
 #include <QFileDevice>
 #include <QString>
 
+#if defined(Q_OS_LINUX)
+#include <errno.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif
+
 /*!
     \internal
 */
@@ -154,6 +162,19 @@ void QInstaller::openForWrite(QFileDevice *dev)
     }
 }
 
+/*!
+    \internal
+
+    Opens \a dev for writing like openForWrite(). Files written with elevated rights are
+    written in the background, so write errors may only be reported by flushWritten(),
+    which the caller must call before closing \a dev.
+*/
+void QInstaller::openForWriteBehind(QFileDevice *dev)
+{
+    const RemoteFileEngine::ScopedWriteBehind writeBehind;
+    openForWrite(dev);
+}
+
 /*!
     \internal
 */
@@ -167,6 +188,22 @@ void QInstaller::openForAppend(QFileDevice *dev)
     }
 }
 
+/*!
+    \internal
+
+    Flushes the data written to \a dev. Throws Error if any of the writes failed, which
+    for files opened with openForWriteBehind() may only be known at this point.
+*/
+void QInstaller::flushWritten(QFileDevice *dev)
+{
+    Q_ASSERT(dev);
+    if (!dev->flush()) {
+        throw Error(QCoreApplication::translate("QInstaller",
+            "Cannot write file \"%1\": %2").arg(
+                        QDir::toNativeSeparators(dev->fileName()), dev->errorString()));
+    }
+}
+
 /*!
     \internal
 */
@@ -190,18 +227,33 @@ qint64 QInstaller::blockingRead(QFileDevice *in, char *buffer, qint64 size)
 
 /*!
     \internal
+
+    Copies \a size bytes from the current position of \a in to \a out. Where the platform
+    supports it, the data is copied by the kernel without passing through user space,
+    otherwise it is copied in blocks of scCopyBufferSize bytes. Throws Error on failure.
 */
 qint64 QInstaller::blockingCopy(QFileDevice *in, QFileDevice *out, qint64 size)
 {
-    static const qint64 blockSize = 4096;
-    QByteArray ba(blockSize, '\0');
-    qint64 actual = qMin(blockSize, size);
+    if (!in->isSequential()) {
+        const qint64 pos = in->pos();
+        const qint64 copied = QInstaller::copyFileRange(in->handle(), pos, out, size);
+        if (copied > 0) {
+            if (!in->seek(pos + copied)) {
+                throw Error(QCoreApplication::translate("QInstaller", "Copy failed: %1")
+                    .arg(in->errorString()));
+            }
+            size -= copied;
+        }
+    }
+
+    QByteArray ba(qMin(scCopyBufferSize, size), '\0');
+    qint64 actual = qMin<qint64>(ba.size(), size);
     while (actual > 0) {
         try {
             QInstaller::blockingRead(in, ba.data(), actual);
             QInstaller::blockingWrite(out, ba.constData(), actual);
             size -= actual;
-            actual = qMin(blockSize, size);
+            actual = qMin<qint64>(ba.size(), size);
         } catch (const Error &error) {
             throw Error(QCoreApplication::translate("QInstaller", "Copy failed: %1")
                 .arg(error.message()));
@@ -210,6 +262,78 @@ qint64 QInstaller::blockingCopy(QFileDevice *in, QFileDevice *out, qint64 size)
     return size;
 }
 
+/*!
+    \internal
+
+    Copies up to \a size bytes starting at \a inOffset of the file identified by the native
+    \a inHandle to the current position of \a out, without passing the data through user
+    space. \a inHandle and \a out must be opened by the native file engine of this process.
+    On Linux, copy_file_range() is tried first, it shares the data blocks on file
+    systems supporting reflinks. sendfile() is used if the files are on different file
+    systems. Returns the number of bytes copied, which is \c 0 if the platform or the files
+    do not support copying in the kernel. The caller is expected to copy the rest.
+*/
+qint64 QInstaller::copyFileRange(int inHandle, qint64 inOffset, QFileDevice *out, qint64 size)
+{
+#if defined(Q_OS_LINUX)
+    // With elevated rights files are accessed through RemoteFileEngine, its handle() is a
+    // file descriptor of the server process and means nothing in this process.
+    if (RemoteClient::instance().isActive())
+        return 0;
+
+    const int outHandle = out->handle();
+    if (inHandle < 0 || outHandle < 0 || out->isSequential() || size <= 0)
+        return 0;
+    // data buffered by QFileDevice has to end up in front of the copied data
+    if (!out->flush())
+        return 0;
+
+    const qint64 outPos = out->pos();
+    qint64 copied = 0;
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+    loff_t inPos = inOffset;
+    loff_t outFilePos = outPos;
+    while (copied < size) {
+        const ssize_t n = ::copy_file_range(inHandle, &inPos, outHandle, &outFilePos,
+            size_t(size - copied), 0);
+        if (n > 0)
+            copied += n;
+        else if (n < 0 && errno == EINTR)
+            continue;
+        else
+            break; // end of input, or the files do not support it, e.g. EXDEV or EBADF
+    }
+#endif
+    // sendfile() writes at the file offset of the output
+    if (copied < size && ::lseek(outHandle, outPos + copied, SEEK_SET) == outPos + copied) {
+        off_t inPos = inOffset + copied;
+        while (copied < size) {
+            const ssize_t n = ::sendfile(outHandle, inHandle, &inPos,
+                size_t(qMin<qint64>(size - copied, 0x7ffff000)));
+            if (n > 0)
+                copied += n;
+            else if (n < 0 && errno == EINTR)
+                continue;
+            else
+                break;
+        }
+    }
+
+    // keep the position of the output in sync, this also resets the file offset
+    if (!out->seek(outPos + copied)) {
+        throw Error(QCoreApplication::translate("QInstaller", "Copy failed: %1")
+            .arg(out->errorString()));
+    }
+    return copied;
+#else
+    Q_UNUSED(inHandle)
+    Q_UNUSED(inOffset)
+    Q_UNUSED(out)
+    Q_UNUSED(size)
+    return 0;
+#endif
+}
+
 /*!
     \internal
 */
@@ -232,6 +356,7 @@ qint64 QInstaller::blockingWrite(QFileDevice *out, const char *data, qint64 size
                 out->errorString()));
         }
         left -= n;
+        data += n;
     }
     return size;
 }
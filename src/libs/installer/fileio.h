@@ -42,6 +42,9 @@ class Range;
 
 namespace QInstaller {
 
+// Size of the buffer used to copy data that cannot be copied by the kernel.
+static const qint64 scCopyBufferSize = 1024 * 1024;
+
 qint64 INSTALLER_EXPORT retrieveInt64(QFileDevice *in);
 void INSTALLER_EXPORT appendInt64(QFileDevice *out, qint64 n);
 
@@ -59,10 +62,13 @@ void INSTALLER_EXPORT appendData(QFileDevice *out, QFileDevice *in, qint64 size)
 
 void INSTALLER_EXPORT openForRead(QFileDevice *dev);
 void INSTALLER_EXPORT openForWrite(QFileDevice *dev);
+void INSTALLER_EXPORT openForWriteBehind(QFileDevice *dev);
 void INSTALLER_EXPORT openForAppend(QFileDevice *dev);
+void INSTALLER_EXPORT flushWritten(QFileDevice *dev);
 
 qint64 INSTALLER_EXPORT blockingRead(QFileDevice *in, char *buffer, qint64 size);
 qint64 INSTALLER_EXPORT blockingCopy(QFileDevice *in, QFileDevice *out, qint64 size);
+qint64 INSTALLER_EXPORT copyFileRange(int inHandle, qint64 inOffset, QFileDevice *out, qint64 size);
 
 qint64 INSTALLER_EXPORT blockingWrite(QFileDevice *out, const QByteArray &data);
 qint64 INSTALLER_EXPORT blockingWrite(QFileDevice *out, const char *data, qint64 size);
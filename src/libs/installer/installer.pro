@@ -51,6 +51,7 @@ HEADERS += packagemanagercore.h \
     concurrentoperationrunner.h \
     genericdatacache.h \
     loggingutils.h \
+    packagequery.h \
     metadata.h \
     packagemanagercore_p.h \
     packagemanagergui.h \
@@ -143,6 +144,7 @@ HEADERS += packagemanagercore.h \
     commandlineparser_p.h \
     abstractarchive.h \
     directoryguard.h \
+    filehasher.h \
     archivefactory.h \
     operationtracer.h
 
@@ -153,10 +155,12 @@ SOURCES += packagemanagercore.cpp \
     calculatorbase.cpp \
     concurrentoperationrunner.cpp \
     directoryguard.cpp \
+    filehasher.cpp \
     fileguard.cpp \
     componentsortfilterproxymodel.cpp \
     genericdatacache.cpp \
     loggingutils.cpp \
+    packagequery.cpp \
     metadata.cpp \
     operationtracer.cpp \
     packagemanagercore_p.cpp \
@@ -112,8 +112,10 @@ bool InstallerCalculator::solve(const QList<Component *> &components)
 
 void InstallerCalculator::addComponentForInstall(Component *component, const QString &version)
 {
-    if (!m_componentsForAutodepencencyCheck.contains(component))
+    if (!m_componentsForAutodepencencyCheckSet.contains(component)) {
         m_componentsForAutodepencencyCheck.append(component);
+        m_componentsForAutodepencencyCheckSet.insert(component);
+    }
 
     if (!component->isInstalled(version) || (m_core->isUpdater() && component->isUpdateAvailable())) {
         m_resolvedComponents.append(component);
@@ -233,6 +235,7 @@ QSet<Component *> InstallerCalculator::autodependencyComponents()
         }
     }
     m_componentsForAutodepencencyCheck.clear();
+    m_componentsForAutodepencencyCheckSet.clear();
     return foundAutoDependOnList;
 }
 
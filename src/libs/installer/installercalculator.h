@@ -61,6 +61,7 @@ private:
 private:
     QHash<Component*, QSet<Component*> > m_visitedComponents;
     QList<const Component*> m_componentsForAutodepencencyCheck;
+    QSet<const Component*> m_componentsForAutodepencencyCheckSet; //for faster lookups
     QSet<QString> m_toInstallComponentIds; //for faster lookups
     //Helper hash for quicker search for autodependency components
     AutoDependencyHash m_autoDependencyComponentHash;
@@ -33,16 +33,22 @@
 #include <Common/MyCom.h>
 #include <7zip/Archive/IArchive.h>
 
+#include <QFile>
 #include <QString>
 
+#include <memory>
+
 class CArc;
 
 QT_BEGIN_NAMESPACE
 class QFileDevice;
+class QThreadPool;
 QT_END_NAMESPACE
 
 namespace Lib7z
 {
+    class ParallelExtractor;
+
     class INSTALLER_EXPORT ExtractCallback : public IArchiveExtractCallback, public CMyUnknownImp
     {
         Q_DISABLE_COPY(ExtractCallback)
@@ -63,16 +69,19 @@ namespace Lib7z
         virtual HRESULT setCompleted(quint64 /*completed*/, quint64 /*total*/) { return S_OK; }
 
     private:
+        friend class ParallelExtractor;
+
         CArc *arc = 0;
 
         QString targetDir;
         quint64 total = 0;
         quint64 completed = 0;
         quint32 currentIndex = 0;
+        std::unique_ptr<QFile> outFile;
     };
 
     void INSTALLER_EXPORT extractArchive(QFileDevice *archive, const QString &targetDirectory,
-        ExtractCallback *callback = 0);
+        ExtractCallback *callback = 0, QThreadPool *threadPool = nullptr);
 
 } // namespace Lib7z
 
@@ -38,6 +38,7 @@
 #include "globals.h"
 #include "directoryguard.h"
 #include "fileguard.h"
+#include "remotefileengine.h"
 
 #ifndef Q_OS_WIN
 #   include "StdAfx.h"
@@ -62,9 +63,14 @@
 #include <QPointer>
 #include <QReadWriteLock>
 #include <QTemporaryFile>
+#include <QThreadPool>
+#include <QtConcurrent>
 
+#include <algorithm>
+#include <limits>
 #include <mutex>
 #include <memory>
+#include <numeric>
 
 #ifdef Q_OS_WIN
 HINSTANCE g_hInstance = nullptr;
@@ -391,9 +397,9 @@ class QIODeviceSequentialOutStream : public ISequentialOutStream, public CMyUnkn
 public:
     MY_UNKNOWN_IMP
 
-    explicit QIODeviceSequentialOutStream(std::unique_ptr<QIODevice> device)
+    explicit QIODeviceSequentialOutStream(QIODevice *device)
         : ISequentialOutStream()
-        , m_device(std::move(device))
+        , m_device(device)
     {
         LIB7Z_ASSERTS(m_device, Writable)
     }
@@ -421,7 +427,7 @@ public:
 
 private:
     QString m_errorString;
-    std::unique_ptr<QIODevice> m_device;
+    QIODevice *m_device;
 };
 
 class QIODeviceInStream : public IInStream, public CMyUnknownImp
@@ -643,15 +649,20 @@ STDMETHODIMP ExtractCallback::GetStream(UInt32 index, ISequentialOutStream **out
             return E_FAIL;
         }
 #endif
-        std::unique_ptr<QFile> file(new QFile(fi.absoluteFilePath()));
-        if (!file->open(QIODevice::WriteOnly)) {
+        // The file is kept open until SetOperationResult() so that write errors of files
+        // written with elevated rights, which may only be known after the last write, are
+        // reported as well.
+        outFile.reset(new QFile(fi.absoluteFilePath()));
+        const QInstaller::RemoteFileEngine::ScopedWriteBehind writeBehind;
+        if (!outFile->open(QIODevice::WriteOnly)) {
             setLastError(QCoreApplication::translate("ExtractCallbackImpl",
                                                      "Cannot open file \"%1\" for writing: %2").arg(
-                             QDir::toNativeSeparators(fi.absoluteFilePath()), file->errorString()));
+                             QDir::toNativeSeparators(fi.absoluteFilePath()), outFile->errorString()));
+            outFile.reset();
             return E_FAIL;
         }
         CMyComPtr<ISequentialOutStream> stream =
-            new QIODeviceSequentialOutStream(std::move(file));
+            new QIODeviceSequentialOutStream(outFile.get());
         *outStream = stream.Detach(); // CMyComPtr is needed, otherwise it crashes in Write().
     }
 
@@ -675,6 +686,17 @@ STDMETHODIMP ExtractCallback::SetOperationResult(Int32 /*resultEOperationResult*
     if (targetDir.isEmpty())
         return S_OK;
 
+    if (outFile) {
+        const std::unique_ptr<QFile> file = std::move(outFile);
+        if (!file->flush()) {
+            setLastError(QCoreApplication::translate("ExtractCallbackImpl",
+                "Cannot write file \"%1\": %2").arg(QDir::toNativeSeparators(file->fileName()),
+                file->errorString()));
+            return E_FAIL;
+        }
+        file->close();
+    }
+
     UString s;
     if (arc->GetItemPath(currentIndex, s) != S_OK) {
         setLastError(QCoreApplication::translate("ExtractCallbackImpl",
@@ -1080,14 +1102,382 @@ void createArchive(const QString &archive, const QStringList &sources, TmpFile m
     }
 }
 
+// -- parallel extraction of independent folders
+
+static const quint32 scNoFolder = std::numeric_limits<quint32>::max();
+static const quint64 scParallelExtractThreshold = 16 * 1024 * 1024;
+
+/*
+    A set of archive items that can be decoded independently of all other items. For 7z
+    archives this is one solid block (folder), which always has to be decoded from its start.
+*/
+struct ExtractFolder
+{
+    QVector<UInt32> indices;
+    quint64 size = 0;
+};
+
+/* \internal
+
+    Groups the items of \a archive by the folder they are stored in. Items without data, like
+    directories and empty files, are returned in the first group. Returns an empty list if the
+    archive format does not report folders.
+*/
+static QVector<ExtractFolder> extractFolders(IInArchive *archive)
+{
+    UInt32 numItems = 0;
+    if (archive->GetNumberOfItems(&numItems) != S_OK)
+        return QVector<ExtractFolder>();
+
+    ExtractFolder noData;
+    QHash<quint32, int> folderPositions;
+    QVector<ExtractFolder> folders;
+    for (UInt32 item = 0; item < numItems; ++item) {
+        const quint32 folder = getUInt32Property(archive, item, kpidBlock, scNoFolder);
+        if (folder == scNoFolder) {
+            noData.indices.append(item);
+            continue;
+        }
+        auto it = folderPositions.find(folder);
+        if (it == folderPositions.end()) {
+            it = folderPositions.insert(folder, folders.count());
+            folders.append(ExtractFolder());
+        }
+        ExtractFolder &current = folders[it.value()];
+        current.indices.append(item);
+        current.size += getUInt64Property(archive, item, kpidSize, 0);
+    }
+
+    // Hand out the largest folders first, so that no thread is left with a big one at the end.
+    std::stable_sort(folders.begin(), folders.end(),
+        [](const ExtractFolder &lhs, const ExtractFolder &rhs) { return lhs.size > rhs.size; });
+    if (!noData.indices.isEmpty())
+        folders.prepend(noData);
+    return folders;
+}
+
+/*
+    The threads of this pool are the budget shared by all archives decoded at the same time.
+    It never runs tasks, extractions only reserve its threads, so that tasks queued in
+    QThreadPool::globalInstance() are not held back while an archive is extracted.
+*/
+Q_GLOBAL_STATIC(QThreadPool, decoderThreadBudget)
+
+/*
+    Reserves \a count threads of \a pool for the lifetime of the object. The workers decoding
+    an archive run in a private pool, which must not be blocked by the tasks of other pools.
+    Reserving the threads makes them count against the limit of \a pool.
+*/
+class ThreadReservation
+{
+    Q_DISABLE_COPY(ThreadReservation)
+
+public:
+    ThreadReservation(QThreadPool *pool, int count)
+        : m_pool(pool)
+        , m_count(count)
+    {
+        for (int i = 0; i < m_count; ++i)
+            m_pool->reserveThread();
+    }
+
+    ~ThreadReservation()
+    {
+        for (int i = 0; i < m_count; ++i)
+            m_pool->releaseThread();
+    }
+
+private:
+    QThreadPool *const m_pool;
+    const int m_count;
+};
+
+/*
+    Decodes the folders of a file based archive with a pool of worker threads. Every worker
+    opens its own stream and archive handler and takes the next folder from a shared queue
+    as soon as it is done with the previous one. Creating output files is serialized, file
+    names and the progress summed up over all workers are forwarded to the external callback
+    from the thread that started the extraction.
+*/
+class ParallelExtractor
+{
+    Q_DISABLE_COPY(ParallelExtractor)
+
+public:
+    ParallelExtractor(const QString &archive, const QString &directory, ExtractCallback *callback,
+            const QVector<ExtractFolder> &folders)
+        : m_archive(archive)
+        , m_directory(directory)
+        , m_callback(callback)
+        , m_folders(folders)
+    {
+        for (const ExtractFolder &folder : folders)
+            m_total += folder.size;
+    }
+
+    void run(int threadCount);
+
+    QMutex *fileMutex() { return &m_fileMutex; }
+    HRESULT result() const { QMutexLocker _(&m_mutex); return m_result; }
+
+    bool prepareForFile(const QString &filename) { return m_callback->prepareForFile(filename); }
+    void setCurrentFile(const QString &filename);
+    HRESULT setCompleted(int worker, quint64 completed);
+
+private:
+    void extract(int worker);
+    quint64 forwardProgress();
+    bool takeFolder(ExtractFolder *folder);
+    void setResult(HRESULT result, const QString &errorString = QString());
+
+private:
+    const QString m_archive;
+    const QString m_directory;
+    ExtractCallback *const m_callback;
+
+    mutable QMutex m_mutex;
+    QMutex m_fileMutex;
+    QVector<ExtractFolder> m_folders;
+    QVector<quint64> m_completed;
+    QStringList m_currentFiles;
+    quint64 m_total = 0;
+    HRESULT m_result = S_OK;
+    QString m_errorString;
+};
+
+/*
+    Extract callback used by a single ParallelExtractor worker.
+*/
+class ParallelExtractCallback : public ExtractCallback
+{
+    Q_DISABLE_COPY(ParallelExtractCallback)
+
+public:
+    ParallelExtractCallback(ParallelExtractor *extractor, int worker)
+        : m_extractor(extractor)
+        , m_worker(worker)
+    {}
+
+    void setBase(quint64 base) { m_base = base; }
+
+    STDMETHOD(GetStream)(UInt32 index, ISequentialOutStream **outStream, Int32 askExtractMode)
+    {
+        QMutexLocker _(m_extractor->fileMutex());
+        if (m_extractor->result() != S_OK) {
+            *outStream = nullptr;
+            return m_extractor->result();
+        }
+        return ExtractCallback::GetStream(index, outStream, askExtractMode);
+    }
+
+protected:
+    bool prepareForFile(const QString &filename) override
+    {
+        return m_extractor->prepareForFile(filename);
+    }
+
+    void setCurrentFile(const QString &filename) override
+    {
+        m_extractor->setCurrentFile(filename);
+    }
+
+    HRESULT setCompleted(quint64 completed, quint64 /*total*/) override
+    {
+        return m_extractor->setCompleted(m_worker, m_base + completed);
+    }
+
+private:
+    ParallelExtractor *const m_extractor;
+    const int m_worker;
+    quint64 m_base = 0;
+};
+
+/* \internal
+
+    Extracts all folders using \a threadCount worker threads. The external callback is asked
+    for cancellation regularly while the workers are running.
+
+    \note Throws SevenZipException on error.
+*/
+void ParallelExtractor::run(int threadCount)
+{
+    m_completed.fill(0, threadCount);
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(threadCount);
+    for (int worker = 0; worker < threadCount; ++worker)
+        QtConcurrent::run(&threadPool, [this, worker]() { extract(worker); });
+
+    while (!threadPool.waitForDone(100)) {
+        const HRESULT state = m_callback->setCompleted(forwardProgress(), m_total);
+        if (state != S_OK)
+            setResult(state);
+    }
+    forwardProgress();
+
+    if (m_result != S_OK) {
+        throw SevenZipException(m_errorString.isEmpty() ? errorMessageFrom7zResult(m_result)
+            : m_errorString);
+    }
+    m_callback->setCompleted(m_total, m_total);
+}
+
+/* \internal
+
+    Forwards the file names collected from the workers to the external callback and returns
+    the number of bytes extracted so far.
+*/
+quint64 ParallelExtractor::forwardProgress()
+{
+    QStringList files;
+    quint64 completed = 0;
+    {
+        QMutexLocker _(&m_mutex);
+        files.swap(m_currentFiles);
+        completed = std::accumulate(m_completed.constBegin(), m_completed.constEnd(), quint64(0));
+    }
+    foreach (const QString &file, files)
+        m_callback->setCurrentFile(file);
+    return completed;
+}
+
+/* \internal
+
+    Queues \a filename to be forwarded to the external callback. Called with the file mutex
+    held, so directories are always reported before the files they contain.
+*/
+void ParallelExtractor::setCurrentFile(const QString &filename)
+{
+    QMutexLocker _(&m_mutex);
+    m_currentFiles.append(filename);
+}
+
+/* \internal
+
+    Returns the combined progress state to the \a worker that reported \a completed bytes.
+*/
+HRESULT ParallelExtractor::setCompleted(int worker, quint64 completed)
+{
+    QMutexLocker _(&m_mutex);
+    m_completed[worker] = completed;
+    return m_result;
+}
+
+/* \internal
+
+    Extracts folders until the queue is drained or any worker failed.
+*/
+void ParallelExtractor::extract(int worker)
+{
+    try {
+        QFile file(m_archive);
+        if (!file.open(QIODevice::ReadOnly)) {
+            setResult(E_FAIL, QCoreApplication::translate("Lib7z",
+                "Cannot open archive \"%1\".").arg(m_archive));
+            return;
+        }
+
+        CCodecs codecs;
+        if (codecs.Load() != S_OK) {
+            setResult(E_FAIL, QCoreApplication::translate("Lib7z", "Cannot load codecs."));
+            return;
+        }
+
+        COpenOptions op;
+        op.codecs = &codecs;
+
+        CObjectVector<COpenType> types;
+        op.types = &types;  // Empty, because we use a stream.
+
+        CIntVector excluded;
+        excluded.Add(codecs.FindFormatForExtension(
+            QString2UString(QLatin1String("xz")))); // handled by libarchive
+        op.excludedFormats = &excluded;
+
+        const CMyComPtr<IInStream> stream = new QIODeviceInStream(&file);
+        op.stream = stream; // CMyComPtr is needed, otherwise it crashes in OpenStream().
+
+        CObjectVector<CProperty> properties;
+        op.props = &properties;
+
+        CArchiveLink archiveLink;
+        if (archiveLink.Open2(op, nullptr) != S_OK || archiveLink.Arcs.Size() != 1) {
+            setResult(E_FAIL, QCoreApplication::translate("Lib7z",
+                "Cannot open archive \"%1\".").arg(m_archive));
+            return;
+        }
+
+        ParallelExtractCallback *callback = new ParallelExtractCallback(this, worker);
+        const CMyComPtr<IArchiveExtractCallback> callbackGuard = callback;
+        callback->setTarget(m_directory);
+        callback->setArchive(&archiveLink.Arcs[0]);
+        IInArchive *const arch = archiveLink.Arcs[0].Archive;
+
+        quint64 base = 0;
+        ExtractFolder folder;
+        while (takeFolder(&folder)) {
+            callback->setBase(base);
+            const HRESULT result = arch->Extract(folder.indices.constData(),
+                static_cast<UInt32>(folder.indices.count()), false, callback);
+            if (result != S_OK) {
+                setResult(result, result == E_ABORT ? QString() : errorMessageFrom7zResult(result));
+                return;
+            }
+            base += folder.size;
+            setCompleted(worker, base);
+        }
+    } catch (const SevenZipException &e) {
+        setResult(E_FAIL, e.message());
+    } catch (...) {
+        setResult(E_FAIL, QCoreApplication::translate("Lib7z",
+            "Unknown exception caught (%1).").arg(QString::fromLatin1(Q_FUNC_INFO)));
+    }
+}
+
+/* \internal
+
+    Moves the next folder to extract into \a folder. Returns \c false if there is none left
+    or the extraction failed.
+*/
+bool ParallelExtractor::takeFolder(ExtractFolder *folder)
+{
+    QMutexLocker _(&m_mutex);
+    if (m_result != S_OK || m_folders.isEmpty())
+        return false;
+    *folder = m_folders.takeFirst();
+    return true;
+}
+
+/* \internal
+
+    Records the first failing \a result and its \a errorString. Running workers stop at
+    their next progress report.
+*/
+void ParallelExtractor::setResult(HRESULT result, const QString &errorString)
+{
+    QMutexLocker _(&m_mutex);
+    if (m_result != S_OK)
+        return;
+    m_result = result;
+    m_errorString = errorString;
+}
+
 /*!
     Extracts the given \a archive content into target directory \a directory using the provided
     extract callback \a callback. The output filenames are deduced from the \a archive content.
 
+    Large archives with several independent folders are decoded with multiple threads. Their
+    number is bounded by the threads available in \a threadPool. If \a threadPool is
+    \c nullptr, a budget of QThread::idealThreadCount() threads shared by all extractions
+    in the process is used. The calling thread and the decoding threads are reserved in
+    \a threadPool while the archive is extracted, so that concurrent extractions, for example
+    those run by ConcurrentOperationRunner, share the threads instead of each using all cores.
+
     \note Throws SevenZipException on error.
     \note The ownership of \a callback is not transferred to the function.
 */
-void extractArchive(QFileDevice *archive, const QString &directory, ExtractCallback *callback)
+void extractArchive(QFileDevice *archive, const QString &directory, ExtractCallback *callback,
+    QThreadPool *threadPool)
 {
     LIB7Z_ASSERTS(archive, Readable)
 
@@ -1131,8 +1521,33 @@ void extractArchive(QFileDevice *archive, const QString &directory, ExtractCallb
                 "Cannot open archive \"%1\".").arg(archive->fileName()));
         }
 
+        // Archives with several independent folders are decoded with multiple threads, each
+        // reading the archive through its own file handle.
+        bool extracted = false;
+        if (!threadPool)
+            threadPool = decoderThreadBudget();
+        // The calling thread decodes the archive itself unless it is split between workers
+        ThreadReservation callerReservation(threadPool, 1);
+        const int availableThreads = threadPool->maxThreadCount() - threadPool->activeThreadCount() + 1;
+        if (!archive->fileName().isEmpty() && archiveLink.Arcs.Size() == 1 && availableThreads > 1) {
+            const QVector<ExtractFolder> folders = extractFolders(archiveLink.Arcs[0].Archive);
+            const quint64 size = std::accumulate(folders.constBegin(), folders.constEnd(),
+                quint64(0), [](quint64 sum, const ExtractFolder &folder) {
+                    return sum + folder.size;
+                });
+            const int dataFolders = std::count_if(folders.constBegin(), folders.constEnd(),
+                [](const ExtractFolder &folder) { return folder.size > 0; });
+            if (dataFolders > 1 && size >= scParallelExtractThreshold) {
+                const int threadCount = qMin(availableThreads, dataFolders);
+                ThreadReservation reservation(threadPool, threadCount - 1);
+                ParallelExtractor extractor(archive->fileName(), directory, callback, folders);
+                extractor.run(threadCount);
+                extracted = true;
+            }
+        }
+
         callback->setTarget(directory);
-        for (unsigned a = 0; a < archiveLink.Arcs.Size(); ++a) {
+        for (unsigned a = 0; !extracted && a < archiveLink.Arcs.Size(); ++a) {
             callback->setArchive(&archiveLink.Arcs[a]);
             IInArchive *const arch = archiveLink.Arcs[a].Archive;
 
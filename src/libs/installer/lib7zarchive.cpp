@@ -120,10 +120,14 @@ void Lib7zArchive::setFilename(const QString &filename)
 
     Extracts the contents of this archive to \a dirPath.
     Returns \c true on success; \c false otherwise.
+
+    If a file preparer is set, it is called for every file entry
+    before the entry is written to disk.
 */
 bool Lib7zArchive::extract(const QString &dirPath)
 {
     m_extractCallback->setState(S_OK);
+    m_extractCallback->setFilePreparer(filePreparer());
     try {
         Lib7z::extractArchive(&m_file, dirPath, m_extractCallback);
     } catch (const Lib7z::SevenZipException &e) {
@@ -218,6 +222,7 @@ void Lib7zArchive::listenExtractCallback()
 
 Lib7zArchive::ExtractCallbackWrapper::ExtractCallbackWrapper()
     : m_state(S_OK)
+    , m_filePreparer(nullptr)
 {
 }
 
@@ -226,6 +231,16 @@ void Lib7zArchive::ExtractCallbackWrapper::setState(HRESULT state)
     m_state = state;
 }
 
+void Lib7zArchive::ExtractCallbackWrapper::setFilePreparer(ArchiveFilePreparer *preparer)
+{
+    m_filePreparer = preparer;
+}
+
+bool Lib7zArchive::ExtractCallbackWrapper::prepareForFile(const QString &filename)
+{
+    return m_filePreparer ? m_filePreparer->prepareForFile(filename) : true;
+}
+
 void Lib7zArchive::ExtractCallbackWrapper::setCurrentFile(const QString &filename)
 {
     emit currentEntryChanged(filename);
@@ -77,17 +77,20 @@ public:
     ExtractCallbackWrapper();
 
     void setState(HRESULT state);
+    void setFilePreparer(ArchiveFilePreparer *preparer);
 
 Q_SIGNALS:
     void currentEntryChanged(const QString &filename);
     void completedChanged(quint64 completed, quint64 total);
 
 private:
+    bool prepareForFile(const QString &filename) override;
     void setCurrentFile(const QString &filename) override;
     HRESULT setCompleted(quint64 completed, quint64 total) override;
 
 private:
     HRESULT m_state;
+    ArchiveFilePreparer *m_filePreparer;
 };
 
 } // namespace QInstaller
@@ -463,7 +463,7 @@ bool ExtractWorker::writeEntry(archive *reader, archive *writer, archive_entry *
 /*!
     \inmodule QtInstallerFramework
     \class QInstaller::LibArchiveArchive::ArchiveData
-    \brief Bundles a file device and associated read buffer for access
+    \brief Bundles a file or memory device and associated read buffer for access
            as client data in libarchive callbacks.
 */
 
@@ -561,8 +561,8 @@ LibArchiveArchive::~LibArchiveArchive()
 */
 bool LibArchiveArchive::open(QIODevice::OpenMode mode)
 {
-    if (!m_data->file.open(mode)) {
-        setErrorString(m_data->file.errorString());
+    if (!m_data->device()->open(mode)) {
+        setErrorString(m_data->device()->errorString());
         return false;
     }
     return true;
@@ -575,7 +575,7 @@ bool LibArchiveArchive::open(QIODevice::OpenMode mode)
 */
 void LibArchiveArchive::close()
 {
-    m_data->file.close();
+    m_data->device()->close();
 }
 
 /*!
@@ -588,6 +588,19 @@ void LibArchiveArchive::setFilename(const QString &filename)
     m_data->file.setFileName(filename);
 }
 
+/*!
+    Sets the contents of the archive to \a data. The archive is then read from
+    memory instead of the underlying file device, so that for example a downloaded
+    archive can be extracted without writing it to disk first. The filename is
+    still used for error messages. Call open() afterwards.
+*/
+void LibArchiveArchive::setData(const QByteArray &data)
+{
+    m_data->memory.close();
+    m_data->memory.setData(data);
+    m_data->fromMemory = true;
+}
+
 /*!
     \reimp
 
@@ -603,17 +616,19 @@ bool LibArchiveArchive::extract(const QString &dirPath)
     \reimp
 
     Extracts the contents of this archive to \a dirPath with
-    precalculated count of \a totalFiles. Returns \c true on
-    success; \c false otherwise.
+    precalculated count of \a totalFiles. If \a totalFiles is \c 0,
+    the progress is reported as the amount of archive data read
+    instead, so that the archive does not need to be listed first.
+    Returns \c true on success; \c false otherwise.
+
+    If a file preparer is set, it is called for every file entry
+    before the entry is written to disk.
 */
 bool LibArchiveArchive::extract(const QString &dirPath, const quint64 totalFiles)
 {
     m_cancelScheduled = false;
     quint64 completed = 0;
-    if (!totalFiles) {
-        setErrorString(QLatin1String("The file count for current archive is null!"));
-        return false;
-    }
+    const qint64 archiveSize = m_data->device()->size();
 
     QScopedPointer<archive, ScopedPointerReaderDeleter> reader(archive_read_new());
     QScopedPointer<archive, ScopedPointerWriterDeleter> writer(archive_write_disk_new());
@@ -657,6 +672,12 @@ bool LibArchiveArchive::extract(const QString &dirPath, const quint64 totalFiles
                 ArchiveEntryPaths::callWithSystemLocale(ArchiveEntryPaths::setHardlink, entry, hardLinkPath);
             }
 
+            if (filePreparer() && archive_entry_filetype(entry) != AE_IFDIR) {
+                FileGuardLocker locker(outputPath, FileGuard::globalObject());
+                if (!filePreparer()->prepareForFile(outputPath))
+                    throw Error(tr("Cannot prepare entry \"%1\" for extraction.").arg(outputPath));
+            }
+
             emit currentEntryChanged(outputPath);
             if (!writeEntry(reader.get(), writer.get(), entry)) {
                 throw Error(tr("Cannot write entry \"%1\" to disk: %2")
@@ -664,17 +685,20 @@ bool LibArchiveArchive::extract(const QString &dirPath, const quint64 totalFiles
             }
 
             ++completed;
-            emit completedChanged(completed, totalFiles);
+            if (totalFiles)
+                emit completedChanged(completed, totalFiles);
+            else if (archiveSize > 0)
+                emit completedChanged(archive_filter_bytes(reader.get(), -1), archiveSize);
 
             qApp->processEvents();
         }
     } catch (const Error &e) {
         setErrorString(e.message());
-        m_data->file.seek(0);
+        m_data->device()->seek(0);
         return false;
     }
     targetDir.release();
-    m_data->file.seek(0);
+    m_data->device()->seek(0);
     return true;
 }
 
@@ -842,10 +866,10 @@ QVector<ArchiveEntry> LibArchiveArchive::list()
         }
     } catch (const Error &e) {
         setErrorString(e.message());
-        m_data->file.seek(0);
+        m_data->device()->seek(0);
         return QVector<ArchiveEntry>();
     }
-    m_data->file.seek(0);
+    m_data->device()->seek(0);
     return entries;
 }
 
@@ -868,10 +892,10 @@ bool LibArchiveArchive::isSupported()
         }
     } catch (const Error &e) {
         setErrorString(e.message());
-        m_data->file.seek(0);
+        m_data->device()->seek(0);
         return false;
     }
-    m_data->file.seek(0);
+    m_data->device()->seek(0);
     return true;
 }
 
@@ -1087,18 +1111,18 @@ bool LibArchiveArchive::writeEntry(archive *reader, archive *writer, archive_ent
 /*!
     \internal
 
-    Reads \a data from the current position of \a file. The maximum bytes to
+    Reads \a data from the current position of \a device. The maximum bytes to
     read are specified by \a maxSize. Returns the amount of bytes read.
 */
-qint64 LibArchiveArchive::readData(QFile *file, char *data, qint64 maxSize)
+qint64 LibArchiveArchive::readData(QIODevice *device, char *data, qint64 maxSize)
 {
-    if (!file->isOpen() || file->isSequential())
+    if (!device->isOpen() || device->isSequential())
         return ARCHIVE_FATAL;
 
-    if (file->atEnd() && file->seek(0))
+    if (device->atEnd() && device->seek(0))
         return ARCHIVE_OK;
 
-    const qint64 bytesRead = file->read(data, maxSize);
+    const qint64 bytesRead = device->read(data, maxSize);
     if (bytesRead == -1)
         return ARCHIVE_FATAL;
 
@@ -1108,7 +1132,7 @@ qint64 LibArchiveArchive::readData(QFile *file, char *data, qint64 maxSize)
 /*!
     \internal
 
-    Called by libarchive when new data is needed. Reads data from the file device
+    Called by libarchive when new data is needed. Reads data from the device
     in \a archiveData into the buffer referenced by \a buff. Returns the number of bytes read.
 */
 ssize_t LibArchiveArchive::readCallback(archive *reader, void *archiveData, const void **buff)
@@ -1131,13 +1155,13 @@ ssize_t LibArchiveArchive::readCallback(archive *reader, void *archiveData, cons
 
     // Doesn't matter if the buffer size exceeds the actual data read,
     // the return value indicates the length of relevant bytes.
-    return readData(&data->file, data->buffer.data(), data->buffer.size());
+    return readData(data->device(), data->buffer.data(), data->buffer.size());
 }
 
 /*!
     \internal
 
-    Seeks to specified \a offset in the file device in \a archiveData and returns the position.
+    Seeks to specified \a offset in the device in \a archiveData and returns the position.
     Possible \a whence values are \c SEEK_SET, \c SEEK_CUR, and \c SEEK_END. Returns
     \c ARCHIVE_FATAL if the seek fails.
 */
@@ -1149,26 +1173,27 @@ la_int64_t LibArchiveArchive::seekCallback(archive *reader, void *archiveData, l
     if (!(data = static_cast<ArchiveData *>(archiveData)))
         return ARCHIVE_FATAL;
 
-    if (!data->file.isOpen() || data->file.isSequential())
+    QIODevice *const device = data->device();
+    if (!device->isOpen() || device->isSequential())
         return ARCHIVE_FATAL;
 
     switch (whence) {
     case SEEK_SET: // moves file pointer position to the beginning of the file
-        if (!data->file.seek(offset))
+        if (!device->seek(offset))
             return ARCHIVE_FATAL;
         break;
     case SEEK_CUR: // moves file pointer position to given location
-        if (!data->file.seek(data->file.pos() + offset))
+        if (!device->seek(device->pos() + offset))
             return ARCHIVE_FATAL;
         break;
     case SEEK_END: // moves file pointer position to the end of file
-        if (!data->file.seek(data->file.size() + offset))
+        if (!device->seek(device->size() + offset))
             return ARCHIVE_FATAL;
         break;
     default:
         return ARCHIVE_FATAL;
     }
-    return data->file.pos();
+    return device->pos();
 }
 
 /*!
@@ -1233,10 +1258,10 @@ quint64 LibArchiveArchive::totalFiles()
         }
     } catch (const Error &e) {
         setErrorString(e.message());
-        m_data->file.seek(0);
+        m_data->device()->seek(0);
         return 0;
     }
-    m_data->file.seek(0);
+    m_data->device()->seek(0);
     return files;
 }
 
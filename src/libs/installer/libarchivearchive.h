@@ -35,6 +35,7 @@
 #include <archive.h>
 #include <archive_entry.h>
 
+#include <QBuffer>
 #include <QThread>
 
 #if defined(_MSC_VER)
@@ -102,6 +103,7 @@ public:
     bool open(QIODevice::OpenMode mode) override;
     void close() override;
     void setFilename(const QString &filename) override;
+    void setData(const QByteArray &data);
 
     bool extract(const QString &dirPath) override;
     bool extract(const QString &dirPath, const quint64 totalFiles) override;
@@ -144,7 +146,7 @@ private:
     int archiveReadOpenWithCallbacks(archive *reader);
     bool writeEntry(archive *reader, archive *writer, archive_entry *entry);
 
-    static qint64 readData(QFile *file, char *data, qint64 maxSize);
+    static qint64 readData(QIODevice *device, char *data, qint64 maxSize);
     static ssize_t readCallback(archive *reader, void *archiveData, const void **buff);
 
     static la_int64_t seekCallback(archive *reader, void *archiveData, la_int64_t offset, int whence);
@@ -160,7 +162,11 @@ private:
 
     struct ArchiveData
     {
+        QIODevice *device() { return fromMemory ? static_cast<QIODevice *>(&memory) : &file; }
+
         QFile file;
+        QBuffer memory;
+        bool fromMemory = false;
         QByteArray buffer;
     };
 
@@ -179,6 +179,19 @@ void LibArchiveWrapper::setCompressionLevel(const CompressionLevel level)
     d->setCompressionLevel(level);
 }
 
+/*!
+    Sets the \a preparer to be called for each file entry before it is written
+    to disk.
+
+    \note The preparer is not called if the remote connection is active,
+    as the files are then extracted by the server process.
+*/
+void LibArchiveWrapper::setFilePreparer(ArchiveFilePreparer *preparer)
+{
+    AbstractArchive::setFilePreparer(preparer);
+    d->setFilePreparer(preparer);
+}
+
 /*!
     Cancels the extract operation in progress.
 
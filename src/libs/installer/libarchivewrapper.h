@@ -59,6 +59,7 @@ public:
     bool isSupported() override;
 
     void setCompressionLevel(const AbstractArchive::CompressionLevel level) override;
+    void setFilePreparer(ArchiveFilePreparer *preparer) override;
 
 public Q_SLOTS:
     void cancel() override;
@@ -138,8 +138,9 @@ QString LibArchiveWrapperPrivate::errorString() const
 */
 bool LibArchiveWrapperPrivate::extract(const QString &dirPath, const quint64 totalFiles)
 {
-    const quint64 total = totalFiles ? totalFiles : m_archive.totalFiles();
     if (connectToServer()) {
+        // The extract worker on the server needs to know the file count in advance
+        const quint64 total = totalFiles ? totalFiles : m_archive.totalFiles();
         QTimer timer;
         connect(&timer, &QTimer::timeout, this, &LibArchiveWrapperPrivate::processSignals);
         timer.start();
@@ -155,7 +156,7 @@ bool LibArchiveWrapperPrivate::extract(const QString &dirPath, const quint64 tot
         timer.stop();
         return (workerStatus() == ExtractWorker::Success);
     }
-    return m_archive.extract(dirPath, total);
+    return m_archive.extract(dirPath, totalFiles);
 }
 
 /*!
@@ -210,6 +211,15 @@ void LibArchiveWrapperPrivate::setCompressionLevel(const AbstractArchive::Compre
     m_archive.setCompressionLevel(level);
 }
 
+/*!
+    Sets the \a preparer to be called for each file entry before it is written
+    to disk. The preparer is used only when the archive is extracted locally.
+*/
+void LibArchiveWrapperPrivate::setFilePreparer(ArchiveFilePreparer *preparer)
+{
+    m_archive.setFilePreparer(preparer);
+}
+
 /*!
     Cancels the extract operation in progress.
 
@@ -60,6 +60,7 @@ public:
     bool isSupported();
 
     void setCompressionLevel(const AbstractArchive::CompressionLevel level);
+    void setFilePreparer(ArchiveFilePreparer *preparer);
 
 Q_SIGNALS:
     void currentEntryChanged(const QString &filename);
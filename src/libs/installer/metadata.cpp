@@ -29,12 +29,13 @@
 #include "metadata.h"
 
 #include "constants.h"
+#include "filehasher.h"
 #include "globals.h"
 #include "metadatajob.h"
+#include "updatesinfo_p.h"
 
 #include <QCryptographicHash>
 #include <QDir>
-#include <QDomDocument>
 #include <QFile>
 #include <QByteArrayMatcher>
 
@@ -78,9 +79,7 @@ QByteArray Metadata::checksum() const
     if (!updateFile.open(QIODevice::ReadOnly))
         return QByteArray();
 
-    QCryptographicHash hash(QCryptographicHash::Sha1);
-    hash.addData(&updateFile);
-    m_checksum = hash.result().toHex();
+    m_checksum = FileHasher::hash(&updateFile, QCryptographicHash::Sha1).toHex();
 
     return m_checksum;
 }
@@ -96,29 +95,70 @@ void Metadata::setChecksum(const QByteArray &checksum)
 }
 
 /*!
-    Returns the root of the document tree representing the \c Updates.xml
-    document of this metadata. Returns an empty \c QDomDocument in case
-    of failure to reading the file.
+    Reads the \c Updates.xml document of this metadata into \a updates. Returns
+    \c true on success, otherwise returns \c false and sets \a errorString.
+
+    \sa readUpdates(QIODevice *, UpdatesRecord *, QString *)
 */
-QDomDocument Metadata::updatesDocument() const
+bool Metadata::readUpdates(UpdatesRecord *updates, QString *errorString) const
 {
     QFile updateFile(path() + QLatin1String("/Updates.xml"));
     if (!updateFile.open(QIODevice::ReadOnly)) {
-        qCWarning(QInstaller::lcInstallerInstallLog)
-            << "Cannot open" << updateFile.fileName()
-            << "for reading:" << updateFile.errorString();
-        return QDomDocument();
+        if (errorString) {
+            *errorString = QString::fromLatin1("Cannot open %1 for reading: %2")
+                .arg(updateFile.fileName(), updateFile.errorString());
+        }
+        return false;
     }
+    return readUpdates(&updateFile, updates, errorString);
+}
 
-    QDomDocument doc;
-    QString errorString;
-    if (!doc.setContent(&updateFile, &errorString)) {
-        qCWarning(QInstaller::lcInstallerInstallLog)
-            << "Cannot set document content:" << errorString;
-        return QDomDocument();
+/*!
+    Reads the \c Updates.xml document from \a device into \a updates with a
+    streaming parser. Only the parts needed for fetching the metadata are kept: the
+    checksum settings, the unified metadata archive, a compact record of each package
+    and the repository update actions. Returns \c true on success, otherwise returns
+    \c false and sets \a errorString.
+*/
+bool Metadata::readUpdates(QIODevice *device, UpdatesRecord *updates, QString *errorString)
+{
+    Q_ASSERT(updates);
+
+    KDUpdater::UpdatesInfo updatesInfo;
+    updatesInfo.parseRecords(device, updates);
+    if (!updatesInfo.isValid()) {
+        if (errorString)
+            *errorString = updatesInfo.errorString();
+        return false;
     }
+    return true;
+}
 
-    return doc;
+/*!
+    Creates a binary index of the \c Updates.xml document of this metadata, unless
+    an up to date index exists already. The package information is read from the index
+    instead of the XML document on later runs. Returns \c true on success, \c false
+    otherwise.
+*/
+bool Metadata::createUpdatesIndex() const
+{
+    const QString updateFile(path() + QLatin1String("/Updates.xml"));
+    if (KDUpdater::UpdatesInfo::hasValidIndex(updateFile))
+        return true;
+
+    KDUpdater::UpdatesInfo updatesInfo;
+    updatesInfo.setFileName(updateFile);
+    updatesInfo.parseFile();
+    if (!updatesInfo.isValid()) {
+        qCWarning(QInstaller::lcInstallerInstallLog) << "Cannot create index for" << updateFile
+            << ":" << updatesInfo.errorString();
+        return false;
+    }
+    if (!updatesInfo.writeIndex()) {
+        qCWarning(QInstaller::lcInstallerInstallLog) << "Cannot write index for" << updateFile;
+        return false;
+    }
+    return true;
 }
 
 /*!
@@ -30,8 +30,10 @@
 #define METADATA_H
 
 #include "installer_global.h"
+#include "constants.h"
 #include "genericdatacache.h"
 #include "repository.h"
+#include "updatesinfo_p.h"
 
 #include <QDomDocument>
 
@@ -40,13 +42,19 @@ namespace QInstaller {
 class INSTALLER_EXPORT Metadata : public CacheableItem
 {
 public:
+    typedef KDUpdater::PackageRecord PackageRecord;
+    typedef KDUpdater::RepositoryAction RepositoryAction;
+    typedef KDUpdater::UpdatesRecord UpdatesRecord;
+
     Metadata();
     explicit Metadata(const QString &path);
     ~Metadata() {}
 
     QByteArray checksum() const override;
     void setChecksum(const QByteArray &checksum);
-    QDomDocument updatesDocument() const;
+    bool createUpdatesIndex() const;
+    bool readUpdates(UpdatesRecord *updates, QString *errorString = nullptr) const;
+    static bool readUpdates(QIODevice *device, UpdatesRecord *updates, QString *errorString = nullptr);
 
     bool isValid() const override;
     bool isActive() const override;
@@ -71,13 +79,6 @@ private:
     bool m_fromDefaultRepository;
 };
 
-Q_GLOBAL_STATIC_WITH_ARGS(QStringList, scMetaElements, (QStringList(
-    QLatin1String("Script")) <<
-    QLatin1String("Licenses") <<
-    QLatin1String("UserInterfaces") <<
-    QLatin1String("Translations")
-));
-
 } // namespace QInstaller
 
 #endif // METADATA_H
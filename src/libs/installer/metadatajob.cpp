@@ -28,6 +28,7 @@
 #include "metadatajob.h"
 
 #include "metadatajob_p.h"
+#include "filehasher.h"
 #include "packagemanagercore.h"
 #include "packagemanagerproxyfactory.h"
 #include "productkeycheck.h"
@@ -88,6 +89,7 @@ MetadataJob::MetadataJob(QObject *parent)
     , m_downloadableChunkSize(1000)
     , m_taskNumber(0)
     , m_defaultRepositoriesFetched(false)
+    , m_metadataTaskRunning(false)
 {
     QByteArray downloadableChunkSize = qgetenv("IFW_METADATA_SIZE");
     if (!downloadableChunkSize.isEmpty()) {
@@ -224,7 +226,7 @@ void MetadataJob::doStart()
 {
     setError(Job::NoError);
     setErrorString(QString());
-    m_metadataResult.clear();
+    m_metadataTaskRunning = false;
     setProgressTotalAmount(100);
 
     if (!m_core) {
@@ -586,7 +588,8 @@ void MetadataJob::unzipTaskFinished()
     m_unzipTasks.remove(watcher);
     delete watcher;
 
-    if (m_unzipTasks.isEmpty())
+    // Wait for the remaining chunks of meta information to be fetched and extracted
+    if (m_unzipTasks.isEmpty() && !m_metadataTaskRunning)
         startUpdateCacheTask();
 }
 
@@ -604,45 +607,55 @@ void MetadataJob::metadataTaskFinished()
 {
     try {
         m_metadataTask.waitForFinished();
-        m_metadataResult.append(m_metadataTask.future().results());
-        if (!fetchMetaDataPackages()) {
-            if (m_metadataResult.count() > 0) {
-                emit infoMessage(this, tr("Extracting meta information..."));
-                foreach (const FileTaskResult &result, m_metadataResult) {
-                    const FileTaskItem item = result.value(TaskRole::TaskItem).value<FileTaskItem>();
-                    if (result.value(TaskRole::ChecksumMismatch).toBool()) {
-                        QString mismatchMessage = tr("Checksum mismatch detected for \"%1\".")
-                                .arg(item.value(TaskRole::SourceFile).toString());
-                        if (m_core->settings().allowUnstableComponents()) {
-                            m_shaMissmatchPackages.append(item.value(TaskRole::Name).toString());
-                            qCWarning(QInstaller::lcInstallerInstallLog) << mismatchMessage;
-                        } else {
-                            throw QInstaller::TaskException(mismatchMessage);
-                        }
-                        QFileInfo fi(result.target());
-                        QString targetPath = fi.absolutePath();
-                        if (m_fetchedMetadata.contains(targetPath)) {
-                            delete m_fetchedMetadata.value(targetPath);
-                            m_fetchedMetadata.remove(targetPath);
-                        }
-                        continue;
-                    }
-                    UnzipArchiveTask *task = new UnzipArchiveTask(result.target(),
-                        item.value(TaskRole::UserRole).toString());
-                    task->setRemoveArchive(true);
-
-                    QFutureWatcher<void> *watcher = new QFutureWatcher<void>();
-                    m_unzipTasks.insert(watcher, qobject_cast<QObject*> (task));
-                    connect(watcher, &QFutureWatcherBase::finished, this, &MetadataJob::unzipTaskFinished);
-                    watcher->setFuture(QtConcurrent::run(&UnzipArchiveTask::doTask, task));
+        m_metadataTaskRunning = false;
+        if (error() != Job::NoError)
+            return; // extracting a previous chunk failed
+
+        // Extract the archives of each downloaded chunk right away, while the next chunk is
+        // fetched. This way archives kept in memory do not pile up until all chunks are done.
+        const QList<FileTaskResult> results = m_metadataTask.future().results();
+        if (!results.isEmpty())
+            emit infoMessage(this, tr("Extracting meta information..."));
+
+        foreach (const FileTaskResult &result, results) {
+            const FileTaskItem item = result.value(TaskRole::TaskItem).value<FileTaskItem>();
+            if (result.value(TaskRole::ChecksumMismatch).toBool()) {
+                QString mismatchMessage = tr("Checksum mismatch detected for \"%1\".")
+                        .arg(item.value(TaskRole::SourceFile).toString());
+                if (m_core->settings().allowUnstableComponents()) {
+                    m_shaMissmatchPackages.append(item.value(TaskRole::Name).toString());
+                    qCWarning(QInstaller::lcInstallerInstallLog) << mismatchMessage;
+                } else {
+                    throw QInstaller::TaskException(mismatchMessage);
+                }
+                QFileInfo fi(result.target());
+                QString targetPath = fi.absolutePath();
+                if (m_fetchedMetadata.contains(targetPath)) {
+                    delete m_fetchedMetadata.value(targetPath);
+                    m_fetchedMetadata.remove(targetPath);
                 }
-                if (m_unzipTasks.isEmpty())
-                    startUpdateCacheTask();
+                continue;
+            }
 
+            UnzipArchiveTask *task = nullptr;
+            if (result.contains(TaskRole::Content)) {
+                task = new UnzipArchiveTask(result.target(),
+                    result.value(TaskRole::Content).toByteArray(),
+                    item.value(TaskRole::UserRole).toString());
             } else {
-                startUpdateCacheTask();
+                task = new UnzipArchiveTask(result.target(),
+                    item.value(TaskRole::UserRole).toString());
+                task->setRemoveArchive(true);
             }
+
+            QFutureWatcher<void> *watcher = new QFutureWatcher<void>();
+            m_unzipTasks.insert(watcher, qobject_cast<QObject*> (task));
+            connect(watcher, &QFutureWatcherBase::finished, this, &MetadataJob::unzipTaskFinished);
+            watcher->setFuture(QtConcurrent::run(&UnzipArchiveTask::doTask, task));
         }
+
+        if (!fetchMetaDataPackages() && m_unzipTasks.isEmpty())
+            startUpdateCacheTask();
     } catch (const TaskException &e) {
         reset();
         emitFinishedWithError(QInstaller::DownloadError, e.message());
@@ -688,6 +701,7 @@ bool MetadataJob::fetchMetaDataPackages()
         setProcessedAmount(0);
         DownloadFileTask *const metadataTask = new DownloadFileTask(tempPackages);
         metadataTask->setProxyFactory(m_core->proxyFactory());
+        m_metadataTaskRunning = true;
         m_metadataTask.setFuture(QtConcurrent::run(&DownloadFileTask::doTask, metadataTask));
         QString metaInformation;
         if (m_totalTaskCount > 1)
@@ -720,7 +734,7 @@ void MetadataJob::reset()
         m_metadataTask.waitForFinished();
     } catch (...) {}
     m_tempDirDeleter.releaseAndDeleteAll();
-    m_metadataResult.clear();
+    m_metadataTaskRunning = false;
     m_taskNumber = 0;
 }
 
@@ -771,10 +785,10 @@ MetadataJob::Status MetadataJob::parseUpdatesXml(const QList<FileTaskResult> &re
         }
         const FileTaskItem item = result.value(TaskRole::TaskItem).value<FileTaskItem>();
 
-        // Check if we have cached the metadata for this repository already
-        QCryptographicHash hash(QCryptographicHash::Sha1);
-        hash.addData(&file);
-        const QByteArray updatesChecksum = hash.result().toHex();
+        // Check if we have cached the metadata for this repository already. The download
+        // already hashed the file while writing it, only hash local files again.
+        const QByteArray updatesChecksum = result.checkSum().isEmpty()
+            ? FileHasher::hash(&file, QCryptographicHash::Sha1).toHex() : result.checkSum().toHex();
 
         bool refreshed;
         Status status = refreshCacheItem(result, updatesChecksum, &refreshed);
@@ -789,8 +803,8 @@ MetadataJob::Status MetadataJob::parseUpdatesXml(const QList<FileTaskResult> &re
         file.seek(0);
 
         QString error;
-        QDomDocument doc;
-        if (!doc.setContent(&file, &error)) {
+        Metadata::UpdatesRecord updates;
+        if (!Metadata::readUpdates(&file, &updates, &error)) {
             qCWarning(QInstaller::lcInstallerInstallLog).nospace() << "Cannot fetch a valid version of Updates.xml from repository "
                                << metadata->repository().displayname() << ": " << error;
             //If there are other repositories, try to use those
@@ -800,47 +814,31 @@ MetadataJob::Status MetadataJob::parseUpdatesXml(const QList<FileTaskResult> &re
 
         metadata->setRepository(item.value(TaskRole::UserRole).value<Repository>());
         const bool online = !(metadata->repository().url().scheme()).isEmpty();
-
-        bool testCheckSum = true;
-        const QDomElement root = doc.documentElement();
-        const QDomNode checksum = root.firstChildElement(QLatin1String("Checksum"));
-        if (!checksum.isNull())
-            testCheckSum = (checksum.toElement().text().toLower() == scTrue);
+        const bool testCheckSum = updates.checksum;
 
         // If we have top level sha1 and MetadataName elements, we have compressed
         // all metadata inside one repository to a single 7z file. Fetch that
         // instead of component specific meta 7z files.
-        const QDomNode sha1 = root.firstChildElement(scSHA1);
-        QDomElement metadataNameElement = root.firstChildElement(scMetadataName);
-        QDomNodeList children = root.childNodes();
-        if (!sha1.isNull() && !metadataNameElement.isNull()) {
+        if (!updates.sha1.isEmpty() && !updates.metadataName.isEmpty()) {
             const QString repoUrl = metadata->repository().url().toString();
-            const QString metadataName = metadataNameElement.toElement().text();
-            addFileTaskItem(QString::fromLatin1("%1/%2").arg(repoUrl, metadataName),
-                metadata->path() + QString::fromLatin1("/%1").arg(metadataName),
-                metadata.get(), sha1.toElement().text(), QString());
+            addFileTaskItem(QString::fromLatin1("%1/%2").arg(repoUrl, updates.metadataName),
+                metadata->path() + QString::fromLatin1("/%1").arg(updates.metadataName),
+                metadata.get(), updates.sha1, QString());
         } else {
-            bool metaFound = false;
-            for (int i = 0; i < children.count(); ++i) {
-                const QDomElement el = children.at(i).toElement();
-                if (!el.isNull() && el.tagName() == QLatin1String("PackageUpdate")) {
-                    const QDomNodeList c2 = el.childNodes();
-                    QString packageName, packageVersion, packageHash;
-                    metaFound = parsePackageUpdate(c2, packageName, packageVersion, packageHash,
-                                                   online, testCheckSum);
-
-                    // If meta element (script, licenses, etc.) is not found, no need to fetch metadata.
-                    if (metaFound) {
-                        const QString repoUrl = metadata->repository().url().toString();
-                        addFileTaskItem(QString::fromLatin1("%1/%2/%3meta.7z").arg(repoUrl, packageName, packageVersion),
-                            metadata->path() + QString::fromLatin1("/%1-%2-meta.7z").arg(packageName, packageVersion),
-                            metadata.get(), packageHash, packageName);
-                    } else {
-                        QString fileName = metadata->path() + QLatin1Char('/') + packageName;
-                        QDir directory(fileName);
-                        if (!directory.exists()) {
-                            directory.mkdir(fileName);
-                        }
+            for (const Metadata::PackageRecord &package : qAsConst(updates.packages)) {
+                // If meta element (script, licenses, etc.) is not found, no need to fetch metadata.
+                if (package.hasMetaElements) {
+                    const QString repoUrl = metadata->repository().url().toString();
+                    const QString packageVersion = online ? package.version : QString();
+                    const QString packageHash = testCheckSum ? package.sha1 : QString();
+                    addFileTaskItem(QString::fromLatin1("%1/%2/%3meta.7z").arg(repoUrl, package.name, packageVersion),
+                        metadata->path() + QString::fromLatin1("/%1-%2-meta.7z").arg(package.name, packageVersion),
+                        metadata.get(), packageHash, package.name);
+                } else {
+                    QString fileName = metadata->path() + QLatin1Char('/') + package.name;
+                    QDir directory(fileName);
+                    if (!directory.exists()) {
+                        directory.mkdir(fileName);
                     }
                 }
             }
@@ -858,7 +856,7 @@ MetadataJob::Status MetadataJob::parseUpdatesXml(const QList<FileTaskResult> &re
         m_fetchedMetadata.insert(metadataPath, metadata.take());
 
         // search for additional repositories that we might need to check
-        status = parseRepositoryUpdates(root, result, metadataPtr);
+        status = parseRepositoryUpdates(updates, result, metadataPtr);
         if (status == XmlDownloadRetry) {
             // The repository update may have removed or replaced current repositories,
             // clear repository information from cached items and refresh on next fetch run.
@@ -900,13 +898,19 @@ MetadataJob::Status MetadataJob::refreshCacheItem(const FileTaskResult &result,
 
         // search for additional repositories that we might need to check
         if (cachedMetadata->containsRepositoryUpdates()) {
-            QDomDocument doc = cachedMetadata->updatesDocument();
-            const Status status = parseRepositoryUpdates(doc.documentElement(), result, cachedMetadata);
-            if (status == XmlDownloadRetry) {
-                // The repository update may have removed or replaced current repositories,
-                // clear repository information from cached items and refresh on next fetch run.
-                resetCacheRepositories();
-                return status;
+            Metadata::UpdatesRecord updates;
+            QString error;
+            if (cachedMetadata->readUpdates(&updates, &error)) {
+                const Status status = parseRepositoryUpdates(updates, result, cachedMetadata);
+                if (status == XmlDownloadRetry) {
+                    // The repository update may have removed or replaced current repositories,
+                    // clear repository information from cached items and refresh on next fetch run.
+                    resetCacheRepositories();
+                    return status;
+                }
+            } else {
+                qCWarning(lcInstallerInstallLog).noquote() << "Cannot read repository updates of "
+                    "cached metadata" << cachedMetadata->path() << ":" << error;
             }
         }
         *refreshed = true;
@@ -947,14 +951,13 @@ MetadataJob::Status MetadataJob::findCachedUpdatesFile(const Repository &reposit
         return XmlDownloadFailure;
 }
 
-MetadataJob::Status MetadataJob::parseRepositoryUpdates(const QDomElement &root,
+MetadataJob::Status MetadataJob::parseRepositoryUpdates(const Metadata::UpdatesRecord &updates,
     const FileTaskResult &result, Metadata *metadata)
 {
     MetadataJob::Status status = XmlDownloadSuccess;
-    const QDomNode repositoryUpdate = root.firstChildElement(QLatin1String("RepositoryUpdate"));
-    if (!repositoryUpdate.isNull()) {
+    if (!updates.repositoryActions.isEmpty()) {
         const QMultiHash<QString, QPair<Repository, Repository> > repositoryUpdates
-            = searchAdditionalRepositories(repositoryUpdate, result, *metadata);
+            = searchAdditionalRepositories(updates.repositoryActions, result, *metadata);
         if (!repositoryUpdates.isEmpty())
             status = setAdditionalRepositories(repositoryUpdates, result, *metadata);
     }
@@ -998,78 +1001,53 @@ void MetadataJob::addFileTaskItem(const QString &source, const QString &target,
     item.insert(TaskRole::Checksum, sha1.toLatin1());
     item.insert(TaskRole::Authenticator, QVariant::fromValue(authenticator));
     item.insert(TaskRole::Name, packageName);
+    // The archive is only needed for extracting it into the cache, so do not write it to disk.
+    item.insert(TaskRole::KeepInMemory, UnzipArchiveTask::canExtractFromMemory());
     m_packages.append(item);
 }
 
-bool MetadataJob::parsePackageUpdate(const QDomNodeList &c2, QString &packageName,
-                                    QString &packageVersion, QString &packageHash,
-                                    bool online, bool testCheckSum)
-{
-    bool metaFound = false;
-    for (int j = 0; j < c2.count(); ++j) {
-        const QDomElement element = c2.at(j).toElement();
-        if (element.tagName() == scName)
-            packageName = element.text();
-        else if (element.tagName() == scVersion)
-            packageVersion = (online ? element.text() : QString());
-        else if ((element.tagName() == QLatin1String("SHA1")) && testCheckSum)
-            packageHash = element.text();
-        else {
-            foreach (QString meta, *scMetaElements) {
-                if (element.tagName() == meta) {
-                    metaFound = true;
-                    break;
-                }
-            }
-        }
-    }
-    return metaFound;
-}
-
 QMultiHash<QString, QPair<Repository, Repository> > MetadataJob::searchAdditionalRepositories
-    (const QDomNode &repositoryUpdate, const FileTaskResult &result, const Metadata &metadata)
+    (const QVector<Metadata::RepositoryAction> &repositoryActions, const FileTaskResult &result,
+     const Metadata &metadata)
 {
     QMultiHash<QString, QPair<Repository, Repository> > repositoryUpdates;
-    const QDomNodeList children = repositoryUpdate.toElement().childNodes();
-    for (int i = 0; i < children.count(); ++i) {
-        const QDomElement el = children.at(i).toElement();
-        if (!el.isNull() && el.tagName() == QLatin1String("Repository")) {
-            const QString action = el.attribute(QLatin1String("action"));
-            if (action == QLatin1String("add")) {
-                // add a new repository to the defaults list
-                Repository repository(resolveUrl(result, el.attribute(QLatin1String("url"))), true);
-                repository.setUsername(el.attribute(QLatin1String("username")));
-                repository.setPassword(el.attribute(QLatin1String("password")));
-                repository.setDisplayName(el.attribute(QLatin1String("displayname")));
-                if (ProductKeyCheck::instance()->isValidRepository(repository)) {
-                    repositoryUpdates.insert(action, qMakePair(repository, Repository()));
-                    qDebug() << "Repository to add:" << repository.displayname();
-                }
-            } else if (action == QLatin1String("remove")) {
-                // remove possible default repositories using the given server url
-                Repository repository(resolveUrl(result, el.attribute(QLatin1String("url"))), true);
-                repository.setDisplayName(el.attribute(QLatin1String("displayname")));
+    for (const Metadata::RepositoryAction &repositoryAction : repositoryActions) {
+        const QXmlStreamAttributes &attributes = repositoryAction.attributes;
+        const QString action = attributes.value(QLatin1String("action")).toString();
+        if (action == QLatin1String("add")) {
+            // add a new repository to the defaults list
+            Repository repository(resolveUrl(result, attributes.value(QLatin1String("url")).toString()), true);
+            repository.setUsername(attributes.value(QLatin1String("username")).toString());
+            repository.setPassword(attributes.value(QLatin1String("password")).toString());
+            repository.setDisplayName(attributes.value(QLatin1String("displayname")).toString());
+            if (ProductKeyCheck::instance()->isValidRepository(repository)) {
                 repositoryUpdates.insert(action, qMakePair(repository, Repository()));
-
-                qDebug() << "Repository to remove:" << repository.displayname();
-            } else if (action == QLatin1String("replace")) {
-                // replace possible default repositories using the given server url
-                Repository oldRepository(resolveUrl(result, el.attribute(QLatin1String("oldUrl"))), true);
-                Repository newRepository(resolveUrl(result, el.attribute(QLatin1String("newUrl"))), true);
-                newRepository.setUsername(el.attribute(QLatin1String("username")));
-                newRepository.setPassword(el.attribute(QLatin1String("password")));
-                newRepository.setDisplayName(el.attribute(QLatin1String("displayname")));
-
-                if (ProductKeyCheck::instance()->isValidRepository(newRepository)) {
-                    // store the new repository and the one old it replaces
-                    repositoryUpdates.insert(action, qMakePair(newRepository, oldRepository));
-                    qDebug() << "Replace repository" << oldRepository.displayname() << "with"
-                        << newRepository.displayname();
-                }
-            } else {
-                qDebug() << "Invalid additional repositories action set in Updates.xml fetched "
-                    "from" << metadata.repository().displayname() << "line:" << el.lineNumber();
+                qDebug() << "Repository to add:" << repository.displayname();
+            }
+        } else if (action == QLatin1String("remove")) {
+            // remove possible default repositories using the given server url
+            Repository repository(resolveUrl(result, attributes.value(QLatin1String("url")).toString()), true);
+            repository.setDisplayName(attributes.value(QLatin1String("displayname")).toString());
+            repositoryUpdates.insert(action, qMakePair(repository, Repository()));
+
+            qDebug() << "Repository to remove:" << repository.displayname();
+        } else if (action == QLatin1String("replace")) {
+            // replace possible default repositories using the given server url
+            Repository oldRepository(resolveUrl(result, attributes.value(QLatin1String("oldUrl")).toString()), true);
+            Repository newRepository(resolveUrl(result, attributes.value(QLatin1String("newUrl")).toString()), true);
+            newRepository.setUsername(attributes.value(QLatin1String("username")).toString());
+            newRepository.setPassword(attributes.value(QLatin1String("password")).toString());
+            newRepository.setDisplayName(attributes.value(QLatin1String("displayname")).toString());
+
+            if (ProductKeyCheck::instance()->isValidRepository(newRepository)) {
+                // store the new repository and the one old it replaces
+                repositoryUpdates.insert(action, qMakePair(newRepository, oldRepository));
+                qDebug() << "Replace repository" << oldRepository.displayname() << "with"
+                    << newRepository.displayname();
             }
+        } else {
+            qDebug() << "Invalid additional repositories action set in Updates.xml fetched "
+                "from" << metadata.repository().displayname() << "line:" << repositoryAction.lineNumber;
         }
     }
     return repositoryUpdates;
@@ -38,9 +38,6 @@
 
 #include <QFutureWatcher>
 
-class QDomNodeList;
-class QDomNode;
-
 namespace QInstaller {
 
 class PackageManagerCore;
@@ -98,13 +95,13 @@ private:
     Status parseUpdatesXml(const QList<FileTaskResult> &results);
     Status refreshCacheItem(const FileTaskResult &result, const QByteArray &checksum, bool *refreshed);
     Status findCachedUpdatesFile(const Repository &repository, const QString &fileUrl);
-    Status parseRepositoryUpdates(const QDomElement &root, const FileTaskResult &result, Metadata *metadata);
+    Status parseRepositoryUpdates(const Metadata::UpdatesRecord &updates, const FileTaskResult &result,
+                                  Metadata *metadata);
     QSet<Repository> getRepositories();
     void addFileTaskItem(const QString &source, const QString &target, Metadata *metadata,
                          const QString &sha1, const QString &packageName);
-    static bool parsePackageUpdate(const QDomNodeList &c2, QString &packageName, QString &packageVersion,
-                            QString &packageHash, bool online, bool testCheckSum);
-    QMultiHash<QString, QPair<Repository, Repository> > searchAdditionalRepositories(const QDomNode &repositoryUpdate,
+    QMultiHash<QString, QPair<Repository, Repository> > searchAdditionalRepositories(
+                            const QVector<Metadata::RepositoryAction> &repositoryActions,
                             const FileTaskResult &result, const Metadata &metadata);
     MetadataJob::Status setAdditionalRepositories(QMultiHash<QString, QPair<Repository, Repository> > repositoryUpdates,
                             const FileTaskResult &result, const Metadata& metadata);
@@ -124,12 +121,12 @@ private:
     QHash<QFutureWatcher<void> *, QObject*> m_unzipRepositoryTasks;
     DownloadType m_downloadType;
     QList<FileTaskItem> m_unzipRepositoryitems;
-    QList<FileTaskResult> m_metadataResult;
     int m_downloadableChunkSize;
     int m_taskNumber;
     int m_totalTaskCount;
     QStringList m_shaMissmatchPackages;
     bool m_defaultRepositoriesFetched;
+    bool m_metadataTaskRunning;
 
     QSet<Repository> m_fetchedCategorizedRepositories;
     QHash<QString, Metadata *> m_fetchedMetadata;
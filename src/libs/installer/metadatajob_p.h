@@ -31,6 +31,9 @@
 
 #include "archivefactory.h"
 #include "metadatajob.h"
+#ifdef IFW_LIBARCHIVE
+#include "libarchivearchive.h"
+#endif
 
 #include <QCryptographicHash>
 #include <QDir>
@@ -64,6 +67,17 @@ public:
     UnzipArchiveTask(const QString &arcive, const QString &target)
         : m_archive(arcive), m_targetDir(target), m_removeArchive(false)
     {}
+    UnzipArchiveTask(const QString &arcive, const QByteArray &data, const QString &target)
+        : m_archive(arcive), m_data(data), m_targetDir(target), m_removeArchive(false)
+    {}
+    static bool canExtractFromMemory()
+    {
+#ifdef IFW_LIBARCHIVE
+        return true;
+#else
+        return false;
+#endif
+    }
     QString target() { return m_targetDir; }
     QString archive() { return m_archive; }
     void setRemoveArchive(bool remove) { m_removeArchive = remove; }
@@ -78,7 +92,18 @@ public:
             return; // ignore already canceled
         }
 
-        QScopedPointer<AbstractArchive> archive(ArchiveFactory::instance().create(m_archive));
+        QScopedPointer<AbstractArchive> archive;
+#ifdef IFW_LIBARCHIVE
+        if (!m_data.isNull()) {
+            // Extract the downloaded data directly, without a temporary archive file
+            LibArchiveArchive *const memoryArchive = new LibArchiveArchive(m_archive);
+            memoryArchive->setData(m_data);
+            archive.reset(memoryArchive);
+        }
+#endif
+        if (!archive)
+            archive.reset(ArchiveFactory::instance().create(m_archive));
+
         if (!archive) {
             fi.reportException(UnzipArchiveException(MetadataJob::tr("Unsupported archive \"%1\": no handler "
                 "registered for file suffix \"%2\".").arg(m_archive, QFileInfo(m_archive).suffix())));
@@ -99,6 +124,7 @@ public:
 
 private:
     QString m_archive;
+    QByteArray m_data;
     QString m_targetDir;
     bool m_removeArchive;
 };
@@ -165,6 +191,11 @@ public:
         for (auto *meta : obsolete)
             m_cache->removeItem(meta->checksum());
 
+        // Package information is read from binary indexes on later runs
+        const QList<Metadata *> cached = m_cache->items();
+        for (auto *meta : cached)
+            meta->createUpdatesIndex();
+
         if (!m_cache->sync()) {
             fi.reportException(CacheTaskException(m_cache->errorString() + u' '
                 + MetadataJob::tr("Clearing the cache directory and restarting the application may solve this.")));
@@ -46,6 +46,7 @@
 #include "installercalculator.h"
 #include "uninstallercalculator.h"
 #include "loggingutils.h"
+#include "packagequery.h"
 
 #include <productkeycheck.h>
 
@@ -459,6 +460,79 @@ static bool sNoDefaultInstallation = false;
 static bool sVirtualComponentsVisible = false;
 static bool sCreateLocalRepositoryFromBinary = false;
 static int sMaxConcurrentOperations = 0;
+static int sMaxConcurrentDownloads = 0;
+static int sMaxConcurrentDownloadsPerHost = 0;
+static bool sPipelinedInstallation = false;
+
+namespace {
+
+// A version requirement like ">=1.0", split into its comparator and the key of the version.
+struct VersionRequirement
+{
+    bool allowEqual = true;
+    bool allowLess = false;
+    bool allowMore = false;
+    KDUpdater::VersionKey version;
+
+    bool matches(const KDUpdater::VersionKey &other) const
+    {
+        if (allowEqual && other.toString() == version.toString())
+            return true;
+
+        if (!allowLess && !allowMore)
+            return false;
+
+        const int result = KDUpdater::compareVersion(version, other);
+        if (allowLess && result > 0)
+            return true;
+
+        if (allowMore && result < 0)
+            return true;
+
+        return false;
+    }
+};
+
+} // namespace
+
+typedef QHash<QString, VersionRequirement> VersionRequirementHash;
+Q_GLOBAL_STATIC(VersionRequirementHash, globalVersionRequirements);
+Q_GLOBAL_STATIC(QMutex, globalVersionRequirementsMutex);
+// Keeps the cache bounded if scripts pass arbitrary requirements to versionMatches().
+static const int scMaxCachedVersionRequirements = 4096;
+
+/*
+    Returns the parsed \a requirement. The same requirements are checked over and over again
+    while resolving dependencies, so each distinct one is only parsed once.
+*/
+static VersionRequirement versionRequirement(const QString &requirement)
+{
+    QMutexLocker _(globalVersionRequirementsMutex());
+    VersionRequirementHash *const requirements = globalVersionRequirements();
+    const VersionRequirementHash::const_iterator it = requirements->constFind(requirement);
+    if (it != requirements->constEnd())
+        return it.value();
+
+    static const QRegularExpression compEx(QLatin1String("^([<=>]+)(.*)$"));
+    const QRegularExpressionMatch match = compEx.match(requirement);
+    const QString comparator = match.hasMatch() ? match.captured(1) : QLatin1String("=");
+
+    VersionRequirement parsed;
+    parsed.allowEqual = comparator.contains(QLatin1Char('='));
+    parsed.allowLess = comparator.contains(QLatin1Char('<'));
+    parsed.allowMore = comparator.contains(QLatin1Char('>'));
+    parsed.version = KDUpdater::VersionKey(match.hasMatch() ? match.captured(2) : requirement);
+
+    if (requirements->size() >= scMaxCachedVersionRequirements)
+        requirements->clear();
+    requirements->insert(requirement, parsed);
+    return parsed;
+}
+
+static bool versionKeyMatches(const KDUpdater::VersionKey &version, const QString &requirement)
+{
+    return versionRequirement(requirement).matches(version);
+}
 
 static bool componentMatches(const Component *component, const QString &name,
     const QString &version = QString())
@@ -470,7 +544,7 @@ static bool componentMatches(const Component *component, const QString &name,
         return true;
 
     // can be remote or local version
-    return PackageManagerCore::versionMatches(component->value(scVersion), version);
+    return versionKeyMatches(component->versionKey(), version);
 }
 
 /*!
@@ -590,6 +664,7 @@ bool PackageManagerCore::resetLocalCache(bool init)
 */
 bool PackageManagerCore::clearLocalCache(QString *error)
 {
+    QFile::remove(d->validatedComponentTreeFile());
     if (d->m_metadataJob.clearCache())
         return true;
 
@@ -815,15 +890,7 @@ int PackageManagerCore::downloadNeededArchives(double partProgressSize)
     QList<Component*> neededComponents = orderedComponentsToInstall();
     foreach (Component *component, neededComponents) {
         // collect all archives to be downloaded
-        const QStringList toDownload = component->downloadableArchives();
-        bool checkSha1CheckSum = (component->value(scCheckSha1CheckSum).toLower() == scTrue);
-        foreach (const QString &versionFreeString, toDownload) {
-            DownloadItem item;
-            item.checkSha1CheckSum = checkSha1CheckSum;
-            item.fileName = scInstallerPrefixWithTwoArgs.arg(component->name(), versionFreeString);
-            item.sourceUrl = scThreeArgs.arg(component->repositoryUrl().toString(), component->name(), versionFreeString);
-            archivesToDownload.push_back(item);
-        }
+        archivesToDownload.append(d->archivesToDownload(component));
         archivesToDownloadTotalSize += component->value(scCompressedSize).toULongLong();
     }
 
@@ -837,19 +904,7 @@ int PackageManagerCore::downloadNeededArchives(double partProgressSize)
     archivesJob.setAutoDelete(false);
     archivesJob.setArchivesToDownload(archivesToDownload);
     archivesJob.setExpectedTotalSize(archivesToDownloadTotalSize);
-    connect(this, &PackageManagerCore::installationInterrupted, &archivesJob, &Job::cancel);
-    connect(&archivesJob, &DownloadArchivesJob::outputTextChanged,
-            ProgressCoordinator::instance(), &ProgressCoordinator::emitLabelAndDetailTextChanged);
-    connect(&archivesJob, &DownloadArchivesJob::downloadStatusChanged,
-            ProgressCoordinator::instance(), &ProgressCoordinator::additionalProgressStatusChanged);
-
-    connect(&archivesJob, &DownloadArchivesJob::fileDownloadReady,
-            d, &PackageManagerCorePrivate::addPathForDeletion);
-    connect(&archivesJob, &DownloadArchivesJob::hashDownloadReady,
-            d, &PackageManagerCorePrivate::addPathForDeletion);
-
-    ProgressCoordinator::instance()->registerPartProgress(&archivesJob,
-        SIGNAL(progressChanged(double)), partProgressSize);
+    d->setupDownloadArchivesJob(&archivesJob, partProgressSize);
 
     archivesJob.start();
     archivesJob.waitForFinished();
@@ -956,11 +1011,16 @@ void PackageManagerCore::rollBackInstallation()
                 }
             }
 
-            d->m_localPackageHub->writeToDisk();
+            if (!d->m_localPackageHub->writeJournal()) {
+                qCWarning(QInstaller::lcInstallerInstallLog) << "Cannot write installation information journal"
+                    << d->m_localPackageHub->journalFileName();
+            }
             if (isInstaller() && d->m_localPackageHub->packageInfoCount() == 0) {
                 QFile file(d->m_localPackageHub->fileName());
-                if (!file.fileName().isEmpty() && file.exists())
+                if (!file.fileName().isEmpty() && file.exists()) {
                     file.remove();
+                    QFile::remove(d->m_localPackageHub->journalFileName());
+                }
             }
 
             if (becameAdmin)
@@ -1481,6 +1541,67 @@ void PackageManagerCore::setMaxConcurrentOperations(int count)
     sMaxConcurrentOperations = count;
 }
 
+/* static */
+/*!
+    Returns the maximum count of archives that should be downloaded
+    concurrently in the downloading phase of components.
+*/
+int PackageManagerCore::maxConcurrentDownloads()
+{
+    return sMaxConcurrentDownloads;
+}
+
+/* static */
+/*!
+    Sets the maximum \a count of archives that should be downloaded
+    concurrently. A value of \c 0 is synonym for the default count.
+*/
+void PackageManagerCore::setMaxConcurrentDownloads(int count)
+{
+    sMaxConcurrentDownloads = count;
+}
+
+/* static */
+/*!
+    Returns the maximum count of archives that should be downloaded
+    concurrently from a single host.
+*/
+int PackageManagerCore::maxConcurrentDownloadsPerHost()
+{
+    return sMaxConcurrentDownloadsPerHost;
+}
+
+/* static */
+/*!
+    Sets the maximum \a count of archives that should be downloaded
+    concurrently from a single host. A value of \c 0 means that the downloads
+    are limited only by maxConcurrentDownloads().
+*/
+void PackageManagerCore::setMaxConcurrentDownloadsPerHost(int count)
+{
+    sMaxConcurrentDownloadsPerHost = count;
+}
+
+/* static */
+/*!
+    Returns \c true if the archives of a component are unpacked as soon as they
+    are downloaded, instead of after all archives have been downloaded.
+*/
+bool PackageManagerCore::pipelinedInstallation()
+{
+    return sPipelinedInstallation;
+}
+
+/* static */
+/*!
+    Sets whether the download and unpacking phases of an installation should
+    overlap to \a pipelined.
+*/
+void PackageManagerCore::setPipelinedInstallation(bool pipelined)
+{
+    sPipelinedInstallation = pipelined;
+}
+
 /*!
     Returns \c true if the package manager is running and installed packages are
     found. Otherwise, returns \c false.
@@ -1976,6 +2097,7 @@ void PackageManagerCore::appendRootComponent(Component *component)
     // For normal installer runs components aren't appended after model reset
     if (Q_UNLIKELY(!d->m_componentByNameHash.isEmpty()))
         d->m_componentByNameHash.clear();
+    d->invalidateDependeeIndex();
 
     d->m_rootComponents.append(component);
     emit componentAdded(component);
@@ -2061,6 +2183,7 @@ void PackageManagerCore::appendUpdaterComponent(Component *component)
     // For normal installer runs components aren't appended after model reset
     if (Q_UNLIKELY(!d->m_componentByNameHash.isEmpty()))
         d->m_componentByNameHash.clear();
+    d->invalidateDependeeIndex();
 
     component->setUpdateAvailable(true);
     d->m_updaterComponents.append(component);
@@ -2181,9 +2304,21 @@ bool PackageManagerCore::calculateComponentsToInstall() const
     d->clearInstallerCalculator();
     const QList<Component*> selectedComponentsToInstall = componentsMarkedForInstallation();
 
-    const bool componentsToInstallCalculated =
+    bool componentsToInstallCalculated =
         d->installerCalculator()->solve(selectedComponentsToInstall);
 
+    // Scripts loaded on demand may add dependencies, solve again until every
+    // component to install has its script loaded.
+    bool scriptsLoaded = true;
+    while (d->loadPendingComponentScripts(d->installerCalculator()->resolvedComponents(),
+            &scriptsLoaded)) {
+        d->clearInstallerCalculator();
+        componentsToInstallCalculated = d->installerCalculator()->solve(componentsMarkedForInstallation());
+    }
+    // The result is incomplete if a script failed to load.
+    if (!scriptsLoaded)
+        componentsToInstallCalculated = false;
+
     d->updateComponentInstallActions();
 
     emit finishedCalculateComponentsToInstall();
@@ -2366,20 +2501,11 @@ QList<Component*> PackageManagerCore::dependees(const Component *_component) con
     if (!_component)
         return QList<Component *>();
 
-    const QList<QInstaller::Component *> availableComponents = components(ComponentType::All);
-    if (availableComponents.isEmpty())
-        return QList<Component *>();
-
     QList<Component *> dependees;
-    QString name;
-    QString version;
-    foreach (Component *component, availableComponents) {
-        const QStringList &dependencies = component->dependencies();
-        foreach (const QString &dependency, dependencies) {
-            parseNameAndVersion(dependency, &name, &version);
-            if (componentMatches(_component, name, version))
-                dependees.append(component);
-        }
+    const QList<QPair<Component *, QString> > candidates = d->componentDependees(_component->name());
+    for (const QPair<Component *, QString> &candidate : candidates) {
+        if (componentMatches(_component, _component->name(), candidate.second))
+            dependees.append(candidate.first);
     }
     return dependees;
 }
@@ -2393,29 +2519,17 @@ bool PackageManagerCore::isDependencyForRequestedComponent(const Component *comp
     if (!component)
         return false;
 
-    const QList<QInstaller::Component *> availableComponents = components(ComponentType::All);
-    if (availableComponents.isEmpty())
-        return false;
-
-    QString name;
-    QString version;
-    for (Component *availableComponent : availableComponents) {
-        if (!availableComponent) {
-            continue;
-        }
+    const QList<QPair<Component *, QString> > candidates = d->componentDependees(component->name());
+    for (const QPair<Component *, QString> &candidate : candidates) {
+        Component *availableComponent = candidate.first;
         // 1. In updater mode, component to be updated might have new dependencies
         // Check if the dependency is still needed
         // 2. If component is selected and not installed, check if the dependency is needed
         if (availableComponent->isSelected()
                 && ((isUpdater() && availableComponent->isInstalled())
                     || (isPackageManager() && !availableComponent->isInstalled()))) {
-            const QStringList &dependencies = availableComponent->dependencies();
-            foreach (const QString &dependency, dependencies) {
-                parseNameAndVersion(dependency, &name, &version);
-                if (componentMatches(component, name, version)) {
-                    return true;
-                }
-            }
+            if (componentMatches(component, component->name(), candidate.second))
+                return true;
         }
     }
     return false;
@@ -2431,17 +2545,10 @@ QStringList PackageManagerCore::localDependenciesToComponent(const Component *co
         return QStringList();
 
     QStringList dependents;
-    QString name;
-    QString version;
-
-    QMap<QString, LocalPackage> localPackages = d->m_localPackageHub->localPackages();
-    for (const KDUpdater::LocalPackage &localPackage : qAsConst(localPackages)) {
-        for (const QString &dependency : localPackage.dependencies) {
-            parseNameAndVersion(dependency, &name, &version);
-            if (componentMatches(component, name, version)) {
-                dependents.append(localPackage.name);
-            }
-        }
+    const QList<QPair<QString, QString> > candidates = d->localPackageDependees(component->name());
+    for (const QPair<QString, QString> &candidate : candidates) {
+        if (componentMatches(component, component->name(), candidate.second))
+            dependents.append(candidate.first);
     }
     return dependents;
 }
@@ -2488,6 +2595,9 @@ ComponentModel *PackageManagerCore::updaterComponentModel() const
     hash containing package information elements and regular expressions
     can be used to further filter listed packages.
 
+    The packages are searched from the repository metadata, components are
+    not created and component scripts are not loaded.
+
     \sa setVirtualComponentsVisible()
 */
 void PackageManagerCore::listAvailablePackages(const QString &regexp, const QHash<QString, QString> &filters)
@@ -2496,42 +2606,27 @@ void PackageManagerCore::listAvailablePackages(const QString &regexp, const QHas
     qCDebug(QInstaller::lcInstallerInstallLog)
         << "Searching packages with regular expression:" << regexp;
 
-    ComponentModel *model = defaultComponentModel();
+    const PackageQuery query(regexp, filters);
+    if (!query.isValid())
+        qCWarning(QInstaller::lcInstallerInstallLog).noquote() << query.errorString();
+
     d->fetchMetaInformationFromRepositories();
 
-    d->addUpdateResourcesFromRepositories();
-    QRegularExpression re(regexp);
-    re.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
-    const PackagesList &packages = d->remotePackages();
-    if (!fetchAllPackages(packages, LocalPackagesMap())) {
-        qCWarning(QInstaller::lcInstallerInstallLog)
-            << "There was a problem with loading the package data.";
-        return;
+    PackagesList packages;
+    foreach (Package *package, d->remotePackages()) {
+        if (ProductKeyCheck::instance()->isValidPackage(package->data(scName).toString()))
+            packages.append(package);
     }
 
-    PackagesList matchedPackages;
-    foreach (Package *package, packages) {
-        const QString name = package->data(scName).toString();
-        Component *component = componentByName(name);
-        if (!component)
-            continue;
+    PackageQuery::SelectOptions options;
+    if (virtualComponentsVisible())
+        options |= PackageQuery::VirtualComponentsVisible;
+    if (settings().allowUnstableComponents())
+        options |= PackageQuery::AllowUnstableComponents;
+    if (isInstaller())
+        options |= PackageQuery::HideReplacedComponents;
 
-        const QModelIndex &idx = model->indexFromComponentName(component->treeName());
-        if (idx.isValid() && re.match(name).hasMatch()) {
-            bool ignoreComponent = false;
-            for (auto &key : filters.keys()) {
-                const QString elementValue = component->value(key);
-                QRegularExpression elementRegexp(filters.value(key));
-                elementRegexp.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
-                if (elementValue.isEmpty() || !elementRegexp.match(elementValue).hasMatch()) {
-                    ignoreComponent = true;
-                    break;
-                }
-            }
-            if (!ignoreComponent)
-                matchedPackages.append(package);
-        }
-    }
+    const PackagesList matchedPackages = query.select(packages, options);
     if (matchedPackages.count() == 0)
         qCDebug(QInstaller::lcInstallerInstallLog) << "No matching packages found.";
     else
@@ -2798,6 +2893,15 @@ void PackageManagerCore::createAutoDependencyHash(const QString &component, cons
 {
     d->createAutoDependencyHash(component, oldDependencies, newDependencies);
 }
+
+/*!
+ * Marks the hash table used for quicker search of dependee components as outdated.
+ * Needs to be called when the dependencies of a component or the component tree change.
+ */
+void PackageManagerCore::invalidateDependeeIndex() const
+{
+    d->invalidateDependeeIndex();
+}
 /*!
     Uninstalls the selected components \a components without GUI.
     Returns PackageManagerCore installation status.
@@ -3115,7 +3219,7 @@ bool PackageManagerCore::checkAvailableSpace(QString &message) const
 */
 bool PackageManagerCore::isProcessRunning(const QString &name) const
 {
-    return PackageManagerCorePrivate::isProcessRunning(name, runningProcesses());
+    return ProcessIndex().contains(name);
 }
 
 /*!
@@ -3378,25 +3482,11 @@ bool PackageManagerCore::performOperation(const QString &name, const QStringList
 */
 bool PackageManagerCore::versionMatches(const QString &version, const QString &requirement)
 {
-    static const QRegularExpression compEx(QLatin1String("^([<=>]+)(.*)$"));
-    const QRegularExpressionMatch match = compEx.match(requirement);
-    const QString comparator = match.hasMatch() ? match.captured(1) : QLatin1String("=");
-    const QString ver = match.hasMatch() ? match.captured(2) : requirement;
-
-    const bool allowEqual = comparator.contains(QLatin1Char('='));
-    const bool allowLess = comparator.contains(QLatin1Char('<'));
-    const bool allowMore = comparator.contains(QLatin1Char('>'));
-
-    if (allowEqual && version == ver)
-        return true;
-
-    if (allowLess && KDUpdater::compareVersion(ver, version) > 0)
+    const VersionRequirement parsed = versionRequirement(requirement);
+    // only split the version into its components if it needs to be compared
+    if (parsed.allowEqual && version == parsed.version.toString())
         return true;
-
-    if (allowMore && KDUpdater::compareVersion(ver, version) < 0)
-        return true;
-
-    return false;
+    return parsed.matches(KDUpdater::VersionKey(version));
 }
 
 /*!
@@ -4088,6 +4178,7 @@ void PackageManagerCore::storeReplacedComponents(QHash<QString, Component *> &co
                 d->m_deletedReplacedComponents.append(componentToReplace);
             }
             d->replacementDependencyComponents().append(componentToReplace);
+            d->invalidateDependeeIndex();
 
             //Following hashes are created for quicker search of components
             d->componentsToReplace().insert(componentName, qMakePair(it.key(), componentToReplace));
@@ -4274,6 +4365,7 @@ bool PackageManagerCore::fetchUpdaterPackages(const PackagesList &remotes, const
             if (updateComponentData(data, component.data())) {
                 // Keep a reference so we can resolve dependencies during update.
                 d->m_updaterComponentsDeps.append(component.take());
+                d->invalidateDependeeIndex();
 
     //            const QString isNew = update->data(scNewComponent).toString();
     //            if (isNew.toLower() != scTrue)
@@ -4317,6 +4409,7 @@ bool PackageManagerCore::fetchUpdaterPackages(const PackagesList &remotes, const
 
                 // this is not a dependency, it is a real update
                 components.insert(name, d->m_updaterComponentsDeps.takeLast());
+                d->invalidateDependeeIndex();
             }
         }
 
@@ -4325,6 +4418,7 @@ bool PackageManagerCore::fetchUpdaterPackages(const PackagesList &remotes, const
             QInstaller::Component *component = new QInstaller::Component(this);
             component->loadDataFromPackage(installedPackages.value(key));
             d->m_updaterComponentsDeps.append(component);
+            d->invalidateDependeeIndex();
         }
 
         foreach (const QString &key, locals.keys()) {
@@ -4402,6 +4496,7 @@ bool PackageManagerCore::fetchUpdaterPackages(const PackagesList &remotes, const
 
             std::sort(d->m_updaterComponents.begin(), d->m_updaterComponents.end(),
                 Component::SortingPriorityGreaterThan());
+            d->invalidateDependeeIndex();
         } else {
             // we have no updates, no need to store possible dependencies
             d->clearUpdaterComponentLists();
@@ -133,6 +133,15 @@ public:
     static int maxConcurrentOperations();
     static void setMaxConcurrentOperations(int count);
 
+    static int maxConcurrentDownloads();
+    static void setMaxConcurrentDownloads(int count);
+
+    static int maxConcurrentDownloadsPerHost();
+    static void setMaxConcurrentDownloadsPerHost(int count);
+
+    static bool pipelinedInstallation();
+    static void setPipelinedInstallation(bool pipelined);
+
     static Component *componentByName(const QString &name, const QList<Component *> &components);
 
     bool directoryWritable(const QString &path) const;
@@ -355,6 +364,7 @@ public:
     void addLicenseItem(const QHash<QString, QVariantMap> &licenses);
     void createLocalDependencyHash(const QString &component, const QString &dependencies) const;
     void createAutoDependencyHash(const QString &component, const QString &oldDependencies, const QString &newDependencies) const;
+    void invalidateDependeeIndex() const;
 
     bool resetLocalCache(bool init = false);
     bool clearLocalCache(QString *error = nullptr);
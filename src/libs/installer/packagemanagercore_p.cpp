@@ -50,6 +50,8 @@
 #include "binarycreator.h"
 #include "loggingutils.h"
 #include "concurrentoperationrunner.h"
+#include "downloadarchivesjob.h"
+#include "extractarchiveoperation.h"
 #include "remoteclient.h"
 #include "operationtracer.h"
 
@@ -59,6 +61,7 @@
 
 #include <productkeycheck.h>
 
+#include <QCryptographicHash>
 #include <QSettings>
 #include <QtConcurrentRun>
 #include <QtCore/QCoreApplication>
@@ -89,6 +92,33 @@ namespace QInstaller {
     \internal
 */
 
+/*
+    \internal
+    Copies the temporary file \a source written by us to \a targetName. Unlike QFile::copy(),
+    this lets the kernel copy the data where possible. With elevated rights the copy is left
+    to QFile::copy(), which copies on the remote server in a single call. Throws Error on failure.
+*/
+static void copyWrittenFile(QFile *source, const QString &targetName)
+{
+    QInstaller::flushWritten(source);
+    source->close();
+
+    if (RemoteClient::instance().isActive()) {
+        if (!source->copy(targetName))
+            throw Error(source->errorString());
+        return;
+    }
+
+    QInstaller::openForRead(source);
+
+    QFile target(targetName);
+    QInstaller::openForWriteBehind(&target);
+    QInstaller::blockingCopy(source, &target, source->size());
+    QInstaller::flushWritten(&target);
+    target.close();
+    source->close();
+}
+
 static bool runOperation(Operation *operation, Operation::OperationType type)
 {
     OperationTracer tracer(operation);
@@ -111,10 +141,10 @@ static bool runOperation(Operation *operation, Operation::OperationType type)
 
 static QStringList checkRunningProcessesFromList(const QStringList &processList)
 {
-    const QList<ProcessInfo> allProcesses = runningProcesses();
+    const ProcessIndex allProcesses;
     QStringList stillRunningProcesses;
     foreach (const QString &process, processList) {
-        if (!process.isEmpty() && PackageManagerCorePrivate::isProcessRunning(process, allProcesses))
+        if (!process.isEmpty() && allProcesses.contains(process))
             stillRunningProcesses.append(process);
     }
     return stillRunningProcesses;
@@ -187,6 +217,10 @@ PackageManagerCorePrivate::PackageManagerCorePrivate(PackageManagerCore *core)
     , m_autoAcceptLicenses(false)
     , m_disableWriteMaintenanceTool(false)
     , m_autoConfirmCommand(false)
+    , m_dependeeIndexValid(false)
+    , m_dependeeIndexUpdater(false)
+    , m_localDependeeIndexValid(false)
+    , m_localDependeeIndexRevision(0)
     , m_datFileName(QString())
 {
 }
@@ -225,6 +259,10 @@ PackageManagerCorePrivate::PackageManagerCorePrivate(PackageManagerCore *core, q
     , m_autoAcceptLicenses(false)
     , m_disableWriteMaintenanceTool(false)
     , m_autoConfirmCommand(false)
+    , m_dependeeIndexValid(false)
+    , m_dependeeIndexUpdater(false)
+    , m_localDependeeIndexValid(false)
+    , m_localDependeeIndexRevision(0)
     , m_datFileName(datFileName)
 {
     foreach (const OperationBlob &operation, performedOperations) {
@@ -236,7 +274,13 @@ PackageManagerCorePrivate::PackageManagerCorePrivate(PackageManagerCore *core, q
             continue;
         }
 
-        if (!op->fromXml(operation.xml)) {
+        if (!operation.data.isEmpty()) {
+            if (!op->fromBinary(operation.data)) {
+                qCWarning(QInstaller::lcInstallerInstallLog) << "Failed to load data for operation"
+                    << operation.name;
+                continue;
+            }
+        } else if (!op->fromXml(operation.xml)) {
             qCWarning(QInstaller::lcInstallerInstallLog) << "Failed to load XML for operation"
                 << operation.name;
             continue;
@@ -279,37 +323,6 @@ PackageManagerCorePrivate::~PackageManagerCorePrivate()
     // delete m_gui;
 }
 
-/*
-    Return true, if a process with \a name is running. On Windows, comparison is case-insensitive.
-*/
-/* static */
-bool PackageManagerCorePrivate::isProcessRunning(const QString &name,
-    const QList<ProcessInfo> &processes)
-{
-    QList<ProcessInfo>::const_iterator it;
-    for (it = processes.constBegin(); it != processes.constEnd(); ++it) {
-        if (it->name.isEmpty())
-            continue;
-
-#ifndef Q_OS_WIN
-        if (it->name == name)
-            return true;
-        const QFileInfo fi(it->name);
-        if (fi.fileName() == name || fi.baseName() == name)
-            return true;
-#else
-        if (it->name.toLower() == name.toLower())
-            return true;
-        if (it->name.toLower() == QDir::toNativeSeparators(name.toLower()))
-            return true;
-        const QFileInfo fi(it->name);
-        if (fi.fileName().toLower() == name.toLower() || fi.baseName().toLower() == name.toLower())
-            return true;
-#endif
-    }
-    return false;
-}
-
 /* static */
 bool PackageManagerCorePrivate::performOperationThreaded(Operation *operation,
     Operation::OperationType type)
@@ -394,18 +407,30 @@ bool PackageManagerCorePrivate::buildComponentTree(QHash<QString, Component*> &c
         }
 
         std::sort(m_rootComponents.begin(), m_rootComponents.end(), Component::SortingPriorityGreaterThan());
+        invalidateDependeeIndex();
 
         storeCheckState();
 
-        foreach (QInstaller::Component *component, components)
-            component->setCheckState(Qt::Checked);
+        // Solving the whole tree is expensive, skip it if the same dependency graph
+        // was already validated without errors.
+        const QByteArray checksum = componentTreeChecksum(components);
+        if (!isComponentTreeValidated(checksum)) {
+            foreach (QInstaller::Component *component, components)
+                component->setCheckState(Qt::Checked);
 
-        clearInstallerCalculator();
-        if (installerCalculator()->solve(components.values()) == false) {
-            setStatus(PackageManagerCore::Failure, installerCalculator()->error());
-            MessageBoxHandler::critical(MessageBoxHandler::currentBestSuitParent(), QLatin1String("Error"),
-                tr("Unresolved dependencies"), installerCalculator()->error());
-            return false;
+            clearInstallerCalculator();
+            if (installerCalculator()->solve(components.values()) == false) {
+                setStatus(PackageManagerCore::Failure, installerCalculator()->error());
+                MessageBoxHandler::critical(MessageBoxHandler::currentBestSuitParent(), QLatin1String("Error"),
+                    tr("Unresolved dependencies"), installerCalculator()->error());
+                return false;
+            }
+            // Only remember a clean result, errors need to be reported on every run.
+            if (installerCalculator()->error().isEmpty())
+                setComponentTreeValidated(checksum);
+        } else {
+            qCDebug(QInstaller::lcInstallerInstallLog) << "Component tree unchanged since its last "
+                "validation, skipping the dependency check.";
         }
 
         restoreCheckState();
@@ -435,12 +460,20 @@ bool PackageManagerCorePrivate::loadComponentScripts(const T &components, const
 {
     infoMessage(nullptr, tr("Loading component scripts..."));
 
+    // The updater selects all of its components right away, deferring their scripts
+    // would only postpone the work.
+    const bool onDemand = !postScript && !isUpdater()
+        && m_data.settings().loadComponentScriptsOnDemand();
+
     quint64 loadedComponents = 0;
     for (auto *component : components) {
         if (statusCanceledOrFailed())
             return false;
 
-        component->loadComponentScript(postScript);
+        if (onDemand)
+            component->deferComponentScript();
+        else
+            component->loadComponentScript(postScript);
         ++loadedComponents;
 
         const int currentProgress = qRound(double(loadedComponents) / components.count() * 100);
@@ -453,6 +486,32 @@ bool PackageManagerCorePrivate::loadComponentScripts(const T &components, const
 template bool PackageManagerCorePrivate::loadComponentScripts<QList<Component *>>(const QList<Component *> &, const bool);
 template bool PackageManagerCorePrivate::loadComponentScripts<QHash<QString, Component *>>(const QHash<QString, Component *> &, const bool);
 
+/*!
+    \internal
+    Loads the deferred scripts of \a components. Returns \c true if at least one script
+    was loaded, as the scripts may have added dependencies that need to be resolved.
+    Sets \a ok to \c false if a script failed to load.
+*/
+bool PackageManagerCorePrivate::loadPendingComponentScripts(const QList<Component *> &components,
+    bool *ok)
+{
+    Q_ASSERT(ok);
+    *ok = true;
+    bool loaded = false;
+    try {
+        for (Component *component : components)
+            loaded |= component->loadPendingComponentScript();
+    } catch (const Error &error) {
+        *ok = false;
+        setStatus(PackageManagerCore::Failure, error.message());
+
+        MessageBoxHandler::critical(MessageBoxHandler::currentBestSuitParent(), QLatin1String("Error"),
+            tr("Error"), error.message());
+        return false;
+    }
+    return loaded;
+}
+
 void PackageManagerCorePrivate::cleanUpComponentEnvironment()
 {
     m_componentReplaces.clear();
@@ -460,6 +519,7 @@ void PackageManagerCorePrivate::cleanUpComponentEnvironment()
     m_localDependencyComponentHash.clear();
     m_localVirtualComponents.clear();
     m_componentByNameHash.clear();
+    invalidateDependeeIndex();
     // clean up registered (downloaded) data
     if (m_core->isMaintainer())
         BinaryFormatEngineHandler::instance()->clear();
@@ -1131,7 +1191,7 @@ void PackageManagerCorePrivate::writeMaintenanceToolBinary(QFile *const input, q
     ProgressCoordinator::instance()->emitLabelAndDetailTextChanged(tr("Writing maintenance tool."));
 
     QFile out(generateTemporaryFileName());
-    QInstaller::openForWrite(&out); // throws an exception in case of error
+    QInstaller::openForWriteBehind(&out); // throws an exception in case of error
 
     if (!input->seek(0))
         throw Error(tr("Failed to seek in file %1: %2").arg(input->fileName(), input->errorString()));
@@ -1149,8 +1209,9 @@ void PackageManagerCorePrivate::writeMaintenanceToolBinary(QFile *const input, q
         // It's a bit odd to have only the magic in the data file, but this simplifies
         // other code a lot (since installers don't have any appended data either)
         QFile dataOut(generateTemporaryFileName());
-        QInstaller::openForWrite(&dataOut);
+        QInstaller::openForWriteBehind(&dataOut);
         QInstallerTools::createMTDatFile(dataOut);
+        QInstaller::flushWritten(&dataOut);
 
         {
             QFile dummy(resourcePath.filePath(QLatin1String("installer.dat")));
@@ -1175,9 +1236,11 @@ void PackageManagerCorePrivate::writeMaintenanceToolBinary(QFile *const input, q
         }
     }
 
-    if (!out.copy(maintenanceToolRenamedName)) {
+    try {
+        copyWrittenFile(&out, maintenanceToolRenamedName);
+    } catch (const Error &error) {
         throw Error(tr("Cannot write maintenance tool to \"%1\": %2").arg(maintenanceToolRenamedName,
-            out.errorString()));
+            error.message()));
     }
 
     QFile mt(maintenanceToolRenamedName);
@@ -1223,10 +1286,12 @@ void PackageManagerCorePrivate::writeMaintenanceToolBinaryData(QFileDevice *outp
     }
 
     const qint64 operationsStart = output->pos();
+    QInstaller::appendInt64(output, BinaryContent::BinaryOperationsMarker);
+    QInstaller::appendInt64(output, BinaryContent::BinaryOperationsVersion);
     QInstaller::appendInt64(output, performedOperations.count());
     foreach (Operation *operation, performedOperations) {
         QInstaller::appendString(output, operation->name());
-        QInstaller::appendString(output, operation->toXml().toString());
+        QInstaller::appendByteArray(output, operation->toBinary());
 
         // for the ui not to get blocked
         qApp->processEvents();
@@ -1287,7 +1352,7 @@ void PackageManagerCorePrivate::writeMaintenanceToolAppBundle(OperationList &per
         QFile sourcePlist(sourceAppDirPath + QLatin1String("/../Info.plist"));
         QInstaller::openForRead(&sourcePlist);
         QFile targetPlist(targetAppDirPath + QLatin1String("/../Info.plist"));
-        QInstaller::openForWrite(&targetPlist);
+        QInstaller::openForWriteBehind(&targetPlist);
 
         QTextStream in(&sourcePlist);
         QTextStream out(&targetPlist);
@@ -1297,6 +1362,7 @@ void PackageManagerCorePrivate::writeMaintenanceToolAppBundle(OperationList &per
             + QLatin1String("</string>");
         while (!in.atEnd())
             out << in.readLine().replace(before, after) << endl;
+        QInstaller::flushWritten(&targetPlist);
 
         // copy qt_menu.nib if it exists
         op = createOwnedOperation(QLatin1String("Mkdir"));
@@ -1499,9 +1565,10 @@ void PackageManagerCorePrivate::writeMaintenanceTool(OperationList performedOper
 
         try {
             QFile file(generateTemporaryFileName());
-            QInstaller::openForWrite(&file);
+            QInstaller::openForWriteBehind(&file);
             writeMaintenanceToolBinaryData(&file, &input, performedOperations, layout);
             QInstaller::appendInt64(&file, BinaryContent::MagicCookieDat);
+            QInstaller::flushWritten(&file);
 
             QFile dummy(dataFile + QLatin1String(".new"));
             if (dummy.exists() && !dummy.remove()) {
@@ -1529,6 +1596,7 @@ void PackageManagerCorePrivate::writeMaintenanceTool(OperationList performedOper
             file.seek(file.size());
             writeMaintenanceToolBinaryData(&file, &input, performedOperations, layout);
             QInstaller::appendInt64(&file, BinaryContent::MagicCookie);
+            QInstaller::flushWritten(&file);
         }
         input.close();
         if (m_core->isInstaller())
@@ -1601,7 +1669,7 @@ void PackageManagerCorePrivate::writeOfflineBaseBinary()
     ProgressCoordinator::instance()->emitLabelAndDetailTextChanged(tr("Writing offline base binary."));
 
     QFile out(generateTemporaryFileName());
-    QInstaller::openForWrite(&out); // throws an exception in case of error
+    QInstaller::openForWriteBehind(&out); // throws an exception in case of error
 
     if (!input.seek(0))
         throw Error(tr("Failed to seek in file %1: %2").arg(input.fileName(), input.errorString()));
@@ -1623,9 +1691,11 @@ void PackageManagerCorePrivate::writeOfflineBaseBinary()
         }
     }
 
-    if (!out.copy(offlineBinaryTempName)) {
+    try {
+        copyWrittenFile(&out, offlineBinaryTempName);
+    } catch (const Error &error) {
         throw Error(tr("Cannot write offline binary to \"%1\": %2").arg(offlineBinaryTempName,
-            out.errorString()));
+            error.message()));
     }
 
     if (out.exists() && !out.remove()) {
@@ -1753,11 +1823,7 @@ bool PackageManagerCorePrivate::runInstaller()
 
         const double downloadPartProgressSize = double(1) / double(3);
         double componentsInstallPartProgressSize = double(2) / double(3);
-        const int downloadedArchivesCount = m_core->downloadNeededArchives(downloadPartProgressSize);
-
-        // if there was no download we have the whole progress for installing components
-        if (!downloadedArchivesCount)
-            componentsInstallPartProgressSize = double(1);
+        double progressOperationSize = 0;
 
         // Force an update on the components xml as the install dir might have changed.
         m_localPackageHub->setFileName(componentsXmlPath());
@@ -1768,13 +1834,26 @@ bool PackageManagerCorePrivate::runInstaller()
             m_data.settings().applicationName()).toString());
         m_localPackageHub->setApplicationVersion(QLatin1String(QUOTE(IFW_REPOSITORY_FORMAT_VERSION)));
 
-        const int progressOperationCount = countProgressOperations(componentsToInstall)
-            // add one more operation as we support progress
-            + (PackageManagerCore::createLocalRepositoryFromBinary() ? 1 : 0);
-        double progressOperationSize = componentsInstallPartProgressSize / progressOperationCount;
+        if (PackageManagerCore::pipelinedInstallation() && !m_core->isOfflineOnly()) {
+            // Download and unpack at the same time, the operations of a component are
+            // created only after its archives have been downloaded.
+            downloadAndInstallComponents(componentsToInstall, downloadPartProgressSize,
+                componentsInstallPartProgressSize, adminRightsGained);
+        } else {
+            const int downloadedArchivesCount = m_core->downloadNeededArchives(downloadPartProgressSize);
 
-        // Now install the requested components
-        unpackAndInstallComponents(componentsToInstall, progressOperationSize, adminRightsGained);
+            // if there was no download we have the whole progress for installing components
+            if (!downloadedArchivesCount)
+                componentsInstallPartProgressSize = double(1);
+
+            const int progressOperationCount = countProgressOperations(componentsToInstall)
+                // add one more operation as we support progress
+                + (PackageManagerCore::createLocalRepositoryFromBinary() ? 1 : 0);
+            progressOperationSize = componentsInstallPartProgressSize / progressOperationCount;
+
+            // Now install the requested components
+            unpackAndInstallComponents(componentsToInstall, progressOperationSize, adminRightsGained);
+        }
 
         if (m_core->isOfflineOnly() && PackageManagerCore::createLocalRepositoryFromBinary()) {
             emit m_core->titleMessageChanged(tr("Creating local repository"));
@@ -1988,20 +2067,29 @@ bool PackageManagerCorePrivate::runPackageUpdater()
 
         ProgressCoordinator::instance()->emitLabelAndDetailTextChanged(tr("Preparing the installation..."));
 
-        // following, we download the needed archives
-        m_core->downloadNeededArchives(downloadPartProgressSize);
+        // Removing components must not start before all archives of the update are
+        // available, so pipelining is used only if there is nothing to remove.
+        if (PackageManagerCore::pipelinedInstallation() && undoOperations.isEmpty()) {
+            m_performedOperationsOld = nonRevertedOperations;
 
-        if (undoOperations.count() > 0) {
-            ProgressCoordinator::instance()->emitLabelAndDetailTextChanged(tr("Removing deselected components..."));
-            runUndoOperations(undoOperations, undoOperationProgressSize, adminRightsGained, true);
-        }
-        m_performedOperationsOld = nonRevertedOperations; // these are all operations left: those not reverted
+            downloadAndInstallComponents(componentsToInstall, downloadPartProgressSize,
+                componentsInstallPartProgressSize, adminRightsGained);
+        } else {
+            // following, we download the needed archives
+            m_core->downloadNeededArchives(downloadPartProgressSize);
 
-        const double progressOperationCount = countProgressOperations(componentsToInstall);
-        const double progressOperationSize = componentsInstallPartProgressSize / progressOperationCount;
+            if (undoOperations.count() > 0) {
+                ProgressCoordinator::instance()->emitLabelAndDetailTextChanged(tr("Removing deselected components..."));
+                runUndoOperations(undoOperations, undoOperationProgressSize, adminRightsGained, true);
+            }
+            m_performedOperationsOld = nonRevertedOperations; // these are all operations left: those not reverted
+
+            const double progressOperationCount = countProgressOperations(componentsToInstall);
+            const double progressOperationSize = componentsInstallPartProgressSize / progressOperationCount;
 
-        // Now install the requested new components
-        unpackAndInstallComponents(componentsToInstall, progressOperationSize, adminRightsGained);
+            // Now install the requested new components
+            unpackAndInstallComponents(componentsToInstall, progressOperationSize, adminRightsGained);
+        }
 
         emit m_core->titleMessageChanged(tr("Creating Maintenance Tool"));
 
@@ -2343,8 +2431,30 @@ void PackageManagerCorePrivate::unpackComponents(const QList<Component *> &compo
     const QHash<Operation *, bool> results = runner.run();
     const OperationList performedOperations = results.keys();
 
+    const QString error = finishUnpackOperations(performedOperations, results);
+
+    if (becameAdmin)
+        m_core->dropAdminRights();
+
+    if (!error.isEmpty())
+        throw Error(error);
+
+    ProgressCoordinator::instance()->emitDetailTextChanged(tr("Done"));
+}
+
+/*!
+    \internal
+
+    Asks the user how to continue for each of the \a operations that failed according
+    to \a results, and registers the operations that need an undo step as performed.
+    Returns the error message of the first operation that failed and whose error was
+    not ignored.
+*/
+QString PackageManagerCorePrivate::finishUnpackOperations(const OperationList &operations,
+    const QHash<Operation *, bool> &results)
+{
     QString error;
-    for (auto &operation : performedOperations) {
+    for (auto &operation : operations) {
         const QString component = operation->value(QLatin1String("component")).toString();
 
         bool ignoreError = false;
@@ -2381,13 +2491,7 @@ void PackageManagerCorePrivate::unpackComponents(const QList<Component *> &compo
             error = operation->errorString();
     }
 
-    if (becameAdmin)
-        m_core->dropAdminRights();
-
-    if (!error.isEmpty())
-        throw Error(error);
-
-    ProgressCoordinator::instance()->emitDetailTextChanged(tr("Done"));
+    return error;
 }
 
 void PackageManagerCorePrivate::installComponent(Component *component, double progressOperationSize,
@@ -2492,7 +2596,10 @@ void PackageManagerCorePrivate::installComponent(Component *component, double pr
                                   component->isCheckable(),
                                   component->isExpandedByDefault(),
                                   component->value(scContentSha1));
-    m_localPackageHub->writeToDisk();
+    if (!m_localPackageHub->writeJournal()) {
+        qCWarning(QInstaller::lcInstallerInstallLog) << "Cannot write installation information journal"
+            << m_localPackageHub->journalFileName();
+    }
 
     component->setInstalled();
     component->markAsPerformedInstallation();
@@ -2501,6 +2608,52 @@ void PackageManagerCorePrivate::installComponent(Component *component, double pr
         ProgressCoordinator::instance()->emitDetailTextChanged(tr("Done"));
 }
 
+/*!
+    \internal
+
+    Returns the archives of \a component that need to be downloaded.
+*/
+QList<PackageManagerCore::DownloadItem> PackageManagerCorePrivate::archivesToDownload(Component *component) const
+{
+    QList<PackageManagerCore::DownloadItem> items;
+    const QStringList toDownload = component->downloadableArchives();
+    const bool checkSha1CheckSum = (component->value(scCheckSha1CheckSum).toLower() == scTrue);
+    foreach (const QString &versionFreeString, toDownload) {
+        PackageManagerCore::DownloadItem item;
+        item.checkSha1CheckSum = checkSha1CheckSum;
+        item.fileName = scInstallerPrefixWithTwoArgs.arg(component->name(), versionFreeString);
+        item.sourceUrl = scThreeArgs.arg(component->repositoryUrl().toString(), component->name(), versionFreeString);
+        items.push_back(item);
+    }
+    return items;
+}
+
+/*!
+    \internal
+
+    Applies the download limits to \a job and connects it to the installer. The
+    progress of \a job is registered with a part progress size of \a partProgressSize.
+*/
+void PackageManagerCorePrivate::setupDownloadArchivesJob(DownloadArchivesJob *job, double partProgressSize)
+{
+    job->setMaxConcurrentDownloads(PackageManagerCore::maxConcurrentDownloads());
+    job->setMaxConcurrentDownloadsPerHost(PackageManagerCore::maxConcurrentDownloadsPerHost());
+
+    connect(m_core, &PackageManagerCore::installationInterrupted, job, &Job::cancel);
+    connect(job, &DownloadArchivesJob::outputTextChanged,
+            ProgressCoordinator::instance(), &ProgressCoordinator::emitLabelAndDetailTextChanged);
+    connect(job, &DownloadArchivesJob::downloadStatusChanged,
+            ProgressCoordinator::instance(), &ProgressCoordinator::additionalProgressStatusChanged);
+
+    connect(job, &DownloadArchivesJob::fileDownloadReady,
+            this, &PackageManagerCorePrivate::addPathForDeletion);
+    connect(job, &DownloadArchivesJob::hashDownloadReady,
+            this, &PackageManagerCorePrivate::addPathForDeletion);
+
+    ProgressCoordinator::instance()->registerPartProgress(job,
+        SIGNAL(progressChanged(double)), partProgressSize);
+}
+
 bool PackageManagerCorePrivate::runningProcessesFound()
 {
     //Check if there are processes running in the install
@@ -2676,6 +2829,31 @@ void PackageManagerCorePrivate::unregisterMaintenanceTool()
 #endif
 }
 
+/*!
+    \internal
+
+    Returns the paths that the undo step of \a operation removes or restores, or an empty
+    list if the undo step must run on its own. Only two kinds of operations are undone
+    concurrently: extracting operations, which remove the files and directories they
+    extracted, and copy operations, which restore their destination file.
+*/
+static QStringList concurrentUndoPaths(Operation *operation)
+{
+    QStringList paths;
+    if (ExtractArchiveOperation *extract = dynamic_cast<ExtractArchiveOperation *>(operation)) {
+        foreach (const QString &path, extract->extractedFiles())
+            paths.append(QDir::cleanPath(QDir::fromNativeSeparators(path)));
+    } else if (operation->name() == QLatin1String("Copy") && operation->arguments().count() >= 2) {
+        const QString source = operation->arguments().at(0);
+        const QString destination = operation->arguments().at(1);
+        if (QFileInfo(destination).isDir())
+            paths.append(QDir::cleanPath(destination + QLatin1Char('/') + QFileInfo(source).fileName()));
+        else
+            paths.append(QDir::cleanPath(destination));
+    }
+    return paths;
+}
+
 void PackageManagerCorePrivate::runUndoOperations(const OperationList &undoOperations, double progressSize,
     bool adminRightsGained, bool deleteOperation)
 {
@@ -2683,53 +2861,104 @@ void PackageManagerCorePrivate::runUndoOperations(const OperationList &undoOpera
         const int operationsCount = undoOperations.size();
         int rolledBackOperations = 0;
 
-        foreach (Operation *undoOperation, undoOperations) {
+        // Undo steps that do not depend on each other are collected into batches that run
+        // concurrently. Everything else, like changes to environment variables or settings,
+        // is undone one after another in the original order.
+        int index = 0;
+        while (index < operationsCount) {
             if (statusCanceledOrFailed())
                 throw Error(tr("Installation canceled by user"));
 
+            OperationList batch;
+            QSet<QString> batchPaths;
+            const QString batchType = undoOperations.at(index)->name();
+            for (; index < operationsCount; ++index) {
+                Operation *undoOperation = undoOperations.at(index);
+                if (undoOperation->name() != batchType)
+                    break;
+                const QStringList paths = concurrentUndoPaths(undoOperation);
+                if (paths.isEmpty())
+                    break;
+
+                // Undo steps that touch the same file or directory, for example archives
+                // extracted into a shared directory, must keep their order.
+                bool overlaps = false;
+                for (const QString &path : paths) {
+                    if (batchPaths.contains(path)) {
+                        overlaps = true;
+                        break;
+                    }
+                }
+                if (overlaps)
+                    break;
+
+                for (const QString &path : paths)
+                    batchPaths.insert(path);
+                batch.append(undoOperation);
+            }
+            if (batch.isEmpty())
+                batch.append(undoOperations.at(index++));
+
             bool becameAdmin = false;
-            if (!adminRightsGained && undoOperation->value(QLatin1String("admin")).toBool())
-                becameAdmin = m_core->gainAdminRights();
+            QHash<Operation *, bool> results;
+            for (Operation *undoOperation : qAsConst(batch)) {
+                if (!adminRightsGained && !becameAdmin && undoOperation->value(QLatin1String("admin")).toBool())
+                    becameAdmin = m_core->gainAdminRights();
+                connectOperationToInstaller(undoOperation, progressSize);
+                qCDebug(QInstaller::lcInstallerInstallLog) << "undo operation=" << undoOperation->name();
+            }
 
-            connectOperationToInstaller(undoOperation, progressSize);
-            qCDebug(QInstaller::lcInstallerInstallLog) << "undo operation=" << undoOperation->name();
+            if (batch.count() == 1) {
+                results.insert(batch.first(), performOperationThreaded(batch.first(), Operation::Undo));
+            } else {
+                ConcurrentOperationRunner runner(&batch, Operation::Undo);
+                runner.setMaxThreadCount(m_core->maxConcurrentOperations());
+                connect(m_core, &PackageManagerCore::installationInterrupted,
+                    &runner, &ConcurrentOperationRunner::cancel);
+                results = runner.run();
+            }
 
-            bool ignoreError = false;
-            bool ok = performOperationThreaded(undoOperation, Operation::Undo);
+            for (Operation *undoOperation : qAsConst(batch)) {
+                if (statusCanceledOrFailed())
+                    throw Error(tr("Installation canceled by user"));
 
-            const QString componentName = undoOperation->value(QLatin1String("component")).toString();
+                bool ignoreError = false;
+                bool ok = results.value(undoOperation, false);
 
-            if (!componentName.isEmpty()) {
-                while (!ok && !ignoreError && m_core->status() != PackageManagerCore::Canceled) {
-                    const QMessageBox::StandardButton button =
-                        MessageBoxHandler::warning(MessageBoxHandler::currentBestSuitParent(),
-                        QLatin1String("installationErrorWithIgnore"), tr("Installer Error"),
-                        tr("Error during removal process:\n%1").arg(undoOperation->errorString()),
-                        QMessageBox::Retry | QMessageBox::Ignore, QMessageBox::Ignore);
+                const QString componentName = undoOperation->value(QLatin1String("component")).toString();
 
-                    if (button == QMessageBox::Retry)
-                        ok = performOperationThreaded(undoOperation, Operation::Undo);
-                    else if (button == QMessageBox::Ignore)
-                        ignoreError = true;
-                }
-                Component *component = m_core->componentByName(PackageManagerCore::checkableName(componentName));
-                if (!component)
-                    component = componentsToReplace().value(componentName).second;
-                if (component) {
-                    component->setUninstalled();
-                    m_localPackageHub->removePackage(component->name());
+                if (!componentName.isEmpty()) {
+                    while (!ok && !ignoreError && m_core->status() != PackageManagerCore::Canceled) {
+                        const QMessageBox::StandardButton button =
+                            MessageBoxHandler::warning(MessageBoxHandler::currentBestSuitParent(),
+                            QLatin1String("installationErrorWithIgnore"), tr("Installer Error"),
+                            tr("Error during removal process:\n%1").arg(undoOperation->errorString()),
+                            QMessageBox::Retry | QMessageBox::Ignore, QMessageBox::Ignore);
+
+                        if (button == QMessageBox::Retry)
+                            ok = performOperationThreaded(undoOperation, Operation::Undo);
+                        else if (button == QMessageBox::Ignore)
+                            ignoreError = true;
+                    }
+                    Component *component = m_core->componentByName(PackageManagerCore::checkableName(componentName));
+                    if (!component)
+                        component = componentsToReplace().value(componentName).second;
+                    if (component) {
+                        component->setUninstalled();
+                        m_localPackageHub->removePackage(component->name());
+                    }
                 }
-            }
 
-            ++rolledBackOperations;
-            ProgressCoordinator::instance()->emitAdditionalProgressStatus(tr("%1 of %2 operations rolled back.")
-                .arg(QString::number(rolledBackOperations), QString::number(operationsCount)));
+                ++rolledBackOperations;
+                ProgressCoordinator::instance()->emitAdditionalProgressStatus(tr("%1 of %2 operations rolled back.")
+                    .arg(QString::number(rolledBackOperations), QString::number(operationsCount)));
+
+                if (deleteOperation)
+                    delete undoOperation;
+            }
 
             if (becameAdmin)
                 m_core->dropAdminRights();
-
-            if (deleteOperation)
-                delete undoOperation;
         }
     } catch (const Error &error) {
         m_localPackageHub->writeToDisk();
@@ -2900,6 +3129,63 @@ void PackageManagerCorePrivate::storeCheckState()
         m_coreCheckedHash.insert(component, component->checkState());
 }
 
+QString PackageManagerCorePrivate::validatedComponentTreeFile() const
+{
+    const QString cachePath = m_data.settings().localCachePath();
+    if (cachePath.isEmpty())
+        return QString();
+    return cachePath + QLatin1String("/validated-component-tree.sha1");
+}
+
+/*!
+    \internal
+    Returns a checksum of everything the dependency validation of \a components depends on.
+*/
+QByteArray PackageManagerCorePrivate::componentTreeChecksum(const QHash<QString, Component *> &components) const
+{
+    QStringList names = components.keys();
+    std::sort(names.begin(), names.end());
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(m_data.settings().allowUnstableComponents()));
+    foreach (const QString &name, names) {
+        const Component *component = components.value(name);
+        const QStringList fields = QStringList() << name << component->value(scVersion)
+            << component->value(scInstalledVersion)
+            << component->currentDependencies().join(QLatin1Char(','))
+            << component->autoDependencies().join(QLatin1Char(','));
+        hash.addData((fields.join(QLatin1Char('\n')) + QLatin1String("\n\n")).toUtf8());
+    }
+    return hash.result().toHex();
+}
+
+/*!
+    \internal
+    Returns \c true if a component tree with \a checksum was validated without errors before.
+*/
+bool PackageManagerCorePrivate::isComponentTreeValidated(const QByteArray &checksum) const
+{
+    QFile file(validatedComponentTreeFile());
+    if (file.fileName().isEmpty() || !file.open(QIODevice::ReadOnly))
+        return false;
+    return file.readAll().trimmed() == checksum;
+}
+
+void PackageManagerCorePrivate::setComponentTreeValidated(const QByteArray &checksum) const
+{
+    const QString fileName = validatedComponentTreeFile();
+    if (fileName.isEmpty() || !QDir().mkpath(QFileInfo(fileName).absolutePath()))
+        return;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCDebug(QInstaller::lcInstallerInstallLog) << "Cannot store validated component tree:"
+            << file.errorString();
+        return;
+    }
+    file.write(checksum);
+}
+
 void PackageManagerCorePrivate::updateComponentInstallActions()
 {
     for (Component *component : m_core->components(PackageManagerCore::ComponentType::All)) {
@@ -2991,6 +3277,241 @@ void PackageManagerCorePrivate::unpackAndInstallComponents(const QList<Component
     ProgressCoordinator::instance()->emitAdditionalProgressStatus(tr("All components installed."));
 }
 
+/*!
+    \internal
+
+    Downloads the archives of \a components and unpacks the archives of a component as
+    soon as all of them have been downloaded, while the archives of other components are
+    still being downloaded. Afterwards the rest of the operations of \a components are
+    performed in the given order.
+
+    The operations are registered as performed in the same order as with separate download
+    and unpack phases, first all unpack operations and then the remaining operations of each
+    component, so undo and rollback are not affected by the overlapping phases.
+*/
+void PackageManagerCorePrivate::downloadAndInstallComponents(const QList<Component *> &components,
+    double downloadPartProgressSize, double installPartProgressSize, bool adminRightsGained)
+{
+    QList<PackageManagerCore::DownloadItem> downloadItems;
+    QHash<QString, Component *> componentByArchive;
+    QHash<Component *, int> pendingArchives;
+    QList<Component *> readyComponents;
+    quint64 totalCompressedSize = 0;
+
+    for (Component *component : components) {
+        const QList<PackageManagerCore::DownloadItem> items = archivesToDownload(component);
+        for (const PackageManagerCore::DownloadItem &item : items)
+            componentByArchive.insert(item.fileName, component);
+
+        if (items.isEmpty())
+            readyComponents.append(component);
+        else
+            pendingArchives.insert(component, items.count());
+
+        downloadItems.append(items);
+        totalCompressedSize += component->value(scCompressedSize).toULongLong();
+    }
+
+    // if there is nothing to download we have the whole progress for installing components
+    if (downloadItems.isEmpty())
+        installPartProgressSize += downloadPartProgressSize;
+
+    DownloadArchivesJob archivesJob(m_core);
+    archivesJob.setAutoDelete(false);
+    archivesJob.setArchivesToDownload(downloadItems);
+    archivesJob.setExpectedTotalSize(totalCompressedSize);
+    setupDownloadArchivesJob(&archivesJob, downloadPartProgressSize);
+
+    QEventLoop loop;
+    bool downloadFinished = false;
+    connect(&archivesJob, &DownloadArchivesJob::archiveRegistered, &loop, [&](const QString &fileName) {
+        Component *const component = componentByArchive.value(fileName);
+        if (!component || !pendingArchives.contains(component))
+            return;
+
+        if (--pendingArchives[component] == 0) {
+            pendingArchives.remove(component);
+            readyComponents.append(component);
+            loop.quit();
+        }
+    });
+    connect(&archivesJob, &Job::finished, &loop, [&] {
+        downloadFinished = true;
+        loop.quit();
+    });
+
+    ConcurrentOperationRunner backupRunner;
+    backupRunner.setType(Operation::Backup);
+    backupRunner.setMaxThreadCount(m_core->maxConcurrentOperations());
+
+    ConcurrentOperationRunner runner;
+    runner.setType(Operation::Perform);
+    runner.setMaxThreadCount(m_core->maxConcurrentOperations());
+
+    connect(m_core, &PackageManagerCore::installationInterrupted,
+        &backupRunner, &ConcurrentOperationRunner::cancel);
+    connect(m_core, &PackageManagerCore::installationInterrupted,
+        &runner, &ConcurrentOperationRunner::cancel);
+
+    ProgressCoordinator::instance()->emitLabelAndDetailTextChanged(QLatin1Char('\n')
+        + tr("Downloading and unpacking components..."));
+
+    QHash<Component *, double> progressOperationSizes;
+    bool becameAdmin = false;
+
+    runner.start();
+    archivesJob.start();
+
+    while (!statusCanceledOrFailed()) {
+        if (downloadFinished && archivesJob.error() != Job::NoError)
+            break;
+
+        if (readyComponents.isEmpty()) {
+            if (!downloadFinished) {
+                loop.exec();
+                continue;
+            }
+            if (pendingArchives.isEmpty())
+                break;
+
+            // The download job skipped archives it could not create a downloader for,
+            // missing archives are reported when the operations get created.
+            for (Component *component : components) {
+                if (pendingArchives.contains(component))
+                    readyComponents.append(component);
+            }
+            pendingArchives.clear();
+        }
+
+        // 1. Collect operations of the components whose archives have landed
+        const QList<Component *> batch = readyComponents;
+        readyComponents.clear();
+
+        OperationList operations;
+        for (Component *component : batch) {
+            const OperationList componentOperations = component->operations(Operation::Unpack);
+            if (!component->operationsCreatedSuccessfully())
+                m_core->setCanceled();
+
+            // The operation count is known only now, divide the part of this component,
+            // weighted by its compressed size, between all of its progress operations.
+            const double weight = double(1) / (2 * components.count()) + (totalCompressedSize > 0
+                ? double(component->value(scCompressedSize).toULongLong()) / (2 * totalCompressedSize)
+                : double(1) / (2 * components.count()));
+            const double progressOperationSize = installPartProgressSize * weight
+                / qMax(1, countProgressOperations(component->operations()));
+            progressOperationSizes.insert(component, progressOperationSize);
+
+            for (auto &op : componentOperations) {
+                connectOperationToInstaller(op, progressOperationSize);
+                connectOperationCallMethodRequest(op);
+
+                if (!adminRightsGained && !becameAdmin && op->value(QLatin1String("admin")).toBool())
+                    becameAdmin = m_core->gainAdminRights();
+            }
+            operations.append(componentOperations);
+        }
+
+        if (statusCanceledOrFailed())
+            break;
+
+        // 2. Backup operations, downloads continue in the event loop of the runner
+        backupRunner.setOperations(&operations);
+        const QHash<Operation *, bool> backupResults = backupRunner.run();
+
+        for (auto &operation : qAsConst(operations)) {
+            if (m_core->status() == PackageManagerCore::Canceled)
+                break; // User canceled, no need to print warnings
+
+            if (!backupResults.value(operation) || operation->error() != Operation::NoError) {
+                qCWarning(QInstaller::lcInstallerInstallLog) << QString::fromLatin1("Backup of operation "
+                    "\"%1\" with arguments \"%2\" failed: %3").arg(operation->name(), operation->arguments()
+                    .join(QLatin1String("; ")), operation->errorString());
+                continue;
+            }
+            // Backup may request performing operation as admin
+            if (!adminRightsGained && !becameAdmin && operation->value(QLatin1String("admin")).toBool())
+                becameAdmin = m_core->gainAdminRights();
+        }
+
+        if (statusCanceledOrFailed())
+            break;
+
+        // 3. Queue the operations for performing, longest taking first
+        std::sort(operations.begin(), operations.end(), [](Operation *lhs, Operation *rhs) {
+            return lhs->sizeHint() > rhs->sizeHint();
+        });
+        runner.addOperations(operations);
+    }
+
+    if (!downloadFinished)
+        archivesJob.cancel();
+
+    if (archivesJob.error() != Job::NoError || statusCanceledOrFailed())
+        runner.cancel();
+
+    const QHash<Operation *, bool> results = runner.waitForFinished();
+
+    // Keep the component order for the performed operations
+    OperationList performedOperations;
+    for (Component *component : components) {
+        if (!progressOperationSizes.contains(component))
+            continue;
+
+        const OperationList componentOperations = component->operations(Operation::Unpack);
+        for (auto &operation : componentOperations) {
+            if (results.contains(operation))
+                performedOperations.append(operation);
+        }
+    }
+
+    if (archivesJob.error() != Job::NoError) {
+        // Remember the operations that ran, so that the rollback can undo them.
+        for (auto &operation : qAsConst(performedOperations)) {
+            if (results.value(operation) || operation->error() > Operation::InvalidArguments)
+                addPerformed(operation);
+        }
+        if (becameAdmin)
+            m_core->dropAdminRights();
+
+        if (archivesJob.error() == Job::Canceled) {
+            m_core->interrupt();
+            throw Error(tr("Installation canceled by user."));
+        }
+        throw Error(archivesJob.errorString());
+    }
+
+    if (!downloadItems.isEmpty()) {
+        ProgressCoordinator::instance()->emitAdditionalProgressStatus(tr("All downloads finished."));
+        emit m_core->downloadArchivesFinished();
+    }
+
+    const QString error = finishUnpackOperations(performedOperations, results);
+
+    if (becameAdmin)
+        m_core->dropAdminRights();
+
+    if (!error.isEmpty())
+        throw Error(error);
+
+    if (statusCanceledOrFailed())
+        throw Error(tr("Installation canceled by user"));
+
+    ProgressCoordinator::instance()->emitDetailTextChanged(tr("Done"));
+
+    // Perform rest of the operations and mark component as installed
+    const int componentsToInstallCount = components.size();
+    int installedComponents = 0;
+    foreach (Component *component, components) {
+        installComponent(component, progressOperationSizes.value(component), adminRightsGained);
+
+        ++installedComponents;
+        ProgressCoordinator::instance()->emitAdditionalProgressStatus(tr("%1 of %2 components installed.")
+            .arg(QString::number(installedComponents), QString::number(componentsToInstallCount)));
+    }
+    ProgressCoordinator::instance()->emitAdditionalProgressStatus(tr("All components installed."));
+}
+
 void PackageManagerCorePrivate::processFilesForDelayedDeletion()
 {
     if (m_filesForDelayedDeletion.isEmpty())
@@ -3008,22 +3529,27 @@ void PackageManagerCorePrivate::processFilesForDelayedDeletion()
     }
 }
 
-void PackageManagerCorePrivate::findExecutablesRecursive(const QString &path, const QStringList &excludeFiles, QStringList *result)
-{
-    QDirIterator it(path, QDir::NoDotAndDotDot | QDir::Executable | QDir::Files | QDir::System, QDirIterator::Subdirectories );
-
-    while (it.hasNext())
-        result->append(QDir::toNativeSeparators(it.next().toLower()));
-
-    foreach (const QString &process, excludeFiles)
-        result->removeAll(QDir::toNativeSeparators(process.toLower()));
-}
-
 QStringList PackageManagerCorePrivate::runningInstallerProcesses(const QStringList &excludeFiles)
 {
+    QSet<QString> excluded;
+    foreach (const QString &file, excludeFiles)
+        excluded.insert(QDir::toNativeSeparators(file.toLower()));
+
+    // Check the running processes for executables inside the installation, instead of
+    // checking every executable of the installation against the running processes.
     QStringList resultFiles;
-    findExecutablesRecursive(QCoreApplication::applicationDirPath(), excludeFiles, &resultFiles);
-    return checkRunningProcessesFromList(resultFiles);
+    const ProcessIndex processIndex;
+    const QList<ProcessInfo> processes
+        = processIndex.processesInDirectory(QCoreApplication::applicationDirPath());
+    for (const ProcessInfo &process : processes) {
+        const QString file = QDir::toNativeSeparators(process.name.toLower());
+        if (excluded.contains(file) || resultFiles.contains(file))
+            continue;
+        const QFileInfo fi(process.name);
+        if (fi.isFile() && fi.isExecutable())
+            resultFiles.append(file);
+    }
+    return resultFiles;
 }
 
 bool PackageManagerCorePrivate::calculateComponentsAndRun()
@@ -3209,4 +3735,79 @@ void PackageManagerCorePrivate::createLocalDependencyHash(const QString &compone
     }
 }
 
+/*!
+    \internal
+
+    Marks the reverse dependency index of the available components as outdated. The index is
+    rebuilt on the next call to componentDependees().
+*/
+void PackageManagerCorePrivate::invalidateDependeeIndex()
+{
+    m_dependeeIndexValid = false;
+    m_dependeeIndex.clear();
+}
+
+/*!
+    \internal
+
+    Returns the available components that have a dependency to a component called \a name,
+    together with the version requirement of each dependency. The components are returned in
+    the order of PackageManagerCore::components(), a component is listed once per matching
+    dependency. The reverse dependency index is created on first use, so that repeated
+    lookups do not need to parse the dependencies of every available component again.
+*/
+QList<QPair<Component *, QString> > PackageManagerCorePrivate::componentDependees(const QString &name)
+{
+    const bool updater = isUpdater();
+    if (!m_dependeeIndexValid || m_dependeeIndexUpdater != updater) {
+        m_dependeeIndex.clear();
+        QString dependencyName;
+        QString dependencyVersion;
+        const QList<Component *> availableComponents
+            = m_core->components(PackageManagerCore::ComponentType::All);
+        for (Component *component : availableComponents) {
+            if (!component)
+                continue;
+            const QStringList dependencies = component->dependencies();
+            for (const QString &dependency : dependencies) {
+                PackageManagerCore::parseNameAndVersion(dependency, &dependencyName, &dependencyVersion);
+                if (!dependencyName.isEmpty())
+                    m_dependeeIndex[dependencyName].append(qMakePair(component, dependencyVersion));
+            }
+        }
+        m_dependeeIndexValid = true;
+        m_dependeeIndexUpdater = updater;
+    }
+    return m_dependeeIndex.value(name);
+}
+
+/*!
+    \internal
+
+    Returns the names of the installed packages that have a dependency to a component
+    called \a name, together with the version requirement of each dependency. The index is
+    rebuilt whenever the content of the local package hub has changed.
+*/
+QList<QPair<QString, QString> > PackageManagerCorePrivate::localPackageDependees(const QString &name)
+{
+    if (!m_localDependeeIndexValid || m_localDependeeIndexRevision != m_localPackageHub->revision()) {
+        m_localDependeeIndex.clear();
+        QString dependencyName;
+        QString dependencyVersion;
+        const QMap<QString, LocalPackage> localPackages = m_localPackageHub->localPackages();
+        for (const LocalPackage &localPackage : localPackages) {
+            for (const QString &dependency : localPackage.dependencies) {
+                PackageManagerCore::parseNameAndVersion(dependency, &dependencyName, &dependencyVersion);
+                if (!dependencyName.isEmpty()) {
+                    m_localDependeeIndex[dependencyName]
+                        .append(qMakePair(localPackage.name, dependencyVersion));
+                }
+            }
+        }
+        m_localDependeeIndexValid = true;
+        m_localDependeeIndexRevision = m_localPackageHub->revision();
+    }
+    return m_localDependeeIndex.value(name);
+}
+
 } // namespace QInstaller
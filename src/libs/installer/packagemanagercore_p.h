@@ -58,6 +58,7 @@ class ScriptEngine;
 class ComponentModel;
 class InstallerCalculator;
 class UninstallerCalculator;
+class DownloadArchivesJob;
 class RemoteFileEngineHandler;
 
 class PackageManagerCorePrivate : public QObject
@@ -72,7 +73,6 @@ public:
         const QList<OperationBlob> &performedOperations, const QString &datFileName);
     ~PackageManagerCorePrivate();
 
-    static bool isProcessRunning(const QString &name, const QList<ProcessInfo> &processes);
 
     static bool performOperationThreaded(Operation *op, UpdateOperation::OperationType type
         = UpdateOperation::Perform);
@@ -109,6 +109,7 @@ public:
 
     template <typename T>
     bool loadComponentScripts(const T &components, const bool postScript = false);
+    bool loadPendingComponentScripts(const QList<Component *> &components, bool *ok);
 
     void cleanUpComponentEnvironment();
     ScriptEngine *componentScriptEngine() const;
@@ -175,6 +176,9 @@ public:
     void installComponent(Component *component, double progressOperationSize,
         bool adminRightsGained = false);
 
+    QList<PackageManagerCore::DownloadItem> archivesToDownload(Component *component) const;
+    void setupDownloadArchivesJob(DownloadArchivesJob *job, double partProgressSize);
+
     bool runningProcessesFound();
     void setComponentSelection(const QString &id, Qt::CheckState state);
 
@@ -245,6 +249,10 @@ private slots:
 private:
     void unpackAndInstallComponents(const QList<Component *> &components,
         const double progressOperationSize, const bool adminRightsGained);
+    void downloadAndInstallComponents(const QList<Component *> &components,
+        double downloadPartProgressSize, double installPartProgressSize, bool adminRightsGained);
+    QString finishUnpackOperations(const OperationList &operations,
+        const QHash<Operation *, bool> &results);
 
     void deleteMaintenanceTool();
     void deleteMaintenanceToolAlias();
@@ -264,7 +272,6 @@ private:
     bool fetchMetaInformationFromRepositories(DownloadType type = DownloadType::All);
     bool addUpdateResourcesFromRepositories(bool compressedRepository = false);
     void processFilesForDelayedDeletion();
-    void findExecutablesRecursive(const QString &path, const QStringList &excludeFiles, QStringList *result);
     QStringList runningInstallerProcesses(const QStringList &exludeFiles);
     bool calculateComponentsAndRun();
     bool acceptLicenseAgreements() const;
@@ -274,12 +281,20 @@ private:
     void commitPendingUnstableComponents();
     void createAutoDependencyHash(const QString &componentName, const QString &oldValue, const QString &newValue);
     void createLocalDependencyHash(const QString &componentName, const QString &dependencies);
+    void invalidateDependeeIndex();
+    QList<QPair<Component *, QString> > componentDependees(const QString &name);
+    QList<QPair<QString, QString> > localPackageDependees(const QString &name);
     void updateComponentInstallActions();
 
     // remove once we deprecate isSelected, setSelected etc...
     void restoreCheckState();
     void storeCheckState();
 
+    QString validatedComponentTreeFile() const;
+    QByteArray componentTreeChecksum(const QHash<QString, Component *> &components) const;
+    bool isComponentTreeValidated(const QByteArray &checksum) const;
+    void setComponentTreeValidated(const QByteArray &checksum) const;
+
 private:
     PackageManagerCore *m_core;
     MetadataJob m_metadataJob;
@@ -318,6 +333,14 @@ private:
     AutoDependencyHash m_autoDependencyComponentHash;
     LocalDependencyHash m_localDependencyComponentHash;
     QHash<QString, Component *> m_componentByNameHash;
+    // < dependency name, < dependee component, required version > >
+    QHash<QString, QList<QPair<Component *, QString> > > m_dependeeIndex;
+    bool m_dependeeIndexValid;
+    bool m_dependeeIndexUpdater;
+    // < dependency name, < dependee local package name, required version > >
+    QHash<QString, QList<QPair<QString, QString> > > m_localDependeeIndex;
+    bool m_localDependeeIndexValid;
+    quint64 m_localDependeeIndexRevision;
 
     QStringList m_localVirtualComponents;
 
@@ -0,0 +1,264 @@
+/**************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "packagequery.h"
+
+#include "constants.h"
+#include "globals.h"
+
+#include <QMap>
+
+#include <functional>
+
+namespace QInstaller {
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::PackageQuery
+    \brief The PackageQuery class searches packages from repository metadata.
+
+    The query matches the name of a package against a regular expression, and the values
+    of package information elements against further regular expressions. All expressions
+    are compiled once when the query is constructed. Packages are selected straight from
+    the parsed repository metadata, no components are created and no component scripts
+    are loaded.
+*/
+
+/*!
+    Constructs a query for packages whose name matches \a regexp. The optional \a filters
+    hash maps package information elements to regular expressions the element values have
+    to match. All expressions are matched case insensitively.
+*/
+PackageQuery::PackageQuery(const QString &regexp, const QHash<QString, QString> &filters)
+    : m_nameExpression(regexp, QRegularExpression::CaseInsensitiveOption)
+{
+    m_nameExpression.optimize();
+    for (auto it = filters.constBegin(); it != filters.constEnd(); ++it) {
+        QRegularExpression expression(it.value(), QRegularExpression::CaseInsensitiveOption);
+        expression.optimize();
+        m_filters.append(qMakePair(it.key(), expression));
+    }
+}
+
+/*!
+    Returns \c true if all expressions of the query are valid; otherwise returns \c false.
+*/
+bool PackageQuery::isValid() const
+{
+    if (!m_nameExpression.isValid())
+        return false;
+    for (const auto &filter : m_filters) {
+        if (!filter.second.isValid())
+            return false;
+    }
+    return true;
+}
+
+/*!
+    Returns a description of the first invalid expression of the query.
+*/
+QString PackageQuery::errorString() const
+{
+    if (!m_nameExpression.isValid()) {
+        return QString::fromLatin1("Invalid regular expression \"%1\": %2").arg(
+            m_nameExpression.pattern(), m_nameExpression.errorString());
+    }
+    for (const auto &filter : m_filters) {
+        if (!filter.second.isValid()) {
+            return QString::fromLatin1("Invalid regular expression \"%1\" for \"%2\": %3").arg(
+                filter.second.pattern(), filter.first, filter.second.errorString());
+        }
+    }
+    return QString();
+}
+
+/*!
+    Returns \c true if the name and the filtered elements of \a package match the query;
+    otherwise returns \c false. Packages that do not have a filtered element never match.
+*/
+bool PackageQuery::matches(const Package *package) const
+{
+    if (!m_nameExpression.match(package->data(scName).toString()).hasMatch())
+        return false;
+
+    for (const auto &filter : m_filters) {
+        const QString value = package->data(filter.first).toString();
+        if (value.isEmpty() || !filter.second.match(value).hasMatch())
+            return false;
+    }
+    return true;
+}
+
+/*!
+    \enum PackageQuery::SelectOption
+
+    This enum holds the options of select():
+
+    \value NoSelectOptions
+            Default options.
+    \value VirtualComponentsVisible
+            Virtual packages, and packages placed below them, are selected too.
+    \value AllowUnstableComponents
+            Packages whose tree name conflicts with an existing identifier are placed by their
+            name, like unstable components are.
+    \value HideReplacedComponents
+            Packages replaced by another package are skipped, like in the installer.
+*/
+
+/*!
+    Returns the packages from \a packages that match the query and would be shown in the
+    component tree, in their original order. The tree is built according to \a options.
+
+    The position of a package in the tree is derived from its name or tree name the same
+    way PackageManagerCore::fetchAllPackages() places components, including children moved
+    along with a tree name. Packages that cannot be registered because their identifier is
+    already taken are skipped.
+*/
+PackagesList PackageQuery::select(const PackagesList &packages, SelectOptions options) const
+{
+    const bool allowUnstable = options.testFlag(AllowUnstableComponents);
+
+    QHash<QString, const Package *> packageById;
+    QHash<const Package *, QString> idByPackage;
+    auto registerPackage = [&](const Package *package, const QString &id) {
+        packageById.insert(id, package);
+        idByPackage.insert(package, id);
+    };
+    auto unregisterPackage = [&](const QString &id) {
+        idByPackage.remove(packageById.take(id));
+    };
+
+    // Register packages without tree name first, tree names must not take over the name
+    // of another package.
+    QMap<QString, QString> treeNames; // name, tree name
+    QVector<const Package *> treeNamePackages;
+    for (const Package *package : packages) {
+        if (!package->data(scTreeName).value<QPair<QString, bool>>().first.isEmpty()) {
+            treeNamePackages.append(package);
+            continue;
+        }
+        const QString name = package->data(scName).toString();
+        if (!packageById.contains(name))
+            registerPackage(package, name);
+    }
+    for (const Package *package : qAsConst(treeNamePackages)) {
+        const QString name = package->data(scName).toString();
+        const QString treeName = package->data(scTreeName).value<QPair<QString, bool>>().first;
+        if (!packageById.contains(treeName)) {
+            registerPackage(package, treeName);
+            treeNames.insert(name, treeName);
+        } else if (allowUnstable && !packageById.contains(name)) {
+            registerPackage(package, name);
+        }
+    }
+
+    // Replaced packages lose their tree name, and their place in the tree if requested.
+    for (const Package *package : packages) {
+        if (!idByPackage.contains(package))
+            continue;
+        const QStringList replaces = splitStringWithComma(package->data(scReplaces).toString());
+        for (const QString &replaced : replaces) {
+            const QString id = treeNames.contains(replaced) ? treeNames.take(replaced) : replaced;
+            if (options.testFlag(HideReplacedComponents) && packageById.contains(id))
+                unregisterPackage(id);
+        }
+    }
+
+    // Children of packages with a tree name that moves children follow their parent.
+    if (!treeNames.isEmpty()) {
+        QHash<QString, const Package *> movedPackages;
+        for (const Package *package : packages) {
+            const QString name = package->data(scName).toString();
+            if (idByPackage.value(package) != name)
+                continue; // not registered, or has a tree name of its own
+
+            QString prefix;
+            for (auto it = treeNames.constBegin(); it != treeNames.constEnd(); ++it) {
+                if (!name.startsWith(it.key()))
+                    continue;
+                const Package *parent = packageById.value(it.value());
+                if (!(parent && parent->data(scTreeName).value<QPair<QString, bool>>().second))
+                    continue;
+                if (prefix.split(QLatin1Char('.'), Qt::SkipEmptyParts).count()
+                        > it.key().split(QLatin1Char('.'), Qt::SkipEmptyParts).count()) {
+                    continue;
+                }
+                prefix = it.key();
+            }
+            if (prefix.isEmpty())
+                continue;
+
+            const QString treeName = QString(name).replace(prefix, treeNames.value(prefix));
+            if (packageById.contains(treeName) || treeNames.contains(treeName)) {
+                if (!allowUnstable)
+                    unregisterPackage(name);
+                continue;
+            }
+            unregisterPackage(name);
+            movedPackages.insert(treeName, package);
+        }
+        for (auto it = movedPackages.constBegin(); it != movedPackages.constEnd(); ++it) {
+            if (packageById.contains(it.key()))
+                unregisterPackage(it.key());
+            registerPackage(it.value(), it.key());
+        }
+    }
+
+    // A package is hidden if it is virtual, or its closest registered ancestor is hidden.
+    const bool virtualComponentsVisible = options.testFlag(VirtualComponentsVisible);
+    QHash<QString, bool> hidden;
+    std::function<bool(const QString &)> isHidden = [&](const QString &id) -> bool {
+        auto it = hidden.constFind(id);
+        if (it != hidden.constEnd())
+            return it.value();
+
+        bool result = !virtualComponentsVisible
+            && packageById.value(id)->data(scVirtual).toString().toLower() == scTrue;
+        QString parent = id;
+        while (!result && !parent.isEmpty()) {
+            parent = parent.section(QLatin1Char('.'), 0, -2);
+            if (packageById.contains(parent)) {
+                result = isHidden(parent);
+                break;
+            }
+        }
+        hidden.insert(id, result);
+        return result;
+    };
+
+    PackagesList selected;
+    for (Package *package : packages) {
+        const QString id = idByPackage.value(package);
+        if (id.isEmpty() || isHidden(id) || !matches(package))
+            continue;
+        selected.append(package);
+    }
+    return selected;
+}
+
+} // namespace QInstaller
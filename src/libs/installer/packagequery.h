@@ -0,0 +1,68 @@
+/**************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef PACKAGEQUERY_H
+#define PACKAGEQUERY_H
+
+#include "qinstallerglobal.h"
+
+#include <QHash>
+#include <QRegularExpression>
+#include <QVector>
+
+namespace QInstaller {
+
+class INSTALLER_EXPORT PackageQuery
+{
+public:
+    enum SelectOption {
+        NoSelectOptions = 0x00,
+        VirtualComponentsVisible = 0x01,
+        AllowUnstableComponents = 0x02,
+        HideReplacedComponents = 0x04
+    };
+    Q_DECLARE_FLAGS(SelectOptions, SelectOption)
+
+    explicit PackageQuery(const QString &regexp = QString(),
+        const QHash<QString, QString> &filters = QHash<QString, QString>());
+
+    bool isValid() const;
+    QString errorString() const;
+
+    bool matches(const Package *package) const;
+    PackagesList select(const PackagesList &packages, SelectOptions options = NoSelectOptions) const;
+
+private:
+    QRegularExpression m_nameExpression;
+    QVector<QPair<QString, QRegularExpression>> m_filters;
+};
+Q_DECLARE_OPERATORS_FOR_FLAGS(PackageQuery::SelectOptions)
+
+} // namespace QInstaller
+
+#endif // PACKAGEQUERY_H
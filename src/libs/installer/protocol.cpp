@@ -27,12 +27,159 @@
 **************************************************************************/
 
 #include "protocol.h"
+
+#include <QHash>
 #include <QIODevice>
+#include <QVector>
 
 namespace QInstaller {
 
 typedef qint32 PackageSize;
 
+namespace Protocol {
+
+struct CommandEntry
+{
+    Command command;
+    const char *name;
+};
+
+static const CommandEntry commandEntries[] = {
+    { Command::Create, Create },
+    { Command::Shutdown, Shutdown },
+    { Command::Authorize, Authorize },
+    { Command::Reply, Reply },
+    { Command::GetQProcessSignals, GetQProcessSignals },
+    { Command::GetAbstractArchiveSignals, GetAbstractArchiveSignals },
+    { Command::QProcessCloseWriteChannel, QProcessCloseWriteChannel },
+    { Command::QProcessExitCode, QProcessExitCode },
+    { Command::QProcessExitStatus, QProcessExitStatus },
+    { Command::QProcessKill, QProcessKill },
+    { Command::QProcessReadAll, QProcessReadAll },
+    { Command::QProcessReadAllStandardOutput, QProcessReadAllStandardOutput },
+    { Command::QProcessReadAllStandardError, QProcessReadAllStandardError },
+    { Command::QProcessStartDetached, QProcessStartDetached },
+    { Command::QProcessStartDetached2, QProcessStartDetached2 },
+    { Command::QProcessSetWorkingDirectory, QProcessSetWorkingDirectory },
+    { Command::QProcessSetEnvironment, QProcessSetEnvironment },
+    { Command::QProcessEnvironment, QProcessEnvironment },
+    { Command::QProcessStart3Arg, QProcessStart3Arg },
+    { Command::QProcessStart2Arg, QProcessStart2Arg },
+    { Command::QProcessState, QProcessState },
+    { Command::QProcessTerminate, QProcessTerminate },
+    { Command::QProcessWaitForFinished, QProcessWaitForFinished },
+    { Command::QProcessWaitForStarted, QProcessWaitForStarted },
+    { Command::QProcessWorkingDirectory, QProcessWorkingDirectory },
+    { Command::QProcessErrorString, QProcessErrorString },
+    { Command::QProcessReadChannel, QProcessReadChannel },
+    { Command::QProcessSetReadChannel, QProcessSetReadChannel },
+    { Command::QProcessWrite, QProcessWrite },
+    { Command::QProcessProcessChannelMode, QProcessProcessChannelMode },
+    { Command::QProcessSetProcessChannelMode, QProcessSetProcessChannelMode },
+    { Command::QProcessSetNativeArguments, QProcessSetNativeArguments },
+    { Command::QSettingsAllKeys, QSettingsAllKeys },
+    { Command::QSettingsBeginGroup, QSettingsBeginGroup },
+    { Command::QSettingsBeginWriteArray, QSettingsBeginWriteArray },
+    { Command::QSettingsBeginReadArray, QSettingsBeginReadArray },
+    { Command::QSettingsChildGroups, QSettingsChildGroups },
+    { Command::QSettingsChildKeys, QSettingsChildKeys },
+    { Command::QSettingsClear, QSettingsClear },
+    { Command::QSettingsContains, QSettingsContains },
+    { Command::QSettingsEndArray, QSettingsEndArray },
+    { Command::QSettingsEndGroup, QSettingsEndGroup },
+    { Command::QSettingsFallbacksEnabled, QSettingsFallbacksEnabled },
+    { Command::QSettingsFileName, QSettingsFileName },
+    { Command::QSettingsGroup, QSettingsGroup },
+    { Command::QSettingsIsWritable, QSettingsIsWritable },
+    { Command::QSettingsRemove, QSettingsRemove },
+    { Command::QSettingsSetArrayIndex, QSettingsSetArrayIndex },
+    { Command::QSettingsSetFallbacksEnabled, QSettingsSetFallbacksEnabled },
+    { Command::QSettingsStatus, QSettingsStatus },
+    { Command::QSettingsSync, QSettingsSync },
+    { Command::QSettingsSetValue, QSettingsSetValue },
+    { Command::QSettingsValue, QSettingsValue },
+    { Command::QSettingsOrganizationName, QSettingsOrganizationName },
+    { Command::QSettingsApplicationName, QSettingsApplicationName },
+    { Command::QAbstractFileEngineAtEnd, QAbstractFileEngineAtEnd },
+    { Command::QAbstractFileEngineCaseSensitive, QAbstractFileEngineCaseSensitive },
+    { Command::QAbstractFileEngineClose, QAbstractFileEngineClose },
+    { Command::QAbstractFileEngineCopy, QAbstractFileEngineCopy },
+    { Command::QAbstractFileEngineEntryList, QAbstractFileEngineEntryList },
+    { Command::QAbstractFileEngineError, QAbstractFileEngineError },
+    { Command::QAbstractFileEngineErrorString, QAbstractFileEngineErrorString },
+    { Command::QAbstractFileEngineFileFlags, QAbstractFileEngineFileFlags },
+    { Command::QAbstractFileEngineFileName, QAbstractFileEngineFileName },
+    { Command::QAbstractFileEngineFlush, QAbstractFileEngineFlush },
+    { Command::QAbstractFileEngineHandle, QAbstractFileEngineHandle },
+    { Command::QAbstractFileEngineIsRelativePath, QAbstractFileEngineIsRelativePath },
+    { Command::QAbstractFileEngineIsSequential, QAbstractFileEngineIsSequential },
+    { Command::QAbstractFileEngineLink, QAbstractFileEngineLink },
+    { Command::QAbstractFileEngineMkdir, QAbstractFileEngineMkdir },
+    { Command::QAbstractFileEngineOpen, QAbstractFileEngineOpen },
+    { Command::QAbstractFileEngineOwner, QAbstractFileEngineOwner },
+    { Command::QAbstractFileEngineOwnerId, QAbstractFileEngineOwnerId },
+    { Command::QAbstractFileEnginePos, QAbstractFileEnginePos },
+    { Command::QAbstractFileEngineRead, QAbstractFileEngineRead },
+    { Command::QAbstractFileEngineReadLine, QAbstractFileEngineReadLine },
+    { Command::QAbstractFileEngineRemove, QAbstractFileEngineRemove },
+    { Command::QAbstractFileEngineRename, QAbstractFileEngineRename },
+    { Command::QAbstractFileEngineRmdir, QAbstractFileEngineRmdir },
+    { Command::QAbstractFileEngineSeek, QAbstractFileEngineSeek },
+    { Command::QAbstractFileEngineSetFileName, QAbstractFileEngineSetFileName },
+    { Command::QAbstractFileEngineSetPermissions, QAbstractFileEngineSetPermissions },
+    { Command::QAbstractFileEngineSetSize, QAbstractFileEngineSetSize },
+    { Command::QAbstractFileEngineSize, QAbstractFileEngineSize },
+    { Command::QAbstractFileEngineSupportsExtension, QAbstractFileEngineSupportsExtension },
+    { Command::QAbstractFileEngineExtension, QAbstractFileEngineExtension },
+    { Command::QAbstractFileEngineWrite, QAbstractFileEngineWrite },
+    { Command::QAbstractFileEngineSyncToDisk, QAbstractFileEngineSyncToDisk },
+    { Command::QAbstractFileEngineRenameOverwrite, QAbstractFileEngineRenameOverwrite },
+    { Command::QAbstractFileEngineFileTime, QAbstractFileEngineFileTime },
+    { Command::QAbstractFileEngineOpenAndStat, QAbstractFileEngineOpenAndStat },
+    { Command::AbstractArchiveOpen, AbstractArchiveOpen },
+    { Command::AbstractArchiveClose, AbstractArchiveClose },
+    { Command::AbstractArchiveSetFilename, AbstractArchiveSetFilename },
+    { Command::AbstractArchiveErrorString, AbstractArchiveErrorString },
+    { Command::AbstractArchiveExtract, AbstractArchiveExtract },
+    { Command::AbstractArchiveCreate, AbstractArchiveCreate },
+    { Command::AbstractArchiveList, AbstractArchiveList },
+    { Command::AbstractArchiveIsSupported, AbstractArchiveIsSupported },
+    { Command::AbstractArchiveSetCompressionLevel, AbstractArchiveSetCompressionLevel },
+    { Command::AbstractArchiveAddDataBlock, AbstractArchiveAddDataBlock },
+    { Command::AbstractArchiveSetClientDataAtEnd, AbstractArchiveSetClientDataAtEnd },
+    { Command::AbstractArchiveSetFilePosition, AbstractArchiveSetFilePosition },
+    { Command::AbstractArchiveWorkerStatus, AbstractArchiveWorkerStatus },
+    { Command::AbstractArchiveCancel, AbstractArchiveCancel },
+};
+
+// Every command except Command::Invalid needs an entry. Adding or changing commands changes
+// the protocol, so Version needs to be bumped together with this count.
+static_assert(sizeof(commandEntries) / sizeof(commandEntries[0]) == 105,
+    "Protocol::commandEntries is out of sync with Protocol::Command.");
+
+} // namespace Protocol
+
+class CommandTable
+{
+public:
+    CommandTable()
+    {
+        for (const Protocol::CommandEntry &entry : Protocol::commandEntries) {
+            commands.insert(QByteArray(entry.name), entry.command);
+            const int id = static_cast<int>(entry.command);
+            if (names.size() <= id)
+                names.resize(id + 1);
+            Q_ASSERT_X(!names.at(id), Q_FUNC_INFO, "Duplicate Protocol::Command value.");
+            names[id] = entry.name;
+        }
+    }
+
+    QHash<QByteArray, Protocol::Command> commands;
+    QVector<const char *> names;
+};
+
+Q_GLOBAL_STATIC(CommandTable, commandTable)
+
 /*!
     \inmodule QtInstallerFramework
     \namespace QInstaller::Protocol
@@ -53,6 +200,14 @@ typedef qint32 PackageSize;
     \value SuperUser
 */
 
+/*!
+    \enum QInstaller::Protocol::Command
+
+    Numeric identifiers of the commands sent between client and server. If both
+    sides use the same protocol version, packets carry these instead of the command
+    names. The values are part of the protocol, changing them requires a new version.
+*/
+
 /*!
     Write a packet containing \a command and \a data to \a device.
 
@@ -113,4 +268,55 @@ bool receivePacket(QIODevice *device, QByteArray *command, QByteArray *data)
     return true;
 }
 
+/*!
+    Returns the packet representation of \a command. The identifier is written as two
+    bytes with the high bit set, so it can neither contain the packet separator nor be
+    mistaken for a command name.
+*/
+QByteArray encodeCommand(Protocol::Command command)
+{
+    const quint16 id = static_cast<quint16>(command);
+    Q_ASSERT(id < (1 << 14));
+
+    const char bytes[2] = { char(0x80 | (id >> 7)), char(0x80 | (id & 0x7f)) };
+    return QByteArray(bytes, 2);
+}
+
+/*!
+    Returns the command identified by the packet field \a command, which either contains
+    an encoded identifier or a command name. Returns \c Protocol::Command::Invalid for
+    unknown commands.
+*/
+Protocol::Command decodeCommand(const QByteArray &command)
+{
+    if (command.size() == 2 && (command.at(0) & 0x80) && (command.at(1) & 0x80)) {
+        const int id = ((uchar(command.at(0)) & 0x7f) << 7) | (uchar(command.at(1)) & 0x7f);
+        const QVector<const char *> &names = commandTable()->names;
+        if (id < names.size() && names.at(id))
+            return static_cast<Protocol::Command>(id);
+        return Protocol::Command::Invalid;
+    }
+    return commandFromName(command);
+}
+
+/*!
+    Returns the command called \a name, or \c Protocol::Command::Invalid if there is none.
+*/
+Protocol::Command commandFromName(const QByteArray &name)
+{
+    return commandTable()->commands.value(name, Protocol::Command::Invalid);
+}
+
+/*!
+    Returns the name of \a command, or an empty string for unknown commands.
+*/
+const char *commandName(Protocol::Command command)
+{
+    const int id = static_cast<int>(command);
+    const QVector<const char *> &names = commandTable()->names;
+    if (id < names.size() && names.at(id))
+        return names.at(id);
+    return "";
+}
+
 } // namespace QInstaller
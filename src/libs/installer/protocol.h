@@ -31,6 +31,8 @@
 
 #include "installer_global.h"
 
+#include <QDataStream>
+
 QT_FORWARD_DECLARE_CLASS(QIODevice)
 
 namespace QInstaller {
@@ -48,6 +50,10 @@ enum struct StartAs {
     SuperUser
 };
 
+// Version 1 sends commands by name, later versions send the numeric Command identifiers.
+// Bump the version whenever the values of Command change.
+const quint32 Version = 3;
+
 const char DefaultSocket[] = "ifw_srv";
 const char DefaultAuthorizationKey[] = "DefaultAuthorizationKey";
 const char DefaultReply[] = "DefaultReply";
@@ -163,6 +169,27 @@ const char QAbstractFileEngineWrite[] = "QAbstractFileEngine::write";
 const char QAbstractFileEngineSyncToDisk[] = "QAbstractFileEngine::syncToDisk";
 const char QAbstractFileEngineRenameOverwrite[] = "QAbstractFileEngine::renameOverwrite";
 const char QAbstractFileEngineFileTime[] = "QAbstractFileEngine::fileTime";
+const char QAbstractFileEngineOpenAndStat[] = "QAbstractFileEngine::openAndStat";
+
+// Reply to QAbstractFileEngineOpenAndStat, saves the size(), pos() and isSequential()
+// round trips otherwise done right after opening a file.
+struct FileEngineOpenReply
+{
+    bool opened = false;
+    bool sequential = false;
+    qint64 size = -1;
+    qint64 pos = 0;
+};
+
+inline QDataStream &operator<<(QDataStream &stream, const FileEngineOpenReply &reply)
+{
+    return stream << reply.opened << reply.sequential << reply.size << reply.pos;
+}
+
+inline QDataStream &operator>>(QDataStream &stream, FileEngineOpenReply &reply)
+{
+    return stream >> reply.opened >> reply.sequential >> reply.size >> reply.pos;
+}
 
 
 // LibArchiveWrapper
@@ -189,11 +216,147 @@ const char AbstractArchiveSignalDataBlockRequested[] = "AbstractArchive::dataBlo
 const char AbstractArchiveSignalSeekRequested[] = "AbstractArchive::seekRequested";
 const char AbstractArchiveSignalWorkerFinished[] = "AbstractArchive::workerFinished";
 
+// Numeric identifiers of the commands above, sent instead of the command names if both
+// sides use the same protocol Version. The values are part of the protocol: never reuse or
+// renumber a value without bumping Version, and add new commands at the end of the range
+// of their wrapped type. The commands of each wrapped type need to stay consecutive.
+enum struct Command : quint16 {
+    Invalid = 0,
+
+    Create = 1,
+    Shutdown = 2,
+    Authorize = 3,
+    Reply = 4,
+    GetQProcessSignals = 5,
+    GetAbstractArchiveSignals = 6,
+
+    // QProcessWrapper
+    QProcessCloseWriteChannel = 100,
+    QProcessExitCode = 101,
+    QProcessExitStatus = 102,
+    QProcessKill = 103,
+    QProcessReadAll = 104,
+    QProcessReadAllStandardOutput = 105,
+    QProcessReadAllStandardError = 106,
+    QProcessStartDetached = 107,
+    QProcessStartDetached2 = 108,
+    QProcessSetWorkingDirectory = 109,
+    QProcessSetEnvironment = 110,
+    QProcessEnvironment = 111,
+    QProcessStart3Arg = 112,
+    QProcessStart2Arg = 113,
+    QProcessState = 114,
+    QProcessTerminate = 115,
+    QProcessWaitForFinished = 116,
+    QProcessWaitForStarted = 117,
+    QProcessWorkingDirectory = 118,
+    QProcessErrorString = 119,
+    QProcessReadChannel = 120,
+    QProcessSetReadChannel = 121,
+    QProcessWrite = 122,
+    QProcessProcessChannelMode = 123,
+    QProcessSetProcessChannelMode = 124,
+    QProcessSetNativeArguments = 125,
+
+    // QSettingsWrapper
+    QSettingsAllKeys = 200,
+    QSettingsBeginGroup = 201,
+    QSettingsBeginWriteArray = 202,
+    QSettingsBeginReadArray = 203,
+    QSettingsChildGroups = 204,
+    QSettingsChildKeys = 205,
+    QSettingsClear = 206,
+    QSettingsContains = 207,
+    QSettingsEndArray = 208,
+    QSettingsEndGroup = 209,
+    QSettingsFallbacksEnabled = 210,
+    QSettingsFileName = 211,
+    QSettingsGroup = 212,
+    QSettingsIsWritable = 213,
+    QSettingsRemove = 214,
+    QSettingsSetArrayIndex = 215,
+    QSettingsSetFallbacksEnabled = 216,
+    QSettingsStatus = 217,
+    QSettingsSync = 218,
+    QSettingsSetValue = 219,
+    QSettingsValue = 220,
+    QSettingsOrganizationName = 221,
+    QSettingsApplicationName = 222,
+
+    // RemoteFileEngine
+    QAbstractFileEngineAtEnd = 300,
+    QAbstractFileEngineCaseSensitive = 301,
+    QAbstractFileEngineClose = 302,
+    QAbstractFileEngineCopy = 303,
+    QAbstractFileEngineEntryList = 304,
+    QAbstractFileEngineError = 305,
+    QAbstractFileEngineErrorString = 306,
+    QAbstractFileEngineFileFlags = 307,
+    QAbstractFileEngineFileName = 308,
+    QAbstractFileEngineFlush = 309,
+    QAbstractFileEngineHandle = 310,
+    QAbstractFileEngineIsRelativePath = 311,
+    QAbstractFileEngineIsSequential = 312,
+    QAbstractFileEngineLink = 313,
+    QAbstractFileEngineMkdir = 314,
+    QAbstractFileEngineOpen = 315,
+    QAbstractFileEngineOwner = 316,
+    QAbstractFileEngineOwnerId = 317,
+    QAbstractFileEnginePos = 318,
+    QAbstractFileEngineRead = 319,
+    QAbstractFileEngineReadLine = 320,
+    QAbstractFileEngineRemove = 321,
+    QAbstractFileEngineRename = 322,
+    QAbstractFileEngineRmdir = 323,
+    QAbstractFileEngineSeek = 324,
+    QAbstractFileEngineSetFileName = 325,
+    QAbstractFileEngineSetPermissions = 326,
+    QAbstractFileEngineSetSize = 327,
+    QAbstractFileEngineSize = 328,
+    QAbstractFileEngineSupportsExtension = 329,
+    QAbstractFileEngineExtension = 330,
+    QAbstractFileEngineWrite = 331,
+    QAbstractFileEngineSyncToDisk = 332,
+    QAbstractFileEngineRenameOverwrite = 333,
+    QAbstractFileEngineFileTime = 334,
+    QAbstractFileEngineOpenAndStat = 335,
+
+    // LibArchiveWrapper
+    AbstractArchiveOpen = 400,
+    AbstractArchiveClose = 401,
+    AbstractArchiveSetFilename = 402,
+    AbstractArchiveErrorString = 403,
+    AbstractArchiveExtract = 404,
+    AbstractArchiveCreate = 405,
+    AbstractArchiveList = 406,
+    AbstractArchiveIsSupported = 407,
+    AbstractArchiveSetCompressionLevel = 408,
+    AbstractArchiveAddDataBlock = 409,
+    AbstractArchiveSetClientDataAtEnd = 410,
+    AbstractArchiveSetFilePosition = 411,
+    AbstractArchiveWorkerStatus = 412,
+    AbstractArchiveCancel = 413,
+};
+
+// The ranges of the wrapped types must not overlap, and all identifiers must fit into the
+// 14 bits written by encodeCommand().
+static_assert(quint16(Command::GetAbstractArchiveSignals) < quint16(Command::QProcessCloseWriteChannel)
+    && quint16(Command::QProcessSetNativeArguments) < quint16(Command::QSettingsAllKeys)
+    && quint16(Command::QSettingsApplicationName) < quint16(Command::QAbstractFileEngineAtEnd)
+    && quint16(Command::QAbstractFileEngineOpenAndStat) < quint16(Command::AbstractArchiveOpen)
+    && quint16(Command::AbstractArchiveCancel) < (1 << 14),
+    "Protocol::Command ranges overlap or exceed the encodable identifiers.");
+
 } // namespace Protocol
 
 void INSTALLER_EXPORT sendPacket(QIODevice *device, const QByteArray &command, const QByteArray &data);
 bool INSTALLER_EXPORT receivePacket(QIODevice *device, QByteArray *command, QByteArray *data);
 
+QByteArray INSTALLER_EXPORT encodeCommand(Protocol::Command command);
+Protocol::Command INSTALLER_EXPORT decodeCommand(const QByteArray &command);
+Protocol::Command INSTALLER_EXPORT commandFromName(const QByteArray &name);
+const char INSTALLER_EXPORT *commandName(Protocol::Command command);
+
 } // namespace QInstaller
 
 #endif // PROTOCOL_H
@@ -35,6 +35,17 @@
 
 namespace QInstaller {
 
+// Bytes fetched per read round trip, the next window is requested in the
+// background once half of the current one has been consumed.
+static const qint64 ReadAheadSize = 1024 * 1024;
+// Bytes collected before a write is sent, and the number of writes that may
+// be in flight before waiting for the server to acknowledge them.
+static const int WriteBehindSize = 1024 * 1024;
+static const int MaxPendingWrites = 4;
+
+// Set while a RemoteFileEngine::ScopedWriteBehind exists on the current thread.
+static thread_local bool s_writeBehind = false;
+
 /*!
     \inmodule QtInstallerFramework
     \class QInstaller::RemoteFileEngineHandler
@@ -115,26 +126,73 @@ QString RemoteFileEngineIterator::currentFileName() const
 }
 
 
+/*!
+    \class QInstaller::RemoteFileEngine::ScopedWriteBehind
+    \inmodule QtInstallerFramework
+    \internal
+
+    Enables write-behind for the files opened through the remote server on the
+    current thread while the object exists. Such files must be flushed, and the
+    result of flush() checked, before they are closed.
+*/
+RemoteFileEngine::ScopedWriteBehind::ScopedWriteBehind()
+    : m_enabled(s_writeBehind)
+{
+    s_writeBehind = true;
+}
+
+RemoteFileEngine::ScopedWriteBehind::~ScopedWriteBehind()
+{
+    s_writeBehind = m_enabled;
+}
+
+
 /*!
     \class QInstaller::RemoteFileEngine
     \inmodule QtInstallerFramework
     \internal
+
+    Regular files opened through the remote server are read with a read-ahead
+    window, so that sequential reading costs one round trip per window instead
+    of one per QFile chunk. The server reads the next window while the client
+    consumes the current one.
+
+    Files opened while a ScopedWriteBehind exists are also written with a
+    write-behind window, the server writes one window while the client produces
+    the next. A write that fails on the server is then only reported by a later
+    write, flush(), or close(), so only callers that check flush() before
+    closing the file may enable it. All other writes are sent one by one and
+    report errors right away.
 */
 RemoteFileEngine::RemoteFileEngine()
     : RemoteObject(QLatin1String(Protocol::QAbstractFileEngine))
+    , m_buffered(false)
+    , m_writeBehind(false)
+    , m_size(-1)
+    , m_position(0)
+    , m_readBufferPos(0)
+    , m_readAheadPending(false)
+    , m_remoteAtEnd(false)
+    , m_writeFailed(false)
+    , m_deferredWriteError(false)
 {
 }
 
 RemoteFileEngine::~RemoteFileEngine()
 {
+    if (m_buffered && isConnectedToServer())
+        flushWriteBuffer();
 }
 
 /*!
 */
 bool RemoteFileEngine::atEnd() const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
+    if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
+        if (m_buffered && m_size >= 0)
+            return m_position >= m_size;
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineAtEnd));
+    }
     return m_fileEngine.atEnd();
 }
 
@@ -175,8 +233,12 @@ bool RemoteFileEngine::caseSensitive() const
 */
 bool RemoteFileEngine::close()
 {
-    if (connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineClose));
+    if (connectToServer()) {
+        const bool flushed = !m_buffered || flushWriteBuffer();
+        resetBuffers();
+        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineClose))
+            && flushed;
+    }
     return m_fileEngine.close();
 }
 
@@ -207,6 +269,8 @@ QStringList RemoteFileEngine::entryList(QDir::Filters filters, const QStringList
 */
 QFile::FileError RemoteFileEngine::error() const
 {
+    if (m_deferredWriteError)
+        return QAbstractFileEngine::error();
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
         return static_cast<QFile::FileError>
             (callRemoteMethod<qint32>(QString::fromLatin1(Protocol::QAbstractFileEngineError)));
@@ -218,6 +282,8 @@ QFile::FileError RemoteFileEngine::error() const
 */
 QString RemoteFileEngine::errorString() const
 {
+    if (m_deferredWriteError)
+        return QAbstractFileEngine::errorString();
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
         return callRemoteMethod<QString>(QString::fromLatin1(Protocol::QAbstractFileEngineErrorString));
     return m_fileEngine.errorString();
@@ -263,8 +329,11 @@ QString RemoteFileEngine::fileName(FileName file) const
 */
 bool RemoteFileEngine::flush()
 {
-    if (connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineFlush));
+    if (connectToServer()) {
+        const bool flushed = !m_buffered || flushWriteBuffer();
+        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineFlush))
+            && flushed;
+    }
     return m_fileEngine.flush();
 }
 
@@ -293,8 +362,11 @@ bool RemoteFileEngine::isRelativePath() const
 */
 bool RemoteFileEngine::isSequential() const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
+    if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
+        if (m_buffered)
+            return false; // sequential files are never buffered
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineIsSequential));
+    }
     return m_fileEngine.isSequential();
 }
 
@@ -328,8 +400,21 @@ bool RemoteFileEngine::mkdir(const QString &dirName, bool createParentDirectorie
 bool RemoteFileEngine::open(QIODevice::OpenMode mode)
 {
     if (connectToServer()) {
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineOpen),
+        const Protocol::FileEngineOpenReply reply = callRemoteMethod<Protocol::FileEngineOpenReply>
+            (QString::fromLatin1(Protocol::QAbstractFileEngineOpenAndStat),
             static_cast<qint32>(mode | QIODevice::Unbuffered));
+
+        resetBuffers();
+        m_deferredWriteError = false;
+        if (reply.opened) {
+            // Appending writes always go to the end of the file on the server side,
+            // which the client side position tracking does not model.
+            m_buffered = !reply.sequential && !(mode & QIODevice::Append);
+            m_writeBehind = m_buffered && s_writeBehind;
+            m_size = reply.size;
+            m_position = reply.pos;
+        }
+        return reply.opened;
     }
     return m_fileEngine.open(mode | QIODevice::Unbuffered);
 }
@@ -363,8 +448,11 @@ uint RemoteFileEngine::ownerId(FileOwner owner) const
 */
 qint64 RemoteFileEngine::pos() const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
+    if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
+        if (m_buffered)
+            return m_position;
         return callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEnginePos));
+    }
     return m_fileEngine.pos();
 }
 
@@ -407,8 +495,33 @@ bool RemoteFileEngine::rmdir(const QString &dirName, bool recurseParentDirectori
 */
 bool RemoteFileEngine::seek(qint64 offset)
 {
-    if (connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSeek), offset);
+    if (connectToServer()) {
+        if (!m_buffered)
+            return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSeek), offset);
+
+        if (!flushWriteBuffer())
+            return false;
+        if (m_readAheadPending)
+            receivePendingReplies();
+
+        // Seeking inside the read-ahead window does not need the server.
+        const qint64 bufferStart = m_position - m_readBufferPos;
+        if (offset >= bufferStart && offset <= bufferStart + m_readBuffer.size()) {
+            m_readBufferPos = offset - bufferStart;
+            m_position = offset;
+            return true;
+        }
+
+        m_readBuffer.clear();
+        m_readBufferPos = 0;
+        m_remoteAtEnd = false;
+        if (!callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSeek), offset)) {
+            m_position = callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEnginePos));
+            return false;
+        }
+        m_position = offset;
+        return true;
+    }
     return m_fileEngine.seek(offset);
 }
 
@@ -442,8 +555,14 @@ bool RemoteFileEngine::setPermissions(uint perms)
 bool RemoteFileEngine::setSize(qint64 size)
 {
     if (connectToServer()) {
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSetSize),
-            size);
+        if (m_buffered && !(flushWriteBuffer() && discardReadAhead()))
+            return false;
+
+        const bool resized = callRemoteMethod<bool>
+            (QString::fromLatin1(Protocol::QAbstractFileEngineSetSize), size);
+        if (resized && m_buffered)
+            m_size = size;
+        return resized;
     }
     return m_fileEngine.setSize(size);
 }
@@ -453,8 +572,11 @@ bool RemoteFileEngine::setSize(qint64 size)
 */
 qint64 RemoteFileEngine::size() const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
+    if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
+        if (m_buffered && m_size >= 0)
+            return m_size;
         return callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEngineSize));
+    }
     return m_fileEngine.size();
 }
 
@@ -474,15 +596,11 @@ bool RemoteFileEngine::supportsExtension(Extension extension) const
 qint64 RemoteFileEngine::read(char *data, qint64 maxlen)
 {
     if (connectToServer()) {
-        QPair<qint64, QByteArray> result = callRemoteMethod<QPair<qint64, QByteArray> >
-            (QString::fromLatin1(Protocol::QAbstractFileEngineRead), maxlen);
-
-        if (result.first <= 0)
-            return result.first;
-
-        QDataStream dataStream(result.second);
-        dataStream.readRawData(data, result.first);
-        return result.first;
+        if (!m_buffered)
+            return readUnbuffered(data, maxlen);
+        if (!flushWriteBuffer())
+            return -1;
+        return readBuffered(data, maxlen);
     }
     return m_fileEngine.read(data, maxlen);
 }
@@ -493,6 +611,9 @@ qint64 RemoteFileEngine::read(char *data, qint64 maxlen)
 qint64 RemoteFileEngine::readLine(char *data, qint64 maxlen)
 {
     if (connectToServer()) {
+        if (m_buffered && !(flushWriteBuffer() && discardReadAhead()))
+            return -1;
+
         QPair<qint64, QByteArray> result = callRemoteMethod<QPair<qint64, QByteArray> >
             (QString::fromLatin1(Protocol::QAbstractFileEngineReadLine), maxlen);
 
@@ -501,6 +622,8 @@ qint64 RemoteFileEngine::readLine(char *data, qint64 maxlen)
 
         QDataStream dataStream(result.second);
         dataStream.readRawData(data, result.first);
+        if (m_buffered)
+            m_position += result.first;
         return result.first;
     }
     return m_fileEngine.readLine(data, maxlen);
@@ -512,16 +635,44 @@ qint64 RemoteFileEngine::readLine(char *data, qint64 maxlen)
 qint64 RemoteFileEngine::write(const char *data, qint64 len)
 {
     if (connectToServer()) {
-        QByteArray ba(data, len);
-        return callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEngineWrite), ba);
+        if (!m_buffered) {
+            QByteArray ba(data, len);
+            return callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEngineWrite), ba);
+        }
+        if (!discardReadAhead())
+            return -1;
+
+        if (!m_writeBehind) {
+            const qint64 written = callRemoteMethod<qint64>(QString::fromLatin1(Protocol
+                ::QAbstractFileEngineWrite), QByteArray(data, len));
+            if (written > 0) {
+                m_position += written;
+                if (m_size >= 0)
+                    m_size = qMax(m_size, m_position);
+            }
+            return written;
+        }
+
+        m_writeBuffer.append(data, static_cast<int>(len));
+        if (m_writeBuffer.size() >= WriteBehindSize && !postWriteBuffer()) {
+            flushWriteBuffer();
+            return -1;
+        }
+        m_position += len;
+        if (m_size >= 0)
+            m_size = qMax(m_size, m_position);
+        return len;
     }
     return m_fileEngine.write(data, len);
 }
 
 bool RemoteFileEngine::syncToDisk()
 {
-    if (connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSyncToDisk));
+    if (connectToServer()) {
+        const bool flushed = !m_buffered || flushWriteBuffer();
+        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSyncToDisk))
+            && flushed;
+    }
     return m_fileEngine.syncToDisk();
 }
 
@@ -544,4 +695,213 @@ QDateTime RemoteFileEngine::fileTime(FileTime time) const
     return m_fileEngine.fileTime(time);
 }
 
+/*!
+    \internal
+
+    Reads the replies of all posted read-ahead and write requests.
+*/
+void RemoteFileEngine::receivePendingReplies()
+{
+    if (m_readAheadPending) {
+        m_readAheadPending = false;
+        appendReadAhead(takeRemoteReply<QPair<qint64, QByteArray> >
+            (QString::fromLatin1(Protocol::QAbstractFileEngineRead)));
+    }
+    while (!m_pendingWrites.isEmpty())
+        receivePendingWrite();
+}
+
+/*!
+    \internal
+
+    Requests the next read-ahead window from the server without waiting for it.
+*/
+void RemoteFileEngine::postReadAhead()
+{
+    postRemoteMethod(QString::fromLatin1(Protocol::QAbstractFileEngineRead), ReadAheadSize);
+    m_readAheadPending = true;
+}
+
+/*!
+    \internal
+
+    Appends the data of the read reply \a result to the read-ahead window and returns
+    the number of bytes read by the server, or \c -1 on error.
+*/
+qint64 RemoteFileEngine::appendReadAhead(const QPair<qint64, QByteArray> &result)
+{
+    if (result.first < ReadAheadSize)
+        m_remoteAtEnd = true;
+    if (result.first > 0) {
+        m_readBuffer.remove(0, m_readBufferPos);
+        m_readBufferPos = 0;
+        m_readBuffer.append(result.second.constData(), result.first);
+    }
+    return result.first;
+}
+
+/*!
+    \internal
+*/
+qint64 RemoteFileEngine::readBuffered(char *data, qint64 maxlen)
+{
+    qint64 total = 0;
+    while (total < maxlen) {
+        const qint64 available = m_readBuffer.size() - m_readBufferPos;
+        if (available > 0) {
+            const qint64 count = qMin(available, maxlen - total);
+            memcpy(data + total, m_readBuffer.constData() + m_readBufferPos, count);
+            m_readBufferPos += count;
+            m_position += count;
+            total += count;
+            continue;
+        }
+
+        m_readBuffer.clear();
+        m_readBufferPos = 0;
+        if (m_readAheadPending) {
+            receivePendingReplies();
+            continue;
+        }
+        if (m_remoteAtEnd && total > 0)
+            break;
+
+        m_remoteAtEnd = false;
+        qint64 result = 0;
+        if (maxlen - total >= ReadAheadSize) {
+            // Large reads go straight into the caller's buffer.
+            result = readUnbuffered(data + total, maxlen - total);
+            if (result > 0) {
+                m_position += result;
+                total += result;
+            }
+            if (total < maxlen)
+                m_remoteAtEnd = true;
+        } else {
+            result = appendReadAhead(callRemoteMethod<QPair<qint64, QByteArray> >
+                (QString::fromLatin1(Protocol::QAbstractFileEngineRead), ReadAheadSize));
+        }
+        if (result <= 0)
+            return total > 0 ? total : result;
+    }
+
+    if (!m_readAheadPending && !m_remoteAtEnd
+            && (m_readBuffer.size() - m_readBufferPos) < ReadAheadSize / 2) {
+        postReadAhead();
+    }
+    return total;
+}
+
+/*!
+    \internal
+*/
+qint64 RemoteFileEngine::readUnbuffered(char *data, qint64 maxlen)
+{
+    QPair<qint64, QByteArray> result = callRemoteMethod<QPair<qint64, QByteArray> >
+        (QString::fromLatin1(Protocol::QAbstractFileEngineRead), maxlen);
+
+    if (result.first <= 0)
+        return result.first;
+
+    QDataStream dataStream(result.second);
+    dataStream.readRawData(data, result.first);
+    return result.first;
+}
+
+/*!
+    \internal
+
+    Drops the read-ahead window and moves the server back to the client side
+    position. Returns \c false if the server could not seek.
+*/
+bool RemoteFileEngine::discardReadAhead()
+{
+    if (m_readAheadPending)
+        receivePendingReplies();
+
+    const qint64 ahead = m_readBuffer.size() - m_readBufferPos;
+    m_readBuffer.clear();
+    m_readBufferPos = 0;
+    m_remoteAtEnd = false;
+    if (ahead == 0)
+        return true;
+    return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSeek),
+        m_position);
+}
+
+/*!
+    \internal
+*/
+void RemoteFileEngine::receivePendingWrite()
+{
+    const qint64 expected = m_pendingWrites.dequeue();
+    if (takeRemoteReply<qint64>(QString::fromLatin1(Protocol::QAbstractFileEngineWrite)) != expected)
+        m_writeFailed = true;
+}
+
+/*!
+    \internal
+
+    Sends the write-behind window to the server without waiting for the reply, unless
+    the maximum number of writes is already in flight. Returns \c false if any of the
+    acknowledged writes failed.
+*/
+bool RemoteFileEngine::postWriteBuffer()
+{
+    if (!m_writeBuffer.isEmpty()) {
+        while (m_pendingWrites.size() >= MaxPendingWrites)
+            receivePendingWrite();
+        postRemoteMethod(QString::fromLatin1(Protocol::QAbstractFileEngineWrite), m_writeBuffer);
+        m_pendingWrites.enqueue(m_writeBuffer.size());
+        m_writeBuffer.clear();
+    }
+    return !m_writeFailed;
+}
+
+/*!
+    \internal
+
+    Sends the write-behind window and waits until the server has acknowledged all
+    writes. Returns \c false if any of them failed, in which case the error of the
+    server is kept as error of this engine until the file is opened again, so that
+    QFile reports it even though write() had already returned. The client side
+    position and size are read back from the server.
+*/
+bool RemoteFileEngine::flushWriteBuffer()
+{
+    postWriteBuffer();
+    receivePendingReplies();
+    if (!m_writeFailed)
+        return true;
+
+    m_writeFailed = false;
+    const QFile::FileError error = static_cast<QFile::FileError>
+        (callRemoteMethod<qint32>(QString::fromLatin1(Protocol::QAbstractFileEngineError)));
+    setError(error == QFile::NoError ? QFile::WriteError : error,
+        callRemoteMethod<QString>(QString::fromLatin1(Protocol::QAbstractFileEngineErrorString)));
+    m_deferredWriteError = true;
+
+    m_position = callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEnginePos));
+    m_size = callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEngineSize));
+    return false;
+}
+
+/*!
+    \internal
+*/
+void RemoteFileEngine::resetBuffers()
+{
+    Q_ASSERT(!m_readAheadPending && m_pendingWrites.isEmpty());
+
+    m_buffered = false;
+    m_writeBehind = false;
+    m_size = -1;
+    m_position = 0;
+    m_readBuffer.clear();
+    m_readBufferPos = 0;
+    m_remoteAtEnd = false;
+    m_writeBuffer.clear();
+    m_writeFailed = false;
+}
+
 } // namespace QInstaller
@@ -34,6 +34,8 @@
 #include <QtCore/private/qabstractfileengine_p.h>
 #include <QtCore/private/qfsfileengine_p.h>
 
+#include <QQueue>
+
 namespace QInstaller {
 
 class INSTALLER_EXPORT RemoteFileEngineHandler : public QAbstractFileEngineHandler
@@ -50,6 +52,18 @@ class RemoteFileEngine : public RemoteObject, public QAbstractFileEngine
     Q_DISABLE_COPY(RemoteFileEngine)
 
 public:
+    class ScopedWriteBehind
+    {
+        Q_DISABLE_COPY(ScopedWriteBehind)
+
+    public:
+        ScopedWriteBehind();
+        ~ScopedWriteBehind();
+
+    private:
+        const bool m_enabled;
+    };
+
     RemoteFileEngine();
     ~RemoteFileEngine();
 
@@ -98,8 +112,38 @@ public:
         ExtensionReturn *output = 0) override;
     bool supportsExtension(Extension extension) const override;
 
+private:
+    void receivePendingReplies() override;
+
+    void postReadAhead();
+    qint64 readBuffered(char *data, qint64 maxlen);
+    qint64 readUnbuffered(char *data, qint64 maxlen);
+    qint64 appendReadAhead(const QPair<qint64, QByteArray> &result);
+    bool discardReadAhead();
+
+    void receivePendingWrite();
+    bool postWriteBuffer();
+    bool flushWriteBuffer();
+
+    void resetBuffers();
+
 private:
     QFSFileEngine m_fileEngine;
+
+    bool m_buffered;
+    bool m_writeBehind;
+    qint64 m_size;
+    qint64 m_position;
+
+    QByteArray m_readBuffer;
+    qint64 m_readBufferPos;
+    bool m_readAheadPending;
+    bool m_remoteAtEnd;
+
+    QByteArray m_writeBuffer;
+    QQueue<qint64> m_pendingWrites;
+    bool m_writeFailed;
+    bool m_deferredWriteError;
 };
 
 } // namespace QInstaller
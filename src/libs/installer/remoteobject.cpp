@@ -49,6 +49,8 @@ RemoteObject::RemoteObject(const QString &wrappedType, QObject *parent)
     , dummy(nullptr)
     , m_type(wrappedType)
     , m_socket(nullptr)
+    , m_pendingReplies(0)
+    , m_protocolVersion(1)
 {
     Q_ASSERT_X(!m_type.isEmpty(), Q_FUNC_INFO, "The wrapped Qt type needs to be passed as "
         "argument and cannot be empty.");
@@ -90,13 +92,38 @@ bool RemoteObject::authorize()
         delete m_socket;
 
     m_socket = new QLocalSocket;
+    m_pendingReplies = 0;
+    m_protocolVersion = 1;
     m_socket->connectToServer(RemoteClient::instance().socketName());
 
     if (m_socket->waitForConnected()) {
-        bool authorized = callRemoteMethod<bool>(QString::fromLatin1(Protocol::Authorize),
-                                                 RemoteClient::instance().authorizationKey());
-        if (authorized)
+        writeData(QString::fromLatin1(Protocol::Authorize),
+            RemoteClient::instance().authorizationKey(), Protocol::Version, dummy);
+        while (m_socket->bytesToWrite())
+            m_socket->waitForBytesWritten();
+
+        QByteArray command;
+        QByteArray data;
+        while (!receivePacket(m_socket, &command, &data)) {
+            if (!m_socket->waitForReadyRead(-1))
+                break;
+        }
+
+        // The server answers with the protocol version to use, or 0 if the authorization
+        // failed. Servers without version handshake answer with a bool instead.
+        QDataStream stream(&data, QIODevice::ReadOnly);
+        quint32 version = 0;
+        if (data.size() == int(sizeof(quint32))) {
+            stream >> version;
+        } else if (data.size() == int(sizeof(bool))) {
+            bool authorized = false;
+            stream >> authorized;
+            version = authorized ? 1 : 0;
+        }
+        if (stream.status() == QDataStream::Ok && version > 0) {
+            m_protocolVersion = version;
             return true;
+        }
     }
     delete m_socket;
     m_socket = nullptr;
@@ -120,7 +147,7 @@ bool RemoteObject::connectToServer(const QVariantList &arguments)
     foreach (const QVariant &arg, arguments)
         out << arg;
 
-    sendPacket(m_socket, Protocol::Create, data);
+    sendPacket(m_socket, packetCommand(QLatin1String(Protocol::Create)), data);
     m_socket->flush();
     while (m_socket->bytesToWrite())
         m_socket->waitForBytesWritten();
@@ -140,6 +167,22 @@ bool RemoteObject::isConnectedToServer() const
     return false;
 }
 
+/*!
+    \internal
+
+    Returns the packet representation of the command \a name for the protocol
+    version negotiated with the server.
+*/
+QByteArray RemoteObject::packetCommand(const QString &name) const
+{
+    const QByteArray command = name.toLatin1();
+    if (m_protocolVersion != Protocol::Version)
+        return command;
+
+    const Protocol::Command id = commandFromName(command);
+    return id == Protocol::Command::Invalid ? command : encodeCommand(id);
+}
+
 void RemoteObject::callRemoteMethod(const QString &name)
 {
     const QString reply = sendReceivePacket<QString>(name, dummy, dummy, dummy);
@@ -101,7 +101,34 @@ protected:
     // generated functions will differ in return type rather given arguments.
     struct Dummy {}; Dummy *dummy;
 
+    // Sends a request without waiting for the reply, the reply must be read back
+    // in order with takeRemoteReply(). Used to pipeline bulk data transfers.
+    template<typename T1>
+    void postRemoteMethod(const QString &name, const T1 &arg)
+    {
+        writeData(name, arg, dummy, dummy);
+        while (m_socket->bytesToWrite())
+            m_socket->waitForBytesWritten();
+        ++m_pendingReplies;
+    }
+
+    template<typename T>
+    T takeRemoteReply(const QString &name)
+    {
+        Q_ASSERT(m_pendingReplies > 0);
+        --m_pendingReplies;
+        return readData<T>(name);
+    }
+
+    int pendingReplies() const { return m_pendingReplies; }
+
+    // Called before any synchronous call while posted requests are unanswered,
+    // derived classes must consume all pending replies.
+    virtual void receivePendingReplies() {}
+
 private:
+    QByteArray packetCommand(const QString &name) const;
+
     template<typename T> bool isValueType(T) const
     {
         return true;
@@ -118,6 +145,10 @@ private:
     template<typename T, typename T1, typename T2, typename T3>
     T sendReceivePacket(const QString &name, const T1 &arg, const T2 &arg2, const T3 &arg3) const
     {
+        if (m_pendingReplies > 0)
+            const_cast<RemoteObject *>(this)->receivePendingReplies();
+        Q_ASSERT(m_pendingReplies == 0);
+
         writeData(name, arg, arg2, arg3);
         while (m_socket->bytesToWrite())
             m_socket->waitForBytesWritten();
@@ -139,7 +170,7 @@ private:
         if (isValueType(arg3))
             out << arg3;
 
-        sendPacket(m_socket, name.toLatin1(), data);
+        sendPacket(m_socket, packetCommand(name), data);
         m_socket->flush();
     }
 
@@ -156,7 +187,7 @@ private:
             }
         }
 
-        Q_ASSERT(command == Protocol::Reply);
+        Q_ASSERT(decodeCommand(command) == Protocol::Command::Reply);
 
         QDataStream stream(&data, QIODevice::ReadOnly);
 
@@ -170,6 +201,8 @@ private:
 private:
     QString m_type;
     QLocalSocket *m_socket;
+    int m_pendingReplies;
+    quint32 m_protocolVersion;
 };
 
 } // namespace QInstaller
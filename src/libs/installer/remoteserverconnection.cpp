@@ -44,6 +44,8 @@
 
 namespace QInstaller {
 
+using Protocol::Command;
+
 /*!
     \inmodule QtInstallerFramework
     \class QInstaller::QProcessSignalReceiver
@@ -62,11 +64,12 @@ namespace QInstaller {
 */
 
 /*!
-    Constructs reply object for \a socket.
+    Constructs reply object for \a socket, using the packet format of \a protocolVersion.
 */
-RemoteServerReply::RemoteServerReply(QLocalSocket *socket)
+RemoteServerReply::RemoteServerReply(QLocalSocket *socket, quint32 protocolVersion)
     : m_socket(socket)
     , m_sent(false)
+    , m_protocolVersion(protocolVersion)
 {}
 
 /*!
@@ -94,7 +97,8 @@ void RemoteServerReply::send(const T &data)
     QDataStream returnStream(&result, QIODevice::WriteOnly);
     returnStream << data;
 
-    sendPacket(m_socket, Protocol::Reply, result);
+    sendPacket(m_socket, m_protocolVersion != Protocol::Version ? QByteArray(Protocol::Reply)
+        : encodeCommand(Protocol::Command::Reply), result);
     m_socket->flush();
     m_sent = true;
 }
@@ -130,6 +134,12 @@ private:
     QDataStream *stream;
 };
 
+// The commands of each wrapped type are consecutive in Protocol::Command.
+static bool isCommandInRange(Command command, Command first, Command last)
+{
+    return command >= first && command <= last;
+}
+
 void RemoteServerConnection::run()
 {
     QLocalSocket socket;
@@ -137,6 +147,7 @@ void RemoteServerConnection::run()
     QScopedPointer<PermissionSettings> settings;
 
     bool authorized = false;
+    quint32 protocolVersion = 1;
     while (socket.state() == QLocalSocket::ConnectedState) {
         QByteArray cmd;
         QByteArray data;
@@ -147,7 +158,7 @@ void RemoteServerConnection::run()
             continue;
         }
 
-        const QString command = QString::fromLatin1(cmd);
+        const Command command = decodeCommand(cmd);
         QBuffer buf;
         buf.setBuffer(&data);
         buf.open(QIODevice::ReadOnly);
@@ -155,27 +166,39 @@ void RemoteServerConnection::run()
         stream.setDevice(&buf);
         StreamChecker streamChecker(&stream);
 
-        RemoteServerReply reply(&socket);
+        RemoteServerReply reply(&socket, protocolVersion);
 
-        if (authorized && command == QLatin1String(Protocol::Shutdown)) {
+        if (authorized && command == Command::Shutdown) {
             authorized = false;
             reply.send(true);
             socket.close();
             emit shutdownRequested();
             return;
-        } else if (command == QLatin1String(Protocol::Authorize)) {
+        } else if (command == Command::Authorize) {
             QString key;
             stream >> key;
-            reply.send(authorized = (key == m_authorizationKey));
+            authorized = (key == m_authorizationKey);
+            if (stream.atEnd()) {
+                // client without version handshake, keep sending command names
+                reply.send(authorized);
+            } else {
+                quint32 clientVersion;
+                stream >> clientVersion;
+                // Command identifiers are only shared with the same version, any other
+                // client keeps sending command names.
+                if (authorized)
+                    protocolVersion = (clientVersion == Protocol::Version) ? Protocol::Version : 1;
+                reply.send(authorized ? protocolVersion : quint32(0));
+            }
             if (!authorized) {
                 socket.close();
                 return;
             }
         } else if (authorized) {
-            if (command.isEmpty())
+            if (cmd.isEmpty())
                 continue;
 
-            if (command == QLatin1String(Protocol::Create)) {
+            if (command == Command::Create) {
                 QString type;
                 stream >> type;
                 if (type == QLatin1String(Protocol::QSettings)) {
@@ -212,14 +235,14 @@ void RemoteServerConnection::run()
                 continue;
             }
 
-            if (command == QLatin1String(Protocol::GetQProcessSignals)) {
+            if (command == Command::GetQProcessSignals) {
                 if (m_processSignalReceiver) {
                     QMutexLocker _(&m_processSignalReceiver->m_lock);
                     reply.send(m_processSignalReceiver->m_receivedSignals);
                     m_processSignalReceiver->m_receivedSignals.clear();
                 }
                 continue;
-            } else if (command == QLatin1String(Protocol::GetAbstractArchiveSignals)) {
+            } else if (command == Command::GetAbstractArchiveSignals) {
 #ifdef IFW_LIBARCHIVE
                 if (m_archiveSignalReceiver) {
                     QMutexLocker _(&m_archiveSignalReceiver->m_lock);
@@ -232,16 +255,20 @@ void RemoteServerConnection::run()
 #endif
             }
 
-            if (command.startsWith(QLatin1String(Protocol::QProcess))) {
+            if (isCommandInRange(command, Command::QProcessCloseWriteChannel,
+                    Command::QProcessSetNativeArguments)) {
                 handleQProcess(&reply, command, stream);
-            } else if (command.startsWith(QLatin1String(Protocol::QSettings))) {
+            } else if (isCommandInRange(command, Command::QSettingsAllKeys,
+                    Command::QSettingsApplicationName)) {
                 handleQSettings(&reply, command, stream, settings.data());
-            } else if (command.startsWith(QLatin1String(Protocol::QAbstractFileEngine))) {
+            } else if (isCommandInRange(command, Command::QAbstractFileEngineAtEnd,
+                    Command::QAbstractFileEngineOpenAndStat)) {
                 handleQFSFileEngine(&reply, command, stream);
-            } else if (command.startsWith(QLatin1String(Protocol::AbstractArchive))) {
+            } else if (isCommandInRange(command, Command::AbstractArchiveOpen,
+                    Command::AbstractArchiveCancel)) {
                 handleArchive(&reply, command, stream);
             } else {
-                qCDebug(QInstaller::lcServer) << "Unknown command:" << command;
+                qCDebug(QInstaller::lcServer) << "Unknown command:" << cmd;
             }
         } else {
             // authorization failed, connection not wanted
@@ -252,380 +279,499 @@ void RemoteServerConnection::run()
     }
 }
 
-void RemoteServerConnection::handleQProcess(RemoteServerReply *reply, const QString &command, QDataStream &data)
+void RemoteServerConnection::handleQProcess(RemoteServerReply *reply, Command command, QDataStream &data)
 {
-    if (command == QLatin1String(Protocol::QProcessCloseWriteChannel)) {
-        m_process->closeWriteChannel();
-    } else if (command == QLatin1String(Protocol::QProcessExitCode)) {
-        reply->send(m_process->exitCode());
-    } else if (command == QLatin1String(Protocol::QProcessExitStatus)) {
-        reply->send(static_cast<qint32> (m_process->exitStatus()));
-    } else if (command == QLatin1String(Protocol::QProcessKill)) {
-        m_process->kill();
-    } else if (command == QLatin1String(Protocol::QProcessReadAll)) {
-        reply->send(m_process->readAll());
-    } else if (command == QLatin1String(Protocol::QProcessReadAllStandardOutput)) {
-        reply->send(m_process->readAllStandardOutput());
-    } else if (command == QLatin1String(Protocol::QProcessReadAllStandardError)) {
-        reply->send(m_process->readAllStandardError());
-    } else if (command == QLatin1String(Protocol::QProcessStartDetached)) {
-        QString program;
-        QStringList arguments;
-        QString workingDirectory;
-        data >> program;
-        data >> arguments;
-        data >> workingDirectory;
-
-        qint64 pid = -1;
-        bool success = QInstaller::startDetached(program, arguments, workingDirectory, &pid);
-        reply->send(QPair<bool, qint64>(success, pid));
-    } else if (command == QLatin1String(Protocol::QProcessStartDetached2)) {
-        QString program;
-        QStringList arguments;
-        QString workingDirectory;
-        data >> program;
-        data >> arguments;
-        data >> workingDirectory;
-
-        qint64 pid = -1;
-        bool success = QProcess::startDetached(program, arguments, workingDirectory, &pid);
-        reply->send(QPair<bool, qint64>(success, pid));
-    } else if (command == QLatin1String(Protocol::QProcessSetWorkingDirectory)) {
-        QString dir;
-        data >> dir;
-        m_process->setWorkingDirectory(dir);
-    } else if (command == QLatin1String(Protocol::QProcessSetEnvironment)) {
-        QStringList env;
-        data >> env;
-        m_process->setEnvironment(env);
-    } else if (command == QLatin1String(Protocol::QProcessEnvironment)) {
-        reply->send(m_process->environment());
-    } else if (command == QLatin1String(Protocol::QProcessStart3Arg)) {
-        QString program;
-        QStringList arguments;
-        qint32 mode;
-        data >> program;
-        data >> arguments;
-        data >> mode;
-        m_process->start(program, arguments, static_cast<QIODevice::OpenMode> (mode));
-    } else if (command == QLatin1String(Protocol::QProcessStart2Arg)) {
-        QString program;
-        qint32 mode;
-        data >> program;
-        data >> mode;
-        m_process->start(program, {}, static_cast<QIODevice::OpenMode> (mode));
-    } else if (command == QLatin1String(Protocol::QProcessState)) {
-        reply->send(static_cast<qint32> (m_process->state()));
-    } else if (command == QLatin1String(Protocol::QProcessTerminate)) {
-        m_process->terminate();
-    } else if (command == QLatin1String(Protocol::QProcessWaitForFinished)) {
-        qint32 msecs;
-        data >> msecs;
-        reply->send(m_process->waitForFinished(msecs));
-    } else if (command == QLatin1String(Protocol::QProcessWaitForStarted)) {
-        qint32 msecs;
-        data >> msecs;
-        reply->send(m_process->waitForStarted(msecs));
-    } else if (command == QLatin1String(Protocol::QProcessWorkingDirectory)) {
-        reply->send(m_process->workingDirectory());
-    } else if (command == QLatin1String(Protocol::QProcessErrorString)) {
-        reply->send(m_process->errorString());
-    } else if (command == QLatin1String(Protocol::QProcessReadChannel)) {
-        reply->send(static_cast<qint32> (m_process->readChannel()));
-    } else if (command == QLatin1String(Protocol::QProcessSetReadChannel)) {
-        qint32 processChannel;
-        data >> processChannel;
-        m_process->setReadChannel(static_cast<QProcess::ProcessChannel>(processChannel));
-    } else if (command == QLatin1String(Protocol::QProcessWrite)) {
-        QByteArray byteArray;
-        data >> byteArray;
-        reply->send(m_process->write(byteArray));
-    } else if (command == QLatin1String(Protocol::QProcessProcessChannelMode)) {
-        reply->send(static_cast<qint32> (m_process->processChannelMode()));
-    } else if (command == QLatin1String(Protocol::QProcessSetProcessChannelMode)) {
-        qint32 processChannel;
-        data >> processChannel;
-        m_process->setProcessChannelMode(static_cast<QProcess::ProcessChannelMode>(processChannel));
-    }
+    switch (command) {
+        case Command::QProcessCloseWriteChannel: {
+            m_process->closeWriteChannel();
+        }   break;
+        case Command::QProcessExitCode: {
+            reply->send(m_process->exitCode());
+        }   break;
+        case Command::QProcessExitStatus: {
+            reply->send(static_cast<qint32> (m_process->exitStatus()));
+        }   break;
+        case Command::QProcessKill: {
+            m_process->kill();
+        }   break;
+        case Command::QProcessReadAll: {
+            reply->send(m_process->readAll());
+        }   break;
+        case Command::QProcessReadAllStandardOutput: {
+            reply->send(m_process->readAllStandardOutput());
+        }   break;
+        case Command::QProcessReadAllStandardError: {
+            reply->send(m_process->readAllStandardError());
+        }   break;
+        case Command::QProcessStartDetached: {
+            QString program;
+            QStringList arguments;
+            QString workingDirectory;
+            data >> program;
+            data >> arguments;
+            data >> workingDirectory;
+
+            qint64 pid = -1;
+            bool success = QInstaller::startDetached(program, arguments, workingDirectory, &pid);
+            reply->send(QPair<bool, qint64>(success, pid));
+        }   break;
+        case Command::QProcessStartDetached2: {
+            QString program;
+            QStringList arguments;
+            QString workingDirectory;
+            data >> program;
+            data >> arguments;
+            data >> workingDirectory;
+
+            qint64 pid = -1;
+            bool success = QProcess::startDetached(program, arguments, workingDirectory, &pid);
+            reply->send(QPair<bool, qint64>(success, pid));
+        }   break;
+        case Command::QProcessSetWorkingDirectory: {
+            QString dir;
+            data >> dir;
+            m_process->setWorkingDirectory(dir);
+        }   break;
+        case Command::QProcessSetEnvironment: {
+            QStringList env;
+            data >> env;
+            m_process->setEnvironment(env);
+        }   break;
+        case Command::QProcessEnvironment: {
+            reply->send(m_process->environment());
+        }   break;
+        case Command::QProcessStart3Arg: {
+            QString program;
+            QStringList arguments;
+            qint32 mode;
+            data >> program;
+            data >> arguments;
+            data >> mode;
+            m_process->start(program, arguments, static_cast<QIODevice::OpenMode> (mode));
+        }   break;
+        case Command::QProcessStart2Arg: {
+            QString program;
+            qint32 mode;
+            data >> program;
+            data >> mode;
+            m_process->start(program, {}, static_cast<QIODevice::OpenMode> (mode));
+        }   break;
+        case Command::QProcessState: {
+            reply->send(static_cast<qint32> (m_process->state()));
+        }   break;
+        case Command::QProcessTerminate: {
+            m_process->terminate();
+        }   break;
+        case Command::QProcessWaitForFinished: {
+            qint32 msecs;
+            data >> msecs;
+            reply->send(m_process->waitForFinished(msecs));
+        }   break;
+        case Command::QProcessWaitForStarted: {
+            qint32 msecs;
+            data >> msecs;
+            reply->send(m_process->waitForStarted(msecs));
+        }   break;
+        case Command::QProcessWorkingDirectory: {
+            reply->send(m_process->workingDirectory());
+        }   break;
+        case Command::QProcessErrorString: {
+            reply->send(m_process->errorString());
+        }   break;
+        case Command::QProcessReadChannel: {
+            reply->send(static_cast<qint32> (m_process->readChannel()));
+        }   break;
+        case Command::QProcessSetReadChannel: {
+            qint32 processChannel;
+            data >> processChannel;
+            m_process->setReadChannel(static_cast<QProcess::ProcessChannel>(processChannel));
+        }   break;
+        case Command::QProcessWrite: {
+            QByteArray byteArray;
+            data >> byteArray;
+            reply->send(m_process->write(byteArray));
+        }   break;
+        case Command::QProcessProcessChannelMode: {
+            reply->send(static_cast<qint32> (m_process->processChannelMode()));
+        }   break;
+        case Command::QProcessSetProcessChannelMode: {
+            qint32 processChannel;
+            data >> processChannel;
+            m_process->setProcessChannelMode(static_cast<QProcess::ProcessChannelMode>(processChannel));
+        }   break;
 #ifdef Q_OS_WIN
-    else if (command == QLatin1String(Protocol::QProcessSetNativeArguments)) {
-        QString arguments;
-        data >> arguments;
-        m_process->setNativeArguments(arguments);
-    }
+        case Command::QProcessSetNativeArguments: {
+            QString arguments;
+            data >> arguments;
+            m_process->setNativeArguments(arguments);
+        }   break;
 #endif
-    else if (!command.isEmpty()) {
-        qCDebug(QInstaller::lcServer) << "Unknown QProcess command:" << command;
+        default:
+            qCDebug(QInstaller::lcServer) << "Unknown QProcess command:"
+                << commandName(command);
+            break;
     }
 }
 
-void RemoteServerConnection::handleQSettings(RemoteServerReply *reply, const QString &command,
+void RemoteServerConnection::handleQSettings(RemoteServerReply *reply, Command command,
                                              QDataStream &data, PermissionSettings *settings)
 {
     if (!settings)
         return;
 
-    if (command == QLatin1String(Protocol::QSettingsAllKeys)) {
-        reply->send(settings->allKeys());
-    } else if (command == QLatin1String(Protocol::QSettingsBeginGroup)) {
-        QString prefix;
-        data >> prefix;
-        settings->beginGroup(prefix);
-    } else if (command == QLatin1String(Protocol::QSettingsBeginWriteArray)) {
-        QString prefix;
-        data >> prefix;
-        qint32 size;
-        data >> size;
-        settings->beginWriteArray(prefix, size);
-    } else if (command == QLatin1String(Protocol::QSettingsBeginReadArray)) {
-        QString prefix;
-        data >> prefix;
-        reply->send(settings->beginReadArray(prefix));
-    } else if (command == QLatin1String(Protocol::QSettingsChildGroups)) {
-        reply->send(settings->childGroups());
-    } else if (command == QLatin1String(Protocol::QSettingsChildKeys)) {
-        reply->send(settings->childKeys());
-    } else if (command == QLatin1String(Protocol::QSettingsClear)) {
-        settings->clear();
-    } else if (command == QLatin1String(Protocol::QSettingsContains)) {
-        QString key;
-        data >> key;
-        reply->send(settings->contains(key));
-    } else if (command == QLatin1String(Protocol::QSettingsEndArray)) {
-        settings->endArray();
-    } else if (command == QLatin1String(Protocol::QSettingsEndGroup)) {
-        settings->endGroup();
-    } else if (command == QLatin1String(Protocol::QSettingsFallbacksEnabled)) {
-        reply->send(settings->fallbacksEnabled());
-    } else if (command == QLatin1String(Protocol::QSettingsFileName)) {
-        reply->send(settings->fileName());
-    } else if (command == QLatin1String(Protocol::QSettingsGroup)) {
-        reply->send(settings->group());
-    } else if (command == QLatin1String(Protocol::QSettingsIsWritable)) {
-        reply->send(settings->isWritable());
-    } else if (command == QLatin1String(Protocol::QSettingsRemove)) {
-        QString key;
-        data >> key;
-        settings->remove(key);
-    } else if (command == QLatin1String(Protocol::QSettingsSetArrayIndex)) {
-        qint32 i;
-        data >> i;
-        settings->setArrayIndex(i);
-    } else if (command == QLatin1String(Protocol::QSettingsSetFallbacksEnabled)) {
-        bool b;
-        data >> b;
-        settings->setFallbacksEnabled(b);
-    } else if (command == QLatin1String(Protocol::QSettingsStatus)) {
-        reply->send(settings->status());
-    } else if (command == QLatin1String(Protocol::QSettingsSync)) {
-        settings->sync();
-    } else if (command == QLatin1String(Protocol::QSettingsSetValue)) {
-        QString key;
-        QVariant value;
-        data >> key;
-        data >> value;
-        settings->setValue(key, value);
-    } else if (command == QLatin1String(Protocol::QSettingsValue)) {
-        QString key;
-        QVariant defaultValue;
-        data >> key;
-        data >> defaultValue;
-        reply->send(settings->value(key, defaultValue));
-    } else if (command == QLatin1String(Protocol::QSettingsOrganizationName)) {
-        reply->send(settings->organizationName());
-    } else if (command == QLatin1String(Protocol::QSettingsApplicationName)) {
-        reply->send(settings->applicationName());
-    } else if (!command.isEmpty()) {
-        qCDebug(QInstaller::lcServer) << "Unknown QSettings command:" << command;
+    switch (command) {
+        case Command::QSettingsAllKeys: {
+            reply->send(settings->allKeys());
+        }   break;
+        case Command::QSettingsBeginGroup: {
+            QString prefix;
+            data >> prefix;
+            settings->beginGroup(prefix);
+        }   break;
+        case Command::QSettingsBeginWriteArray: {
+            QString prefix;
+            data >> prefix;
+            qint32 size;
+            data >> size;
+            settings->beginWriteArray(prefix, size);
+        }   break;
+        case Command::QSettingsBeginReadArray: {
+            QString prefix;
+            data >> prefix;
+            reply->send(settings->beginReadArray(prefix));
+        }   break;
+        case Command::QSettingsChildGroups: {
+            reply->send(settings->childGroups());
+        }   break;
+        case Command::QSettingsChildKeys: {
+            reply->send(settings->childKeys());
+        }   break;
+        case Command::QSettingsClear: {
+            settings->clear();
+        }   break;
+        case Command::QSettingsContains: {
+            QString key;
+            data >> key;
+            reply->send(settings->contains(key));
+        }   break;
+        case Command::QSettingsEndArray: {
+            settings->endArray();
+        }   break;
+        case Command::QSettingsEndGroup: {
+            settings->endGroup();
+        }   break;
+        case Command::QSettingsFallbacksEnabled: {
+            reply->send(settings->fallbacksEnabled());
+        }   break;
+        case Command::QSettingsFileName: {
+            reply->send(settings->fileName());
+        }   break;
+        case Command::QSettingsGroup: {
+            reply->send(settings->group());
+        }   break;
+        case Command::QSettingsIsWritable: {
+            reply->send(settings->isWritable());
+        }   break;
+        case Command::QSettingsRemove: {
+            QString key;
+            data >> key;
+            settings->remove(key);
+        }   break;
+        case Command::QSettingsSetArrayIndex: {
+            qint32 i;
+            data >> i;
+            settings->setArrayIndex(i);
+        }   break;
+        case Command::QSettingsSetFallbacksEnabled: {
+            bool b;
+            data >> b;
+            settings->setFallbacksEnabled(b);
+        }   break;
+        case Command::QSettingsStatus: {
+            reply->send(settings->status());
+        }   break;
+        case Command::QSettingsSync: {
+            settings->sync();
+        }   break;
+        case Command::QSettingsSetValue: {
+            QString key;
+            QVariant value;
+            data >> key;
+            data >> value;
+            settings->setValue(key, value);
+        }   break;
+        case Command::QSettingsValue: {
+            QString key;
+            QVariant defaultValue;
+            data >> key;
+            data >> defaultValue;
+            reply->send(settings->value(key, defaultValue));
+        }   break;
+        case Command::QSettingsOrganizationName: {
+            reply->send(settings->organizationName());
+        }   break;
+        case Command::QSettingsApplicationName: {
+            reply->send(settings->applicationName());
+        }   break;
+        default:
+            qCDebug(QInstaller::lcServer) << "Unknown QSettings command:"
+                << commandName(command);
+            break;
     }
 }
 
-void RemoteServerConnection::handleQFSFileEngine(RemoteServerReply *reply, const QString &command,
+void RemoteServerConnection::handleQFSFileEngine(RemoteServerReply *reply, Command command,
                                                  QDataStream &data)
 {
-    if (command == QLatin1String(Protocol::QAbstractFileEngineAtEnd)) {
-        reply->send(m_engine->atEnd());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineCaseSensitive)) {
-        reply->send(m_engine->caseSensitive());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineClose)) {
-        reply->send(m_engine->close());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineCopy)) {
-        QString newName;
-        data >>newName;
+    switch (command) {
+        case Command::QAbstractFileEngineAtEnd: {
+            reply->send(m_engine->atEnd());
+        }   break;
+        case Command::QAbstractFileEngineCaseSensitive: {
+            reply->send(m_engine->caseSensitive());
+        }   break;
+        case Command::QAbstractFileEngineClose: {
+            reply->send(m_engine->close());
+        }   break;
+        case Command::QAbstractFileEngineCopy: {
+            QString newName;
+            data >>newName;
 #ifdef Q_OS_LINUX
-        // QFileSystemEngine::copyFile() is currently unimplemented on Linux,
-        // copy using QFile instead of directly with QFSFileEngine.
-        QFile file(m_engine->fileName(QAbstractFileEngine::AbsoluteName));
-        reply->send(file.copy(newName));
+            // QFileSystemEngine::copyFile() is currently unimplemented on Linux,
+            // copy using QFile instead of directly with QFSFileEngine.
+            QFile file(m_engine->fileName(QAbstractFileEngine::AbsoluteName));
+            reply->send(file.copy(newName));
 #else
-        reply->send(m_engine->copy(newName));
+            reply->send(m_engine->copy(newName));
 #endif
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineEntryList)) {
-        qint32 filters;
-        QStringList filterNames;
-        data >>filters;
-        data >>filterNames;
-        reply->send(m_engine->entryList(static_cast<QDir::Filters> (filters), filterNames));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineError)) {
-        reply->send(static_cast<qint32> (m_engine->error()));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineErrorString)) {
-        reply->send(m_engine->errorString());
-    }
-    else if (command == QLatin1String(Protocol::QAbstractFileEngineFileFlags)) {
-        qint32 flags;
-        data >>flags;
-        flags = m_engine->fileFlags(static_cast<QAbstractFileEngine::FileFlags>(flags));
-        reply->send(static_cast<qint32>(flags));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineFileName)) {
-        qint32 file;
-        data >>file;
-        reply->send(m_engine->fileName(static_cast<QAbstractFileEngine::FileName> (file)));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineFlush)) {
-        reply->send(m_engine->flush());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineHandle)) {
-        reply->send(m_engine->handle());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineIsRelativePath)) {
-        reply->send(m_engine->isRelativePath());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineIsSequential)) {
-        reply->send(m_engine->isSequential());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineLink)) {
-        QString newName;
-        data >>newName;
-        reply->send(m_engine->link(newName));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineMkdir)) {
-        QString dirName;
-        bool createParentDirectories;
-        data >>dirName;
-        data >>createParentDirectories;
-        reply->send(m_engine->mkdir(dirName, createParentDirectories));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineOpen)) {
-        qint32 openMode;
-        data >>openMode;
-        reply->send(m_engine->open(static_cast<QIODevice::OpenMode> (openMode)));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineOwner)) {
-        qint32 owner;
-        data >>owner;
-        reply->send(m_engine->owner(static_cast<QAbstractFileEngine::FileOwner> (owner)));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineOwnerId)) {
-        qint32 owner;
-        data >>owner;
-        reply->send(m_engine->ownerId(static_cast<QAbstractFileEngine::FileOwner> (owner)));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEnginePos)) {
-        reply->send(m_engine->pos());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRead)) {
-        qint64 maxlen;
-        data >> maxlen;
-        QByteArray byteArray(maxlen, '\0');
-        const qint64 r = m_engine->read(byteArray.data(), maxlen);
-        reply->send(QPair<qint64, QByteArray>(r, byteArray));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineReadLine)) {
-        qint64 maxlen;
-        data >> maxlen;
-        QByteArray byteArray(maxlen, '\0');
-        const qint64 r = m_engine->readLine(byteArray.data(), maxlen);
-        reply->send(QPair<qint64, QByteArray>(r, byteArray));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRemove)) {
-        reply->send(m_engine->remove());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRename)) {
-        QString newName;
-        data >>newName;
-        reply->send(m_engine->rename(newName));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRmdir)) {
-        QString dirName;
-        bool recurseParentDirectories;
-        data >>dirName;
-        data >>recurseParentDirectories;
-        reply->send(m_engine->rmdir(dirName, recurseParentDirectories));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSeek)) {
-        quint64 offset;
-        data >>offset;
-        reply->send(m_engine->seek(offset));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSetFileName)) {
-        QString fileName;
-        data >>fileName;
-        m_engine->setFileName(fileName);
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSetPermissions)) {
-        uint perms;
-        data >>perms;
-        reply->send(m_engine->setPermissions(perms));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSetSize)) {
-        qint64 size;
-        data >>size;
-        reply->send(m_engine->setSize(size));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSize)) {
-        reply->send(m_engine->size());
-    } else if ((command == QLatin1String(Protocol::QAbstractFileEngineSupportsExtension))
-        || (command == QLatin1String(Protocol::QAbstractFileEngineExtension))) {
+        }   break;
+        case Command::QAbstractFileEngineEntryList: {
+            qint32 filters;
+            QStringList filterNames;
+            data >>filters;
+            data >>filterNames;
+            reply->send(m_engine->entryList(static_cast<QDir::Filters> (filters), filterNames));
+        }   break;
+        case Command::QAbstractFileEngineError: {
+            reply->send(static_cast<qint32> (m_engine->error()));
+        }   break;
+        case Command::QAbstractFileEngineErrorString: {
+            reply->send(m_engine->errorString());
+        }   break;
+        case Command::QAbstractFileEngineFileFlags: {
+            qint32 flags;
+            data >>flags;
+            flags = m_engine->fileFlags(static_cast<QAbstractFileEngine::FileFlags>(flags));
+            reply->send(static_cast<qint32>(flags));
+        }   break;
+        case Command::QAbstractFileEngineFileName: {
+            qint32 file;
+            data >>file;
+            reply->send(m_engine->fileName(static_cast<QAbstractFileEngine::FileName> (file)));
+        }   break;
+        case Command::QAbstractFileEngineFlush: {
+            reply->send(m_engine->flush());
+        }   break;
+        case Command::QAbstractFileEngineHandle: {
+            reply->send(m_engine->handle());
+        }   break;
+        case Command::QAbstractFileEngineIsRelativePath: {
+            reply->send(m_engine->isRelativePath());
+        }   break;
+        case Command::QAbstractFileEngineIsSequential: {
+            reply->send(m_engine->isSequential());
+        }   break;
+        case Command::QAbstractFileEngineLink: {
+            QString newName;
+            data >>newName;
+            reply->send(m_engine->link(newName));
+        }   break;
+        case Command::QAbstractFileEngineMkdir: {
+            QString dirName;
+            bool createParentDirectories;
+            data >>dirName;
+            data >>createParentDirectories;
+            reply->send(m_engine->mkdir(dirName, createParentDirectories));
+        }   break;
+        case Command::QAbstractFileEngineOpen: {
+            qint32 openMode;
+            data >>openMode;
+            reply->send(m_engine->open(static_cast<QIODevice::OpenMode> (openMode)));
+        }   break;
+        case Command::QAbstractFileEngineOpenAndStat: {
+            qint32 openMode;
+            data >>openMode;
+            Protocol::FileEngineOpenReply result;
+            result.opened = m_engine->open(static_cast<QIODevice::OpenMode> (openMode));
+            if (result.opened) {
+                result.sequential = m_engine->isSequential();
+                result.size = m_engine->size();
+                result.pos = m_engine->pos();
+            }
+            reply->send(result);
+        }   break;
+        case Command::QAbstractFileEngineOwner: {
+            qint32 owner;
+            data >>owner;
+            reply->send(m_engine->owner(static_cast<QAbstractFileEngine::FileOwner> (owner)));
+        }   break;
+        case Command::QAbstractFileEngineOwnerId: {
+            qint32 owner;
+            data >>owner;
+            reply->send(m_engine->ownerId(static_cast<QAbstractFileEngine::FileOwner> (owner)));
+        }   break;
+        case Command::QAbstractFileEnginePos: {
+            reply->send(m_engine->pos());
+        }   break;
+        case Command::QAbstractFileEngineRead: {
+            qint64 maxlen;
+            data >> maxlen;
+            QByteArray byteArray(maxlen, '\0');
+            const qint64 r = m_engine->read(byteArray.data(), maxlen);
+            byteArray.resize(qMax<qint64>(r, 0));
+            reply->send(QPair<qint64, QByteArray>(r, byteArray));
+        }   break;
+        case Command::QAbstractFileEngineReadLine: {
+            qint64 maxlen;
+            data >> maxlen;
+            QByteArray byteArray(maxlen, '\0');
+            const qint64 r = m_engine->readLine(byteArray.data(), maxlen);
+            reply->send(QPair<qint64, QByteArray>(r, byteArray));
+        }   break;
+        case Command::QAbstractFileEngineRemove: {
+            reply->send(m_engine->remove());
+        }   break;
+        case Command::QAbstractFileEngineRename: {
+            QString newName;
+            data >>newName;
+            reply->send(m_engine->rename(newName));
+        }   break;
+        case Command::QAbstractFileEngineRmdir: {
+            QString dirName;
+            bool recurseParentDirectories;
+            data >>dirName;
+            data >>recurseParentDirectories;
+            reply->send(m_engine->rmdir(dirName, recurseParentDirectories));
+        }   break;
+        case Command::QAbstractFileEngineSeek: {
+            quint64 offset;
+            data >>offset;
+            reply->send(m_engine->seek(offset));
+        }   break;
+        case Command::QAbstractFileEngineSetFileName: {
+            QString fileName;
+            data >>fileName;
+            m_engine->setFileName(fileName);
+        }   break;
+        case Command::QAbstractFileEngineSetPermissions: {
+            uint perms;
+            data >>perms;
+            reply->send(m_engine->setPermissions(perms));
+        }   break;
+        case Command::QAbstractFileEngineSetSize: {
+            qint64 size;
+            data >>size;
+            reply->send(m_engine->setSize(size));
+        }   break;
+        case Command::QAbstractFileEngineSize: {
+            reply->send(m_engine->size());
+        }   break;
+        case Command::QAbstractFileEngineSupportsExtension:
+        case Command::QAbstractFileEngineExtension: {
             // Implemented client side.
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineWrite)) {
-        QByteArray content;
-        data >> content;
-        reply->send(m_engine->write(content.data(), content.size()));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSyncToDisk)) {
-        reply->send(m_engine->syncToDisk());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRenameOverwrite)) {
-        QString newFilename;
-        data >> newFilename;
-        reply->send(m_engine->renameOverwrite(newFilename));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineFileTime)) {
-        qint32 filetime;
-        data >> filetime;
-        reply->send(m_engine->fileTime(static_cast<QAbstractFileEngine::FileTime> (filetime)));
-    } else if (!command.isEmpty()) {
-        qCDebug(QInstaller::lcServer) << "Unknown QAbstractFileEngine command:" << command;
+        }   break;
+        case Command::QAbstractFileEngineWrite: {
+            QByteArray content;
+            data >> content;
+            reply->send(m_engine->write(content.data(), content.size()));
+        }   break;
+        case Command::QAbstractFileEngineSyncToDisk: {
+            reply->send(m_engine->syncToDisk());
+        }   break;
+        case Command::QAbstractFileEngineRenameOverwrite: {
+            QString newFilename;
+            data >> newFilename;
+            reply->send(m_engine->renameOverwrite(newFilename));
+        }   break;
+        case Command::QAbstractFileEngineFileTime: {
+            qint32 filetime;
+            data >> filetime;
+            reply->send(m_engine->fileTime(static_cast<QAbstractFileEngine::FileTime> (filetime)));
+        }   break;
+        default:
+            qCDebug(QInstaller::lcServer) << "Unknown QAbstractFileEngine command:"
+                << commandName(command);
+            break;
     }
 }
 
-void RemoteServerConnection::handleArchive(RemoteServerReply *reply, const QString &command, QDataStream &data)
+void RemoteServerConnection::handleArchive(RemoteServerReply *reply, Command command, QDataStream &data)
 {
 #ifdef IFW_LIBARCHIVE
     LibArchiveArchive *archive = static_cast<LibArchiveArchive *>(m_archive.get());
-    if (command == QLatin1String(Protocol::AbstractArchiveOpen)) {
-        qint32 openMode;
-        data >> openMode;
-        reply->send(archive->open(static_cast<QIODevice::OpenMode>(openMode)));
-    } else if (command == QLatin1String(Protocol::AbstractArchiveClose)) {
-        archive->close();
-    } else if (command == QLatin1String(Protocol::AbstractArchiveSetFilename)) {
-        QString fileName;
-        data >> fileName;
-        archive->setFilename(fileName);
-    } else if (command == QLatin1String(Protocol::AbstractArchiveErrorString)) {
-        reply->send(archive->errorString());
-    } else if (command == QLatin1String(Protocol::AbstractArchiveExtract)) {
-        QString dirPath;
-        quint64 total;
-        data >> dirPath;
-        data >> total;
-        archive->workerExtract(dirPath, total);
-    } else if (command == QLatin1String(Protocol::AbstractArchiveCreate)) {
-        QStringList entries;
-        data >> entries;
-        reply->send(archive->create(entries));
-    } else if (command == QLatin1String(Protocol::AbstractArchiveList)) {
-        reply->send(archive->list());
-    } else if (command == QLatin1String(Protocol::AbstractArchiveIsSupported)) {
-        reply->send(archive->isSupported());
-    } else if (command == QLatin1String(Protocol::AbstractArchiveSetCompressionLevel)) {
-        qint32 level;
-        data >> level;
-        archive->setCompressionLevel(static_cast<AbstractArchive::CompressionLevel>(level));
-    } else if (command == QLatin1String(Protocol::AbstractArchiveAddDataBlock)) {
-        QByteArray buff;
-        data >> buff;
-        archive->workerAddDataBlock(buff);
-    } else if (command == QLatin1String(Protocol::AbstractArchiveSetClientDataAtEnd)) {
-        archive->workerSetDataAtEnd();
-    } else if (command == QLatin1String(Protocol::AbstractArchiveSetFilePosition)) {
-        qint64 pos;
-        data >> pos;
-        archive->workerSetFilePosition(pos);
-    } else if (command == QLatin1String(Protocol::AbstractArchiveWorkerStatus)) {
-        reply->send(static_cast<qint32>(archive->workerStatus()));
-    } else if (command == QLatin1String(Protocol::AbstractArchiveCancel)) {
-        archive->workerCancel();
-    } else if (!command.isEmpty()) {
-        qCDebug(QInstaller::lcServer) << "Unknown AbstractArchive command:" << command;
+    switch (command) {
+        case Command::AbstractArchiveOpen: {
+            qint32 openMode;
+            data >> openMode;
+            reply->send(archive->open(static_cast<QIODevice::OpenMode>(openMode)));
+        }   break;
+        case Command::AbstractArchiveClose: {
+            archive->close();
+        }   break;
+        case Command::AbstractArchiveSetFilename: {
+            QString fileName;
+            data >> fileName;
+            archive->setFilename(fileName);
+        }   break;
+        case Command::AbstractArchiveErrorString: {
+            reply->send(archive->errorString());
+        }   break;
+        case Command::AbstractArchiveExtract: {
+            QString dirPath;
+            quint64 total;
+            data >> dirPath;
+            data >> total;
+            archive->workerExtract(dirPath, total);
+        }   break;
+        case Command::AbstractArchiveCreate: {
+            QStringList entries;
+            data >> entries;
+            reply->send(archive->create(entries));
+        }   break;
+        case Command::AbstractArchiveList: {
+            reply->send(archive->list());
+        }   break;
+        case Command::AbstractArchiveIsSupported: {
+            reply->send(archive->isSupported());
+        }   break;
+        case Command::AbstractArchiveSetCompressionLevel: {
+            qint32 level;
+            data >> level;
+            archive->setCompressionLevel(static_cast<AbstractArchive::CompressionLevel>(level));
+        }   break;
+        case Command::AbstractArchiveAddDataBlock: {
+            QByteArray buff;
+            data >> buff;
+            archive->workerAddDataBlock(buff);
+        }   break;
+        case Command::AbstractArchiveSetClientDataAtEnd: {
+            archive->workerSetDataAtEnd();
+        }   break;
+        case Command::AbstractArchiveSetFilePosition: {
+            qint64 pos;
+            data >> pos;
+            archive->workerSetFilePosition(pos);
+        }   break;
+        case Command::AbstractArchiveWorkerStatus: {
+            reply->send(static_cast<qint32>(archive->workerStatus()));
+        }   break;
+        case Command::AbstractArchiveCancel: {
+            archive->workerCancel();
+        }   break;
+        default:
+            qCDebug(QInstaller::lcServer) << "Unknown AbstractArchive command:"
+                << commandName(command);
+            break;
     }
 #else
     Q_ASSERT_X(false, Q_FUNC_INFO, "No compatible archive handler exists for protocol.");
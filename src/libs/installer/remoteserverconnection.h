@@ -30,6 +30,7 @@
 #define REMOTESERVERCONNECTION_H
 
 #include "abstractarchive.h"
+#include "protocol.h"
 
 #include <QPointer>
 #include <QThread>
@@ -51,7 +52,7 @@ class AbstractArchiveSignalReceiver;
 class RemoteServerReply
 {
 public:
-    explicit RemoteServerReply(QLocalSocket *socket);
+    RemoteServerReply(QLocalSocket *socket, quint32 protocolVersion);
     ~RemoteServerReply();
 
     template <typename T>
@@ -60,6 +61,7 @@ public:
 private:
     QLocalSocket *m_socket;
     bool m_sent;
+    quint32 m_protocolVersion;
 };
 
 class RemoteServerConnection : public QThread
@@ -77,11 +79,11 @@ signals:
     void shutdownRequested();
 
 private:
-    void handleQProcess(RemoteServerReply *reply, const QString &command, QDataStream &data);
-    void handleQSettings(RemoteServerReply *reply, const QString &command, QDataStream &data,
+    void handleQProcess(RemoteServerReply *reply, Protocol::Command command, QDataStream &data);
+    void handleQSettings(RemoteServerReply *reply, Protocol::Command command, QDataStream &data,
                          PermissionSettings *settings);
-    void handleQFSFileEngine(RemoteServerReply *reply, const QString &command, QDataStream &data);
-    void handleArchive(RemoteServerReply *reply, const QString &command, QDataStream &data);
+    void handleQFSFileEngine(RemoteServerReply *reply, Protocol::Command command, QDataStream &data);
+    void handleArchive(RemoteServerReply *reply, Protocol::Command command, QDataStream &data);
 
 private:
     qintptr m_socketDescriptor;
@@ -331,7 +331,7 @@ Settings Settings::fromFileAndPrefix(const QString &path, const QString &prefix,
                 << scRepositorySettingsPageVisible << scTargetConfigurationFile
                 << scRemoteRepositories << scTranslations << scUrlQueryString << QLatin1String(scControlScript)
                 << scCreateLocalRepository << scInstallActionColumnVisible << scSupportsModify << scAllowUnstableComponents
-                << scSaveDefaultRepositories << scRepositoryCategories;
+                << scLoadComponentScriptsOnDemand << scSaveDefaultRepositories << scRepositoryCategories;
 
     Settings s;
     s.d->m_data.replace(scPrefix, prefix);
@@ -410,6 +410,8 @@ Settings Settings::fromFileAndPrefix(const QString &path, const QString &prefix,
         s.d->m_data.replace(scInstallActionColumnVisible, false);
     if (!s.d->m_data.contains(scAllowUnstableComponents))
         s.d->m_data.replace(scAllowUnstableComponents, false);
+    if (!s.d->m_data.contains(scLoadComponentScriptsOnDemand))
+        s.d->m_data.replace(scLoadComponentScriptsOnDemand, false);
     if (!s.d->m_data.contains(scSaveDefaultRepositories))
         s.d->m_data.replace(scSaveDefaultRepositories, true);
     return s;
@@ -980,6 +982,16 @@ void Settings::setAllowUnstableComponents(bool allow)
     d->m_data.replace(scAllowUnstableComponents, allow);
 }
 
+bool Settings::loadComponentScriptsOnDemand() const
+{
+    return d->m_data.value(scLoadComponentScriptsOnDemand, false).toBool();
+}
+
+void Settings::setLoadComponentScriptsOnDemand(bool onDemand)
+{
+    d->m_data.replace(scLoadComponentScriptsOnDemand, onDemand);
+}
+
 bool Settings::saveDefaultRepositories() const
 {
     return d->m_data.value(scSaveDefaultRepositories, true).toBool();
@@ -181,6 +181,9 @@ public:
     bool allowUnstableComponents() const;
     void setAllowUnstableComponents(bool allow);
 
+    bool loadComponentScriptsOnDemand() const;
+    void setLoadComponentScriptsOnDemand(bool onDemand);
+
     bool saveDefaultRepositories() const;
     void setSaveDefaultRepositories(bool save);
 
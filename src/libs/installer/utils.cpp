@@ -28,6 +28,7 @@
 
 #include "utils.h"
 
+#include "filehasher.h"
 #include "fileutils.h"
 #include "qsettingswrapper.h"
 
@@ -161,30 +162,22 @@ std::ostream &QInstaller::operator<<(std::ostream &os, const QString &string)
 
 /*!
     \internal
+
+    \sa FileHasher::hash()
 */
 QByteArray QInstaller::calculateHash(QIODevice *device, QCryptographicHash::Algorithm algo)
 {
-    Q_ASSERT(device);
-    QCryptographicHash hash(algo);
-    static QByteArray buffer(1024 * 1024, '\0');
-    while (true) {
-        const qint64 numRead = device->read(buffer.data(), buffer.size());
-        if (numRead <= 0)
-            return hash.result();
-        hash.addData(buffer.constData(), numRead);
-    }
-    return QByteArray(); // never reached
+    return FileHasher::hash(device, algo);
 }
 
 /*!
     \internal
+
+    \sa FileHasher::hashFile()
 */
 QByteArray QInstaller::calculateHash(const QString &path, QCryptographicHash::Algorithm algo)
 {
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly))
-        return QByteArray();
-    return calculateHash(&file, algo);
+    return FileHasher::hashFile(path, algo);
 }
 
 /*!
@@ -32,9 +32,12 @@
 #include "globals.h"
 #include "constants.h"
 
+#include <QDataStream>
+#include <QDateTime>
 #include <QDomDocument>
 #include <QDomElement>
 #include <QFileInfo>
+#include <QVector>
 
 using namespace KDUpdater;
 using namespace QInstaller;
@@ -53,8 +56,24 @@ using namespace QInstaller;
         \li Get information about the number of packages installed and their meta-data via the
             packageInfoCount() and packageInfo() methods.
     \endlist
+
+    Changes can either be written by rewriting the whole XML file with writeToDisk(), or be
+    appended to a journal file next to it with writeJournal(). The journal is replayed on top of
+    the XML file by refresh(), so that changes survive a crash before the next writeToDisk().
 */
 
+static const quint32 scJournalMagic = 0x49464A4C; // IFJL
+static const qint32 scJournalFormatVersion = 1;
+static const qint64 scMinimumCompactionSize = 64 * 1024;
+
+enum JournalRecordType : quint8
+{
+    AddPackageRecord = 1,
+    RemovePackageRecord,
+    ClearPackagesRecord,
+    ApplicationRecord
+};
+
 /*!
     \enum LocalPackageHub::Error
     Error codes related to retrieving information about installed packages:
@@ -74,7 +93,8 @@ struct LocalPackageHub::PackagesInfoData
 {
     PackagesInfoData() :
         error(LocalPackageHub::NotYetReadError),
-        modified(false)
+        modified(false),
+        revision(0)
     {}
     QString errorMessage;
     LocalPackageHub::Error error;
@@ -82,13 +102,166 @@ struct LocalPackageHub::PackagesInfoData
     QString applicationName;
     QString applicationVersion;
     bool modified;
+    quint64 revision;
 
     QMap<QString, LocalPackage> m_packageInfoMap;
 
+    // journal records not yet written to disk
+    QVector<QByteArray> pendingRecords;
+    QString journalApplicationName;
+    QString journalApplicationVersion;
+
     void addPackageFrom(const QDomElement &packageE);
     void setInvalidContentError(const QString &detail);
+
+    QString journalFileName() const { return fileName + QLatin1String(".journal"); }
+    void appendRecord(JournalRecordType type, const LocalPackage &info = LocalPackage());
+    bool writeJournalHeader();
+    bool writeXml();
+    void replayJournal();
 };
 
+static quint16 journalChecksum(const QByteArray &record)
+{
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    return qChecksum(record.constData(), record.size());
+#else
+    return qChecksum(record);
+#endif
+}
+
+static void writeJournalPackage(QDataStream &stream, const LocalPackage &info)
+{
+    stream << info.name << info.title << info.description << qint32(info.sortingPriority)
+        << info.treeName.first << info.treeName.second << info.version << info.inheritVersionFrom
+        << info.dependencies << info.autoDependencies << info.lastUpdateDate << info.installDate
+        << info.forcedInstallation << info.virtualComp << info.uncompressedSize << info.checkable
+        << info.expandedByDefault << info.contentSha1;
+}
+
+static void readJournalPackage(QDataStream &stream, LocalPackage *info)
+{
+    qint32 sortingPriority = 0;
+    stream >> info->name >> info->title >> info->description >> sortingPriority
+        >> info->treeName.first >> info->treeName.second >> info->version >> info->inheritVersionFrom
+        >> info->dependencies >> info->autoDependencies >> info->lastUpdateDate >> info->installDate
+        >> info->forcedInstallation >> info->virtualComp >> info->uncompressedSize >> info->checkable
+        >> info->expandedByDefault >> info->contentSha1;
+    info->sortingPriority = sortingPriority;
+}
+
+void LocalPackageHub::PackagesInfoData::appendRecord(JournalRecordType type, const LocalPackage &info)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << quint8(type);
+    if (type == AddPackageRecord)
+        writeJournalPackage(stream, info);
+    else if (type == RemovePackageRecord)
+        stream << info.name;
+    else if (type == ApplicationRecord)
+        stream << applicationName << applicationVersion;
+    pendingRecords.append(payload);
+}
+
+/*
+    Starts a new journal for the current installation information file. The header binds the
+    journal to the size and modification time of the file, so that a journal left behind next to
+    a file rewritten by someone else is not applied to it.
+*/
+bool LocalPackageHub::PackagesInfoData::writeJournalHeader()
+{
+    const QFileInfo fi(fileName);
+    QFile file(journalFileName());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << scJournalMagic << scJournalFormatVersion << qint64(fi.size())
+        << qint64(fi.lastModified().toMSecsSinceEpoch());
+    file.close();
+    QInstaller::setDefaultFilePermissions(&file, DefaultFilePermissions::NonExecutable);
+
+    journalApplicationName = applicationName;
+    journalApplicationVersion = applicationVersion;
+    return stream.status() == QDataStream::Ok;
+}
+
+/*
+    Applies the records of a journal that belongs to the current installation information file.
+    Reading stops at the first incomplete or damaged record, which is what is left behind if the
+    application is interrupted while appending to the journal.
+*/
+void LocalPackageHub::PackagesInfoData::replayJournal()
+{
+    QFile file(journalFileName());
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic = 0;
+    qint32 version = 0;
+    qint64 size = -1;
+    qint64 lastModified = -1;
+    stream >> magic >> version >> size >> lastModified;
+
+    const QFileInfo fi(fileName);
+    if (stream.status() != QDataStream::Ok || magic != scJournalMagic
+            || version != scJournalFormatVersion || size != fi.size()
+            || lastModified != fi.lastModified().toMSecsSinceEpoch()) {
+        qCWarning(QInstaller::lcInstallerInstallLog) << "Ignoring outdated journal"
+            << file.fileName();
+        return;
+    }
+
+    int records = 0;
+    while (!stream.atEnd()) {
+        QByteArray payload;
+        quint16 checksum = 0;
+        stream >> payload >> checksum;
+        if (stream.status() != QDataStream::Ok || payload.isEmpty()
+                || checksum != journalChecksum(payload)) {
+            qCWarning(QInstaller::lcInstallerInstallLog) << "Ignoring incomplete record at the end of"
+                << file.fileName();
+            break;
+        }
+
+        QDataStream record(payload);
+        record.setVersion(QDataStream::Qt_5_12);
+        quint8 type = 0;
+        record >> type;
+        switch (type) {
+        case AddPackageRecord: {
+            LocalPackage info;
+            readJournalPackage(record, &info);
+            m_packageInfoMap.insert(info.name, info);
+        }   break;
+        case RemovePackageRecord: {
+            QString name;
+            record >> name;
+            m_packageInfoMap.remove(name);
+        }   break;
+        case ClearPackagesRecord:
+            m_packageInfoMap.clear();
+            break;
+        case ApplicationRecord:
+            record >> applicationName >> applicationVersion;
+            break;
+        default:
+            break;
+        }
+        ++records;
+    }
+    journalApplicationName = applicationName;
+    journalApplicationVersion = applicationVersion;
+    qCDebug(QInstaller::lcInstallerInstallLog) << "Replayed" << records << "records from"
+        << file.fileName();
+}
+
 void LocalPackageHub::PackagesInfoData::setInvalidContentError(const QString &detail)
 {
     error = LocalPackageHub::InvalidContentError;
@@ -138,6 +311,16 @@ QStringList LocalPackageHub::packageNames() const
     return d->m_packageInfoMap.keys();
 }
 
+/*!
+    Returns a counter that is increased whenever the list of local packages changes, either by
+    re-reading the installation information XML file or by adding or removing packages. Can be
+    used to detect whether information derived from localPackages() is still up to date.
+*/
+quint64 LocalPackageHub::revision() const
+{
+    return d->revision;
+}
+
 /*!
     Returns a human-readable description of the last error that occurred.
 */
@@ -246,7 +429,9 @@ void LocalPackageHub::refresh()
     d->applicationName.clear();
     d->applicationVersion.clear();
     d->m_packageInfoMap.clear();
+    d->pendingRecords.clear();
     d->modified = false;
+    ++d->revision;
 
     QFile file(d->fileName);
 
@@ -302,6 +487,12 @@ void LocalPackageHub::refresh()
         else if (childNodeE.tagName() == QLatin1String("Package"))
             d->addPackageFrom(childNodeE);
     }
+    d->journalApplicationName = d->applicationName;
+    d->journalApplicationVersion = d->applicationVersion;
+
+    // Apply changes that were journaled but not yet written to the XML file.
+    if (QFileInfo::exists(d->journalFileName()))
+        d->replayJournal();
 
     d->error = NoError;
     d->errorMessage.clear();
@@ -365,7 +556,9 @@ void LocalPackageHub::addPackage(const QString &name,
         info.contentSha1 = contentSha1;
         d->m_packageInfoMap.insert(name, info);
     }
+    d->appendRecord(AddPackageRecord, d->m_packageInfoMap.value(name));
     d->modified = true;
+    ++d->revision;
 }
 
 /*!
@@ -376,7 +569,11 @@ bool LocalPackageHub::removePackage(const QString &name)
     if (d->m_packageInfoMap.remove(name) <= 0)
         return false;
 
+    LocalPackage info;
+    info.name = name;
+    d->appendRecord(RemovePackageRecord, info);
     d->modified = true;
+    ++d->revision;
     return true;
 }
 
@@ -396,19 +593,95 @@ static void addTextChildHelper(QDomNode *node,
 }
 
 /*!
-    Writes the installation information file to disk.
+    Writes the installation information file to disk. Any journal written with writeJournal()
+    is merged into the file and removed.
 */
 void LocalPackageHub::writeToDisk()
 {
-    if (d->modified && (!d->m_packageInfoMap.isEmpty() || QFile::exists(d->fileName))) {
+    const bool journaled = QFileInfo::exists(d->journalFileName());
+    if ((d->modified || journaled) && d->writeXml()) {
+        if (journaled)
+            QFile::remove(d->journalFileName());
+    }
+}
+
+/*!
+    Writes the changes made since the last call to writeJournal() or writeToDisk() to disk.
+    Instead of rewriting the whole installation information file, the changes are appended to a
+    journal file next to it, which keeps the cost of recording a single package change independent
+    of the number of installed packages. The journal is merged into the installation information
+    file once it grows larger than the file itself, and by writeToDisk().
+
+    Returns \c true if the changes were written; otherwise returns \c false.
+
+    \sa journalFileName()
+*/
+bool LocalPackageHub::writeJournal()
+{
+    if (!d->modified)
+        return true;
+
+    if (d->applicationName != d->journalApplicationName
+            || d->applicationVersion != d->journalApplicationVersion) {
+        d->appendRecord(ApplicationRecord);
+        d->journalApplicationName = d->applicationName;
+        d->journalApplicationVersion = d->applicationVersion;
+    }
+
+    const QFileInfo xmlInfo(d->fileName);
+    const QFileInfo journalInfo(d->journalFileName());
+    qint64 pendingSize = 0;
+    for (const QByteArray &record : qAsConst(d->pendingRecords))
+        pendingSize += record.size();
+
+    // Start a new journal from a freshly written file if there is none yet, or if replaying
+    // the journal would cost more than reading the compacted file.
+    if (!xmlInfo.exists() || !journalInfo.exists()
+            || journalInfo.size() + pendingSize > qMax(xmlInfo.size(), scMinimumCompactionSize)) {
+        if (!d->writeXml())
+            return false;
+        if (!QFile::exists(d->fileName)) {
+            d->pendingRecords.clear();
+            return true; // nothing installed yet, nothing to write
+        }
+        return d->writeJournalHeader();
+    }
+
+    QFile file(d->journalFileName());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    for (const QByteArray &record : qAsConst(d->pendingRecords))
+        stream << record << journalChecksum(record);
+    if (stream.status() != QDataStream::Ok || !file.flush())
+        return false;
+
+    d->pendingRecords.clear();
+    d->modified = false;
+    return true;
+}
+
+/*!
+    Returns the name of the journal file that writeJournal() appends changes to.
+*/
+QString LocalPackageHub::journalFileName() const
+{
+    return d->journalFileName();
+}
+
+bool LocalPackageHub::PackagesInfoData::writeXml()
+{
+    if (!m_packageInfoMap.isEmpty() || QFile::exists(fileName)) {
         QDomDocument doc;
         QDomElement root = doc.createElement(QLatin1String("Packages")) ;
         doc.appendChild(root);
 
-        addTextChildHelper(&root, QLatin1String("ApplicationName"), d->applicationName);
-        addTextChildHelper(&root, QLatin1String("ApplicationVersion"), d->applicationVersion);
+        addTextChildHelper(&root, QLatin1String("ApplicationName"), applicationName);
+        addTextChildHelper(&root, QLatin1String("ApplicationVersion"), applicationVersion);
 
-        Q_FOREACH (const LocalPackage &info, d->m_packageInfoMap) {
+        Q_FOREACH (const LocalPackage &info, m_packageInfoMap) {
             QDomElement package = doc.createElement(QLatin1String("Package"));
 
             addTextChildHelper(&package, QLatin1String("Name"), info.name);
@@ -448,9 +721,9 @@ void LocalPackageHub::writeToDisk()
         }
 
         // Open Packages.xml
-        QFile file(d->fileName);
+        QFile file(fileName);
         if (!file.open(QFile::WriteOnly))
-            return;
+            return false;
 
         file.write(doc.toByteArray(4));
         file.close();
@@ -459,8 +732,10 @@ void LocalPackageHub::writeToDisk()
         QInstaller::setDefaultFilePermissions(
             &file, DefaultFilePermissions::NonExecutable);
 
-        d->modified = false;
+        pendingRecords.clear();
+        modified = false;
     }
+    return true;
 }
 
 void LocalPackageHub::PackagesInfoData::addPackageFrom(const QDomElement &packageE)
@@ -530,7 +805,10 @@ void LocalPackageHub::PackagesInfoData::addPackageFrom(const QDomElement &packag
 void LocalPackageHub::clearPackageInfos()
 {
     d->m_packageInfoMap.clear();
+    d->pendingRecords.clear();
+    d->appendRecord(ClearPackagesRecord);
     d->modified = true;
+    ++d->revision;
 }
 
 /*!
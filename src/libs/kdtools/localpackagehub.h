@@ -81,6 +81,7 @@ public:
 
     QMap<QString, LocalPackage> localPackages() const;
     QStringList packageNames() const;
+    quint64 revision() const;
 
     Error error() const;
     QString errorString() const;
@@ -119,6 +120,8 @@ public:
 
     void refresh();
     void writeToDisk();
+    bool writeJournal();
+    QString journalFileName() const;
 
 private:
     struct PackagesInfoData;
@@ -30,6 +30,7 @@
 
 #include <QtCore/QDebug>
 #include <QtCore/QDir>
+#include <QtCore/QFileInfo>
 
 using namespace KDUpdater;
 
@@ -144,6 +145,93 @@ bool VolumeInfo::operator==(const VolumeInfo &other) const
     return m_volumeDescriptor == other.m_volumeDescriptor;
 }
 
+/*!
+    \inmodule kdupdater
+    \class KDUpdater::ProcessIndex
+    \brief The ProcessIndex class provides fast lookups in a snapshot of running processes.
+
+    The list of running processes is read once on construction. Checking whether a process
+    is running is then a hash lookup of the process name, instead of a comparison against
+    every running process.
+*/
+
+/*!
+    Creates an index of the currently running processes.
+*/
+ProcessIndex::ProcessIndex()
+    : ProcessIndex(runningProcesses())
+{
+}
+
+/*!
+    Creates an index of \a processes.
+*/
+ProcessIndex::ProcessIndex(const QList<ProcessInfo> &processes)
+    : m_processes(processes)
+{
+    for (const ProcessInfo &process : processes) {
+        if (process.name.isEmpty())
+            continue;
+
+        const QFileInfo fi(process.name);
+#ifdef Q_OS_WIN
+        m_names.insert(process.name.toLower());
+        m_names.insert(fi.fileName().toLower());
+        m_names.insert(fi.baseName().toLower());
+#else
+        m_names.insert(process.name);
+        m_names.insert(fi.fileName());
+        m_names.insert(fi.baseName());
+#endif
+    }
+}
+
+/*!
+    \fn KDUpdater::ProcessIndex::processes() const
+
+    Returns the indexed processes.
+*/
+
+/*!
+    Returns \c true if a process with \a name is running. The \a name can be the absolute
+    path of the executable, its file name, or its file name without suffix. On Windows, the
+    comparison is case-insensitive.
+*/
+bool ProcessIndex::contains(const QString &name) const
+{
+    if (name.isEmpty())
+        return false;
+#ifdef Q_OS_WIN
+    const QString lowerName = name.toLower();
+    return m_names.contains(lowerName) || m_names.contains(QDir::toNativeSeparators(lowerName));
+#else
+    return m_names.contains(name);
+#endif
+}
+
+/*!
+    Returns the processes whose executable is located in \a directory or one of its
+    subdirectories. On Windows, the comparison is case-insensitive.
+*/
+QList<ProcessInfo> ProcessIndex::processesInDirectory(const QString &directory) const
+{
+    QString prefix = QDir::cleanPath(QDir::fromNativeSeparators(directory));
+    if (!prefix.endsWith(QLatin1Char('/')))
+        prefix.append(QLatin1Char('/'));
+#ifdef Q_OS_WIN
+    const Qt::CaseSensitivity cs = Qt::CaseInsensitive;
+#else
+    const Qt::CaseSensitivity cs = Qt::CaseSensitive;
+#endif
+
+    QList<ProcessInfo> result;
+    for (const ProcessInfo &process : m_processes) {
+        if (QDir::fromNativeSeparators(process.name).startsWith(prefix, cs))
+            result.append(process);
+    }
+    return result;
+}
+
 QDebug operator<<(QDebug dbg, const VolumeInfo &volume)
 {
     return dbg << "KDUpdater::Volume(" << volume.mountPath() << ")";
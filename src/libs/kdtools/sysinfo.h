@@ -31,6 +31,8 @@
 
 #include "kdtoolsglobal.h"
 
+#include <QtCore/QList>
+#include <QtCore/QSet>
 #include <QtCore/QString>
 
 namespace KDUpdater {
@@ -73,6 +75,22 @@ struct ProcessInfo
     QString name;
 };
 
+class KDTOOLS_EXPORT ProcessIndex
+{
+public:
+    ProcessIndex();
+    explicit ProcessIndex(const QList<ProcessInfo> &processes);
+
+    QList<ProcessInfo> processes() const { return m_processes; }
+
+    bool contains(const QString &name) const;
+    QList<ProcessInfo> processesInDirectory(const QString &directory) const;
+
+private:
+    QList<ProcessInfo> m_processes;
+    QSet<QString> m_names;
+};
+
 quint64 installedMemory();
 QList<VolumeInfo> mountedVolumes();
 QList<ProcessInfo> runningProcesses();
@@ -30,6 +30,8 @@
 
 #include <sys/utsname.h>
 #include <sys/statvfs.h>
+#include <limits.h>
+#include <unistd.h>
 
 #ifdef Q_OS_FREEBSD
 #include <sys/types.h>
@@ -39,8 +41,8 @@
 #include <QtCore/QFile>
 #include <QtCore/QTextStream>
 #include <QtCore/QDir>
+#include <QtCore/QDirIterator>
 #include <QtCore/QFileInfo>
-#include <QtCore/QRegularExpression>
 
 namespace KDUpdater {
 
@@ -122,20 +124,29 @@ QList<VolumeInfo> mountedVolumes()
 QList<ProcessInfo> runningProcesses()
 {
     QList<ProcessInfo> processes;
-    QDir procDir(QLatin1String("/proc"));
-    const QFileInfoList procCont = procDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Readable);
-    static const QRegularExpression validator(QLatin1String("^[0-9]+$"));
-    for (const QFileInfo &info : procCont) {
-        if (validator.match(info.fileName()).hasMatch()) {
-            const QString linkPath = QDir(info.absoluteFilePath()).absoluteFilePath(QLatin1String("exe"));
-            const QFileInfo linkInfo(linkPath);
-            if (linkInfo.exists()) {
-                ProcessInfo processInfo;
-                processInfo.name = linkInfo.symLinkTarget();
-                processInfo.id = info.fileName().toInt();
-                processes.append(processInfo);
-            }
-        }
+    QDirIterator it(QLatin1String("/proc"), QDir::Dirs | QDir::NoDotAndDotDot);
+    QByteArray target(PATH_MAX, Qt::Uninitialized);
+    while (it.hasNext()) {
+        it.next();
+        const QString pid = it.fileName();
+        bool isPid = false;
+        const quint32 id = pid.toUInt(&isPid);
+        if (!isPid)
+            continue;
+
+        // Read the link directly, processes of other users cannot be resolved and the
+        // link of a process whose executable was removed points to "<path> (deleted)".
+        const QByteArray link = QFile::encodeName(it.filePath() + QLatin1String("/exe"));
+        const ssize_t size = ::readlink(link.constData(), target.data(), target.size());
+        if (size <= 0 || size >= target.size())
+            continue;
+
+        ProcessInfo processInfo;
+        processInfo.name = QFile::decodeName(QByteArray(target.constData(), int(size)));
+        if (processInfo.name.endsWith(QLatin1String(" (deleted)")))
+            continue;
+        processInfo.id = id;
+        processes.append(processInfo);
     }
     return processes;
 }
@@ -48,12 +48,21 @@ using namespace KDUpdater;
     Returns the package source.
 */
 
+/*!
+    \fn KDUpdater::Update::versionKey() const
+
+    Returns the precompiled version of the update, used for comparing it against the
+    versions of other packages.
+*/
+
 /*!
    \internal
 */
-Update::Update(const QInstaller::PackageSource &packageSource, const UpdateInfo &updateInfo)
+Update::Update(const QInstaller::PackageSource &packageSource, const UpdateInfo &updateInfo,
+        const VersionKey &versionKey)
     : m_packageSource(packageSource)
     , m_updateInfo(updateInfo)
+    , m_versionKey(versionKey)
 {
 }
 
@@ -31,24 +31,26 @@
 
 #include "packagesource.h"
 #include "updatesinfo_p.h"
+#include "updater.h"
 #include <QVariant>
 
 namespace KDUpdater {
 
-class Update
+class KDTOOLS_EXPORT Update
 {
 public:
+    Update(const QInstaller::PackageSource &packageSource, const UpdateInfo &updateInfo,
+        const VersionKey &versionKey);
+
     QVariant data(const QString &name, const QVariant &defaultValue = QVariant()) const;
 
     QInstaller::PackageSource packageSource() const {return m_packageSource; }
-
-private:
-    friend class UpdateFinder;
-    Update(const QInstaller::PackageSource &packageSource, const UpdateInfo &updateInfo);
+    const VersionKey &versionKey() const { return m_versionKey; }
 
 private:
     QInstaller::PackageSource m_packageSource;
     UpdateInfo m_updateInfo;
+    VersionKey m_versionKey;
 };
 
 } // namespace KDUpdater
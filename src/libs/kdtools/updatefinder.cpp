@@ -39,7 +39,6 @@
 
 #include <QCoreApplication>
 #include <QFileInfo>
-#include <QRegularExpression>
 #include <QFutureWatcher>
 
 using namespace KDUpdater;
@@ -455,16 +454,18 @@ void UpdateFinder::createUpdateObjects(const PackageSource &source,
     const QList<UpdateInfo> &updateInfoList)
 {
     foreach (const UpdateInfo &info, updateInfoList) {
-        const Resolution value = checkPriorityAndVersion(source, info.data);
+        // The version is split into its components once and kept with the update.
+        const VersionKey version(info.data.version());
+        const Resolution value = checkPriorityAndVersion(source, info.data, version);
         if (value == Resolution::KeepExisting)
             continue;
 
-        const QString name = info.data.value(QLatin1String("Name")).toString();
+        const QString name = info.data.name();
         if (value == Resolution::RemoveExisting)
             delete m_updates.take(name);
 
         // Create and register the update
-        m_updates.insert(name, new Update(source, info));
+        m_updates.insert(name, new Update(source, info, version));
     }
 }
 
@@ -473,16 +474,16 @@ void UpdateFinder::createUpdateObjects(const PackageSource &source,
     If a package of the same name exists, always use the one with the higher
     version. If the new package has the same version but a higher
     priority, use the new new package, otherwise keep the already existing package.
+    \a version is the version key of \a newPackage.
 */
 UpdateFinder::Resolution UpdateFinder::checkPriorityAndVersion(
-    const PackageSource &source, const QVariantHash &newPackage) const
+    const PackageSource &source, const UpdateRecord &newPackage, const VersionKey &version) const
 {
-    const QString name = newPackage.value(QLatin1String("Name")).toString();
+    const QString name = newPackage.name();
     if (Update *existingPackage = m_updates.value(name)) {
         // Bingo, package was previously found elsewhere.
 
-        const int match = compareVersion(newPackage.value(QLatin1String("Version")).toString(),
-            existingPackage->data(QLatin1String("Version")).toString());
+        const int match = compareVersion(version, existingPackage->versionKey());
 
         if (match > 0) {
             // new package has higher version, use
@@ -490,7 +491,7 @@ UpdateFinder::Resolution UpdateFinder::checkPriorityAndVersion(
                 << ", Version: "<< existingPackage->data(QLatin1String("Version")).toString()
                 << ", Source: " << QFileInfo(existingPackage->packageSource().url.toLocalFile()).fileName()
                 << "' found a package with higher version 'Name: "
-                << name << ", Version: " << newPackage.value(QLatin1String("Version")).toString()
+                << name << ", Version: " << newPackage.version()
                 << ", Source: " << QFileInfo(source.url.toLocalFile()).fileName() << "'";
             return Resolution::RemoveExisting;
         }
@@ -599,78 +600,176 @@ int KDUpdater::compareVersion(const QString &v1, const QString &v2)
     if (v1 == v2)
         return 0;
 
-    // Split version components across ".", "-" or "_"
-    static const QRegularExpression regex(QLatin1String( "\\.|-|_"));
-    QStringList v1_comps = v1.split(regex);
-    QStringList v2_comps = v2.split(regex);
+    return VersionKey::compare(VersionKey(v1), VersionKey(v2));
+}
 
-    // Check each component of the version
-    int index = 0;
-    while (true) {
-        bool v1_ok = false;
-        bool v2_ok = false;
+/*!
+   \inmodule kdupdater
 
-        if (index == v1_comps.count() && index < v2_comps.count()) {
-            v2_comps.at(index).toLongLong(&v2_ok);
-            return v2_ok ? -1 : +1;
-        }
-        if (index < v1_comps.count() && index == v2_comps.count()) {
-            v1_comps.at(index).toLongLong(&v1_ok);
-            return v1_ok ? +1 : -1;
-        }
-        if (index >= v1_comps.count() || index >= v2_comps.count())
-            break;
+   \overload
 
-        qlonglong v1_comp = v1_comps.at(index).toLongLong(&v1_ok);
-        qlonglong v2_comp = v2_comps.at(index).toLongLong(&v2_ok);
+   Compares the precompiled version keys \a v1 and \a v2. The result is the same as
+   comparing the version strings the keys were created from, but the strings are not
+   split and parsed again.
+*/
+int KDUpdater::compareVersion(const VersionKey &v1, const VersionKey &v2)
+{
+    return VersionKey::compare(v1, v2);
+}
 
-        if (!v1_ok) {
-            if (v1_comps.at(index) == QLatin1String("x"))
-                return 0;
-        }
-        if (!v2_ok) {
-            if (v2_comps.at(index) == QLatin1String("x"))
-                return 0;
+/*!
+   \inmodule kdupdater
+   \class KDUpdater::VersionKey
+   \brief The VersionKey class holds a version string split into its components.
+
+   Splitting a version string across ".", "-" and "_" and parsing the numeric components is
+   the expensive part of KDUpdater::compareVersion(). A VersionKey does this once, so that
+   versions which are compared over and over again, for example while resolving the
+   dependencies of a component tree, can be compared with a few integer operations.
+
+   Comparing two keys follows exactly the same rules as comparing the version strings,
+   including the "x" wildcard and the comparison of non-numeric components with a common
+   prefix.
+*/
+
+/*!
+   \fn KDUpdater::VersionKey::VersionKey()
+
+   Creates an empty version key.
+*/
+
+/*!
+   \fn KDUpdater::VersionKey::toString() const
+
+   Returns the version string this key was created from.
+*/
+
+/*!
+   \fn KDUpdater::VersionKey::componentCount() const
+
+   Returns the number of components of the version.
+*/
+
+/*!
+   Creates a version key for \a version.
+*/
+VersionKey::VersionKey(const QString &version)
+    : m_version(version)
+{
+    int position = 0;
+    const int size = m_version.size();
+    for (int i = 0; i <= size; ++i) {
+        if (i < size) {
+            const QChar c = m_version.at(i);
+            if (c != QLatin1Char('.') && c != QLatin1Char('-') && c != QLatin1Char('_'))
+                continue;
         }
-        if (!v1_ok && !v2_ok) {
+        Component component;
+        component.position = position;
+        component.length = i - position;
+        component.number = m_version.mid(position, component.length).toLongLong(&component.isNumber);
+        m_components.append(component);
+        position = i + 1;
+    }
+}
+
+/*!
+    \internal
+*/
+QStringView VersionKey::componentText(const Component &component) const
+{
+    return QStringView(m_version).mid(component.position, component.length);
+}
+
+/*!
+    \internal
+
+    Compares two version components of which at least one is not a number. Returns -1, 0
+    or +1 if the result of the version comparison is decided, or 2 if both components are
+    equal and the comparison has to continue with the next component.
+*/
+static int compareTextComponents(QStringView text1, qlonglong number1, bool isNumber1,
+    QStringView text2, qlonglong number2, bool isNumber2)
+{
+    static const QLatin1Char wildcard('x');
+    while (true) {
+        if (!isNumber1 && text1.size() == 1 && text1.at(0) == wildcard)
+            return 0;
+        if (!isNumber2 && text2.size() == 1 && text2.at(0) == wildcard)
+            return 0;
+
+        if (!isNumber1 && !isNumber2) {
             // try remove equal start
             int i = 0;
-            while (i < v1_comps.at(index).size()
-                && i < v2_comps.at(index).size()
-                && v1_comps.at(index).at(i) == v2_comps.at(index).at(i)) {
+            while (i < text1.size() && i < text2.size() && text1.at(i) == text2.at(i))
                 ++i;
-            }
             if (i > 0) {
-                v1_comps[index] = v1_comps.at(index).mid(i);
-                v2_comps[index] = v2_comps.at(index).mid(i);
+                text1 = text1.mid(i);
+                text2 = text2.mid(i);
+                number1 = text1.toString().toLongLong(&isNumber1);
+                number2 = text2.toString().toLongLong(&isNumber2);
                 // compare again
                 continue;
             }
         }
-        if (!v1_ok || !v2_ok) {
-            int res = v1_comps.at(index).compare(v2_comps.at(index));
-            if (res == 0) {
-                // v1_comps.at(index) == v2_comps(index)
-                ++index;
-                continue;
-            }
+        if (!isNumber1 || !isNumber2) {
+            const int res = text1.compare(text2);
+            if (res == 0)
+                return 2;
             return res > 0 ? +1 : -1;
         }
 
-        if (v1_comp < v2_comp)
+        if (number1 < number2)
             return -1;
-
-        if (v1_comp > v2_comp)
+        if (number1 > number2)
             return +1;
+        return 2;
+    }
+}
+
+/*!
+   Compares the version keys \a v1 and \a v2 and returns -1, 0 or +1 like
+   KDUpdater::compareVersion().
+*/
+int VersionKey::compare(const VersionKey &v1, const VersionKey &v2)
+{
+    // Check for equality
+    if (v1.m_version == v2.m_version)
+        return 0;
 
-        // v1_comp == v2_comp
+    const int v1_count = v1.m_components.count();
+    const int v2_count = v2.m_components.count();
+
+    // Check each component of the version
+    int index = 0;
+    while (true) {
+        if (index == v1_count && index < v2_count)
+            return v2.m_components.at(index).isNumber ? -1 : +1;
+        if (index < v1_count && index == v2_count)
+            return v1.m_components.at(index).isNumber ? +1 : -1;
+        if (index >= v1_count || index >= v2_count)
+            break;
+
+        const Component &c1 = v1.m_components.at(index);
+        const Component &c2 = v2.m_components.at(index);
+        if (c1.isNumber && c2.isNumber) {
+            if (c1.number < c2.number)
+                return -1;
+            if (c1.number > c2.number)
+                return +1;
+        } else {
+            const int res = compareTextComponents(v1.componentText(c1), c1.number, c1.isNumber,
+                v2.componentText(c2), c2.number, c2.isNumber);
+            if (res != 2)
+                return res;
+        }
         ++index;
     }
 
-    if (index < v2_comps.count())
+    if (index < v2_count)
         return +1;
 
-    if (index < v1_comps.count())
+    if (index < v1_count)
         return -1;
 
     // Controversial return. I hope this never happens.
@@ -118,7 +118,8 @@ private:
 
     QList<UpdateInfo> applicableUpdates(UpdatesInfo *updatesInfo);
     void createUpdateObjects(const PackageSource &source, const QList<UpdateInfo> &updateInfoList);
-    Resolution checkPriorityAndVersion(const QInstaller::PackageSource &source, const QVariantHash &data) const;
+    Resolution checkPriorityAndVersion(const QInstaller::PackageSource &source, const UpdateRecord &data,
+        const VersionKey &version) const;
     bool waitForJobToFinish(const int &currentCount, const int &totalsCount);
 
 private slots:
@@ -42,6 +42,8 @@
 
 using namespace KDUpdater;
 
+static const quint8 scBinaryFormatVersion = 1;
+
 /*!
    \inmodule kdupdater
    \class KDUpdater::UpdateOperation
@@ -111,6 +113,88 @@ static QString backupFileName(const QString &templateName)
     return name;
 }
 
+/*
+    \internal
+    Returns the directory that replaces the relocatable placeholder when restoring operations.
+*/
+static QString relocationTarget()
+{
+    QString target = QCoreApplication::applicationDirPath();
+    // Does not change target on non macOS platforms.
+    if (QInstaller::isInBundle(target, &target))
+        target = QDir::cleanPath(target + QLatin1String("/.."));
+    return target;
+}
+
+/*
+    \internal
+    Replaces \a target in the arguments \a args of the operation called \a name with the
+    relocatable placeholder.
+*/
+static QStringList relocatableArguments(const QString &name, const QStringList &args,
+    const QString &target)
+{
+    // Do not call cleanPath to Execute operations paths. The operation might require the
+    // exact separators that are set in the operation call.
+    const bool useCleanPath = (name != QLatin1String("Execute"));
+
+    QStringList result;
+    result.reserve(args.count());
+    foreach (const QString &arg, args) {
+        result.append(QInstaller::replacePath(arg, target,
+            QLatin1String(QInstaller::scRelocatable), useCleanPath));
+    }
+    return result;
+}
+
+/*
+    \internal
+    Replaces the relocatable placeholder in the arguments \a args of the operation called
+    \a name with \a target.
+*/
+static QStringList resolvedArguments(const QString &name, const QStringList &args, QString target)
+{
+    static const QLatin1String relocatable = QLatin1String(QInstaller::scRelocatable);
+
+    QStringList result;
+    result.reserve(args.count());
+    foreach (const QString &arg, args) {
+        // Sniff the Execute -operations file path separator. The operation might be
+        // strict with the used path separator
+        bool useCleanPath = true;
+        if (name == QLatin1String("Execute")) {
+            if (arg.startsWith(relocatable) && arg.size() > relocatable.size()) {
+                const QChar separator = arg.at(relocatable.size());
+                if (separator == QLatin1Char('\\')) {
+                    target = QDir::toNativeSeparators(target);
+                    useCleanPath = false;
+                }
+            }
+        }
+        result.append(QInstaller::replacePath(arg, relocatable, target, useCleanPath));
+    }
+    return result;
+}
+
+/*
+    \internal
+    Replaces \a before with \a after in the string and string list values of \a value.
+*/
+static QVariant replacePathInValue(const QVariant &value, const QString &before,
+    const QString &after)
+{
+    if (value.type() == QVariant::String)
+        return QInstaller::replacePath(value.toString(), before, after);
+
+    if (value.type() == QVariant::StringList) {
+        QStringList list = value.toStringList();
+        for (int i = 0; i < list.count(); ++i)
+            list[i] = QInstaller::replacePath(list.at(i), before, after);
+        return list;
+    }
+    return value;
+}
+
 /*!
     \internal
 */
@@ -153,6 +237,7 @@ QString UpdateOperation::name() const
 */
 QString UpdateOperation::operationCommand() const
 {
+    ensureDecoded();
     QString argsStr = m_arguments.join(QLatin1String( " " ));
     return QString::fromLatin1( "%1 %2" ).arg(m_name, argsStr);
 }
@@ -172,6 +257,7 @@ UpdateOperation::OperationGroup UpdateOperation::group() const
 */
 bool UpdateOperation::hasValue(const QString &name) const
 {
+    ensureDecoded();
     return m_values.contains(name);
 }
 
@@ -180,6 +266,7 @@ bool UpdateOperation::hasValue(const QString &name) const
 */
 void UpdateOperation::clearValue(const QString &name)
 {
+    ensureDecoded();
     m_values.remove(name);
 }
 
@@ -188,6 +275,7 @@ void UpdateOperation::clearValue(const QString &name)
 */
 QVariant UpdateOperation::value(const QString &name) const
 {
+    ensureDecoded();
     return m_values.value(name);
 }
 
@@ -196,6 +284,7 @@ QVariant UpdateOperation::value(const QString &name) const
 */
 void UpdateOperation::setValue(const QString &name, const QVariant &value)
 {
+    ensureDecoded();
     m_values[name] = value;
 }
 
@@ -224,6 +313,7 @@ void UpdateOperation::setGroup(const OperationGroup &group)
 */
 void UpdateOperation::setArguments(const QStringList &args)
 {
+    ensureDecoded();
     m_arguments = args;
 }
 
@@ -232,6 +322,7 @@ void UpdateOperation::setArguments(const QStringList &args)
 */
 QStringList UpdateOperation::arguments() const
 {
+    ensureDecoded();
     return m_arguments;
 }
 
@@ -440,6 +531,7 @@ void UpdateOperation::setError(int error, const QString &errorString)
 */
 void UpdateOperation::clear()
 {
+    ensureDecoded();
     m_arguments.clear();
 }
 
@@ -542,23 +634,17 @@ bool UpdateOperation::deleteFileNowOrLater(const QString &file, QString *errorSt
 */
 QDomDocument UpdateOperation::toXml() const
 {
+    ensureDecoded();
+
     QDomDocument doc;
     QDomElement root = doc.createElement(QLatin1String("operation"));
     doc.appendChild(root);
 
     QDomElement args = doc.createElement(QLatin1String("arguments"));
     const QString target = m_core ? m_core->value(QInstaller::scTargetDir) : QString();
-    Q_FOREACH (const QString &s, arguments()) {
+    Q_FOREACH (const QString &s, relocatableArguments(name(), arguments(), target)) {
         QDomElement arg = doc.createElement(QLatin1String("argument"));
-        // Do not call cleanPath to Execute operations paths. The operation might require the
-        // exact separators that are set in the operation call.
-        if (name() == QLatin1String("Execute")) {
-            arg.appendChild(doc.createTextNode(QInstaller::replacePath(s, target,
-                QLatin1String(QInstaller::scRelocatable), false)));
-        } else {
-            arg.appendChild(doc.createTextNode(QInstaller::replacePath(s, target,
-                QLatin1String(QInstaller::scRelocatable))));
-        }
+        arg.appendChild(doc.createTextNode(s));
         args.appendChild(arg);
     }
     root.appendChild(args);
@@ -609,11 +695,10 @@ QDomDocument UpdateOperation::toXml() const
 */
 bool UpdateOperation::fromXml(const QDomDocument &doc)
 {
-    QString target = QCoreApplication::applicationDirPath();
+    m_pendingBinary.clear();
+
+    const QString target = relocationTarget();
     static const QLatin1String relocatable = QLatin1String(QInstaller::scRelocatable);
-    // Does not change target on non macOS platforms.
-    if (QInstaller::isInBundle(target, &target))
-        target = QDir::cleanPath(target + QLatin1String("/.."));
 
     QStringList args;
     const QDomElement root = doc.documentElement();
@@ -621,24 +706,10 @@ bool UpdateOperation::fromXml(const QDomDocument &doc)
     Q_ASSERT(! argsElem.isNull());
     for (QDomNode n = argsElem.firstChild(); ! n.isNull(); n = n.nextSibling()) {
         const QDomElement e = n.toElement();
-        if (!e.isNull() && e.tagName() == QLatin1String("argument")) {
-            // Sniff the Execute -operations file path separator. The operation might be
-            // strict with the used path separator
-            bool useCleanPath = true;
-            if (name() == QLatin1String("Execute")) {
-                if (e.text().startsWith(relocatable) && e.text().size() > relocatable.size()) {
-                    const QChar separator = e.text().at(relocatable.size());
-                    if (separator == QLatin1Char('\\')) {
-                        target = QDir::toNativeSeparators(target);
-                        useCleanPath = false;
-                    }
-                }
-            }
-            args << QInstaller::replacePath(e.text(), relocatable,
-                target, useCleanPath);
-        }
+        if (!e.isNull() && e.tagName() == QLatin1String("argument"))
+            args << e.text();
     }
-    setArguments(args);
+    setArguments(resolvedArguments(name(), args, target));
 
     m_values.clear();
     const QDomElement values = root.firstChildElement(QLatin1String("values"));
@@ -676,6 +747,111 @@ bool UpdateOperation::fromXml(const QDomDocument &doc)
     return true;
 }
 
+/*!
+    Saves operation arguments and values in a compact binary form and returns the data. Paths
+    below the target directory are stored relocatable, like with toXml(). You can override this
+    method to leave out or add values, in the same way as for toXml().
+
+    \sa fromBinary()
+*/
+QByteArray UpdateOperation::toBinary() const
+{
+    // Operations restored from binary data that were not touched since can be saved as is.
+    if (!m_pendingBinary.isEmpty())
+        return m_pendingBinary;
+
+    const QString target = m_core ? m_core->value(QInstaller::scTargetDir) : QString();
+    const QLatin1String relocatable = QLatin1String(QInstaller::scRelocatable);
+
+    QVariantMap values;
+    for (QVariantMap::const_iterator it = m_values.constBegin(); it != m_values.constEnd(); ++it) {
+        // the installer can't be serialized, ignore
+        if (it.key() == QLatin1String("installer"))
+            continue;
+        values.insert(it.key(), replacePathInValue(it.value(), target, relocatable));
+    }
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << scBinaryFormatVersion << relocatableArguments(name(), m_arguments, target) << values;
+    return data;
+}
+
+/*!
+    Restores operation arguments and values from \a data previously created with toBinary().
+    Returns \c true if the data has a known format, otherwise \c false.
+
+    The data is decoded the first time the arguments or values of the operation are accessed,
+    so that restoring a large number of operations stays cheap. \note: Clears all previously
+    set values and arguments.
+
+    \sa toBinary()
+*/
+bool UpdateOperation::fromBinary(const QByteArray &data)
+{
+    if (data.isEmpty() || quint8(data.at(0)) != scBinaryFormatVersion) {
+        qCWarning(QInstaller::lcInstallerInstallLog) << "Unknown binary format of operation"
+            << name();
+        return false;
+    }
+    m_pendingBinary = data;
+    return true;
+}
+
+/*!
+    Returns \c true if the operation was restored with fromBinary() and its arguments and
+    values have not been decoded yet.
+*/
+bool UpdateOperation::hasPendingBinary() const
+{
+    return !m_pendingBinary.isEmpty();
+}
+
+/*!
+    \internal
+
+    Decodes the data passed to fromBinary(), if any.
+*/
+void UpdateOperation::ensureDecoded() const
+{
+    if (m_pendingBinary.isEmpty())
+        return;
+
+    UpdateOperation *const me = const_cast<UpdateOperation *>(this);
+    const QByteArray data = me->m_pendingBinary;
+    me->m_pendingBinary.clear();
+    if (!me->decodeBinary(data)) {
+        qCWarning(QInstaller::lcInstallerInstallLog) << "Cannot decode binary data of operation"
+            << name();
+    }
+}
+
+/*!
+    \internal
+*/
+bool UpdateOperation::decodeBinary(const QByteArray &data)
+{
+    quint8 version;
+    QStringList args;
+    QVariantMap values;
+
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream >> version >> args >> values;
+    if (stream.status() != QDataStream::Ok || version != scBinaryFormatVersion)
+        return false;
+
+    const QString target = relocationTarget();
+    const QLatin1String relocatable = QLatin1String(QInstaller::scRelocatable);
+
+    m_arguments = resolvedArguments(name(), args, target);
+    m_values.clear();
+    for (QVariantMap::const_iterator it = values.constBegin(); it != values.constEnd(); ++it)
+        m_values.insert(it.key(), replacePathInValue(it.value(), relocatable, target));
+    return true;
+}
+
 /*!
     Returns a numerical representation of how this operation compares to
     other operations in size, and in time it takes to perform the operation.
@@ -100,6 +100,9 @@ public:
     virtual bool fromXml(const QString &xml);
     virtual bool fromXml(const QDomDocument &doc);
 
+    virtual QByteArray toBinary() const;
+    virtual bool fromBinary(const QByteArray &data);
+
     virtual quint64 sizeHint();
 
 protected:
@@ -115,8 +118,12 @@ protected:
     QStringList parseUndoOperationArguments();
     void setRequiresUnreplacedVariables(bool isRequired);
     bool variableReplacement(QString *variableValue);
+    bool hasPendingBinary() const;
 
 private:
+    void ensureDecoded() const;
+    bool decodeBinary(const QByteArray &data);
+
     QString m_name;
     OperationGroup m_group;
     QStringList m_arguments;
@@ -126,6 +133,7 @@ private:
     QStringList m_delayedDeletionFiles;
     QInstaller::PackageManagerCore *m_core;
     bool m_requiresUnreplacedVariables;
+    QByteArray m_pendingBinary;
 };
 
 } // namespace KDUpdater
@@ -240,6 +240,24 @@ QDomDocument CopyOperation::toXml() const
     return xml;
 }
 
+/*!
+ \reimp
+ */
+QByteArray CopyOperation::toBinary() const
+{
+    // we don't want to save the backupOfExistingDestination
+    if (hasPendingBinary() || !hasValue(QLatin1String("backupOfExistingDestination")))
+        return UpdateOperation::toBinary();
+
+    CopyOperation *const me = const_cast<CopyOperation *>(this);
+
+    const QVariant v = value(QLatin1String("backupOfExistingDestination"));
+    me->clearValue(QLatin1String("backupOfExistingDestination"));
+    const QByteArray data = UpdateOperation::toBinary();
+    me->setValue(QLatin1String("backupOfExistingDestination"), v);
+    return data;
+}
+
 bool CopyOperation::testOperation()
 {
     // TODO
@@ -435,6 +453,24 @@ QDomDocument DeleteOperation::toXml() const
     return xml;
 }
 
+/*!
+ \reimp
+ */
+QByteArray DeleteOperation::toBinary() const
+{
+    // we don't want to save the backupOfExistingFile
+    if (hasPendingBinary() || !hasValue(QLatin1String("backupOfExistingFile")))
+        return UpdateOperation::toBinary();
+
+    DeleteOperation *const me = const_cast<DeleteOperation *>(this);
+
+    const QVariant v = value(QLatin1String("backupOfExistingFile"));
+    me->clearValue(QLatin1String("backupOfExistingFile"));
+    const QByteArray data = UpdateOperation::toBinary();
+    me->setValue(QLatin1String("backupOfExistingFile"), v);
+    return data;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // KDUpdater::MkdirOperation
 ////////////////////////////////////////////////////////////////////////////
@@ -47,6 +47,7 @@ public:
     bool testOperation() override;
 
     QDomDocument toXml() const override;
+    QByteArray toBinary() const override;
 private:
     QString sourcePath();
     QString destinationPath();
@@ -78,6 +79,7 @@ public:
     bool testOperation() override;
 
     QDomDocument toXml() const override;
+    QByteArray toBinary() const override;
 };
 
 class KDTOOLS_EXPORT MkdirOperation : public UpdateOperation
@@ -31,6 +31,9 @@
 
 #include "kdtoolsglobal.h"
 
+#include <QString>
+#include <QVector>
+
 namespace KDUpdater
 {
     enum Error
@@ -42,7 +45,35 @@ namespace KDUpdater
         ECannotStopTask,
         EUnknown
     };
+
+    class KDTOOLS_EXPORT VersionKey
+    {
+    public:
+        VersionKey() = default;
+        explicit VersionKey(const QString &version);
+
+        QString toString() const { return m_version; }
+        int componentCount() const { return m_components.count(); }
+
+        static int compare(const VersionKey &v1, const VersionKey &v2);
+
+    private:
+        struct Component
+        {
+            int position;
+            int length;
+            qlonglong number;
+            bool isNumber;
+        };
+        QStringView componentText(const Component &component) const;
+
+    private:
+        QString m_version;
+        QVector<Component> m_components;
+    };
+
     KDTOOLS_EXPORT int compareVersion(const QString &v1, const QString &v2);
+    KDTOOLS_EXPORT int compareVersion(const VersionKey &v1, const VersionKey &v2);
 }
 
 #endif // UPDATER_H
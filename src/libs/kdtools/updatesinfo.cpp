@@ -31,15 +31,52 @@
 #include "utils.h"
 #include "constants.h"
 
+#include <QDataStream>
+#include <QDateTime>
 #include <QFile>
+#include <QFileInfo>
 #include <QLocale>
 #include <QPair>
+#include <QSet>
 #include <QVector>
 #include <QUrl>
 #include <QXmlStreamReader>
 
+#include <algorithm>
+#include <limits>
+
 using namespace KDUpdater;
 
+static const quint32 scIndexMagic = 0x49465755; // "IFWU"
+static const quint32 scIndexFormatVersion = 2;
+static const QDataStream::Version scIndexStreamVersion = QDataStream::Qt_5_12;
+
+/*
+    Reads the header of an index and checks that it matches the current state of the
+    Updates.xml file it was created from. A file of different size or modification
+    time means the index is stale. The index stores the localized elements resolved
+    for the locale it was written with, so it is stale for any other locale as well.
+*/
+static bool readIndexHeader(QDataStream &stream, const QString &updateXmlFile)
+{
+    quint32 magic = 0;
+    quint32 formatVersion = 0;
+    qint64 size = -1;
+    qint64 lastModified = -1;
+    QString locale;
+    stream >> magic >> formatVersion;
+    if (stream.status() != QDataStream::Ok || magic != scIndexMagic || formatVersion != scIndexFormatVersion)
+        return false;
+
+    stream >> size >> lastModified >> locale;
+    if (stream.status() != QDataStream::Ok || locale != QLocale().name())
+        return false;
+
+    const QFileInfo fileInfo(updateXmlFile);
+    return fileInfo.exists() && fileInfo.size() == size
+        && fileInfo.lastModified().toMSecsSinceEpoch() == lastModified;
+}
+
 UpdatesInfoData::UpdatesInfoData()
      : error(UpdatesInfo::NotYetReadError)
 {
@@ -55,6 +92,29 @@ void UpdatesInfoData::setInvalidContentError(const QString &detail)
     errorMessage = tr("Updates.xml contains invalid content: %1").arg(detail);
 }
 
+/*
+    Reads the compact record of a PackageUpdate element, which holds only what is needed
+    for fetching the metadata of the package.
+*/
+static PackageRecord readPackageRecord(QXmlStreamReader &reader)
+{
+    PackageRecord package;
+    while (reader.readNextStartElement()) {
+        if (reader.name() == QInstaller::scName) {
+            package.name = reader.readElementText();
+        } else if (reader.name() == QInstaller::scVersion) {
+            package.version = reader.readElementText();
+        } else if (reader.name() == QInstaller::scSHA1) {
+            package.sha1 = reader.readElementText();
+        } else {
+            if (QInstaller::scMetaElements->contains(reader.name().toString()))
+                package.hasMetaElements = true;
+            reader.skipCurrentElement();
+        }
+    }
+    return package;
+}
+
 void UpdatesInfoData::parseFile(const QString &updateXmlFile)
 {
     QFile file(updateXmlFile);
@@ -63,8 +123,19 @@ void UpdatesInfoData::parseFile(const QString &updateXmlFile)
         errorMessage = tr("Cannot read \"%1\"").arg(updateXmlFile);
         return;
     }
+    parse(&file, nullptr);
+}
 
-    QXmlStreamReader reader(&file);
+/*
+    Parses the Updates.xml document from \a device. If \a records is set, the packages are
+    only stored as compact records to it, together with the checksum settings, the unified
+    metadata archive and the repository update actions. The full package information is
+    neither kept nor checked for required elements in that case.
+*/
+void UpdatesInfoData::parse(QIODevice *device, UpdatesRecord *records)
+{
+    QSet<QString> stringPool;
+    QXmlStreamReader reader(device);
     if (reader.readNextStartElement()) {
         if (reader.name() == QLatin1String("Updates")) {
             while (reader.readNextStartElement()) {
@@ -74,9 +145,27 @@ void UpdatesInfoData::parseFile(const QString &updateXmlFile)
                     applicationVersion = reader.readElementText();
                 } else if (reader.name() == QLatin1String("Checksum")) {
                     checkSha1CheckSum = (reader.readElementText());
+                    if (records)
+                        records->checksum = (checkSha1CheckSum.toLower() == QInstaller::scTrue);
                 } else if (reader.name() == QLatin1String("PackageUpdate")) {
-                    if (!parsePackageUpdateElement(reader, checkSha1CheckSum))
+                    if (records)
+                        records->packages.append(readPackageRecord(reader));
+                    else if (!parsePackageUpdateElement(reader, checkSha1CheckSum, &stringPool))
                         return; //error handled in subroutine
+                } else if (records && reader.name() == QInstaller::scSHA1) {
+                    records->sha1 = reader.readElementText();
+                } else if (records && reader.name() == QInstaller::scMetadataName) {
+                    records->metadataName = reader.readElementText();
+                } else if (records && reader.name() == QLatin1String("RepositoryUpdate")) {
+                    while (reader.readNextStartElement()) {
+                        if (reader.name() == QLatin1String("Repository")) {
+                            RepositoryAction action;
+                            action.attributes = reader.attributes();
+                            action.lineNumber = reader.lineNumber();
+                            records->repositoryActions.append(action);
+                        }
+                        reader.skipCurrentElement();
+                    }
                 } else {
                     reader.skipCurrentElement();
                 }
@@ -87,6 +176,19 @@ void UpdatesInfoData::parseFile(const QString &updateXmlFile)
         }
     }
 
+    if (reader.hasError()) {
+        error = UpdatesInfo::InvalidXmlError;
+        errorMessage = tr("Parse error in Updates.xml at line %1: %2").arg(reader.lineNumber())
+            .arg(reader.errorString());
+        return;
+    }
+
+    if (records) {
+        errorMessage.clear();
+        error = UpdatesInfo::NoError;
+        return;
+    }
+
     if (applicationName.isEmpty()) {
         setInvalidContentError(tr("ApplicationName element is missing."));
         return;
@@ -101,7 +203,126 @@ void UpdatesInfoData::parseFile(const QString &updateXmlFile)
     error = UpdatesInfo::NoError;
 }
 
-bool UpdatesInfoData::parsePackageUpdateElement(QXmlStreamReader &reader, const QString &checkSha1CheckSum)
+/*
+    Reads the package information from the binary index of \a updateXmlFile instead of
+    parsing the XML document. The index is memory mapped, so only the parts actually
+    deserialized are read from disk. Returns \c false if there is no usable index, in
+    which case the current data is left untouched.
+*/
+bool UpdatesInfoData::readIndex(const QString &updateXmlFile)
+{
+    QFile file(UpdatesInfo::indexFileName(updateXmlFile));
+    if (!file.open(QIODevice::ReadOnly) || file.size() > std::numeric_limits<int>::max())
+        return false;
+
+    const qint64 size = file.size();
+    const uchar *const mapped = file.map(0, size);
+    if (!mapped)
+        return false;
+
+    const QByteArray buffer = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), int(size));
+    QDataStream stream(buffer);
+    stream.setVersion(scIndexStreamVersion);
+    if (!readIndexHeader(stream, updateXmlFile))
+        return false;
+
+    QString name;
+    QString version;
+    QString checksum;
+    quint32 count = 0;
+    stream >> name >> version >> checksum >> count;
+
+    QSet<QString> stringPool;
+    QList<UpdateInfo> infos;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        UpdateInfo info;
+        quint32 entries = 0;
+        stream >> entries;
+        for (quint32 j = 0; j < entries && stream.status() == QDataStream::Ok; ++j) {
+            QString key;
+            stream >> key;
+            if (key == QLatin1String("TreeName")) {
+                QPair<QString, bool> treeNamePair;
+                stream >> treeNamePair.first >> treeNamePair.second;
+                info.data.insert(key, QVariant::fromValue(treeNamePair));
+            } else if (key == QLatin1String("Operations")) {
+                QList<QPair<QString, QVariant>> operationsList;
+                quint32 operations = 0;
+                stream >> operations;
+                for (quint32 k = 0; k < operations && stream.status() == QDataStream::Ok; ++k) {
+                    QPair<QString, QVariant> pair;
+                    stream >> pair.first >> pair.second;
+                    operationsList.append(pair);
+                }
+                info.data.insert(key, QVariant::fromValue(operationsList));
+            } else {
+                QVariant value;
+                stream >> value;
+                info.data.insert(key, value);
+            }
+        }
+        info.data.shareStrings(&stringPool);
+        info.data.squeeze();
+        infos.append(info);
+    }
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    applicationName = name;
+    applicationVersion = version;
+    checkSha1CheckSum = checksum;
+    updateInfoList = infos;
+    errorMessage.clear();
+    error = UpdatesInfo::NoError;
+    return true;
+}
+
+/*
+    Writes the current package information to the binary index of \a updateXmlFile.
+*/
+bool UpdatesInfoData::writeIndex(const QString &updateXmlFile) const
+{
+    const QFileInfo fileInfo(updateXmlFile);
+    QFile file(UpdatesInfo::indexFileName(updateXmlFile));
+    if (!fileInfo.exists() || !file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(scIndexStreamVersion);
+    stream << scIndexMagic << scIndexFormatVersion << qint64(fileInfo.size())
+        << qint64(fileInfo.lastModified().toMSecsSinceEpoch()) << QLocale().name();
+    stream << applicationName << applicationVersion << checkSha1CheckSum
+        << quint32(updateInfoList.count());
+
+    for (const UpdateInfo &info : updateInfoList) {
+        const QStringList keys = info.data.keys();
+        stream << quint32(keys.count());
+        for (const QString &key : keys) {
+            stream << key;
+            if (key == QLatin1String("TreeName")) {
+                const QPair<QString, bool> treeNamePair = info.data.value(key).value<QPair<QString, bool>>();
+                stream << treeNamePair.first << treeNamePair.second;
+            } else if (key == QLatin1String("Operations")) {
+                const QList<QPair<QString, QVariant>> operationsList
+                    = info.data.value(key).value<QList<QPair<QString, QVariant>>>();
+                stream << quint32(operationsList.count());
+                for (const auto &pair : operationsList)
+                    stream << pair.first << pair.second;
+            } else {
+                stream << info.data.value(key);
+            }
+        }
+    }
+
+    if (stream.status() != QDataStream::Ok || !file.flush()) {
+        file.remove();
+        return false;
+    }
+    return true;
+}
+
+bool UpdatesInfoData::parsePackageUpdateElement(QXmlStreamReader &reader, const QString &checkSha1CheckSum,
+    QSet<QString> *stringPool)
 {
     UpdateInfo info;
     QHash<QString, QVariant> scriptHash;
@@ -124,13 +345,13 @@ bool UpdatesInfoData::parsePackageUpdateElement(QXmlStreamReader &reader, const
             const QXmlStreamAttributes attr = reader.attributes();
             info.data.insert(QLatin1String("inheritVersionFrom"),
                 attr.value(QLatin1String("inheritVersionFrom")).toString());
-            info.data[elementName] = reader.readElementText();
+            info.data.insert(elementName, reader.readElementText());
         } else if (elementName == QLatin1String("DisplayName")
                     || elementName == QLatin1String("Description")) {
             processLocalizedTag(reader, info.data);
         } else if (elementName == QLatin1String("UpdateFile")) {
-            info.data[QLatin1String("CompressedSize")] = reader.attributes().value(QLatin1String("CompressedSize")).toString();
-            info.data[QLatin1String("UncompressedSize")] = reader.attributes().value(QLatin1String("UncompressedSize")).toString();
+            info.data.insert(QLatin1String("CompressedSize"), reader.attributes().value(QLatin1String("CompressedSize")).toString());
+            info.data.insert(QLatin1String("UncompressedSize"), reader.attributes().value(QLatin1String("UncompressedSize")).toString());
         } else if (elementName == QLatin1String("Operations")) {
             parseOperations(reader, info.data);
         } else if (elementName == QLatin1String("Script")) {
@@ -141,7 +362,7 @@ bool UpdatesInfoData::parsePackageUpdateElement(QXmlStreamReader &reader, const
             else
                 scriptHash.insert(QLatin1String("installScript"), reader.readElementText());
         } else {
-            info.data[elementName] = reader.readElementText();
+            info.data.insert(elementName, reader.readElementText());
         }
     }
     if (!scriptHash.isEmpty())
@@ -159,26 +380,28 @@ bool UpdatesInfoData::parsePackageUpdateElement(QXmlStreamReader &reader, const
         setInvalidContentError(tr("PackageUpdate element without ReleaseDate"));
         return false;
     }
-    info.data[QLatin1String("CheckSha1CheckSum")] = checkSha1CheckSum;
+    info.data.insert(QLatin1String("CheckSha1CheckSum"), checkSha1CheckSum);
+    info.data.shareStrings(stringPool);
+    info.data.squeeze();
     updateInfoList.append(info);
     return true;
 }
 
-void UpdatesInfoData::processLocalizedTag(QXmlStreamReader &reader, QHash<QString, QVariant> &info) const
+void UpdatesInfoData::processLocalizedTag(QXmlStreamReader &reader, UpdateRecord &info) const
 {
     const QString languageAttribute =  reader.attributes().value(QLatin1String("xml:lang")).toString().toLower();
     const QString elementName = reader.name().toString();
     if (!info.contains(elementName) && (languageAttribute.isEmpty()))
-        info[elementName] = reader.readElementText();
+        info.insert(elementName, reader.readElementText());
 
     if (languageAttribute.isEmpty())
         return;
     // overwrite default if we have a language specific description
     if (QLocale().name().startsWith(languageAttribute, Qt::CaseInsensitive))
-        info[elementName] = reader.readElementText();
+        info.insert(elementName, reader.readElementText());
 }
 
-void UpdatesInfoData::parseOperations(QXmlStreamReader &reader, QHash<QString, QVariant> &info) const
+void UpdatesInfoData::parseOperations(QXmlStreamReader &reader, UpdateRecord &info) const
 {
     QList<QPair<QString, QVariant>> operationsList;
     while (reader.readNext()) {
@@ -211,7 +434,7 @@ void UpdatesInfoData::parseOperations(QXmlStreamReader &reader, QHash<QString, Q
     info.insert(QLatin1String("Operations"), QVariant::fromValue(operationsList));
 }
 
-void UpdatesInfoData::parseLicenses(QXmlStreamReader &reader, QHash<QString, QVariant> &info) const
+void UpdatesInfoData::parseLicenses(QXmlStreamReader &reader, UpdateRecord &info) const
 {
     QHash<QString, QVariant> licenseHash;
     while (reader.readNext()) {
@@ -235,6 +458,153 @@ void UpdatesInfoData::parseLicenses(QXmlStreamReader &reader, QHash<QString, QVa
     if (!licenseHash.isEmpty())
         info.insert(QLatin1String("Licenses"), licenseHash);
 }
+//
+// UpdateRecord
+//
+static const char *const scFieldNames[UpdateRecord::FieldCount] = {
+    "Name", "Version", "inheritVersionFrom", "DisplayName", "Description", "ReleaseDate", "Default",
+    "Virtual", "Dependencies", "AutoDependOn", "Replaces", "DownloadableArchives", "SortingPriority",
+    "Checkable", "Essential", "ForcedInstallation", "ForcedUpdate", "ExpandedByDefault",
+    "RequiresAdminRights", "CompressedSize", "UncompressedSize", "SHA1", "ContentSha1",
+    "CheckSha1CheckSum", "UpdateText", "UserInterfaces", "Translations"
+};
+
+static int fieldForKey(const QString &key)
+{
+    static const QHash<QString, int> fields = [] {
+        QHash<QString, int> hash;
+        for (int i = 0; i < UpdateRecord::FieldCount; ++i)
+            hash.insert(QLatin1String(scFieldNames[i]), i);
+        return hash;
+    }();
+    return fields.value(key, -1);
+}
+
+// Values of most fields repeat across the packages of a repository, for example versions,
+// release dates, dependencies and boolean flags. These are shared through the string pool
+// of the parse instead of being allocated for every package. Free text and checksums are
+// not pooled.
+static bool isPooledField(UpdateRecord::Field field)
+{
+    switch (field) {
+    case UpdateRecord::DisplayName:
+    case UpdateRecord::Description:
+    case UpdateRecord::UpdateText:
+    case UpdateRecord::SHA1:
+    case UpdateRecord::ContentSha1:
+        return false;
+    default:
+        return true;
+    }
+}
+
+QString UpdateRecord::value(Field field) const
+{
+    const QString *const entry = find(field);
+    return entry ? *entry : QString();
+}
+
+QVariant UpdateRecord::value(const QString &key, const QVariant &defaultValue) const
+{
+    const int field = fieldForKey(key);
+    if (field >= 0) {
+        if (const QString *const entry = find(Field(field)))
+            return *entry;
+    }
+    return m_overflow.value(key, defaultValue);
+}
+
+void UpdateRecord::insert(const QString &key, const QVariant &value)
+{
+    const int field = fieldForKey(key);
+    if (field >= 0 && value.userType() == QMetaType::QString) {
+        m_overflow.remove(key);
+        insert(Field(field), value.toString());
+    } else {
+        if (field >= 0)
+            remove(Field(field));
+        m_overflow.insert(key, value);
+    }
+}
+
+bool UpdateRecord::contains(const QString &key) const
+{
+    const int field = fieldForKey(key);
+    if (field >= 0 && find(Field(field)))
+        return true;
+    return m_overflow.contains(key);
+}
+
+int UpdateRecord::count() const
+{
+    return m_fields.count() + m_overflow.count();
+}
+
+QStringList UpdateRecord::keys() const
+{
+    QStringList keys;
+    keys.reserve(count());
+    for (const Entry &entry : m_fields)
+        keys.append(QLatin1String(scFieldNames[entry.field]));
+    keys.append(m_overflow.keys());
+    return keys;
+}
+
+void UpdateRecord::squeeze()
+{
+    m_fields.squeeze();
+    m_overflow.squeeze();
+}
+
+const QString *UpdateRecord::find(Field field) const
+{
+    for (const Entry &entry : m_fields) {
+        if (entry.field == field)
+            return &entry.value;
+        if (entry.field > field)
+            break;
+    }
+    return nullptr;
+}
+
+void UpdateRecord::insert(Field field, const QString &value)
+{
+    const auto it = std::lower_bound(m_fields.begin(), m_fields.end(), field,
+        [](const Entry &entry, Field key) { return entry.field < key; });
+    if (it != m_fields.end() && it->field == field)
+        it->value = value;
+    else
+        m_fields.insert(it, Entry { field, value });
+}
+
+/*
+    Replaces the values of fields that usually repeat across packages by an equal string
+    from \a stringPool, so that all records using the pool share a single copy of each
+    value. Values not yet in \a stringPool are added to it.
+*/
+void UpdateRecord::shareStrings(QSet<QString> *stringPool)
+{
+    for (Entry &entry : m_fields) {
+        if (entry.value.isEmpty() || !isPooledField(entry.field))
+            continue;
+        const QSet<QString>::const_iterator it = stringPool->constFind(entry.value);
+        if (it != stringPool->constEnd())
+            entry.value = *it;
+        else
+            stringPool->insert(entry.value);
+    }
+}
+
+void UpdateRecord::remove(Field field)
+{
+    for (int i = 0; i < m_fields.count(); ++i) {
+        if (m_fields.at(i).field == field) {
+            m_fields.remove(i);
+            return;
+        }
+    }
+}
+
 //
 // UpdatesInfo
 //
@@ -269,9 +639,60 @@ void UpdatesInfo::setFileName(const QString &updateXmlFile)
     d->updateXmlFile = updateXmlFile;
 }
 
+/*
+    Reads the package information from the binary index next to the Updates.xml
+    file if there is an up to date one, and parses the XML document otherwise.
+*/
 void UpdatesInfo::parseFile()
 {
-    d->parseFile(d->updateXmlFile);
+    if (!d->readIndex(d->updateXmlFile))
+        d->parseFile(d->updateXmlFile);
+}
+
+/*
+    Parses the Updates.xml document from \a device into the compact \a records needed
+    for fetching the metadata of a repository, instead of the full package information.
+    Use isValid() and errorString() to check the result.
+*/
+void UpdatesInfo::parseRecords(QIODevice *device, UpdatesRecord *records)
+{
+    Q_ASSERT(records);
+    d->parse(device, records);
+}
+
+/*
+    Writes a binary index of the parsed package information next to the Updates.xml
+    file, which makes later calls to parseFile() skip the XML parsing. Returns \c true
+    on success, \c false otherwise.
+*/
+bool UpdatesInfo::writeIndex() const
+{
+    if (!isValid())
+        return false;
+    return d->writeIndex(d->updateXmlFile);
+}
+
+/*
+    Returns the name of the binary index file for \a updateXmlFile.
+*/
+QString UpdatesInfo::indexFileName(const QString &updateXmlFile)
+{
+    return updateXmlFile + QLatin1String(".idx");
+}
+
+/*
+    Returns \c true if there is a binary index for \a updateXmlFile that was created
+    from its current contents, \c false otherwise.
+*/
+bool UpdatesInfo::hasValidIndex(const QString &updateXmlFile)
+{
+    QFile file(indexFileName(updateXmlFile));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(scIndexStreamVersion);
+    return readIndexHeader(stream, updateXmlFile);
 }
 
 QString UpdatesInfo::fileName() const
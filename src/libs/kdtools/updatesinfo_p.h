@@ -34,17 +34,106 @@
 #include "updatesinfodata_p.h"
 
 #include <QHash>
+#include <QSet>
 #include <QSharedData>
 #include <QVariant>
+#include <QVector>
+#include <QXmlStreamAttributes>
 
 // They are not a part of the public API
 // Classes and structures in this header file are for internal use only but still exported for auto tests.
 
 namespace KDUpdater {
 
+class KDTOOLS_EXPORT UpdateRecord
+{
+public:
+    enum Field : quint8
+    {
+        Name,
+        Version,
+        InheritVersionFrom,
+        DisplayName,
+        Description,
+        ReleaseDate,
+        Default,
+        Virtual,
+        Dependencies,
+        AutoDependOn,
+        Replaces,
+        DownloadableArchives,
+        SortingPriority,
+        Checkable,
+        Essential,
+        ForcedInstallation,
+        ForcedUpdate,
+        ExpandedByDefault,
+        RequiresAdminRights,
+        CompressedSize,
+        UncompressedSize,
+        SHA1,
+        ContentSha1,
+        CheckSha1CheckSum,
+        UpdateText,
+        UserInterfaces,
+        Translations,
+        FieldCount
+    };
+
+    QString value(Field field) const;
+    QVariant value(const QString &key, const QVariant &defaultValue = QVariant()) const;
+    void insert(const QString &key, const QVariant &value);
+    bool contains(const QString &key) const;
+
+    int count() const;
+    QStringList keys() const;
+    void squeeze();
+    void shareStrings(QSet<QString> *stringPool);
+
+    QString name() const { return value(Name); }
+    QString version() const { return value(Version); }
+
+private:
+    const QString *find(Field field) const;
+    void insert(Field field, const QString &value);
+    void remove(Field field);
+
+private:
+    struct Entry
+    {
+        Field field;
+        QString value;
+    };
+    QVector<Entry> m_fields;
+    QHash<QString, QVariant> m_overflow;
+};
+
 struct KDTOOLS_EXPORT UpdateInfo
 {
-    QHash<QString, QVariant> data;
+    UpdateRecord data;
+};
+
+struct KDTOOLS_EXPORT PackageRecord
+{
+    QString name;
+    QString version;
+    QString sha1;
+    bool hasMetaElements = false;
+};
+
+struct KDTOOLS_EXPORT RepositoryAction
+{
+    QXmlStreamAttributes attributes;
+    qint64 lineNumber = 0;
+};
+
+struct KDTOOLS_EXPORT UpdatesRecord
+{
+    bool checksum = true;
+    QString sha1;
+    QString metadataName;
+    QVector<PackageRecord> packages;
+    QVector<RepositoryAction> repositoryActions;
 };
 
 class KDTOOLS_EXPORT UpdatesInfo
@@ -70,6 +159,11 @@ public:
     QString fileName() const;
     void setFileName(const QString &updateXmlFile);
     void parseFile();
+    void parseRecords(QIODevice *device, UpdatesRecord *records);
+    bool writeIndex() const;
+
+    static QString indexFileName(const QString &updateXmlFile);
+    static bool hasValidIndex(const QString &updateXmlFile);
 
     QString applicationName() const;
     QString applicationVersion() const;
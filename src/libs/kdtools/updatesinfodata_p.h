@@ -30,13 +30,17 @@
 #define UPDATESINFODATA_P_H
 
 #include <QCoreApplication>
+#include <QSet>
 #include <QSharedData>
 
+QT_FORWARD_DECLARE_CLASS(QIODevice)
 QT_FORWARD_DECLARE_CLASS(QXmlStreamReader)
 
 namespace KDUpdater {
 
 struct UpdateInfo;
+struct UpdatesRecord;
+class UpdateRecord;
 
 struct UpdatesInfoData : public QSharedData
 {
@@ -55,14 +59,18 @@ public:
     QList<UpdateInfo> updateInfoList;
 
     void parseFile(const QString &updateXmlFile);
-    bool parsePackageUpdateElement(QXmlStreamReader &reader, const QString &checkSha1CheckSum);
+    void parse(QIODevice *device, UpdatesRecord *records);
+    bool readIndex(const QString &updateXmlFile);
+    bool writeIndex(const QString &updateXmlFile) const;
+    bool parsePackageUpdateElement(QXmlStreamReader &reader, const QString &checkSha1CheckSum,
+        QSet<QString> *stringPool);
 
     void setInvalidContentError(const QString &detail);
 
 private:
-    void processLocalizedTag(QXmlStreamReader &reader, QHash<QString, QVariant> &info) const;
-    void parseOperations(QXmlStreamReader &reader, QHash<QString, QVariant> &info) const;
-    void parseLicenses(QXmlStreamReader &reader, QHash<QString, QVariant> &info) const;
+    void processLocalizedTag(QXmlStreamReader &reader, UpdateRecord &info) const;
+    void parseOperations(QXmlStreamReader &reader, UpdateRecord &info) const;
+    void parseLicenses(QXmlStreamReader &reader, UpdateRecord &info) const;
 };
 
 } // namespace KDUpdater
@@ -355,6 +355,8 @@ public:
             .isSet(CommandLineOptions::scNoForceInstallationLong));
         QInstaller::PackageManagerCore::setNoDefaultInstallation(m_parser
             .isSet(CommandLineOptions::scNoDefaultInstallationLong));
+        QInstaller::PackageManagerCore::setPipelinedInstallation(m_parser
+            .isSet(CommandLineOptions::scPipelinedInstallationLong));
         QInstaller::PackageManagerCore::setCreateLocalRepositoryFromBinary(m_parser
             .isSet(CommandLineOptions::scCreateLocalRepositoryLong)
             || m_core->settings().createLocalRepository());
@@ -369,6 +371,27 @@ public:
             QInstaller::PackageManagerCore::setMaxConcurrentOperations(count);
         }
 
+        if (m_parser.isSet(CommandLineOptions::scMaxConcurrentDownloadsLong)) {
+            bool isValid;
+            const int count = m_parser.value(CommandLineOptions::scMaxConcurrentDownloadsLong).toInt(&isValid);
+            if (!isValid || count < 0) {
+                errorMessage = QObject::tr("Invalid value for 'max-concurrent-downloads'.");
+                return false;
+            }
+            QInstaller::PackageManagerCore::setMaxConcurrentDownloads(count);
+        }
+
+        if (m_parser.isSet(CommandLineOptions::scMaxConcurrentDownloadsPerHostLong)) {
+            bool isValid;
+            const int count = m_parser.value(CommandLineOptions::scMaxConcurrentDownloadsPerHostLong)
+                .toInt(&isValid);
+            if (!isValid || count < 0) {
+                errorMessage = QObject::tr("Invalid value for 'max-concurrent-downloads-per-host'.");
+                return false;
+            }
+            QInstaller::PackageManagerCore::setMaxConcurrentDownloadsPerHost(count);
+        }
+
         if (m_parser.isSet(CommandLineOptions::scAcceptLicensesLong))
             m_core->setAutoAcceptLicenses();
 
@@ -392,6 +392,162 @@ private slots:
         resource->close();
     }
 
+    void testOperationBinaryRoundTrip()
+    {
+        const QString relocatable = QLatin1String("@RELOCATABLE_PATH@");
+        TestOperation op(QLatin1String("Operation 3"));
+        op.setArguments(QStringList() << QLatin1String("arg1") << relocatable
+            + QLatin1String("/bin"));
+        op.setValue(QLatin1String("string"), QLatin1String("Operation 3 value."));
+        op.setValue(QLatin1String("list"), QStringList() << QLatin1String("a")
+            << relocatable + QLatin1String("/lib"));
+        op.setValue(QLatin1String("number"), 42);
+        const QByteArray data = op.toBinary();
+        QVERIFY(!data.isEmpty());
+
+        TestOperation restored(QLatin1String("Operation 3"));
+        QVERIFY(restored.fromBinary(data));
+        // not decoded yet, must be written back unchanged
+        QCOMPARE(restored.toBinary(), data);
+
+        const QString target = QCoreApplication::applicationDirPath();
+        QCOMPARE(restored.arguments(), QStringList() << QLatin1String("arg1")
+            << target + QLatin1String("/bin"));
+        QCOMPARE(restored.value(QLatin1String("string")).toString(),
+            QLatin1String("Operation 3 value."));
+        QCOMPARE(restored.value(QLatin1String("list")).toStringList(), QStringList()
+            << QLatin1String("a") << target + QLatin1String("/lib"));
+        QCOMPARE(restored.value(QLatin1String("number")).toInt(), 42);
+        QCOMPARE(restored.hasValue(QLatin1String("installer")), false);
+
+        QTest::ignoreMessage(QtWarningMsg, "Unknown binary format of operation \"Operation 3\"");
+        QCOMPARE(restored.fromBinary(QByteArray(1, char(0x7f))), false);
+    }
+
+    void testBinaryOperationsFunction()
+    {
+        QList<OperationBlob> operations;
+        for (int i = 0; i < 2; ++i) {
+            TestOperation op(QString::fromLatin1("Operation %1").arg(i + 1));
+            op.setValue(QLatin1String("key"), op.name() + QLatin1String(" value."));
+            op.setArguments(QStringList() << QLatin1String("arg1") << QLatin1String("arg2"));
+            operations.append(OperationBlob(op.name(), op.toBinary()));
+        }
+
+        QTemporaryFile file;
+        QInstaller::openForWrite(&file);
+        QInstaller::blockingWrite(&file, QByteArray(scTinySize, '1'));
+        BinaryContent::writeBinaryContent(&file, operations, m_manager, m_layout.magicMarker,
+            m_layout.magicCookie);
+        file.close();
+
+        QInstaller::openForRead(&file);
+        const BinaryLayout layout = BinaryContent::binaryLayout(&file, m_layout.magicCookie);
+        file.seek(layout.operationsSegment.start());
+        QCOMPARE(QInstaller::retrieveInt64(&file), qint64(BinaryContent::BinaryOperationsMarker));
+        QCOMPARE(QInstaller::retrieveInt64(&file), qint64(BinaryContent::BinaryOperationsVersion));
+
+        QList<OperationBlob> readOperations;
+        BinaryContent::readBinaryContent(&file, &readOperations, nullptr, nullptr,
+            m_layout.magicCookie);
+        file.close();
+
+        QCOMPARE(readOperations.count(), operations.count());
+        for (int i = 0; i < readOperations.count(); ++i) {
+            QCOMPARE(readOperations.at(i).name, operations.at(i).name);
+            QCOMPARE(readOperations.at(i).data, operations.at(i).data);
+            QVERIFY(readOperations.at(i).xml.isEmpty());
+
+            TestOperation op(readOperations.at(i).name);
+            QVERIFY(op.fromBinary(readOperations.at(i).data));
+            QCOMPARE(op.value(QLatin1String("key")).toString(), op.name()
+                + QLatin1String(" value."));
+        }
+    }
+
+    void testCopyData()
+    {
+        QByteArray data;
+        for (int i = 0; i < 3 * 1024 * 1024 / 16; ++i)
+            data += QByteArray::number(i).rightJustified(16, '.');
+
+        QTemporaryFile in;
+        QVERIFY(in.open());
+
+        try {
+            QInstaller::blockingWrite(&in, data);
+            QVERIFY(in.flush());
+
+            // Copy from the middle of the input after data buffered in the output
+            QTemporaryFile out;
+            QVERIFY(out.open());
+            QInstaller::blockingWrite(&out, QByteArray("head"));
+            QVERIFY(in.seek(1000));
+            QInstaller::blockingCopy(&in, &out, data.size() - 2000);
+            QCOMPARE(in.pos(), qint64(data.size() - 1000));
+            QInstaller::blockingWrite(&out, QByteArray("tail"));
+
+            QVERIFY(out.seek(0));
+            QCOMPARE(out.readAll(), "head" + data.mid(1000, data.size() - 2000) + "tail");
+
+            // Copy a resource limited to a segment of the input
+            Resource resource(in.fileName(), Range<qint64>::fromStartAndLength(16, data.size() - 32));
+            QVERIFY(resource.open());
+            QTemporaryFile resourceOut;
+            QVERIFY(resourceOut.open());
+            resource.copyData(&resourceOut);
+            QVERIFY(resourceOut.seek(0));
+            QCOMPARE(resourceOut.readAll(), data.mid(16, data.size() - 32));
+
+            // Sequential reads only see the segment
+            QVERIFY(resource.seek(0));
+            QCOMPARE(resource.read(32), data.mid(16, 32));
+            QCOMPARE(resource.read(16), data.mid(48, 16));
+            QVERIFY(resource.seek(data.size() - 48));
+            QCOMPARE(resource.readAll(), data.mid(data.size() - 32, 16));
+        } catch (const QInstaller::Error &error) {
+            QFAIL(qPrintable(error.message()));
+        }
+    }
+
+    void benchmarkCopyData_data()
+    {
+        QTest::addColumn<bool>("blockingCopy");
+        QTest::newRow("4 KiB blocks") << false;
+        QTest::newRow("blockingCopy") << true;
+    }
+
+    void benchmarkCopyData()
+    {
+        QFETCH(bool, blockingCopy);
+
+        // Kept small so the auto test stays cheap, the difference grows with the size
+        const qint64 size = 16 * 1024 * 1024;
+        QTemporaryFile in;
+        QVERIFY(in.open());
+        const QByteArray block(1024 * 1024, 'x');
+        for (qint64 written = 0; written < size; written += block.size())
+            QVERIFY(in.write(block) == block.size());
+        QVERIFY(in.flush());
+
+        QBENCHMARK {
+            QTemporaryFile out;
+            QVERIFY(out.open());
+            QVERIFY(in.seek(0));
+            if (blockingCopy) {
+                QInstaller::blockingCopy(&in, &out, size);
+            } else {
+                char data[4096];
+                for (qint64 left = size; left > 0; left -= sizeof(data)) {
+                    QVERIFY(in.read(data, sizeof(data)) == sizeof(data));
+                    QVERIFY(out.write(data, sizeof(data)) == sizeof(data));
+                }
+            }
+            QVERIFY(out.flush());
+            QCOMPARE(out.size(), size);
+        }
+    }
+
     void cleanupTestCase()
     {
         m_manager.clear();
@@ -29,6 +29,8 @@
 #include "../shared/verifyinstaller.h"
 #include "../shared/packagemanager.h"
 
+#include <binaryformat.h>
+#include <fileio.h>
 #include <protocol.h>
 #include <qprocesswrapper.h>
 #include <qsettingswrapper.h>
@@ -466,6 +468,146 @@ private slots:
         wrapper.endGroup();
     }
 
+    void testCommandEncoding()
+    {
+        QVERIFY(decodeCommand("NoSuchCommand") == Protocol::Command::Invalid);
+        QVERIFY(decodeCommand(QByteArray()) == Protocol::Command::Invalid);
+
+        int count = 0;
+        for (int id = static_cast<int>(Protocol::Command::Create); id < (1 << 14); ++id) {
+            const Protocol::Command command = static_cast<Protocol::Command>(id);
+            if (qstrlen(commandName(command)) == 0)
+                continue;
+            const QByteArray encoded = encodeCommand(command);
+            QCOMPARE(encoded.size(), 2);
+            QVERIFY(!encoded.contains('\0'));
+            QVERIFY(decodeCommand(encoded) == command);
+            QVERIFY(decodeCommand(commandName(command)) == command);
+            QVERIFY(commandFromName(commandName(command)) == command);
+            ++count;
+        }
+        QCOMPARE(count, 105);
+        QVERIFY(commandFromName(Protocol::QSettingsValue) == Protocol::Command::QSettingsValue);
+    }
+
+    void testProtocolVersion()
+    {
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        QLocalSocket socket;
+        socket.connectToServer(socketName);
+        QVERIFY2(socket.waitForConnected(), "Cannot connect to server.");
+
+        // a client with another version has other command identifiers and keeps using names
+        QLocalSocket otherSocket;
+        otherSocket.connectToServer(socketName);
+        QVERIFY2(otherSocket.waitForConnected(), "Cannot connect to server.");
+
+        QByteArray data;
+        QDataStream otherStream(&data, QIODevice::WriteOnly);
+        otherStream << QString::fromLatin1("SomeKey") << quint32(Protocol::Version + 1);
+        sendPacket(&otherSocket, Protocol::Authorize, data);
+
+        QByteArray command;
+        quint32 version = 0;
+        receiveCommand(&otherSocket, &command, &version);
+        QCOMPARE(command, QByteArray(Protocol::Reply));
+        QCOMPARE(version, quint32(1));
+
+        // a client with the same version gets the identifiers
+        data.clear();
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream << QString::fromLatin1("SomeKey") << Protocol::Version;
+        sendPacket(&socket, Protocol::Authorize, data);
+
+        receiveCommand(&socket, &command, &version);
+        QCOMPARE(command, QByteArray(Protocol::Reply));
+        QCOMPARE(version, Protocol::Version);
+
+        // from now on replies carry the command identifier instead of the name
+        sendCommand(&socket, encodeCommand(Protocol::Command::Create),
+            QString::fromLatin1(Protocol::QAbstractFileEngine));
+        QString reply;
+        receiveCommand(&socket, &command, &reply);
+        QVERIFY(decodeCommand(command) == Protocol::Command::Reply);
+        QCOMPARE(command, encodeCommand(Protocol::Command::Reply));
+        QCOMPARE(reply, QString::fromLatin1(Protocol::DefaultReply));
+
+        sendCommand(&socket, encodeCommand(Protocol::Command::QAbstractFileEngineSetFileName),
+            QCoreApplication::applicationFilePath());
+        receiveCommand(&socket, &command, &reply);
+
+        // command names are still understood
+        sendPacket(&socket, Protocol::QAbstractFileEngineSize, QByteArray());
+        qint64 size = -1;
+        receiveCommand(&socket, &command, &size);
+        QCOMPARE(size, QFileInfo(QCoreApplication::applicationFilePath()).size());
+    }
+
+    void benchmarkDecodeCommand_data()
+    {
+        QTest::addColumn<QByteArray>("command");
+        QTest::newRow("name") << QByteArray(Protocol::QAbstractFileEngineFileTime);
+        QTest::newRow("identifier") << encodeCommand(Protocol::Command::QAbstractFileEngineFileTime);
+    }
+
+    void benchmarkDecodeCommand()
+    {
+        QFETCH(QByteArray, command);
+
+        Protocol::Command result = Protocol::Command::Invalid;
+        QBENCHMARK {
+            result = decodeCommand(command);
+        }
+        QVERIFY(result == Protocol::Command::QAbstractFileEngineFileTime);
+    }
+
+    void benchmarkQSettingsWrapperValue()
+    {
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        RemoteClient::instance().init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Debug,
+                                      Protocol::StartAs::User);
+
+        QSettingsWrapper wrapper(QSettings::IniFormat, QSettingsWrapper::UserScope, "digia",
+            "clientserver");
+        wrapper.setValue("benchmark", 42);
+
+        QVariant value;
+        QBENCHMARK {
+            value = wrapper.value("benchmark");
+        }
+        QCOMPARE(value.toInt(), 42);
+        wrapper.remove("benchmark");
+    }
+
+    void benchmarkRemoteFileEngineStat()
+    {
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        RemoteClient::instance().init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Debug,
+                                      Protocol::StartAs::User);
+
+        RemoteFileEngineHandler handler;
+        QFileInfo info(QCoreApplication::applicationFilePath());
+
+        bool exists = false;
+        QBENCHMARK {
+            info.refresh();
+            exists = info.exists();
+        }
+        QVERIFY(exists);
+    }
+
     void testQProcessWrapper()
     {
         RemoteServer server;
@@ -597,6 +739,150 @@ private slots:
         QCOMPARE(file.atEnd(), true);
     }
 
+    void testRemoteFileEngineBuffered()
+    {
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        RemoteClient::instance().init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Debug,
+                                      Protocol::StartAs::User);
+
+        // larger than the read-ahead and write-behind windows, and not a multiple of them
+        QByteArray content;
+        for (int i = 0; content.size() < 3 * 1024 * 1024 + 123; ++i)
+            content.append(QByteArray::number(i)).append('\n');
+
+        QString filename;
+        {
+            QTemporaryFile file;
+            file.setAutoRemove(false);
+            QVERIFY(file.open());
+            filename = file.fileName();
+        }
+
+        RemoteFileEngineHandler handler;
+
+        QFile file(filename);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Unbuffered));
+        for (int i = 0; i < content.size(); i += 4000)
+            QCOMPARE(file.write(content.mid(i, 4000)), qint64(qMin(4000, content.size() - i)));
+        QCOMPARE(file.pos(), qint64(content.size()));
+        QCOMPARE(file.size(), qint64(content.size()));
+        file.close();
+        QCOMPARE(QFileInfo(filename).size(), qint64(content.size()));
+
+        QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Unbuffered));
+        QCOMPARE(file.size(), qint64(content.size()));
+        QByteArray readBack;
+        char chunk[16 * 1024];
+        qint64 bytesRead = 0;
+        while ((bytesRead = file.read(chunk, sizeof(chunk))) > 0)
+            readBack.append(chunk, bytesRead);
+        QCOMPARE(bytesRead, qint64(0));
+        QVERIFY(readBack == content);
+        QVERIFY(file.atEnd());
+
+        // inside and outside of the current read-ahead window
+        QVERIFY(file.seek(content.size() - 10));
+        QCOMPARE(file.read(10), content.right(10));
+        QVERIFY(file.seek(100));
+        QCOMPARE(file.pos(), qint64(100));
+        QCOMPARE(file.read(100), content.mid(100, 100));
+        QCOMPARE(file.read(2 * 1024 * 1024), content.mid(200, 2 * 1024 * 1024));
+        file.close();
+
+        // writing in the middle of a read-ahead window
+        QVERIFY(file.open(QIODevice::ReadWrite | QIODevice::Unbuffered));
+        QCOMPARE(file.read(10), content.left(10));
+        QCOMPARE(file.write("xyz"), qint64(3));
+        QCOMPARE(file.pos(), qint64(13));
+        QCOMPARE(file.read(10), content.mid(13, 10));
+        file.close();
+
+        content.replace(10, 3, "xyz");
+        QFile result(filename);
+        QVERIFY(result.open(QIODevice::ReadOnly));
+        QVERIFY(result.readAll() == content);
+        result.close();
+
+        QVERIFY(QFile::remove(filename));
+    }
+
+    void testRemoteFileEngineCopy()
+    {
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        RemoteClient::instance().init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Debug,
+                                      Protocol::StartAs::User);
+
+        QByteArray content;
+        for (int i = 0; content.size() < 2 * 1024 * 1024 + 123; ++i)
+            content.append(QByteArray::number(i)).append('\n');
+
+        QString source;
+        QString target;
+        QString resourceTarget;
+        QString decoy;
+        {
+            QTemporaryFile file;
+            file.setAutoRemove(false);
+            QVERIFY(file.open());
+            QCOMPARE(file.write(content), qint64(content.size()));
+            source = file.fileName();
+        }
+        for (QString *fileName : { &target, &resourceTarget, &decoy }) {
+            QTemporaryFile file;
+            file.setAutoRemove(false);
+            QVERIFY(file.open());
+            *fileName = file.fileName();
+        }
+
+        // A file of this process that must not be touched by copying through the remote engine
+        QFSFileEngine decoyFile(decoy);
+        QVERIFY(decoyFile.open(QIODevice::ReadWrite | QIODevice::Unbuffered));
+        QCOMPARE(decoyFile.write("decoy", 5), qint64(5));
+
+        RemoteFileEngineHandler handler;
+        try {
+            QFile in(source);
+            QInstaller::openForRead(&in);
+            QFile out(target);
+            QInstaller::openForWrite(&out);
+            QInstaller::blockingCopy(&in, &out, in.size());
+            out.close();
+
+            Resource resource(source);
+            QVERIFY(resource.open());
+            QFile resourceOut(resourceTarget);
+            QInstaller::openForWrite(&resourceOut);
+            resource.copyData(&resourceOut);
+            resourceOut.close();
+        } catch (const Error &error) {
+            QFAIL(qPrintable(error.message()));
+        }
+
+        for (const QString &fileName : { target, resourceTarget }) {
+            QFile result(fileName);
+            QVERIFY(result.open(QIODevice::ReadOnly));
+            QVERIFY(result.readAll() == content);
+        }
+
+        QCOMPARE(decoyFile.size(), qint64(5));
+        QVERIFY(decoyFile.seek(0));
+        char data[5];
+        QCOMPARE(decoyFile.read(data, 5), qint64(5));
+        QCOMPARE(QByteArray(data, 5), QByteArray("decoy"));
+        decoyFile.close();
+
+        for (const QString &fileName : { source, target, resourceTarget, decoy })
+            QVERIFY(QFile::remove(fileName));
+    }
+
     void testArchiveWrapper_data()
     {
         QTest::addColumn<QString>("suffix");
@@ -40,6 +40,15 @@
 
 using namespace QInstaller;
 
+static const QString scSkippedValidationMessage = QLatin1String("Component tree unchanged since "
+    "its last validation, skipping the dependency check.");
+static QStringList s_messages;
+
+static void collectingTestMessageHandler(QtMsgType, const QMessageLogContext &, const QString &msg)
+{
+    s_messages.append(msg);
+}
+
 typedef QList<QPair<QString, QString> > ComponentResourceHash;
 typedef QPair<QString, QString> ComponentResource;
 
@@ -52,7 +61,6 @@ public:
     {
         QTest::ignoreMessage(QtDebugMsg, QRegularExpression("Searching packages with regular expression:"));
         QTest::ignoreMessage(QtDebugMsg, "Fetching latest update information...");
-        QTest::ignoreMessage(QtDebugMsg, "Loading component scripts...");
         QTest::ignoreMessage(QtDebugMsg, "No matching packages found.");
     }
 
@@ -126,6 +134,14 @@ private slots:
              "    <package name=\"B\" displayname=\"B\" version=\"1.0.0-1\"/>\n"
              "</availablepackages>\n"), func, QString(), searchHash);
 
+        // Children of virtual components are listed only if virtual components are visible
+        core->setVirtualComponentsVisible(true);
+        verifyListPackagesMessage(core.get(), QLatin1String("<?xml version=\"1.0\"?>\n"
+             "<availablepackages>\n"
+             "    <package name=\"C.virt.subcomponent\" displayname=\"Subcomponent of virtual component\" version=\"1.0.0-1\"/>\n"
+             "</availablepackages>\n"), func, QLatin1String("C.virt.sub"), QHash<QString, QString>());
+        core->setVirtualComponentsVisible(false);
+
         QLoggingCategory::setFilterRules("ifw.* = true\n");
         ignoreAvailablePackagesMissingMessages();
         core->listAvailablePackages(QLatin1String("C.virt"));
@@ -647,6 +663,84 @@ private slots:
     }
 
 
+    void testValidatedComponentTreeIsCached()
+    {
+        const QString cachePath = QInstaller::generateTemporaryFileName();
+        const QString validatedFile = cachePath + "/validated-component-tree.sha1";
+
+        QScopedPointer<PackageManagerCore> core(PackageManager::getPackageManagerWithInit
+                (m_installDir, ":///data/installPackagesRepository"));
+        core->settings().setLocalCachePath(cachePath);
+
+        QLoggingCategory::setFilterRules(QLatin1String("ifw.* = false\n"
+                                                       "ifw.installer.installlog = true\n"));
+        s_messages.clear();
+        qInstallMessageHandler(collectingTestMessageHandler);
+        QVERIFY(core->fetchRemotePackagesTree());
+        QVERIFY(!s_messages.contains(scSkippedValidationMessage));
+        QVERIFY(QFileInfo::exists(validatedFile));
+
+        QFile file(validatedFile);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        const QByteArray checksum = file.readAll();
+        file.close();
+        QVERIFY(!checksum.isEmpty());
+
+        // Building the same tree again skips solving it
+        core->reset();
+        core->cancelMetaInfoJob(); //Call cancel to reset metadata so that the tree is built again
+        QVERIFY(core->fetchRemotePackagesTree());
+        qInstallMessageHandler(silentTestMessageHandler);
+        QVERIFY(s_messages.contains(scSkippedValidationMessage));
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.readAll(), checksum);
+        file.close();
+
+        core->reset();
+        core->cancelMetaInfoJob();
+        QCOMPARE(PackageManagerCore::Success, core->installDefaultComponentsSilently());
+
+        // The installed components change the dependency graph, validate again
+        core->reset();
+        core->cancelMetaInfoJob(); //Call cancel to reset metadata so that the tree is built again
+        QCOMPARE(PackageManagerCore::Success, core->installSelectedComponentsSilently(QStringList()
+            << QLatin1String("componentB")));
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QVERIFY(file.readAll() != checksum);
+        file.close();
+
+        core->clearLocalCache();
+        QVERIFY(!QFileInfo::exists(validatedFile));
+        if (QFileInfo::exists(cachePath))
+            QInstaller::removeDirectory(cachePath, true);
+    }
+
+    void testInvalidComponentTreeIsNotCached()
+    {
+        const QString cachePath = QInstaller::generateTemporaryFileName();
+        const QString validatedFile = cachePath + "/validated-component-tree.sha1";
+
+        QScopedPointer<PackageManagerCore> core(PackageManager::getPackageManagerWithInit
+                (m_installDir, ":///data/repositoryMissingDependency"));
+        core->settings().setLocalCachePath(cachePath);
+        core->settings().setAllowUnstableComponents(false);
+        core->autoRejectMessageBoxes();
+
+        // Errors of the dependency check are reported on every run
+        for (int run = 0; run < 2; ++run) {
+            core->reset();
+            core->cancelMetaInfoJob(); //Call cancel to reset metadata so that the tree is built again
+            QVERIFY(!core->fetchRemotePackagesTree());
+            QCOMPARE(core->status(), PackageManagerCore::Failure);
+            QVERIFY2(core->error().contains("missing.dependency.component"), qPrintable(core->error()));
+            QVERIFY(!QFileInfo::exists(validatedFile));
+        }
+
+        core->clearLocalCache();
+        if (QFileInfo::exists(cachePath))
+            QInstaller::removeDirectory(cachePath, true);
+    }
+
     void testNoDefaultInstallations()
     {
         QScopedPointer<PackageManagerCore> core(PackageManager::getPackageManagerWithInit
@@ -28,8 +28,88 @@
 
 #include "updater.h"
 
+#include <QRegularExpression>
 #include <QTest>
 
+// The regular expression based implementation KDUpdater::VersionKey replaced, kept as the
+// reference for the comparison results and for the benchmarks.
+static int referenceCompareVersion(const QString &v1, const QString &v2)
+{
+    if (v1 == v2)
+        return 0;
+
+    static const QRegularExpression regex(QLatin1String( "\\.|-|_"));
+    QStringList v1_comps = v1.split(regex);
+    QStringList v2_comps = v2.split(regex);
+
+    int index = 0;
+    while (true) {
+        bool v1_ok = false;
+        bool v2_ok = false;
+
+        if (index == v1_comps.count() && index < v2_comps.count()) {
+            v2_comps.at(index).toLongLong(&v2_ok);
+            return v2_ok ? -1 : +1;
+        }
+        if (index < v1_comps.count() && index == v2_comps.count()) {
+            v1_comps.at(index).toLongLong(&v1_ok);
+            return v1_ok ? +1 : -1;
+        }
+        if (index >= v1_comps.count() || index >= v2_comps.count())
+            break;
+
+        qlonglong v1_comp = v1_comps.at(index).toLongLong(&v1_ok);
+        qlonglong v2_comp = v2_comps.at(index).toLongLong(&v2_ok);
+
+        if (!v1_ok && v1_comps.at(index) == QLatin1String("x"))
+            return 0;
+        if (!v2_ok && v2_comps.at(index) == QLatin1String("x"))
+            return 0;
+        if (!v1_ok && !v2_ok) {
+            int i = 0;
+            while (i < v1_comps.at(index).size() && i < v2_comps.at(index).size()
+                && v1_comps.at(index).at(i) == v2_comps.at(index).at(i)) {
+                ++i;
+            }
+            if (i > 0) {
+                v1_comps[index] = v1_comps.at(index).mid(i);
+                v2_comps[index] = v2_comps.at(index).mid(i);
+                continue;
+            }
+        }
+        if (!v1_ok || !v2_ok) {
+            int res = v1_comps.at(index).compare(v2_comps.at(index));
+            if (res == 0) {
+                ++index;
+                continue;
+            }
+            return res > 0 ? +1 : -1;
+        }
+
+        if (v1_comp < v2_comp)
+            return -1;
+        if (v1_comp > v2_comp)
+            return +1;
+        ++index;
+    }
+
+    if (index < v2_comps.count())
+        return +1;
+    if (index < v1_comps.count())
+        return -1;
+    return 0;
+}
+
+static QStringList versionSamples()
+{
+    return QStringList() << "" << "1" << "1." << ".1" << "1..0" << "2.0" << "2.1" << "2.x" << "x"
+        << "2.0.0" << "2.0-0" << "2.0_1" << "2.1-201903190747" << "2.0.12.4" << "2.0.12.x"
+        << "v2.0" << "v2.x" << "v2.0-alpha" << "v2.0-beta" << "v2.0-rc1" << "v2.0-rc11"
+        << "v2.0-rc" << "rc" << "rcx" << "ax" << "ay" << "1a" << "1b" << "a1" << "10" << "010"
+        << "+1" << " 1" << "1 " << "99999999999999999999" << "-1" << "2.0-" << "OpenSSL_1_0_2k"
+        << "OpenSSL_1_1_0f" << "1.2.3.4.5.6.7.8.9";
+}
+
 class tst_CompareVersion : public QObject
 {
     Q_OBJECT
@@ -39,6 +119,11 @@ private slots:
     void compareVersionX();
     void compareVersionAll();
     void compareVersionExtra();
+    void compareVersionKey();
+    void compareVersionReference();
+
+    void benchmarkCompareVersion_data();
+    void benchmarkCompareVersion();
 };
 
 void tst_CompareVersion::compareVersion()
@@ -92,6 +177,68 @@ void tst_CompareVersion::compareVersionExtra()
     QCOMPARE(KDUpdater::compareVersion("OpenSSL_1_1_0f", "OpenSSL_1_0_2k"), +1);
 }
 
+void tst_CompareVersion::compareVersionKey()
+{
+    const KDUpdater::VersionKey key(QLatin1String("v2.0-rc11"));
+    QCOMPARE(key.toString(), QLatin1String("v2.0-rc11"));
+    QCOMPARE(key.componentCount(), 3);
+    QCOMPARE(KDUpdater::VersionKey(QString()).componentCount(), 1);
+
+    QCOMPARE(KDUpdater::compareVersion(key, KDUpdater::VersionKey("v2.0-rc2")), +1);
+    QCOMPARE(KDUpdater::compareVersion(KDUpdater::VersionKey("v2.0-rc2"), key), -1);
+    QCOMPARE(KDUpdater::compareVersion(key, KDUpdater::VersionKey("v2.x")), 0);
+    QCOMPARE(KDUpdater::compareVersion(key, key), 0);
+}
+
+void tst_CompareVersion::compareVersionReference()
+{
+    const QStringList samples = versionSamples();
+    for (const QString &v1 : samples) {
+        const KDUpdater::VersionKey key1(v1);
+        for (const QString &v2 : samples) {
+            const int expected = referenceCompareVersion(v1, v2);
+            QVERIFY2(KDUpdater::compareVersion(v1, v2) == expected,
+                qPrintable(QString::fromLatin1("\"%1\" <=> \"%2\"").arg(v1, v2)));
+            QVERIFY2(KDUpdater::compareVersion(key1, KDUpdater::VersionKey(v2)) == expected,
+                qPrintable(QString::fromLatin1("\"%1\" <=> \"%2\"").arg(v1, v2)));
+        }
+    }
+}
+
+void tst_CompareVersion::benchmarkCompareVersion_data()
+{
+    QTest::addColumn<int>("method");
+    QTest::newRow("reference") << 0;
+    QTest::newRow("string") << 1;
+    QTest::newRow("key") << 2;
+}
+
+void tst_CompareVersion::benchmarkCompareVersion()
+{
+    QFETCH(int, method);
+
+    QStringList versions;
+    for (int i = 0; i < 1000; ++i)
+        versions.append(QString::fromLatin1("%1.%2.%3-%4").arg(i % 7).arg(i % 13).arg(i).arg(i % 3));
+
+    QVector<KDUpdater::VersionKey> keys;
+    for (const QString &version : qAsConst(versions))
+        keys.append(KDUpdater::VersionKey(version));
+
+    int result = 0;
+    QBENCHMARK {
+        for (int i = 1; i < versions.count(); ++i) {
+            if (method == 0)
+                result += referenceCompareVersion(versions.at(i - 1), versions.at(i));
+            else if (method == 1)
+                result += KDUpdater::compareVersion(versions.at(i - 1), versions.at(i));
+            else
+                result += KDUpdater::compareVersion(keys.at(i - 1), keys.at(i));
+        }
+    }
+    Q_UNUSED(result)
+}
+
 QTEST_MAIN(tst_CompareVersion)
 
 #include "tst_compareversion.moc"
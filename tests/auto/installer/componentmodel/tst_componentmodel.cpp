@@ -28,9 +28,11 @@
 
 #include "component.h"
 #include "componentmodel.h"
+#include "componentsortfilterproxymodel.h"
 #include "updatesinfo_p.h"
 #include "packagemanagercore.h"
 
+#include <QSignalSpy>
 #include <QTest>
 #include <QtCore/QLocale>
 
@@ -419,6 +421,69 @@ private slots:
             + m_uncheckable + m_defaultPartially + QStringList() << vendorSecondProductSub);
     }
 
+    void testSearchPattern()
+    {
+        setPackageManagerOptions(NoFlags);
+
+        QList<Component*> rootComponents = loadComponents();
+        testComponentsLoaded(rootComponents);
+
+        ComponentModel model(1, &m_core);
+        model.reset(rootComponents);
+
+        ComponentSortFilterProxyModel proxy;
+        proxy.setRecursiveFilteringEnabled(true);
+        proxy.setSourceModel(&model);
+        QSignalSpy spy(&proxy, &ComponentSortFilterProxyModel::searchPatternApplied);
+
+        auto isVisible = [&](const QString &name) {
+            return proxy.mapFromSource(model.indexFromComponentName(name)).isValid();
+        };
+
+        // component names are matched case insensitive
+        proxy.setSearchPattern(QLatin1String("SUBNODE"));
+        QVERIFY(spy.wait());
+        QCOMPARE(proxy.searchPattern(), QLatin1String("SUBNODE"));
+        QCOMPARE(proxy.directlyAcceptedIndexes().count(), 2);
+        QVERIFY(isVisible(vendorSecondProductSubnode));
+        QVERIFY(isVisible(vendorSecondProductSubnodeSub));
+        QVERIFY(isVisible(vendorSecondProduct)); // parent of a match
+        QVERIFY(!isVisible(vendorSecondProductSub));
+        QVERIFY(!isVisible(vendorProduct));
+
+        // refines the previous result
+        proxy.setSearchPattern(QLatin1String("SUBNODE.sub"));
+        QVERIFY(spy.wait());
+        QCOMPARE(proxy.directlyAcceptedIndexes().count(), 1);
+        QVERIFY(isVisible(vendorSecondProductSubnodeSub));
+
+        // display names are matched, children of matches are accepted as well
+        proxy.setSearchPattern(QLatin1String("second root component"));
+        QVERIFY(spy.wait());
+        QCOMPARE(proxy.directlyAcceptedIndexes().count(), 1);
+        QVERIFY(isVisible(vendorSecondProduct));
+        QVERIFY(isVisible(vendorSecondProductSub));
+        QVERIFY(isVisible(vendorSecondProductSubnodeSub));
+        QVERIFY(!isVisible(vendorFourthProductCheckable));
+
+        proxy.setSearchPattern(QLatin1String("fifth*sub"));
+        QVERIFY(spy.wait());
+        QCOMPARE(proxy.directlyAcceptedIndexes().count(), 2);
+        QVERIFY(isVisible(vendorFifthProductSub));
+        QVERIFY(isVisible(vendorFifthProductSubWithTreeName));
+        QVERIFY(!isVisible(vendorSecondProductSub));
+
+        // an empty pattern is applied immediately and accepts everything
+        spy.clear();
+        proxy.setSearchPattern(QString());
+        QCOMPARE(spy.count(), 1);
+        QVERIFY(proxy.searchPattern().isEmpty());
+        QVERIFY(isVisible(vendorProduct));
+        QVERIFY(isVisible(vendorSecondProductSubnodeSub));
+
+        qDeleteAll(rootComponents);
+    }
+
 private:
     void setPackageManagerOptions(Options flags) const
     {
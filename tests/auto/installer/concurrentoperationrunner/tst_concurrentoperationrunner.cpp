@@ -0,0 +1,185 @@
+/**************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+
+#include <concurrentoperationrunner.h>
+
+#include <QMutex>
+#include <QTest>
+#include <QThread>
+
+using namespace QInstaller;
+
+static QMutex s_mutex;
+static QStringList s_startedOperations;
+static QStringList s_adjustments;
+static int s_running = 0;
+static int s_maxRunning = 0;
+
+static void adjustmentMessageHandler(QtMsgType type, const QMessageLogContext &context,
+    const QString &message)
+{
+    Q_UNUSED(type)
+    Q_UNUSED(context)
+    if (message.startsWith(QLatin1String("Concurrent operations:")))
+        s_adjustments.append(message);
+}
+
+class SizedOperation : public KDUpdater::UpdateOperation
+{
+public:
+    SizedOperation(const QString &name, quint64 size, unsigned long duration = 0)
+        : KDUpdater::UpdateOperation(nullptr)
+        , m_size(size)
+        , m_duration(duration)
+    { setName(name); }
+
+    void backup() override {}
+    bool performOperation() override
+    {
+        {
+            QMutexLocker _(&s_mutex);
+            s_startedOperations.append(name());
+            s_maxRunning = qMax(s_maxRunning, ++s_running);
+        }
+        if (m_duration > 0)
+            QThread::msleep(m_duration);
+        QMutexLocker _(&s_mutex);
+        --s_running;
+        return true;
+    }
+    bool undoOperation() override { return true; }
+    bool testOperation() override { return true; }
+    quint64 sizeHint() override { return m_size; }
+
+private:
+    const quint64 m_size;
+    const unsigned long m_duration;
+};
+
+class tst_ConcurrentOperationRunner : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init()
+    {
+        s_startedOperations.clear();
+        s_adjustments.clear();
+        s_running = 0;
+        s_maxRunning = 0;
+    }
+
+    void testLargestOperationsFirst()
+    {
+        OperationList operations;
+        operations << new SizedOperation(QLatin1String("small"), 1)
+            << new SizedOperation(QLatin1String("large"), 100)
+            << new SizedOperation(QLatin1String("medium"), 10)
+            << new SizedOperation(QLatin1String("large too"), 100)
+            << new SizedOperation(QLatin1String("default"), 0);
+
+        // A single thread starts the operations strictly in the order they are queued
+        ConcurrentOperationRunner runner(&operations, Operation::Perform);
+        runner.setMaxThreadCount(1);
+        const QHash<Operation *, bool> results = runner.run();
+        QCOMPARE(results.count(), operations.count());
+        for (Operation *operation : operations)
+            QVERIFY(results.value(operation));
+
+        QCOMPARE(s_startedOperations, QStringList() << QLatin1String("large")
+            << QLatin1String("large too") << QLatin1String("medium") << QLatin1String("small")
+            << QLatin1String("default"));
+        qDeleteAll(operations);
+    }
+
+    void testConcurrencyAdjustment_data()
+    {
+        QTest::addColumn<int>("maxThreadCount");
+        QTest::newRow("Adaptive") << 0;
+        QTest::newRow("Fixed") << 2;
+    }
+
+    void testConcurrencyAdjustment()
+    {
+        QFETCH(int, maxThreadCount);
+
+        // Enough operations to take a couple of throughput samples with every thread in use
+        const int threadCount = maxThreadCount > 0 ? maxThreadCount : QThread::idealThreadCount();
+        OperationList operations;
+        for (int i = 0; i < threadCount * 8; ++i)
+            operations << new SizedOperation(QString::number(i), 1024, 50);
+
+        QtMessageHandler previousHandler = qInstallMessageHandler(adjustmentMessageHandler);
+        ConcurrentOperationRunner runner(&operations, Operation::Perform);
+        runner.setMaxThreadCount(maxThreadCount);
+        const QHash<Operation *, bool> results = runner.run();
+        qInstallMessageHandler(previousHandler);
+
+        QCOMPARE(results.count(), operations.count());
+        // An adaptive runner may go beyond the ideal thread count for I/O bound operations
+        QVERIFY(s_maxRunning <= (maxThreadCount > 0 ? threadCount : threadCount * 2));
+        if (maxThreadCount > 0) {
+            // A fixed thread count is never tuned
+            QVERIFY2(s_adjustments.isEmpty(), qPrintable(s_adjustments.join(QLatin1Char('\n'))));
+            QCOMPARE(s_maxRunning, maxThreadCount);
+        } else if (threadCount > 1) {
+            // The first sample only records the baseline and keeps all threads running
+            QVERIFY(!s_adjustments.isEmpty());
+            const QString expected = QString::fromLatin1("Concurrent operations: %1 -> %1 (baseline,")
+                .arg(threadCount);
+            QVERIFY2(s_adjustments.first().startsWith(expected), qPrintable(s_adjustments.first()));
+        }
+        qDeleteAll(operations);
+    }
+
+    void testConcurrencyProbing()
+    {
+        // Sleeping operations finish faster the more of them run at the same time, so a
+        // held or rising throughput must make the runner try more operations than cores.
+        const int threadCount = QThread::idealThreadCount();
+        OperationList operations;
+        for (int i = 0; i < threadCount * 100; ++i)
+            operations << new SizedOperation(QString::number(i), 1024, 20);
+
+        QtMessageHandler previousHandler = qInstallMessageHandler(adjustmentMessageHandler);
+        ConcurrentOperationRunner runner(&operations, Operation::Perform);
+        runner.setMaxThreadCount(0);
+        const QHash<Operation *, bool> results = runner.run();
+        qInstallMessageHandler(previousHandler);
+
+        QCOMPARE(results.count(), operations.count());
+        QVERIFY2(s_maxRunning > threadCount, qPrintable(s_adjustments.join(QLatin1Char('\n'))));
+        QVERIFY(s_maxRunning <= threadCount * 2);
+        qDeleteAll(operations);
+    }
+};
+
+QTEST_GUILESS_MAIN(tst_ConcurrentOperationRunner)
+
+#include "tst_concurrentoperationrunner.moc"
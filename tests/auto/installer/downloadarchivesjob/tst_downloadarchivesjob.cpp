@@ -0,0 +1,237 @@
+/**************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+
+#include <binaryformatenginehandler.h>
+#include <component.h>
+#include <constants.h>
+#include <downloadarchivesjob.h>
+#include <packagemanagercore.h>
+
+#include <QDir>
+#include <QFile>
+#include <QMessageBox>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace QInstaller;
+
+class tst_DownloadArchivesJob : public QObject
+{
+    Q_OBJECT
+
+private:
+    // Creates a component for every archive, and the archive itself unless it is listed in
+    // \a missing. Returns the items to download.
+    QList<PackageManagerCore::DownloadItem> setupArchives(PackageManagerCore *core,
+        const QStringList &names, int size, const QStringList &missing = QStringList())
+    {
+        QList<PackageManagerCore::DownloadItem> items;
+        for (const QString &name : names) {
+            Component *component = new Component(core);
+            component->setValue(scName, name);
+            component->setValue(scDisplayName, QLatin1String("component ") + name);
+            component->setValue(scVersion, QLatin1String("1.0.0"));
+            component->setLocalTempPath(m_tempDir.path());
+            core->appendRootComponent(component);
+            QDir(m_tempDir.path()).mkpath(name);
+
+            const QString source = m_repository.filePath(name + QLatin1String("content.7z"));
+            if (!missing.contains(name))
+                writeArchive(source, name, size);
+
+            PackageManagerCore::DownloadItem item;
+            item.fileName = QString::fromLatin1("installer://%1/1.0.0content.7z").arg(name);
+            item.sourceUrl = QUrl::fromLocalFile(source).toString();
+            item.checkSha1CheckSum = false;
+            items.append(item);
+        }
+        return items;
+    }
+
+    static QByteArray archiveContent(const QString &name, int size)
+    {
+        QByteArray content;
+        content.reserve(size);
+        while (content.size() < size)
+            content.append(name.toLatin1()).append(char(content.size() % 251));
+        content.truncate(size);
+        return content;
+    }
+
+    static void writeArchive(const QString &fileName, const QString &name, int size)
+    {
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(archiveContent(name, size)), qint64(size));
+    }
+
+    QString downloadedFile(const QString &name) const
+    {
+        return m_tempDir.filePath(name + QLatin1String("/1.0.0content.7z"));
+    }
+
+private slots:
+    void init()
+    {
+        QVERIFY(m_tempDir.isValid());
+        QVERIFY(m_repository.isValid());
+    }
+
+    void cleanup()
+    {
+        BinaryFormatEngineHandler::instance()->clear();
+        QDir(m_tempDir.path()).removeRecursively();
+        QDir(m_repository.path()).removeRecursively();
+        QDir().mkpath(m_tempDir.path());
+        QDir().mkpath(m_repository.path());
+    }
+
+    void testDownloadArchives()
+    {
+        PackageManagerCore core;
+        core.setPackageManager();
+        const QStringList names = QStringList() << "A" << "B" << "C" << "D" << "E";
+        DownloadArchivesJob job(&core);
+        job.setAutoDelete(false);
+        job.setArchivesToDownload(setupArchives(&core, names, 256 * 1024));
+        job.setMaxConcurrentDownloads(2);
+
+        QSignalSpy registered(&job, &DownloadArchivesJob::archiveRegistered);
+        QSignalSpy finished(&job, &Job::finished);
+        job.start();
+        QVERIFY(finished.wait(10000));
+
+        QCOMPARE(job.error(), int(Job::NoError));
+        QCOMPARE(job.numberOfDownloads(), names.count());
+        QCOMPARE(registered.count(), names.count());
+        for (const QString &name : names) {
+            QFile file(downloadedFile(name));
+            QVERIFY(file.open(QIODevice::ReadOnly));
+            QVERIFY(file.readAll() == archiveContent(name, 256 * 1024));
+        }
+    }
+
+    void testFailingArchiveAmongSeveral()
+    {
+        PackageManagerCore core;
+        core.setPackageManager();
+        core.setMessageBoxAutomaticAnswer(QLatin1String("archiveDownloadError"), QMessageBox::Cancel);
+        const QStringList names = QStringList() << "A" << "B" << "C" << "D";
+        DownloadArchivesJob job(&core);
+        job.setAutoDelete(false);
+        job.setArchivesToDownload(setupArchives(&core, names, 256 * 1024, QStringList() << "B"));
+        job.setMaxConcurrentDownloads(1);
+
+        QSignalSpy registered(&job, &DownloadArchivesJob::archiveRegistered);
+        QSignalSpy finished(&job, &Job::finished);
+        job.start();
+        QVERIFY(finished.wait(10000));
+        QTest::qWait(100); // no further downloads are started or reported after finishing
+
+        QCOMPARE(finished.count(), 1);
+        QCOMPARE(job.error(), int(Job::Canceled));
+        QVERIFY2(job.errorString().contains("Bcontent.7z"), qPrintable(job.errorString()));
+        QCOMPARE(registered.count(), 1);
+        QCOMPARE(registered.first().first().toString(), QLatin1String("installer://A/1.0.0content.7z"));
+        QVERIFY(!QFileInfo::exists(downloadedFile(QLatin1String("C"))));
+    }
+
+    void testRetryFailingArchive()
+    {
+        PackageManagerCore core;
+        core.setPackageManager();
+        core.setMessageBoxAutomaticAnswer(QLatin1String("archiveDownloadError"), QMessageBox::Retry);
+        const QStringList names = QStringList() << "A" << "B" << "C";
+        DownloadArchivesJob job(&core);
+        job.setAutoDelete(false);
+        job.setArchivesToDownload(setupArchives(&core, names, 256 * 1024, QStringList() << "B"));
+
+        // The archive becomes available when it is downloaded the second time
+        int attempts = 0;
+        connect(&job, &DownloadArchivesJob::outputTextChanged, this, [&](const QString &text) {
+            if (!text.endsWith(QLatin1String("component B.")))
+                return;
+            if (++attempts == 2)
+                writeArchive(m_repository.filePath(QLatin1String("Bcontent.7z")), QLatin1String("B"), 1024);
+        });
+
+        QSignalSpy registered(&job, &DownloadArchivesJob::archiveRegistered);
+        QSignalSpy finished(&job, &Job::finished);
+        job.start();
+        QVERIFY(finished.wait(10000));
+
+        QCOMPARE(job.error(), int(Job::NoError));
+        QCOMPARE(attempts, 2);
+        QCOMPARE(registered.count(), names.count());
+        QCOMPARE(job.numberOfDownloads(), names.count());
+        QFile file(downloadedFile(QLatin1String("B")));
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QVERIFY(file.readAll() == archiveContent(QLatin1String("B"), 1024));
+    }
+
+    void testCancelWhileDownloading()
+    {
+        PackageManagerCore core;
+        core.setPackageManager();
+        const QStringList names = QStringList() << "A" << "B" << "C" << "D";
+        DownloadArchivesJob job(&core);
+        job.setAutoDelete(false);
+        job.setArchivesToDownload(setupArchives(&core, names, 8 * 1024 * 1024));
+        job.setMaxConcurrentDownloads(1);
+
+        // Cancel as soon as the first archive is partially downloaded
+        bool canceled = false;
+        connect(&job, &DownloadArchivesJob::progressChanged, &job, [&job, &canceled](double progress) {
+            if (progress > 0 && !canceled) {
+                canceled = true;
+                job.cancel();
+            }
+        });
+
+        QSignalSpy registered(&job, &DownloadArchivesJob::archiveRegistered);
+        QSignalSpy finished(&job, &Job::finished);
+        job.start();
+        QVERIFY(finished.wait(10000));
+        QTest::qWait(100); // canceled downloads do not report anything afterwards
+
+        QCOMPARE(finished.count(), 1);
+        QCOMPARE(job.error(), int(Job::Canceled));
+        QVERIFY(registered.count() < names.count());
+        QVERIFY(!QFileInfo::exists(downloadedFile(names.last())));
+    }
+
+private:
+    QTemporaryDir m_tempDir;
+    QTemporaryDir m_repository;
+};
+
+QTEST_GUILESS_MAIN(tst_DownloadArchivesJob)
+
+#include "tst_downloadarchivesjob.moc"
@@ -33,6 +33,7 @@
 #include "extractarchiveoperation.h"
 
 #include <QDir>
+#include <QDirIterator>
 #include <QObject>
 #include <QTest>
 
@@ -44,6 +45,18 @@ class tst_extractarchiveoperationtest : public QObject
     Q_OBJECT
 
 private:
+    QStringList filesInDirectory(const QString &path)
+    {
+        QStringList files;
+        QDirIterator it(path, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            const QString filePath = it.next();
+            if (!filePath.contains(QLatin1String("installerResources")))
+                files.append(QDir(path).relativeFilePath(filePath));
+        }
+        files.sort();
+        return files;
+    }
 
 private slots:
     void initTestCase()
@@ -51,6 +64,12 @@ private slots:
         QInstaller::init();
     }
 
+    void cleanup()
+    {
+        // Do not leak the pipelined mode of a failed test into the following ones
+        PackageManagerCore::setPipelinedInstallation(false);
+    }
+
     void testMissingArguments()
     {
         ExtractArchiveOperation op(nullptr);
@@ -138,6 +157,126 @@ private slots:
         QDir().rmdir(testDirectory);
     }
 
+    void testIncrementalConcurrentExtract()
+    {
+        // Suppress warnings about already deleted installerResources file
+        qInstallMessageHandler(silentTestMessageHandler);
+
+        const QString testDirectory = generateTemporaryFileName() + "/incremental/";
+
+        OperationList operations;
+        for (int i = 0; i < 20; ++i) {
+            ExtractArchiveOperation *op = new ExtractArchiveOperation(nullptr);
+            const QString new7zPath = generateTemporaryFileName() + ".7z";
+            QFile old7z(":///data/subdirs.7z");
+            QVERIFY(old7z.copy(new7zPath));
+
+            op->setArguments(QStringList() << new7zPath << testDirectory);
+            operations.append(op);
+        }
+
+        ConcurrentOperationRunner runner;
+        runner.setType(Operation::Perform);
+        runner.start();
+
+        // Add operations in batches, earlier batches may finish before the later ones are added
+        for (int i = 0; i < operations.size(); i += 5) {
+            runner.addOperations(operations.mid(i, 5));
+            QCoreApplication::processEvents();
+        }
+
+        const QHash<Operation *, bool> results = runner.waitForFinished();
+        QCOMPARE(results.count(), operations.count());
+
+        for (auto *operation : operations) {
+            QVERIFY2((results.value(operation) && operation->error() == Operation::NoError),
+                     operation->errorString().toLatin1());
+        }
+
+        for (auto *operation : operations) {
+            QVERIFY(operation->undoOperation());
+            QFile::remove(operation->arguments().at(0));
+        }
+
+        qDeleteAll(operations);
+        QDir().rmdir(testDirectory);
+    }
+
+    void testBackupExistingFilesWhileExtracting()
+    {
+        // Suppress warnings about already deleted installerResources file
+        qInstallMessageHandler(silentTestMessageHandler);
+
+        const QString testDirectory = generateTemporaryFileName();
+
+        ExtractArchiveOperation first(nullptr);
+        first.setArguments(QStringList() << ":///data/valid.7z" << testDirectory);
+        first.backup();
+        QVERIFY(first.performOperation());
+
+        const QStringList extractedFiles = filesInDirectory(testDirectory);
+        QVERIFY(!extractedFiles.isEmpty());
+
+        QHash<QString, QByteArray> extractedContent;
+        for (const QString &fileName : extractedFiles) {
+            QFile file(testDirectory + QLatin1Char('/') + fileName);
+            QVERIFY(file.open(QIODevice::ReadOnly));
+            extractedContent.insert(fileName, file.readAll());
+            file.close();
+
+            QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+            file.write("modified");
+        }
+
+        // Existing files are backed up during extraction, and the backups
+        // are removed once the archive has been extracted.
+        ExtractArchiveOperation second(nullptr);
+        second.setArguments(QStringList() << ":///data/valid.7z" << testDirectory);
+        second.backup();
+        QVERIFY2(second.error() == Operation::NoError, second.errorString().toLatin1());
+        QVERIFY(second.performOperation());
+
+        // No backup is left next to the extracted files
+        QCOMPARE(filesInDirectory(testDirectory), extractedFiles);
+        for (const QString &fileName : extractedFiles) {
+            QFile file(testDirectory + QLatin1Char('/') + fileName);
+            QVERIFY(file.open(QIODevice::ReadOnly));
+            QCOMPARE(file.readAll(), extractedContent.value(fileName));
+        }
+
+        QVERIFY(second.undoOperation());
+        QVERIFY(first.undoOperation());
+        QVERIFY(QDir(testDirectory).removeRecursively());
+    }
+
+    void testPipelinedExtractArchiveFromXML()
+    {
+        m_testDirectory = QInstaller::generateTemporaryFileName();
+        QVERIFY(QDir().mkpath(m_testDirectory));
+        QVERIFY(QDir(m_testDirectory).exists());
+
+        PackageManagerCore::setPipelinedInstallation(true);
+        QScopedPointer<PackageManagerCore> core(PackageManager::getPackageManagerWithInit
+                (m_testDirectory, ":///data/xmloperationrepository"));
+        QCOMPARE(PackageManagerCore::Success, core->installDefaultComponentsSilently());
+
+        QFile extractedFile(m_testDirectory + QDir::separator() + "FolderForContent/content.txt");
+        QVERIFY(extractedFile.exists());
+
+        extractedFile.setFileName(m_testDirectory + QDir::separator() + "FolderForAnotherContent/anothercontent.txt");
+        QVERIFY(extractedFile.exists());
+
+        extractedFile.setFileName(m_testDirectory + QDir::separator() + "FolderForDefault/default.txt");
+        QVERIFY(extractedFile.exists());
+
+        core->setPackageManager();
+        core->commitSessionOperations();
+
+        QCOMPARE(PackageManagerCore::Success, core->uninstallComponentsSilently(QStringList() << "A"));
+        QDir dir(m_testDirectory);
+        QVERIFY(dir.removeRecursively());
+    }
+
     void testExtractArchiveFromXML()
     {
         m_testDirectory = QInstaller::generateTemporaryFileName();
@@ -28,11 +28,16 @@
 
 #include <qinstallerglobal.h>
 #include <fileutils.h>
+#include <filehasher.h>
+#include <utils.h>
 
 #include <QObject>
 #include <QTest>
 #include <QFile>
 #include <QDir>
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QtConcurrent/QtConcurrentRun>
 
 using namespace QInstaller;
 
@@ -40,7 +45,121 @@ class tst_fileutils : public QObject
 {
     Q_OBJECT
 
+private:
+    QString createFile(const QByteArray &data)
+    {
+        const QString fileName = QInstaller::generateTemporaryFileName();
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size())
+            return QString();
+        m_files.append(fileName);
+        return fileName;
+    }
+
+    QByteArray testData(int size, char seed)
+    {
+        QByteArray data(size, Qt::Uninitialized);
+        for (int i = 0; i < size; ++i)
+            data[i] = char(seed + i * 31);
+        return data;
+    }
+
 private slots:
+    void cleanup()
+    {
+        for (const QString &fileName : qAsConst(m_files))
+            QFile::remove(fileName);
+        m_files.clear();
+    }
+
+    void testFileHasher_data()
+    {
+        QTest::addColumn<int>("size");
+        QTest::newRow("empty") << 0;
+        QTest::newRow("read") << 3 * 1024 * 1024 + 17;
+        QTest::newRow("mapped") << 9 * 1024 * 1024 + 17;
+    }
+
+    void testFileHasher()
+    {
+        QFETCH(int, size);
+
+        const QByteArray data = testData(size, 'a');
+        const QByteArray expected = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+        const QString fileName = createFile(data);
+        QVERIFY(!fileName.isEmpty());
+
+        QCOMPARE(FileHasher::hashFile(fileName, QCryptographicHash::Sha1), expected);
+        QCOMPARE(calculateHash(fileName, QCryptographicHash::Sha1), expected);
+
+        // hashing starts at the current position of the device and reads it to the end
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        if (size > 0) {
+            QVERIFY(file.seek(1));
+            QCOMPARE(FileHasher::hash(&file, QCryptographicHash::Sha1),
+                QCryptographicHash::hash(data.mid(1), QCryptographicHash::Sha1));
+            QVERIFY(file.atEnd());
+        }
+
+        QBuffer buffer;
+        buffer.setData(data);
+        QVERIFY(buffer.open(QIODevice::ReadOnly));
+        QCOMPARE(FileHasher::hash(&buffer, QCryptographicHash::Sha1), expected);
+
+        QVERIFY(FileHasher::hashFile(fileName + QLatin1String(".missing"),
+            QCryptographicHash::Sha1).isEmpty());
+    }
+
+    void testFileHasherConcurrent()
+    {
+        QStringList fileNames;
+        QHash<QString, QByteArray> expected;
+        for (int i = 0; i < 16; ++i) {
+            const QByteArray data = testData((i % 2 ? 5 : 1) * 1024 * 1024 + i, char(i));
+            const QString fileName = createFile(data);
+            QVERIFY(!fileName.isEmpty());
+            fileNames.append(fileName);
+            expected.insert(fileName, QCryptographicHash::hash(data, QCryptographicHash::Sha1));
+        }
+        QCOMPARE(FileHasher::hashFiles(fileNames, QCryptographicHash::Sha1, 4), expected);
+
+        // calculateHash() used to share a single read buffer between all threads
+        QList<QFuture<bool>> futures;
+        for (const QString &fileName : qAsConst(fileNames)) {
+            futures.append(QtConcurrent::run([fileName, &expected]() {
+                return calculateHash(fileName, QCryptographicHash::Sha1) == expected.value(fileName);
+            }));
+        }
+        for (QFuture<bool> &future : futures)
+            QVERIFY(future.result());
+    }
+
+    void benchmarkFileHasher_data()
+    {
+        QTest::addColumn<bool>("batch");
+        QTest::newRow("serial") << false;
+        QTest::newRow("batch") << true;
+    }
+
+    void benchmarkFileHasher()
+    {
+        QFETCH(bool, batch);
+
+        QStringList fileNames;
+        for (int i = 0; i < 8; ++i)
+            fileNames.append(createFile(testData(8 * 1024 * 1024, char(i))));
+
+        QBENCHMARK {
+            if (batch) {
+                QCOMPARE(FileHasher::hashFiles(fileNames, QCryptographicHash::Sha1).count(), 8);
+            } else {
+                for (const QString &fileName : qAsConst(fileNames))
+                    QVERIFY(!FileHasher::hashFile(fileName, QCryptographicHash::Sha1).isEmpty());
+            }
+        }
+    }
+
     void testSetDefaultFilePermissions()
     {
 #if defined(Q_OS_WIN)
@@ -128,6 +247,9 @@ private slots:
         QVERIFY(testFile.remove());
 #endif
     }
+
+private:
+    QStringList m_files;
 };
 
 QTEST_MAIN(tst_fileutils)
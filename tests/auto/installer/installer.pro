@@ -43,7 +43,11 @@ SUBDIRS += \
     contentshaupdate \
     componentreplace \
     metadatacache \
-    contentsha1check
+    contentsha1check \
+    localpackagehub \
+    concurrentoperationrunner \
+    downloadarchivesjob \
+    undooperations
 
 CONFIG(libarchive) {
     SUBDIRS += libarchivearchive
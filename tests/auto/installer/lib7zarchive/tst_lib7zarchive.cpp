@@ -26,17 +26,68 @@
 **
 **************************************************************************/
 
+#include <lib7z_create.h>
+#include <lib7z_extract.h>
 #include <lib7z_facade.h>
 #include <lib7zarchive.h>
 #include <fileutils.h>
 
 #include <QDir>
+#include <QMutex>
 #include <QObject>
+#include <QSet>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTest>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
 
 using namespace QInstaller;
 
+class TestExtractCallback : public Lib7z::ExtractCallback
+{
+public:
+    QStringList files;
+    QList<quint64> progress;
+    quint64 total = 0;
+    unsigned long prepareDelay = 0;
+    bool cancel = false;
+    QAtomicInt globalPoolUsed = 0;
+    QSet<QThread *> threads;
+
+protected:
+    bool prepareForFile(const QString &filename) override
+    {
+        Q_UNUSED(filename)
+        if (QThreadPool::globalInstance()->activeThreadCount() > 0)
+            globalPoolUsed.fetchAndStoreRelaxed(1);
+        {
+            QMutexLocker _(&m_threadsMutex);
+            threads.insert(QThread::currentThread());
+        }
+        if (prepareDelay > 0)
+            QThread::msleep(prepareDelay);
+        return true;
+    }
+
+    void setCurrentFile(const QString &filename) override
+    {
+        files.append(filename);
+    }
+
+    HRESULT setCompleted(quint64 completed, quint64 total) override
+    {
+        progress.append(completed);
+        this->total = total;
+        return cancel ? E_ABORT : S_OK;
+    }
+
+private:
+    QMutex m_threadsMutex;
+};
+
 class tst_lib7zarchive : public QObject
 {
     Q_OBJECT
@@ -127,7 +178,139 @@ private slots:
         QVERIFY(QFile::remove(QDir::tempPath() + QString("/valid")));
     }
 
+    void testExtractMultiFolderArchive_data()
+    {
+        QTest::addColumn<int>("maxThreadCount");
+        QTest::newRow("Parallel") << 4;
+        QTest::newRow("Sequential") << 1;
+    }
+
+    void testExtractMultiFolderArchive()
+    {
+        QFETCH(int, maxThreadCount);
+
+        QTemporaryDir source;
+        QTemporaryDir target;
+        QVERIFY(source.isValid() && target.isValid());
+        const QString archiveName = createMultiFolderArchive(source.path());
+        QVERIFY(!archiveName.isEmpty());
+
+        QThreadPool threadPool;
+        threadPool.setMaxThreadCount(maxThreadCount);
+        TestExtractCallback callback;
+        callback.prepareDelay = 20; // creating the files is serialized, let other workers queue up
+        QFile archive(archiveName);
+        QVERIFY(archive.open(QIODevice::ReadOnly));
+        try {
+            Lib7z::extractArchive(&archive, target.path(), &callback, &threadPool);
+        } catch (const Lib7z::SevenZipException &e) {
+            QFAIL(qPrintable(e.message()));
+        }
+        // Threads reserved in the pool of the caller are released again
+        QCOMPARE(threadPool.activeThreadCount(), 0);
+
+        // The parallel path creates the files from several workers, the sequential one
+        // from the calling thread
+        if (maxThreadCount > 1) {
+            QVERIFY(!callback.threads.contains(QThread::currentThread()));
+            QVERIFY(callback.threads.count() > 1);
+        } else {
+            QCOMPARE(callback.threads, QSet<QThread *>() << QThread::currentThread());
+        }
+
+        QStringList expectedFiles;
+        for (int i = 0; i < scFolderCount; ++i) {
+            const QString fileName = target.filePath(QString::fromLatin1("folder%1.bin").arg(i));
+            expectedFiles.append(QFileInfo(fileName).absoluteFilePath());
+            QFile file(fileName);
+            QVERIFY(file.open(QIODevice::ReadOnly));
+            QVERIFY(file.readAll() == folderContent(i));
+        }
+        callback.files.sort();
+        QCOMPARE(callback.files, expectedFiles);
+
+        QVERIFY(!callback.progress.isEmpty());
+        QVERIFY(std::is_sorted(callback.progress.constBegin(), callback.progress.constEnd()));
+        QCOMPARE(callback.progress.last(), quint64(scFolderCount) * scFolderSize);
+        QCOMPARE(callback.total, quint64(scFolderCount) * scFolderSize);
+    }
+
+    void testExtractMultiFolderArchiveWithDecoderBudget()
+    {
+        QTemporaryDir source;
+        QTemporaryDir target;
+        QVERIFY(source.isValid() && target.isValid());
+        const QString archiveName = createMultiFolderArchive(source.path());
+        QVERIFY(!archiveName.isEmpty());
+
+        TestExtractCallback callback;
+        QFile archive(archiveName);
+        QVERIFY(archive.open(QIODevice::ReadOnly));
+        try {
+            Lib7z::extractArchive(&archive, target.path(), &callback);
+        } catch (const Lib7z::SevenZipException &e) {
+            QFAIL(qPrintable(e.message()));
+        }
+        // Without a pool of the caller, the threads of the global pool stay available
+        QCOMPARE(callback.globalPoolUsed.loadAcquire(), 0);
+        QCOMPARE(QDir(target.path()).entryList(QDir::Files).count(), scFolderCount);
+    }
+
+    void testCancelExtractMultiFolderArchive()
+    {
+        QTemporaryDir source;
+        QTemporaryDir target;
+        QVERIFY(source.isValid() && target.isValid());
+        const QString archiveName = createMultiFolderArchive(source.path());
+        QVERIFY(!archiveName.isEmpty());
+
+        QThreadPool threadPool;
+        threadPool.setMaxThreadCount(4);
+        TestExtractCallback callback;
+        callback.prepareDelay = 100; // creating the files is serialized, keep the workers busy
+        callback.cancel = true;
+        QFile archive(archiveName);
+        QVERIFY(archive.open(QIODevice::ReadOnly));
+        QVERIFY_EXCEPTION_THROWN(Lib7z::extractArchive(&archive, target.path(), &callback,
+            &threadPool), Lib7z::SevenZipException);
+        QCOMPARE(threadPool.activeThreadCount(), 0);
+
+        QVERIFY(!callback.progress.isEmpty());
+        QVERIFY(QDir(target.path()).entryList(QDir::Files).count() < scFolderCount);
+    }
+
 private:
+    static QByteArray folderContent(int folder)
+    {
+        QByteArray data(scFolderSize, Qt::Uninitialized);
+        for (int i = 0; i < data.size(); ++i)
+            data[i] = char((i / 4096 + folder * 31) % 251);
+        return data;
+    }
+
+    // Files stored without compression are put into a folder of their own each. The archive
+    // is large enough to be extracted with multiple threads.
+    QString createMultiFolderArchive(const QString &directory)
+    {
+        QStringList sources;
+        for (int i = 0; i < scFolderCount; ++i) {
+            QFile file(directory + QString::fromLatin1("/folder%1.bin").arg(i));
+            if (!file.open(QIODevice::WriteOnly))
+                return QString();
+            file.write(folderContent(i));
+            sources.append(file.fileName());
+        }
+
+        const QString archiveName = directory + QLatin1String("/multifolder.7z");
+        try {
+            Lib7z::createArchive(archiveName, sources, Lib7z::TmpFile::No, Lib7z::Compression::Non);
+        } catch (const Lib7z::SevenZipException &e) {
+            qWarning() << e.message();
+            return QString();
+        }
+        return archiveName;
+    }
+
     QString tempSourceFile(const QByteArray &data, const QString &templateName = QString())
     {
         QTemporaryFile source;
@@ -141,6 +324,9 @@ private:
     }
 
 private:
+    static const int scFolderCount = 6;
+    static const int scFolderSize = 3 * 1024 * 1024;
+
     ArchiveEntry m_file;
 };
 
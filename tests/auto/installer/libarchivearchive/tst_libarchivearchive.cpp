@@ -189,6 +189,31 @@ private slots:
         QVERIFY(QFile(QDir::tempPath() + QString("/valid")).remove());
     }
 
+    void testExtractArchiveFromMemory_data()
+    {
+        archiveFilenamesTestData();
+    }
+
+    void testExtractArchiveFromMemory()
+    {
+        QFETCH(QString, filename);
+
+        QFile file(filename);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        const QByteArray data = file.readAll();
+        file.close();
+
+        LibArchiveArchive source(QLatin1String("in-memory archive"));
+        source.setData(data);
+        QVERIFY(source.open(QIODevice::ReadOnly));
+        QCOMPARE(source.list().count(), 1);
+
+        QVERIFY(source.extract(QDir::tempPath()));
+        QCOMPARE(QFile::exists(QDir::tempPath() + QString("/valid")), true);
+        QVERIFY(QFile(QDir::tempPath() + QString("/valid")).remove());
+        source.close();
+    }
+
     void testCreateExtractWithSymlink_data()
     {
         archiveSuffixesTestData();
@@ -0,0 +1,241 @@
+/**************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include <fileutils.h>
+#include <localpackagehub.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTest>
+
+using namespace KDUpdater;
+using namespace QInstaller;
+
+class tst_LocalPackageHub : public QObject
+{
+    Q_OBJECT
+
+private:
+    void addPackage(LocalPackageHub &hub, const QString &name, const QString &version)
+    {
+        hub.addPackage(name, version, name, QPair<QString, bool>(), QLatin1String("Description"),
+            1, QStringList() << QLatin1String("dependency"), QStringList(), false, false, 1024,
+            QString(), true, false, QString());
+    }
+
+    // Detaches the hub from the file without writing it, like an application that crashed.
+    void abandon(LocalPackageHub &hub)
+    {
+        hub.setFileName(QString());
+    }
+
+    QByteArray readFile(const QString &fileName)
+    {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly))
+            return QByteArray();
+        return file.readAll();
+    }
+
+private slots:
+    void init()
+    {
+        m_dir = generateTemporaryFileName();
+        QVERIFY(QDir().mkpath(m_dir));
+        m_fileName = m_dir + QLatin1String("/components.xml");
+    }
+
+    void cleanup()
+    {
+        QDir(m_dir).removeRecursively();
+    }
+
+    void testWriteToDisk()
+    {
+        {
+            LocalPackageHub hub;
+            hub.setFileName(m_fileName);
+            hub.setApplicationName(QLatin1String("Application"));
+            addPackage(hub, QLatin1String("A"), QLatin1String("1.0"));
+            addPackage(hub, QLatin1String("B"), QLatin1String("2.0"));
+            hub.writeToDisk();
+        }
+        QVERIFY(QFile::exists(m_fileName));
+        QVERIFY(!QFile::exists(m_fileName + QLatin1String(".journal")));
+
+        LocalPackageHub hub;
+        hub.setFileName(m_fileName);
+        QCOMPARE(hub.error(), LocalPackageHub::NoError);
+        QCOMPARE(hub.applicationName(), QLatin1String("Application"));
+        QCOMPARE(hub.packageNames(), QStringList() << QLatin1String("A") << QLatin1String("B"));
+        QCOMPARE(hub.packageInfo(QLatin1String("B")).version, QLatin1String("2.0"));
+        QCOMPARE(hub.packageInfo(QLatin1String("B")).title, QLatin1String("B"));
+    }
+
+    void testJournalReadBack()
+    {
+        LocalPackageHub hub;
+        hub.setFileName(m_fileName);
+        QCOMPARE(hub.journalFileName(), m_fileName + QLatin1String(".journal"));
+
+        // the first change creates the file and starts the journal
+        addPackage(hub, QLatin1String("A"), QLatin1String("1.0"));
+        QVERIFY(hub.writeJournal());
+        QVERIFY(QFile::exists(m_fileName));
+        QVERIFY(QFile::exists(hub.journalFileName()));
+
+        const QByteArray xml = readFile(m_fileName);
+        addPackage(hub, QLatin1String("B"), QLatin1String("1.0"));
+        QVERIFY(hub.writeJournal());
+        addPackage(hub, QLatin1String("C"), QLatin1String("1.0"));
+        QVERIFY(hub.writeJournal());
+        QVERIFY(hub.removePackage(QLatin1String("A")));
+        hub.setApplicationVersion(QLatin1String("2.0"));
+        QVERIFY(hub.writeJournal());
+        // later changes only go to the journal
+        QCOMPARE(readFile(m_fileName), xml);
+
+        {
+            LocalPackageHub reader;
+            reader.setFileName(m_fileName);
+            QCOMPARE(reader.error(), LocalPackageHub::NoError);
+            QCOMPARE(reader.packageNames(), QStringList() << QLatin1String("B") << QLatin1String("C"));
+            QCOMPARE(reader.packageInfo(QLatin1String("C")).dependencies,
+                QStringList() << QLatin1String("dependency"));
+            QCOMPARE(reader.packageInfo(QLatin1String("C")).uncompressedSize, quint64(1024));
+            QCOMPARE(reader.applicationVersion(), QLatin1String("2.0"));
+            abandon(reader);
+        }
+
+        hub.writeToDisk();
+        QVERIFY(!QFile::exists(hub.journalFileName()));
+
+        LocalPackageHub reader;
+        reader.setFileName(m_fileName);
+        QCOMPARE(reader.packageNames(), QStringList() << QLatin1String("B") << QLatin1String("C"));
+        QCOMPARE(reader.applicationVersion(), QLatin1String("2.0"));
+    }
+
+    void testJournalClear()
+    {
+        LocalPackageHub hub;
+        hub.setFileName(m_fileName);
+        addPackage(hub, QLatin1String("A"), QLatin1String("1.0"));
+        QVERIFY(hub.writeJournal());
+        hub.clearPackageInfos();
+        addPackage(hub, QLatin1String("B"), QLatin1String("1.0"));
+        QVERIFY(hub.writeJournal());
+        abandon(hub);
+
+        LocalPackageHub reader;
+        reader.setFileName(m_fileName);
+        QCOMPARE(reader.packageNames(), QStringList() << QLatin1String("B"));
+    }
+
+    void testJournalCrashRecovery()
+    {
+        LocalPackageHub hub;
+        hub.setFileName(m_fileName);
+        addPackage(hub, QLatin1String("A"), QLatin1String("1.0"));
+        QVERIFY(hub.writeJournal());
+        addPackage(hub, QLatin1String("B"), QLatin1String("1.0"));
+        QVERIFY(hub.writeJournal());
+        const qint64 journalSize = QFileInfo(hub.journalFileName()).size();
+        addPackage(hub, QLatin1String("C"), QLatin1String("1.0"));
+        QVERIFY(hub.writeJournal());
+        abandon(hub);
+
+        // cut the last record in half, as if writing it was interrupted
+        QFile journal(m_fileName + QLatin1String(".journal"));
+        QVERIFY(journal.resize((journalSize + journal.size()) / 2));
+
+        LocalPackageHub reader;
+        reader.setFileName(m_fileName);
+        QCOMPARE(reader.error(), LocalPackageHub::NoError);
+        QCOMPARE(reader.packageNames(), QStringList() << QLatin1String("A") << QLatin1String("B"));
+
+        // the recovered state is written back and the damaged journal dropped
+        addPackage(reader, QLatin1String("D"), QLatin1String("1.0"));
+        reader.writeToDisk();
+        QVERIFY(!journal.exists());
+        reader.refresh();
+        QCOMPARE(reader.packageNames(), QStringList() << QLatin1String("A") << QLatin1String("B")
+            << QLatin1String("D"));
+    }
+
+    void testOutdatedJournal()
+    {
+        LocalPackageHub hub;
+        hub.setFileName(m_fileName);
+        addPackage(hub, QLatin1String("A"), QLatin1String("1.0"));
+        QVERIFY(hub.writeJournal());
+        addPackage(hub, QLatin1String("B"), QLatin1String("1.0"));
+        QVERIFY(hub.writeJournal());
+        abandon(hub);
+
+        // the file was rewritten by someone not knowing about the journal
+        QFile file(m_fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("<Packages>\n    <ApplicationName>Other</ApplicationName>\n</Packages>\n");
+        file.close();
+
+        LocalPackageHub reader;
+        reader.setFileName(m_fileName);
+        QCOMPARE(reader.error(), LocalPackageHub::NoError);
+        QCOMPARE(reader.applicationName(), QLatin1String("Other"));
+        QCOMPARE(reader.packageInfoCount(), 0);
+        abandon(reader);
+    }
+
+    void testJournalCompaction()
+    {
+        LocalPackageHub hub;
+        hub.setFileName(m_fileName);
+        for (int i = 0; i < 1000; ++i) {
+            addPackage(hub, QString::fromLatin1("package.%1").arg(i), QLatin1String("1.0"));
+            QVERIFY(hub.writeJournal());
+            // the journal never grows much beyond the compacted file
+            QVERIFY(QFileInfo(hub.journalFileName()).size()
+                <= qMax(QFileInfo(m_fileName).size(), qint64(64 * 1024)));
+        }
+        abandon(hub);
+
+        LocalPackageHub reader;
+        reader.setFileName(m_fileName);
+        QCOMPARE(reader.packageInfoCount(), 1000);
+    }
+
+private:
+    QString m_dir;
+    QString m_fileName;
+};
+
+QTEST_MAIN(tst_LocalPackageHub)
+
+#include "tst_localpackagehub.moc"
@@ -33,20 +33,48 @@
 #include <genericdatacache.h>
 #include <metadata.h>
 #include <repository.h>
+#include <updatesinfo_p.h>
 
+#include <QBuffer>
 #include <QCryptographicHash>
 #include <QDir>
 #include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QLocale>
 #include <QObject>
+#include <QSet>
+#include <QTemporaryDir>
 #include <QTest>
 
 using namespace QInstaller;
 
 static const QByteArray scPlaceholderSha1("placeholder_sha1");
 
+#ifdef Q_OS_LINUX
+// Returns the value of \a field of /proc/self/status in kB, or -1 if it cannot be read.
+static qint64 procStatusKb(const QByteArray &field)
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly))
+        return -1;
+    const QList<QByteArray> lines = status.readAll().split('\n');
+    for (const QByteArray &line : lines) {
+        if (line.startsWith(field + ':'))
+            return line.mid(field.size() + 1).simplified().split(' ').first().toLongLong();
+    }
+    return -1;
+}
+
+// Resets the peak resident set size (VmHWM) of the process to the current one.
+static bool resetPeakMemory()
+{
+    QFile clearRefs("/proc/self/clear_refs");
+    return clearRefs.open(QIODevice::WriteOnly) && clearRefs.write("5") == 1;
+}
+#endif
+
 class tst_metadatacache : public QObject
 {
     Q_OBJECT
@@ -305,6 +333,247 @@ private slots:
         QVERIFY(!QFileInfo::exists(m_cachePath));
     }
 
+    void testUpdatesIndex()
+    {
+        GenericDataCache<Metadata> cache(m_cachePath, "Metadata", "1.0.0");
+        Metadata *metadata = new Metadata(":/data/local-temp-repository/");
+
+        QVERIFY(cache.registerItem(metadata));
+        metadata = cache.itemByChecksum(m_newMetadataItemChecksum);
+        QVERIFY(metadata);
+
+        const QString updatesFile = metadata->path() + "/Updates.xml";
+        QVERIFY(!KDUpdater::UpdatesInfo::hasValidIndex(updatesFile));
+        QVERIFY(metadata->createUpdatesIndex());
+        QVERIFY(KDUpdater::UpdatesInfo::hasValidIndex(updatesFile));
+
+        KDUpdater::UpdatesInfo indexedInfo;
+        indexedInfo.setFileName(updatesFile);
+        indexedInfo.parseFile();
+        QVERIFY(indexedInfo.isValid());
+        QCOMPARE(indexedInfo.applicationName(), "{AnyApplication}");
+        QCOMPARE(indexedInfo.updateInfoCount(), 1);
+
+        const KDUpdater::UpdateInfo info = indexedInfo.updateInfo(0);
+        QCOMPARE(info.data.value("Name").toString(), "A");
+        QCOMPARE(info.data.value("Version").toString(), "1.0.2-1");
+        QCOMPARE(info.data.value("SHA1").toString(), "f46c677db8bc779d70d0c72fae264a321caea6f8");
+        QVERIFY(info.data.value("Licenses").toHash().contains("Example license"));
+
+        // Localized elements are resolved when writing the index, other locales must not use it
+        const QLocale defaultLocale;
+        QLocale::setDefault(QLocale(defaultLocale.language() == QLocale::German
+            ? QLocale::French : QLocale::German));
+        const bool validForOtherLocale = KDUpdater::UpdatesInfo::hasValidIndex(updatesFile);
+        QLocale::setDefault(defaultLocale);
+        QVERIFY(!validForOtherLocale);
+        QVERIFY(KDUpdater::UpdatesInfo::hasValidIndex(updatesFile));
+
+        // Modifying Updates.xml makes the index stale, the XML document is parsed instead
+        QFile file(updatesFile);
+        QVERIFY(file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner));
+        QVERIFY(file.open(QIODevice::Append));
+        QVERIFY(file.write("\n") == 1);
+        file.close();
+        QVERIFY(!KDUpdater::UpdatesInfo::hasValidIndex(updatesFile));
+
+        KDUpdater::UpdatesInfo parsedInfo;
+        parsedInfo.setFileName(updatesFile);
+        parsedInfo.parseFile();
+        QVERIFY(parsedInfo.isValid());
+        QCOMPARE(parsedInfo.updateInfoCount(), 1);
+        QCOMPARE(parsedInfo.updateInfo(0).data.value("Name").toString(), "A");
+
+        QVERIFY(cache.clear());
+        QVERIFY(!QFileInfo::exists(m_cachePath));
+    }
+
+    void testUpdateRecord()
+    {
+        KDUpdater::UpdateRecord first;
+        first.insert("Name", QString("A"));
+        first.insert("Version", QString("1.0.0"));
+        first.insert("Description", QString("Example component A"));
+        first.insert("TreeName", QVariant::fromValue(qMakePair(QString("root.A"), true)));
+        first.insert("CustomElement", QString("custom"));
+
+        QCOMPARE(first.count(), 5);
+        QCOMPARE(first.name(), "A");
+        QCOMPARE(first.version(), "1.0.0");
+        QCOMPARE(first.value("Description").toString(), "Example component A");
+        QCOMPARE(first.value("CustomElement").toString(), "custom");
+        QCOMPARE(first.value("TreeName").value<QPair<QString, bool>>().first, "root.A");
+        QCOMPARE(first.value("Virtual", "false").toString(), "false");
+        QVERIFY(first.contains("Version"));
+        QVERIFY(first.contains("TreeName"));
+        QVERIFY(!first.contains("Virtual"));
+
+        QStringList keys = first.keys();
+        keys.sort();
+        QCOMPARE(keys, QStringList() << "CustomElement" << "Description" << "Name" << "TreeName" << "Version");
+
+        // Versions are shared between records using the same string pool, free text is not
+        KDUpdater::UpdateRecord second;
+        second.insert("Version", QString("1.0.") + QString::number(0));
+        second.insert("Description", QString("Example component ") + QString("A"));
+        QVERIFY(second.version().constData() != first.version().constData());
+
+        QSet<QString> stringPool;
+        first.shareStrings(&stringPool);
+        second.shareStrings(&stringPool);
+        QCOMPARE(stringPool.count(), 2);
+        QCOMPARE(second.version(), first.version());
+        QCOMPARE(second.version().constData(), first.version().constData());
+        QVERIFY(second.value("Description").toString().constData()
+            != first.value("Description").toString().constData());
+    }
+
+    void testSharedStringsMemory()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString updatesFile = dir.filePath("Updates.xml");
+
+        const int packageCount = 1000;
+        QByteArray data("<Updates>\n <ApplicationName>{AnyApplication}</ApplicationName>\n"
+            " <ApplicationVersion>1.0.0</ApplicationVersion>\n");
+        for (int i = 0; i < packageCount; ++i) {
+            data += QString::fromLatin1(" <PackageUpdate>\n  <Name>component.%1</Name>\n"
+                "  <DisplayName>Component %1</DisplayName>\n  <Version>1.0.0-1</Version>\n"
+                "  <ReleaseDate>2023-01-01</ReleaseDate>\n  <Default>false</Default>\n"
+                "  <Dependencies>component.base, component.runtime</Dependencies>\n"
+                "  <DownloadableArchives>content.7z</DownloadableArchives>\n"
+                " </PackageUpdate>\n").arg(i).toLatin1();
+        }
+        data += "</Updates>\n";
+        QFile file(updatesFile);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(data), qint64(data.size()));
+        file.close();
+
+        // Measures the string data allocated for the package values, counting shared strings once
+        const auto measure = [](const QList<KDUpdater::UpdateInfo> &infos,
+                QSet<const QChar *> *allocations) {
+            qint64 total = 0;
+            qint64 allocated = 0;
+            for (const KDUpdater::UpdateInfo &info : infos) {
+                for (const QString &key : info.data.keys()) {
+                    const QVariant value = info.data.value(key);
+                    if (value.userType() != QMetaType::QString)
+                        continue;
+                    const QString string = value.toString();
+                    const qint64 bytes = string.size() * qint64(sizeof(QChar));
+                    total += bytes;
+                    if (!allocations->contains(string.constData())) {
+                        allocations->insert(string.constData());
+                        allocated += bytes;
+                    }
+                }
+            }
+            return qMakePair(total, allocated);
+        };
+
+        KDUpdater::UpdatesInfo first;
+        first.setFileName(updatesFile);
+        first.parseFile();
+        QVERIFY(first.isValid());
+        QCOMPARE(first.updateInfoCount(), packageCount);
+
+        QSet<const QChar *> allocations;
+        const QPair<qint64, qint64> firstBytes = measure(first.updatesInfo(), &allocations);
+        qDebug() << "String data of" << packageCount << "packages without sharing:"
+            << firstBytes.first << "bytes, with sharing:" << firstBytes.second << "bytes";
+        QVERIFY(firstBytes.second * 2 < firstBytes.first);
+
+        // The string pool is scoped to a single parse, another parse allocates its own strings
+        KDUpdater::UpdatesInfo second;
+        second.setFileName(updatesFile);
+        second.parseFile();
+        QVERIFY(second.isValid());
+        const QPair<qint64, qint64> secondBytes = measure(second.updatesInfo(), &allocations);
+        QCOMPARE(secondBytes, firstBytes);
+    }
+
+    void testReadUpdates()
+    {
+        Metadata metadata(":/data/local-temp-repository/");
+        Metadata::UpdatesRecord updates;
+        QString error;
+        QVERIFY2(metadata.readUpdates(&updates, &error), qPrintable(error));
+
+        QVERIFY(!updates.checksum);
+        QVERIFY(updates.sha1.isEmpty());
+        QVERIFY(updates.metadataName.isEmpty());
+        QVERIFY(updates.repositoryActions.isEmpty());
+        QCOMPARE(updates.packages.count(), 1);
+        QCOMPARE(updates.packages.first().name, "A");
+        QCOMPARE(updates.packages.first().version, "1.0.2-1");
+        QCOMPARE(updates.packages.first().sha1, "f46c677db8bc779d70d0c72fae264a321caea6f8");
+        QVERIFY(updates.packages.first().hasMetaElements);
+
+        QBuffer invalid;
+        invalid.setData("<Updates><PackageUpdate><Name>A</Name></Updates>");
+        QVERIFY(invalid.open(QIODevice::ReadOnly));
+        Metadata::UpdatesRecord invalidUpdates;
+        QVERIFY(!Metadata::readUpdates(&invalid, &invalidUpdates, &error));
+        QVERIFY(!error.isEmpty());
+    }
+
+    void benchmarkReadUpdates_data()
+    {
+        QTest::addColumn<bool>("streaming");
+        QTest::newRow("QXmlStreamReader") << true;
+        QTest::newRow("QDomDocument") << false;
+    }
+
+    void benchmarkReadUpdates()
+    {
+        QFETCH(bool, streaming);
+
+        QByteArray data("<Updates>\n <ApplicationName>{AnyApplication}</ApplicationName>\n"
+            " <ApplicationVersion>1.0.0</ApplicationVersion>\n <Checksum>true</Checksum>\n");
+        for (int i = 0; i < 20000; ++i) {
+            data += QString::fromLatin1(" <PackageUpdate>\n  <Name>component.%1</Name>\n"
+                "  <DisplayName>Component %1</DisplayName>\n  <Description>Description %1</Description>\n"
+                "  <Version>1.0.%1</Version>\n  <ReleaseDate>2022-01-01</ReleaseDate>\n"
+                "  <Dependencies>component.%2</Dependencies>\n  <Script>installscript.qs</Script>\n"
+                "  <DownloadableArchives>content.7z</DownloadableArchives>\n"
+                "  <UpdateFile CompressedSize=\"1024\" OS=\"Any\" UncompressedSize=\"4096\"/>\n"
+                "  <SHA1>f46c677db8bc779d70d0c72fae264a321caea6f8</SHA1>\n </PackageUpdate>\n")
+                .arg(i).arg(i + 1).toLatin1();
+        }
+        data += "</Updates>\n";
+
+        QBuffer buffer(&data);
+        QVERIFY(buffer.open(QIODevice::ReadOnly));
+        const auto parse = [&buffer, streaming]() -> int {
+            buffer.seek(0);
+            if (streaming) {
+                Metadata::UpdatesRecord updates;
+                return Metadata::readUpdates(&buffer, &updates) ? updates.packages.count() : -1;
+            }
+            QDomDocument doc;
+            return doc.setContent(&buffer)
+                ? doc.documentElement().elementsByTagName("PackageUpdate").count() : -1;
+        };
+
+#ifdef Q_OS_LINUX
+        if (resetPeakMemory()) {
+            const qint64 before = procStatusKb("VmRSS");
+            QCOMPARE(parse(), 20000);
+            const qint64 peak = procStatusKb("VmHWM");
+            QVERIFY(before >= 0 && peak >= before);
+            qDebug() << "Peak memory while parsing 20000 packages:" << (peak - before) << "kB";
+        } else {
+            qDebug() << "Cannot reset the peak memory of the process, it is not recorded.";
+        }
+#endif
+
+        QBENCHMARK {
+            QCOMPARE(parse(), 20000);
+        }
+    }
+
     void testRetrieveItemFails()
     {
         GenericDataCache<Metadata> cache(m_cachePath, "Metadata", "1.0.0");
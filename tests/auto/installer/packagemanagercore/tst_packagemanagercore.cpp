@@ -34,9 +34,11 @@
 #include <progresscoordinator.h>
 #include <init.h>
 #include <settings.h>
+#include <sysinfo.h>
 
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QTemporaryFile>
 #include <QTest>
 #include <QRegularExpression>
@@ -333,6 +335,68 @@ private slots:
         QVERIFY(QDir().rmdir(testDirectory));
     }
 
+    void testIsProcessRunning()
+    {
+        #ifdef Q_OS_MACOS
+            QSKIP("Running processes are not listed on macOS.");
+        #endif
+        PackageManagerCore core;
+        const QFileInfo application(QCoreApplication::applicationFilePath());
+        QVERIFY(core.isProcessRunning(application.absoluteFilePath()));
+        QVERIFY(core.isProcessRunning(application.fileName()));
+        QVERIFY(core.isProcessRunning(application.baseName()));
+        QVERIFY(!core.isProcessRunning(QLatin1String("no-such-process-is-running")));
+        QVERIFY(!core.isProcessRunning(QString()));
+
+        const KDUpdater::ProcessIndex index;
+        const QList<KDUpdater::ProcessInfo> processes
+            = index.processesInDirectory(application.absolutePath());
+        bool found = false;
+        for (const KDUpdater::ProcessInfo &process : processes)
+            found |= QFileInfo(process.name) == application;
+        QVERIFY(found);
+        QVERIFY(index.processesInDirectory(application.absolutePath() + QLatin1String("_")).isEmpty());
+    }
+
+    void benchmarkIsProcessRunning_data()
+    {
+        QTest::addColumn<bool>("indexed");
+        QTest::newRow("linear") << false;
+        QTest::newRow("indexed") << true;
+    }
+
+    void benchmarkIsProcessRunning()
+    {
+        QFETCH(bool, indexed);
+
+        QStringList names;
+        for (int i = 0; i < 500; ++i)
+            names.append(QString::fromLatin1("/opt/application/bin/tool%1").arg(i));
+        names.append(QCoreApplication::applicationFilePath());
+
+        QBENCHMARK {
+            const QList<KDUpdater::ProcessInfo> processes = KDUpdater::runningProcesses();
+            int running = 0;
+            if (indexed) {
+                const KDUpdater::ProcessIndex index(processes);
+                for (const QString &name : qAsConst(names))
+                    running += index.contains(name);
+                QCOMPARE(running, 1);
+            } else {
+                for (const QString &name : qAsConst(names)) {
+                    for (const KDUpdater::ProcessInfo &process : processes) {
+                        const QFileInfo fi(process.name);
+                        if (process.name == name || fi.fileName() == name || fi.baseName() == name) {
+                            ++running;
+                            break;
+                        }
+                    }
+                }
+            }
+            Q_UNUSED(running)
+        }
+    }
+
     void testCoreDataValues()
     {
         QHash<QString, QString> userValues;
@@ -391,6 +455,36 @@ private slots:
         QCOMPARE(core.fromNativeSeparators(path), path);
 #endif
     }
+
+    void testVersionMatches_data()
+    {
+        QTest::addColumn<QString>("version");
+        QTest::addColumn<QString>("requirement");
+        QTest::addColumn<bool>("matches");
+        QTest::newRow("Plain equal") << "1.0.1" << "1.0.1" << true;
+        QTest::newRow("Plain not equal") << "1.0.2" << "1.0.1" << false;
+        QTest::newRow("Equal") << "1.0.1" << "=1.0.1" << true;
+        QTest::newRow("Equal by value") << "1.0.01" << "=1.0.1" << false;
+        QTest::newRow("Greater or equal, equal") << "1.0.1" << ">=1.0.1" << true;
+        QTest::newRow("Greater or equal, greater") << "1.10" << ">=1.9" << true;
+        QTest::newRow("Greater or equal, less") << "1.0.0" << ">=1.0.1" << false;
+        QTest::newRow("Greater, equal") << "1.0.1" << ">1.0.1" << false;
+        QTest::newRow("Greater, greater") << "1.0.1-2" << ">1.0.1-1" << true;
+        QTest::newRow("Less, less") << "1.0" << "<1.0.1" << true;
+        QTest::newRow("Less, greater") << "2.0" << "<1.0.1" << false;
+        QTest::newRow("Less or equal, equal") << "1.0.1" << "<=1.0.1" << true;
+    }
+
+    void testVersionMatches()
+    {
+        QFETCH(QString, version);
+        QFETCH(QString, requirement);
+        QFETCH(bool, matches);
+
+        // The second call uses the cached requirement
+        QCOMPARE(PackageManagerCore::versionMatches(version, requirement), matches);
+        QCOMPARE(PackageManagerCore::versionMatches(version, requirement), matches);
+    }
 };
 
 
@@ -33,6 +33,9 @@
 #include <packagemanagercore.h>
 #include <packagemanagergui.h>
 #include <scriptengine.h>
+#include <settings.h>
+#include <update.h>
+#include <updatesinfo_p.h>
 
 #include <../unicodeexecutable/stringdata.h>
 
@@ -40,6 +43,7 @@
 #include <QSet>
 #include <QFile>
 #include <QString>
+#include <QTemporaryDir>
 
 using namespace QInstaller;
 
@@ -652,7 +656,151 @@ private slots:
         }
     }
 
+    void testLoadComponentScriptsOnDemand()
+    {
+        QTemporaryDir repository;
+        QVERIFY(repository.isValid());
+        writeComponentScript(repository.path(), "A", 0);
+        writeComponentScript(repository.path(), "B", 0);
+
+        PackageManagerCore core;
+        core.settings().setLoadComponentScriptsOnDemand(true);
+        Component *a = createScriptedComponent(&core, repository.path(), "A");
+        Component *b = createScriptedComponent(&core, repository.path(), "B");
+        const QList<Component *> components = { a, b };
+
+        QVERIFY(core.loadComponentScripts(components));
+        QVERIFY(a->isComponentScriptPending());
+        QVERIFY(b->isComponentScriptPending());
+        QVERIFY(a->value("Loaded").isEmpty());
+
+        // A language change does not load deferred scripts
+        a->languageChanged();
+        QVERIFY(a->isComponentScriptPending());
+        QVERIFY(a->value("Loaded").isEmpty());
+
+        // Calling a script method loads the script first
+        a->beginInstallation();
+        QVERIFY(!a->isComponentScriptPending());
+        QCOMPARE(a->value("Loaded"), QLatin1String("true"));
+        QVERIFY(b->isComponentScriptPending());
+
+        // Selecting a component loads its script
+        b->setCheckState(Qt::Checked);
+        QVERIFY(core.calculateComponentsToInstall());
+        QVERIFY(!b->isComponentScriptPending());
+        QCOMPARE(b->value("Loaded"), QLatin1String("true"));
+    }
+
+    void testLoadComponentScriptsOnDemandAddingDependencies()
+    {
+        QTemporaryDir repository;
+        QVERIFY(repository.isValid());
+        writeComponentScript(repository.path(), "A", 0, "    component.addDependency(\"B\");\n");
+        writeComponentScript(repository.path(), "B", 0, "    component.addDependency(\"C\");\n");
+        writeComponentScript(repository.path(), "C", 0);
+        writeComponentScript(repository.path(), "D", 0, "    throw \"Broken component script\";\n");
+
+        PackageManagerCore core;
+        core.autoRejectMessageBoxes();
+        core.settings().setLoadComponentScriptsOnDemand(true);
+        Component *a = createScriptedComponent(&core, repository.path(), "A");
+        Component *b = createScriptedComponent(&core, repository.path(), "B");
+        Component *c = createScriptedComponent(&core, repository.path(), "C");
+        Component *d = createScriptedComponent(&core, repository.path(), "D");
+        QVERIFY(core.loadComponentScripts({ a, b, c, d }));
+
+        // Dependencies added by deferred scripts are resolved, and their scripts loaded in turn
+        a->setCheckState(Qt::Checked);
+        QVERIFY(core.calculateComponentsToInstall());
+        QCOMPARE(a->dependencies(), QStringList() << "B");
+        QCOMPARE(c->value("Loaded"), QLatin1String("true"));
+        QCOMPARE(core.orderedComponentsToInstall(), QList<Component *>() << c << b << a);
+        QVERIFY(d->isComponentScriptPending());
+
+        // A script failing to load makes the calculation fail
+        d->setCheckState(Qt::Checked);
+        QVERIFY(!core.calculateComponentsToInstall());
+        QCOMPARE(core.status(), PackageManagerCore::Failure);
+        QVERIFY(core.error().contains("Broken component script"));
+    }
+
+    void benchmarkLoadComponentScripts_data()
+    {
+        QTest::addColumn<bool>("onDemand");
+        QTest::addColumn<int>("componentCount");
+        for (const int componentCount : { 50, 200, 500 }) {
+            QTest::addRow("Eager, %d components", componentCount) << false << componentCount;
+            QTest::addRow("On demand, %d components", componentCount) << true << componentCount;
+        }
+    }
+
+    void benchmarkLoadComponentScripts()
+    {
+        QFETCH(bool, onDemand);
+        QFETCH(int, componentCount);
+
+        QTemporaryDir repository;
+        QVERIFY(repository.isValid());
+        for (int i = 0; i < componentCount; ++i)
+            writeComponentScript(repository.path(), QString::fromLatin1("component%1").arg(i), 50);
+
+        QBENCHMARK {
+            PackageManagerCore core;
+            core.settings().setLoadComponentScriptsOnDemand(onDemand);
+            QList<Component *> components;
+            for (int i = 0; i < componentCount; ++i) {
+                components.append(createScriptedComponent(&core, repository.path(),
+                    QString::fromLatin1("component%1").arg(i)));
+            }
+            QVERIFY(core.loadComponentScripts(components));
+
+            // The user selects a handful of components
+            for (int i = 0; i < 10; ++i)
+                components.at(i)->setCheckState(Qt::Checked);
+            QVERIFY(core.calculateComponentsToInstall());
+            QCOMPARE(components.first()->value("Loaded"), QLatin1String("true"));
+        }
+    }
+
 private:
+    void writeComponentScript(const QString &repository, const QString &name, int functionCount,
+        const QByteArray &constructor = QByteArray())
+    {
+        QVERIFY(QDir(repository).mkpath(name));
+        QFile file(repository + QLatin1Char('/') + name + QLatin1String("/installscript.qs"));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+
+        QByteArray script("function Component()\n{\n    component.setValue(\"Loaded\", \"true\");\n"
+            + constructor + "}\n\n"
+            "Component.prototype.createOperations = function()\n{\n    component.createOperations();\n}\n");
+        for (int i = 0; i < functionCount; ++i) {
+            script += QString::fromLatin1("\nComponent.prototype.helper%1 = function(value)\n{\n"
+                "    var result = [];\n    for (var i = 0; i < value; ++i)\n"
+                "        result.push(installer.value(\"TargetDir\") + \"/%1/\" + i);\n"
+                "    return result.join(\";\");\n}\n").arg(i).toLatin1();
+        }
+        QVERIFY(file.write(script) == script.size());
+    }
+
+    Component *createScriptedComponent(PackageManagerCore *core, const QString &repository,
+        const QString &name)
+    {
+        KDUpdater::UpdateInfo info;
+        info.data.insert(scName, name);
+        info.data.insert(scVersion, QLatin1String("1.0.0"));
+        QHash<QString, QVariant> scripts;
+        scripts.insert(scInstallScript, QLatin1String("installscript.qs"));
+        info.data.insert(scScriptTag, scripts);
+
+        Component *component = new Component(core);
+        component->loadDataFromPackage(KDUpdater::Update(PackageSource(QUrl::fromLocalFile(repository), 0),
+            info, KDUpdater::VersionKey(info.data.version())));
+        // the core becomes the owner of the component and deletes it in the destructor
+        core->appendRootComponent(component);
+        return component;
+    }
+
     void setExpectedScriptOutput(const char *message)
     {
         // Using setExpectedScriptOutput(...); inside the test method
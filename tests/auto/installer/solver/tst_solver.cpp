@@ -380,6 +380,62 @@ private slots:
             QCOMPARE(result, expectedResult.value(component));
         }
     }
+
+    void dependees()
+    {
+        PackageManagerCore core;
+        core.setPackageManager();
+
+        NamedComponent *componentA = new NamedComponent(&core, QLatin1String("A"), QLatin1String("1.0.0"));
+        NamedComponent *componentB = new NamedComponent(&core, QLatin1String("B"));
+        NamedComponent *componentC = new NamedComponent(&core, QLatin1String("C"));
+        componentB->addDependency(QLatin1String("A->=1.0.0"));
+        componentC->addDependency(QLatin1String("A-2.0.0"));
+        core.appendRootComponent(componentA);
+        core.appendRootComponent(componentB);
+        core.appendRootComponent(componentC);
+
+        QCOMPARE(core.dependees(componentA), QList<Component *>() << componentB);
+        QCOMPARE(core.dependees(componentB), QList<Component *>());
+
+        // Changed dependencies need to be reflected in subsequent lookups
+        componentC->setValue(scDependencies, QLatin1String("A"));
+        QCOMPARE(core.dependees(componentA), QList<Component *>() << componentB << componentC);
+
+        NamedComponent *componentD = new NamedComponent(&core, QLatin1String("D"));
+        componentD->addDependency(QLatin1String("B"));
+        componentC->appendComponent(componentD);
+        QCOMPARE(core.dependees(componentB), QList<Component *>() << componentD);
+    }
+
+    void dependeesBenchmark()
+    {
+        static const int componentCount = 10000;
+
+        PackageManagerCore core;
+        core.setPackageManager();
+
+        QList<Component *> components;
+        NamedComponent *base = new NamedComponent(&core, QLatin1String("base"));
+        core.appendRootComponent(base);
+        components.append(base);
+        for (int i = 1; i < componentCount; ++i) {
+            NamedComponent *component = new NamedComponent(&core,
+                QString::fromLatin1("component%1").arg(i));
+            component->addDependency(QLatin1String("base->=1.0.0"));
+            if (i > 1)
+                component->addDependency(components.last()->name());
+            core.appendRootComponent(component);
+            components.append(component);
+        }
+
+        QCOMPARE(core.dependees(base).count(), componentCount - 1);
+
+        QBENCHMARK {
+            for (Component *component : qAsConst(components))
+                core.dependees(component);
+        }
+    }
 };
 
 QTEST_MAIN(tst_Solver)
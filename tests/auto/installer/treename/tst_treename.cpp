@@ -31,10 +31,13 @@
 #include <packagemanagercore.h>
 #include <component.h>
 #include <componentmodel.h>
+#include <packagequery.h>
 
 #include <QTest>
 #include <QRegularExpression>
 
+#include <functional>
+
 class tst_TreeName : public QObject
 {
     Q_OBJECT
@@ -61,6 +64,9 @@ private slots:
 
     void remotePackageConflictsLocal();
 
+    void searchMatchesComponentModel_data();
+    void searchMatchesComponentModel();
+
     void init();
     void cleanup();
 
@@ -440,6 +446,52 @@ void tst_TreeName::remotePackageConflictsLocal()
     QVERIFY(QFile::remove(packageHubFile));
 }
 
+void tst_TreeName::searchMatchesComponentModel_data()
+{
+    QTest::addColumn<QString>("repository");
+    QTest::addColumn<bool>("allowUnstableComponents");
+
+    QTest::newRow("Tree names") << ":///data/repository" << false;
+    QTest::newRow("Tree names moving children") << ":///data/repository_children" << false;
+    QTest::newRow("Conflicts, unstable components") << ":///data/invalid_repository" << true;
+    QTest::newRow("Conflicts, no unstable components") << ":///data/invalid_repository" << false;
+}
+
+void tst_TreeName::searchMatchesComponentModel()
+{
+    // Searching packages from the metadata must list what the component tree shows
+    QFETCH(QString, repository);
+    QFETCH(bool, allowUnstableComponents);
+
+    QScopedPointer<PackageManagerCore> core(PackageManager::getPackageManagerWithInit
+            (m_installDir, repository));
+    core->settings().setAllowUnstableComponents(allowUnstableComponents);
+    QVERIFY(core->fetchRemotePackagesTree());
+
+    ComponentModel model(1, core.data());
+    model.reset(core->components(PackageManagerCore::ComponentType::Root));
+    QStringList modelComponents;
+    std::function<void(const QModelIndex &)> collectComponents = [&](const QModelIndex &parent) {
+        for (int row = 0; row < model.rowCount(parent); ++row) {
+            const QModelIndex index = model.index(row, 0, parent);
+            modelComponents.append(model.componentFromIndex(index)->name());
+            collectComponents(index);
+        }
+    };
+    collectComponents(QModelIndex());
+
+    PackageQuery::SelectOptions options = PackageQuery::HideReplacedComponents;
+    if (allowUnstableComponents)
+        options |= PackageQuery::AllowUnstableComponents;
+    QStringList selectedPackages;
+    foreach (const Package *package, PackageQuery().select(core->remotePackages(), options))
+        selectedPackages.append(package->data(scName).toString());
+
+    modelComponents.sort();
+    selectedPackages.sort();
+    QCOMPARE(selectedPackages, modelComponents);
+}
+
 void tst_TreeName::init()
 {
     m_installDir = QInstaller::generateTemporaryFileName();
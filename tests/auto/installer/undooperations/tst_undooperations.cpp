@@ -0,0 +1,294 @@
+/**************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "../shared/packagemanager.h"
+
+#include <extractarchiveoperation.h>
+#include <messageboxhandler.h>
+#include <updateoperation.h>
+#include <updateoperationfactory.h>
+
+#include <QDir>
+#include <QMessageBox>
+#include <QMutex>
+#include <QTest>
+#include <QThread>
+
+using namespace KDUpdater;
+using namespace QInstaller;
+
+struct UndoLog
+{
+    void clear()
+    {
+        QMutexLocker _(&mutex);
+        events.clear();
+        undoCount.clear();
+        failingUndos.clear();
+    }
+
+    bool record(const QString &id)
+    {
+        {
+            QMutexLocker _(&mutex);
+            events.append(QLatin1String("start ") + id);
+            ++undoCount[id];
+        }
+
+        // Give operations of the same batch time to overlap
+        QThread::msleep(100);
+
+        QMutexLocker _(&mutex);
+        events.append(QLatin1String("end ") + id);
+        if (failingUndos.value(id) > 0) {
+            --failingUndos[id];
+            return false;
+        }
+        return true;
+    }
+
+    QMutex mutex;
+    QStringList events;
+    QHash<QString, int> undoCount;
+    QHash<QString, int> failingUndos;
+};
+
+static UndoLog undoLog;
+
+class RecordingOperation : public UpdateOperation
+{
+public:
+    explicit RecordingOperation(PackageManagerCore *core)
+        : UpdateOperation(core)
+    {}
+
+    void backup() override {}
+    bool performOperation() override { return true; }
+    bool testOperation() override { return true; }
+
+    bool undoOperation() override
+    {
+        const QString id = arguments().value(0);
+        if (!undoLog.record(id)) {
+            setError(UserDefinedError, QString::fromLatin1("Cannot undo %1.").arg(id));
+            return false;
+        }
+        return true;
+    }
+};
+
+// Batched like an Extract operation, by the files listed after the identifier
+class UnpackRecordingOperation : public ExtractArchiveOperation
+{
+public:
+    explicit UnpackRecordingOperation(PackageManagerCore *core)
+        : ExtractArchiveOperation(core)
+    {
+        setName(QLatin1String("UnpackRecorder"));
+    }
+
+    void backup() override {}
+    bool testOperation() override { return true; }
+
+    bool performOperation() override
+    {
+        setValue(QLatin1String("files"), arguments().mid(1));
+        return true;
+    }
+
+    bool undoOperation() override
+    {
+        const QString id = arguments().value(0);
+        if (!undoLog.record(id)) {
+            setError(UserDefinedError, QString::fromLatin1("Cannot undo %1.").arg(id));
+            return false;
+        }
+        return true;
+    }
+};
+
+class CopyRecordingOperation : public RecordingOperation
+{
+public:
+    explicit CopyRecordingOperation(PackageManagerCore *core)
+        : RecordingOperation(core)
+    {
+        setName(QLatin1String("Copy"));
+    }
+};
+
+class SequentialRecordingOperation : public RecordingOperation
+{
+public:
+    explicit SequentialRecordingOperation(PackageManagerCore *core)
+        : RecordingOperation(core)
+    {
+        setName(QLatin1String("SequentialRecorder"));
+    }
+};
+
+class tst_UndoOperations : public QObject
+{
+    Q_OBJECT
+
+private:
+    int eventIndex(const QString &event, int from = 0) const
+    {
+        const int index = undoLog.events.indexOf(event, from);
+        if (index < 0)
+            qWarning() << "Missing undo event" << event << "in" << undoLog.events;
+        return index;
+    }
+
+    void installAndUninstall()
+    {
+        QScopedPointer<PackageManagerCore> core(PackageManager::getPackageManagerWithInit
+            (m_testDirectory, ":///data/repository"));
+        QCOMPARE(core->installDefaultComponentsSilently(), PackageManagerCore::Success);
+        QVERIFY(undoLog.events.isEmpty());
+
+        core->setPackageManager();
+        core->commitSessionOperations();
+        QCOMPARE(core->uninstallComponentsSilently(QStringList() << "A"), PackageManagerCore::Success);
+    }
+
+private slots:
+    void initTestCase()
+    {
+        UpdateOperationFactory &factory = UpdateOperationFactory::instance();
+        factory.registerUpdateOperation<UnpackRecordingOperation>(QLatin1String("UnpackRecorder"));
+        factory.registerUpdateOperation<SequentialRecordingOperation>(QLatin1String("SequentialRecorder"));
+        // Replaces the built-in copy operation, its undo steps are batched by destination
+        factory.registerUpdateOperation<CopyRecordingOperation>(QLatin1String("Copy"));
+
+        // Fixed thread count, so that batched undo steps always run side by side
+        PackageManagerCore::setMaxConcurrentOperations(2);
+    }
+
+    void init()
+    {
+        undoLog.clear();
+        m_testDirectory = QInstaller::generateTemporaryFileName();
+        QVERIFY(QDir().mkpath(m_testDirectory));
+    }
+
+    void cleanup()
+    {
+        QVERIFY(QDir(m_testDirectory).removeRecursively());
+    }
+
+    void cleanupTestCase()
+    {
+        PackageManagerCore::setMaxConcurrentOperations(0);
+    }
+
+    void testBatchesAreConsecutiveRuns()
+    {
+        installAndUninstall();
+
+        for (const QString &id : m_operationIds)
+            QCOMPARE(undoLog.undoCount.value(id), 1);
+
+        // The unpack operations are performed first, so the operations were performed as
+        // U0 U1 U2 C1 C2 S1 C3 C4. Undoing them in reverse order gives the batches C4 C3,
+        // S1 on its own, C2 C1, U2 U1 and U0, which shares a directory with U1.
+        QVERIFY(eventIndex("start C3") < eventIndex("end C4"));
+        QVERIFY(eventIndex("start C4") < eventIndex("end C3"));
+        QVERIFY(eventIndex("start C1") < eventIndex("end C2"));
+        QVERIFY(eventIndex("start C2") < eventIndex("end C1"));
+        QVERIFY(eventIndex("start U1") < eventIndex("end U2"));
+        QVERIFY(eventIndex("start U2") < eventIndex("end U1"));
+
+        // The sequential operation ends one batch and starts the next one
+        const int startS1 = eventIndex("start S1");
+        QVERIFY(eventIndex("end C4") < startS1);
+        QVERIFY(eventIndex("end C3") < startS1);
+        QVERIFY(eventIndex("end S1") < eventIndex("start C2"));
+        QVERIFY(eventIndex("end S1") < eventIndex("start C1"));
+
+        // Consecutive operations of another type are not added to the batch
+        QVERIFY(eventIndex("end C2") < eventIndex("start U2"));
+        QVERIFY(eventIndex("end C1") < eventIndex("start U2"));
+        QVERIFY(eventIndex("end C2") < eventIndex("start U1"));
+        QVERIFY(eventIndex("end C1") < eventIndex("start U1"));
+
+        // Extracted files overlapping with the batch start a new one
+        QVERIFY(eventIndex("end U1") < eventIndex("start U0"));
+        QVERIFY(eventIndex("end U2") < eventIndex("start U0"));
+    }
+
+    void testRetryFailedUndoInBatch()
+    {
+        MessageBoxHandler::instance()->setAutomaticAnswer(QLatin1String("installationErrorWithIgnore"),
+            QMessageBox::Retry);
+        {
+            QMutexLocker _(&undoLog.mutex);
+            undoLog.failingUndos.insert(QLatin1String("C3"), 1);
+        }
+        installAndUninstall();
+
+        QCOMPARE(undoLog.undoCount.value("C3"), 2);
+        for (const QString &id : m_operationIds) {
+            if (id != QLatin1String("C3"))
+                QCOMPARE(undoLog.undoCount.value(id), 1);
+        }
+
+        // Only the failed operation is run again, after its batch finished
+        // and before the next operation is undone.
+        const int retryC3 = eventIndex("start C3", eventIndex("start C3") + 1);
+        QVERIFY(retryC3 > eventIndex("end C4"));
+        QVERIFY(eventIndex("end C3", retryC3) < eventIndex("start S1"));
+    }
+
+    void testIgnoreFailedUndoInBatch()
+    {
+        MessageBoxHandler::instance()->setAutomaticAnswer(QLatin1String("installationErrorWithIgnore"),
+            QMessageBox::Ignore);
+        {
+            QMutexLocker _(&undoLog.mutex);
+            undoLog.failingUndos.insert(QLatin1String("C4"), 1);
+        }
+        installAndUninstall();
+
+        // The ignored operation is not run again, the others are still undone in order
+        for (const QString &id : m_operationIds)
+            QCOMPARE(undoLog.undoCount.value(id), 1);
+        QVERIFY(eventIndex("end C4") < eventIndex("start S1"));
+        QVERIFY(eventIndex("end S1") < eventIndex("start C2"));
+        QVERIFY(eventIndex("end C1") < eventIndex("start U2"));
+    }
+
+private:
+    const QStringList m_operationIds = QStringList() << "U0" << "U1" << "U2" << "C1" << "C2" << "S1"
+        << "C3" << "C4";
+    QString m_testDirectory;
+};
+
+QTEST_GUILESS_MAIN(tst_UndoOperations)
+
+#include "tst_undooperations.moc"
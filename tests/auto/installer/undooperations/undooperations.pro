@@ -0,0 +1,7 @@
+include(../../qttest.pri)
+
+QT -= gui
+
+RESOURCES += data.qrc \
+    ../shared/config.qrc
+SOURCES += tst_undooperations.cpp
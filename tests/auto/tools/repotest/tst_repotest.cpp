@@ -45,12 +45,14 @@ class tst_repotest : public QObject
     Q_OBJECT
 private:
     void generateRepo(bool createSplitMetadata, bool createUnifiedMetadata, bool updateNewComponents,
-                      QStringList packagesUpdatedWithSha = QStringList())
+                      QStringList packagesUpdatedWithSha = QStringList(), int jobs = 0,
+                      bool updateChangedComponents = false)
     {
         QStringList filteredPackages;
 
         m_packages = QInstallerTools::collectPackages(m_repoInfo,
-            &filteredPackages, QInstallerTools::Exclude, updateNewComponents, packagesUpdatedWithSha);
+            &filteredPackages, QInstallerTools::Exclude, updateNewComponents, packagesUpdatedWithSha,
+            updateChangedComponents);
 
         if (updateNewComponents) { //Verify that component B exists as that is not updated
             if (createSplitMetadata) {
@@ -65,7 +67,9 @@ private:
         tmp.setAutoRemove(false);
         const QString tmpMetaDir = tmp.path();
         QInstallerTools::createRepository(m_repoInfo, &m_packages, tmpMetaDir, createSplitMetadata,
-                                          createUnifiedMetadata, QLatin1String("7z"));
+                                          createUnifiedMetadata, QLatin1String("7z"),
+                                          QInstaller::AbstractArchive::Normal, jobs,
+                                          updateChangedComponents);
         QInstaller::removeDirectory(tmpMetaDir, true);
     }
 
@@ -302,6 +306,17 @@ private slots:
         ignoreMessagesForComponentSha(QStringList () << "A" << "B", false);
         generateRepo(true, false, false);
 
+        verifyComponentRepository("1.0.0", "1.0.0", true);
+        verifyComponentMetaUpdatesXml();
+        // The input manifest is only written with --update-changed-components
+        QVERIFY(!QFile::exists(m_repoInfo.repositoryDir + "/RepogenManifest.xml"));
+    }
+
+    void testWithComponentMetaSingleJob()
+    {
+        ignoreMessagesForComponentSha(QStringList () << "A" << "B", false);
+        generateRepo(true, false, false, QStringList(), 1);
+
         verifyComponentRepository("1.0.0", "1.0.0", true);
         verifyComponentMetaUpdatesXml();
     }
@@ -403,6 +418,81 @@ private slots:
         verifyUniteMetadata("2.0.0");
     }
 
+    void testUpdateChangedComponents()
+    {
+        ignoreMessagesForComponentSha(QStringList() << "A" << "B", false);
+        generateRepo(true, false, false, QStringList(), 0, true);
+        verifyComponentRepository("1.0.0", "1.0.0", true);
+        VerifyInstaller::verifyFileExistence(m_repoInfo.repositoryDir, QStringList() << "Updates.xml"
+                                            << "RepogenManifest.xml");
+
+        // Nothing changed, existing archives and metadata are kept
+        QStringList filteredPackages;
+        ignoreMessageForCollectingPackages("1.0.0", "1.0.0");
+        m_packages = QInstallerTools::collectPackages(m_repoInfo, &filteredPackages,
+            QInstallerTools::Exclude, false, QStringList(), true, QLatin1String("7z"),
+            QInstaller::AbstractArchive::Normal);
+        QVERIFY(m_packages.isEmpty());
+        verifyComponentRepository("1.0.0", "1.0.0", true);
+
+        // Changing an input file regenerates only the component it belongs to. The
+        // manifest stores paths relative to the packages directory, so a modified copy
+        // of the directory can stand in for it.
+        const QStringList packageDirs = m_repoInfo.packages;
+        const QString changedPackages = QInstaller::generateTemporaryFileName();
+        m_tempDirDeleter.add(changedPackages);
+        QInstaller::copyDirectoryContents(packageDirs.first(), changedPackages);
+        {
+            QFile dataFile(changedPackages + "/A/data/A.txt");
+            QVERIFY(dataFile.open(QIODevice::Append));
+            QVERIFY(dataFile.write("changed") > 0);
+        }
+        m_repoInfo.packages = QStringList() << changedPackages;
+
+        const QString message = "Update component \"%1\" in \"%2\" .";
+        ignoreMessageForCollectingPackages("1.0.0", "1.0.0");
+        QTest::ignoreMessage(QtDebugMsg, qPrintable(message.arg("A", m_repoInfo.repositoryDir)));
+        m_packages = QInstallerTools::collectPackages(m_repoInfo, &filteredPackages,
+            QInstallerTools::Exclude, false, QStringList(), true, QLatin1String("7z"),
+            QInstaller::AbstractArchive::Normal);
+        QCOMPARE(m_packages.count(), 1);
+        QCOMPARE(m_packages.first().name, QLatin1String("A"));
+        QVERIFY(!m_packages.first().inputsSha1.isEmpty());
+        QVERIFY(!QFileInfo::exists(m_repoInfo.repositoryDir + "/A"));
+        VerifyInstaller::verifyFileExistence(m_repoInfo.repositoryDir + "/B", QStringList()
+            << "1.0.0content.7z" << "1.0.0content.7z.sha1" << "1.0.0meta.7z");
+
+        QTemporaryDir tmp;
+        QInstallerTools::createRepository(m_repoInfo, &m_packages, tmp.path(), true, false,
+            QLatin1String("7z"), QInstaller::AbstractArchive::Normal, 0, true);
+        verifyComponentRepository("1.0.0", "1.0.0", true);
+
+        // The manifest now describes the changed input
+        ignoreMessageForCollectingPackages("1.0.0", "1.0.0");
+        m_packages = QInstallerTools::collectPackages(m_repoInfo, &filteredPackages,
+            QInstallerTools::Exclude, false, QStringList(), true, QLatin1String("7z"),
+            QInstaller::AbstractArchive::Normal);
+        QVERIFY(m_packages.isEmpty());
+        m_repoInfo.packages = packageDirs;
+
+        // Components missing from the repository are generated again
+        QInstaller::removeDirectory(m_repoInfo.repositoryDir + "/B");
+        ignoreMessageForCollectingPackages("1.0.0", "1.0.0");
+        QTest::ignoreMessage(QtDebugMsg, qPrintable(message.arg("B", m_repoInfo.repositoryDir)));
+        m_packages = QInstallerTools::collectPackages(m_repoInfo, &filteredPackages,
+            QInstallerTools::Exclude, false, QStringList(), true, QLatin1String("7z"),
+            QInstaller::AbstractArchive::Normal);
+        QCOMPARE(m_packages.count(), 1);
+        QCOMPARE(m_packages.first().name, QLatin1String("B"));
+
+        // Changing the compression level invalidates all archives
+        ignoreMessageForCollectingPackages("1.0.0", "1.0.0");
+        m_packages = QInstallerTools::collectPackages(m_repoInfo, &filteredPackages,
+            QInstallerTools::Exclude, false, QStringList(), true, QLatin1String("7z"),
+            QInstaller::AbstractArchive::Maximum);
+        QCOMPARE(m_packages.count(), 2);
+    }
+
     void testUpdateComponents()
     {
         ignoreMessagesForComponentSha(QStringList() << "A" << "B", false);
@@ -83,6 +83,8 @@ static void printUsage()
     std::cout << "                            you omit this option the 7z format will be used as a default." << std::endl;
     std::cout << "  --ac|--compression 0,1,3,5,7,9" << std::endl;
     std::cout << "                            Sets the compression level used when packaging new data archives." << std::endl;
+    std::cout << "  -j|--jobs count           Sets the number of packages compressed and hashed in parallel." << std::endl;
+    std::cout << "                            Defaults to the number of CPU cores." << std::endl;
     std::cout << std::endl;
     std::cout << "Packages are to be found in the current working directory and get listed as "
         "their names" << std::endl << std::endl;
@@ -213,6 +215,17 @@ int main(int argc, char **argv)
                     "Error: Unknown compression level \"%1\".").arg(value));
             }
             parsedArgs.compression = static_cast<AbstractArchive::CompressionLevel>(value);
+        } else if (*it == QLatin1String("-j") || *it == QLatin1String("--jobs")) {
+            ++it;
+            if (it == args.end())
+                return printErrorAndUsageAndExit(QString::fromLatin1("Error: Jobs parameter missing argument."));
+
+            bool ok = false;
+            parsedArgs.jobs = it->toInt(&ok);
+            if (!ok || parsedArgs.jobs < 1) {
+                return printErrorAndUsageAndExit(QString::fromLatin1(
+                    "Error: Invalid number of jobs \"%1\".").arg(*it));
+            }
 #ifdef Q_OS_MACOS
         } else if (*it == QLatin1String("--mt") || *it == QLatin1String("--create-maintenancetool")) {
             parsedArgs.createMaintenanceTool = true;
@@ -69,6 +69,10 @@ static void printUsage()
     std::cout << "                            --include or --exclude) in the repository with all new components"
         << std::endl;
 
+    std::cout << "  --update-changed-components Update a set of existing components (defined by " << std::endl;
+    std::cout << "                            --include or --exclude) in the repository whose data or meta" << std::endl;
+    std::cout << "                            files changed since the repository was last generated" << std::endl;
+
     std::cout << "  -v|--verbose              Verbose output" << std::endl;
 
     std::cout << "  --unite-metadata          Combine all metadata into one 7z. This speeds up metadata " << std::endl;
@@ -80,6 +84,8 @@ static void printUsage()
     std::cout << "                            you omit this option the 7z format will be used as a default." << std::endl;
     std::cout << "  --ac|--compression 0,1,3,5,7,9" << std::endl;
     std::cout << "                            Sets the compression level used when packaging new data archives." << std::endl;
+    std::cout << "  -j|--jobs count           Sets the number of packages compressed and hashed in parallel." << std::endl;
+    std::cout << "                            Defaults to the number of CPU cores." << std::endl;
 
     std::cout << std::endl;
     std::cout << "Example:" << std::endl;
@@ -112,10 +118,12 @@ int main(int argc, char** argv)
         QInstallerTools::FilterType filterType = QInstallerTools::Exclude;
         bool remove = false;
         bool updateExistingRepositoryWithNewComponents = false;
+        bool updateExistingRepositoryWithChangedComponents = false;
         bool createUnifiedMetadata = true;
         bool createComponentMetadata = true;
         QString archiveSuffix = QLatin1String("7z");
         AbstractArchive::CompressionLevel compression = AbstractArchive::Normal;
+        int jobs = 0;
 
         //TODO: use a for loop without removing values from args like it is in binarycreator.cpp
         //for (QStringList::const_iterator it = args.begin(); it != args.end(); ++it) {
@@ -160,6 +168,9 @@ int main(int argc, char** argv)
             } else if (args.first() == QLatin1String("--update-new-components")) {
                 args.removeFirst();
                 updateExistingRepositoryWithNewComponents = true;
+            } else if (args.first() == QLatin1String("--update-changed-components")) {
+                args.removeFirst();
+                updateExistingRepositoryWithChangedComponents = true;
             } else if (args.first() == QLatin1String("-p") || args.first() == QLatin1String("--packages")) {
                 args.removeFirst();
                 if (args.isEmpty()) {
@@ -231,6 +242,19 @@ int main(int argc, char** argv)
                 }
                 compression = static_cast<AbstractArchive::CompressionLevel>(value);
                 args.removeFirst();
+            } else if (args.first() == QLatin1String("-j") || args.first() == QLatin1String("--jobs")) {
+                args.removeFirst();
+                if (args.isEmpty()) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Jobs parameter missing argument"));
+                }
+                bool ok = false;
+                jobs = args.first().toInt(&ok);
+                if (!ok || jobs < 1) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Invalid number of jobs \"%1\".").arg(args.first()));
+                }
+                args.removeFirst();
             } else {
                 printUsage();
                 return 1;
@@ -242,10 +266,12 @@ int main(int argc, char** argv)
                 return 1;
         }
 
-        const bool update = updateExistingRepository || updateExistingRepositoryWithNewComponents;
+        const bool update = updateExistingRepository || updateExistingRepositoryWithNewComponents
+            || updateExistingRepositoryWithChangedComponents;
         if (remove && update) {
             throw QInstaller::Error(QCoreApplication::translate("QInstaller",
-                "Argument -r|--remove and --update|--update-new-components are mutually exclusive!"));
+                "Argument -r|--remove and --update|--update-new-components|--update-changed-components "
+                "are mutually exclusive!"));
         }
 
         repoInfo.repositoryDir = QInstallerTools::makePathAbsolute(args.first());
@@ -260,7 +286,8 @@ int main(int argc, char** argv)
         }
 
         QInstallerTools::PackageInfoVector packages = QInstallerTools::collectPackages(repoInfo,
-            &filteredPackages, filterType, updateExistingRepositoryWithNewComponents, packagesUpdatedWithSha);
+            &filteredPackages, filterType, updateExistingRepositoryWithNewComponents, packagesUpdatedWithSha,
+            updateExistingRepositoryWithChangedComponents, archiveSuffix, compression);
         if (packages.isEmpty()) {
             std::cout << QString::fromLatin1("Cannot find components to update \"%1\".")
                 .arg(repoInfo.repositoryDir) << std::endl;
@@ -271,7 +298,8 @@ int main(int argc, char** argv)
         tmp.setAutoRemove(false);
         tmpMetaDir = tmp.path();
         QInstallerTools::createRepository(repoInfo, &packages, tmpMetaDir,
-            createComponentMetadata, createUnifiedMetadata, archiveSuffix, compression);
+            createComponentMetadata, createUnifiedMetadata, archiveSuffix, compression, jobs,
+            updateExistingRepositoryWithChangedComponents);
 
         exitCode = EXIT_SUCCESS;
     } catch (const QInstaller::Error &e) {